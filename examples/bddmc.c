@@ -15,20 +15,27 @@
 static int report_levels = 0; // report states at end of every level
 static int report_table = 0; // report table size at end of every level
 static int report_nodes = 0; // report number of nodes of BDDs
+static int report_profile = 0; // report the nodes per variable of the final states
 static int strategy = 2; // 0 = BFS, 1 = PAR, 2 = SAT, 3 = CHAINING
 static int check_deadlocks = 0; // set to 1 to check for deadlocks on-the-fly (only bfs/par)
 static int merge_relations = 0; // merge relations to 1 relation
 static int print_transition_matrix = 0; // print transition relation matrix
 static int workers = 0; // autodetect
 static char* model_filename = NULL; // filename of model
+static char* stats_filename = NULL; // filename for the statistics in JSON
+static int stats_sample = 0; // sampling period of the statistics (0 = off)
+static char* trace_filename = NULL; // filename for the trace of Sylvan events
+static int trace_cache = 0; // also trace the operation cache
 
 static void
 print_usage()
 {
     printf("Usage: bddmc [-h] [-s <bfs|par|sat|chaining>] [-w <workers>]\n");
     printf("        [--strategy=<bfs|par|sat|chaining>] [--workers=<workers>]\n");
-    printf("        [--count-nodes] [--count-states] [--count-table] [--deadlocks]\n");
-    printf("        [--merge-relations] [--print-matrix] [--help] [--usage] <model>\n");
+    printf("        [--count-nodes] [--count-states] [--count-table] [--profile] [--deadlocks]\n");
+    printf("        [--merge-relations] [--print-matrix] [--stats-json=<file>]\n");
+    printf("        [--stats-sample=<period>] [--trace=<file>] [--trace-cache]\n");
+    printf("        [--help] [--usage] <model>\n");
 }
 
 static void
@@ -41,9 +48,16 @@ print_help()
     printf("      --count-nodes          Report #nodes for BDDs\n");
     printf("      --count-states         Report #states at each level\n");
     printf("      --count-table          Report table usage at each level\n");
+    printf("      --profile              Report the nodes per variable of the final states\n");
     printf("      --deadlocks            Check for deadlocks\n");
     printf("      --merge-relations      Merge transition relations into one transition relation\n");
     printf("      --print-matrix         Print transition matrix\n");
+    printf("      --stats-json=<file>    Write the Sylvan statistics to <file> in JSON\n");
+    printf("      --stats-sample=<period>\n");
+    printf("                             Sample the Sylvan statistics (one of every <period> events)\n");
+    printf("      --trace=<file>         Write a trace of garbage collections and levels to <file>\n");
+    printf("                             (requires Sylvan built with SYLVAN_TRACE)\n");
+    printf("      --trace-cache          Also trace the operation cache (many events)\n");
     printf("  -h, --help                 Give this help list\n");
     printf("      --usage                Give a short usage message\n");
 }
@@ -60,6 +74,11 @@ parse_args(int argc, char **argv)
         {.name = "count-table", .val = 2, .has_arg = no_argument},
         {.name = "merge-relations", .val = 6, .has_arg = no_argument},
         {.name = "print-matrix", .val = 4, .has_arg = no_argument},
+        {.name = "stats-json", .val = 7, .has_arg = required_argument},
+        {.name = "stats-sample", .val = 8, .has_arg = required_argument},
+        {.name = "profile", .val = 9, .has_arg = no_argument},
+        {.name = "trace", .val = 10, .has_arg = required_argument},
+        {.name = "trace-cache", .val = 11, .has_arg = no_argument},
         {.name = "help", .val = 'h', .has_arg = no_argument},
         {.name = "usage", .val = 99, .has_arg = no_argument},
         {},
@@ -99,6 +118,21 @@ parse_args(int argc, char **argv)
             case 6:
                 merge_relations = 1;
                 break;
+            case 7:
+                stats_filename = optarg;
+                break;
+            case 8:
+                stats_sample = atoi(optarg);
+                break;
+            case 9:
+                report_profile = 1;
+                break;
+            case 10:
+                trace_filename = optarg;
+                break;
+            case 11:
+                trace_cache = 1;
+                break;
             case 99:
                 print_usage();
                 exit(0);
@@ -294,7 +328,44 @@ TASK_1(rel_t, rel_load_proj, FILE*, f)
 #define rel_load(rel, f) RUN(rel_load, rel, f)
 VOID_TASK_2(rel_load, rel_t, rel, FILE*, f)
 {
-    if (mtbdd_reader_frombinary(f, &rel->bdd, 1) != 0) Abort("Invalid file format!\n");
+    if (CALL(mtbdd_reader_frombinary, f, &rel->bdd, 1) != 0) Abort("Invalid file format!\n");
+}
+
+/**
+ * Load the bdds of the relations <rels> in parallel, one task per relation.
+ * Every task reads its relation from <offsets> with its own FILE*.
+ */
+VOID_TASK_3(rel_load_par, rel_t*, rels, long*, offsets, int, count)
+{
+    if (count > 1) {
+        SPAWN(rel_load_par, rels, offsets, count/2);
+        CALL(rel_load_par, rels+count/2, offsets+count/2, count-count/2);
+        SYNC(rel_load_par);
+        return;
+    }
+
+    FILE *f = fopen(model_filename, "rb");
+    if (f == NULL) Abort("Cannot open file '%s'!\n", model_filename);
+    if (fseek(f, offsets[0], SEEK_SET) != 0) Abort("Invalid file format!\n");
+    CALL(rel_load, rels[0], f);
+    fclose(f);
+}
+
+/**
+ * Load the bdds of all relations from file
+ * The nodes of every relation are first skipped to find where the next relation starts,
+ * then all relations are read at the same time by rel_load_par.
+ */
+#define rel_load_all(f, rels, count) RUN(rel_load_all, f, rels, count)
+VOID_TASK_3(rel_load_all, FILE*, f, rel_t*, rels, int, count)
+{
+    long *offsets = (long*)malloc(sizeof(long[count]));
+    for (int i=0; i<count; i++) {
+        offsets[i] = ftell(f);
+        if (mtbdd_reader_skipbinary(f) != 0) Abort("Invalid file format!\n");
+    }
+    if (count > 0) CALL(rel_load_par, rels, offsets, count);
+    free(offsets);
 }
 
 /**
@@ -323,78 +394,20 @@ VOID_TASK_2(print_example, BDD, example, BDDSET, variables)
     }
 }
 
-/**
- * Implementation of (parallel) saturation
- * (assumes relations are ordered on first variable)
- */
-TASK_2(BDD, go_sat, BDD, set, int, idx)
-{
-    /* Terminal cases */
-    if (set == sylvan_false) return sylvan_false;
-    if (idx == next_count) return set;
-
-    /* Consult the cache */
-    BDD result;
-    const BDD _set = set;
-    if (cache_get3(200LL<<40, _set, idx, 0, &result)) return result;
-    mtbdd_refs_pushptr(&_set);
-
-    /**
-     * Possible improvement: cache more things (like intermediate results?)
-     *   and chain-apply more of the current level before going deeper?
-     */
-
-    /* Check if the relation should be applied */
-    const uint32_t var = sylvan_var(next[idx]->variables);
-    if (set == sylvan_true || var <= sylvan_var(set)) {
-        /* Count the number of relations starting here */
-        int count = idx+1;
-        while (count < next_count && var == sylvan_var(next[count]->variables)) count++;
-        count -= idx;
-        /*
-         * Compute until fixpoint:
-         * - SAT deeper
-         * - chain-apply all current level once
-         */
-        BDD prev = sylvan_false;
-        BDD step = sylvan_false;
-        mtbdd_refs_pushptr(&set);
-        mtbdd_refs_pushptr(&prev);
-        mtbdd_refs_pushptr(&step);
-        while (prev != set) {
-            prev = set;
-            // SAT deeper
-            set = CALL(go_sat, set, idx+count);
-            // chain-apply all current level once
-            for (int i=0;i<count;i++) {
-                step = sylvan_relnext(set, next[idx+i]->bdd, next[idx+i]->variables);
-                set = sylvan_or(set, step);
-                step = sylvan_false; // unset, for gc
-            }
-        }
-        mtbdd_refs_popptr(3);
-        result = set;
-    } else {
-        /* Recursive computation */
-        mtbdd_refs_spawn(SPAWN(go_sat, sylvan_low(set), idx));
-        BDD high = mtbdd_refs_push(CALL(go_sat, sylvan_high(set), idx));
-        BDD low = mtbdd_refs_sync(SYNC(go_sat));
-        mtbdd_refs_pop(1);
-        result = sylvan_makenode(sylvan_var(set), low, high);
-    }
-
-    /* Store in cache */
-    cache_put3(200LL<<40, _set, idx, 0, result);
-    mtbdd_refs_popptr(1);
-    return result;
-}
-
 /**
  * Wrapper for the Saturation strategy
  */
 VOID_TASK_1(sat, set_t, set)
 {
-    set->bdd = CALL(go_sat, set->bdd, 0);
+    BDD *relations = (BDD*)malloc(sizeof(BDD) * next_count);
+    BDDSET *vars = (BDDSET*)malloc(sizeof(BDDSET) * next_count);
+    for (int i=0; i<next_count; i++) {
+        relations[i] = next[i]->bdd;
+        vars[i] = next[i]->variables;
+    }
+    set->bdd = sylvan_saturate(set->bdd, relations, vars, next_count);
+    free(relations);
+    free(vars);
 }
 
 /**
@@ -501,6 +514,7 @@ VOID_TASK_1(par, set_t, set)
         } else {
             INFO("Level %d done\n", iteration);
         }
+        sylvan_trace_mark("level");
         iteration++;
     } while (next_level != sylvan_false);
 
@@ -617,6 +631,7 @@ VOID_TASK_1(bfs, set_t, set)
         } else {
             INFO("Level %d done\n", iteration);
         }
+        sylvan_trace_mark("level");
         iteration++;
     } while (next_level != sylvan_false);
 
@@ -672,6 +687,7 @@ VOID_TASK_1(chaining, set_t, set)
         } else {
             INFO("Level %d done\n", iteration);
         }
+        sylvan_trace_mark("level");
         iteration++;
     } while (next_level != sylvan_false);
 
@@ -715,19 +731,20 @@ TASK_2(BDD, extend_relation, MTBDD, relation, MTBDD, variables)
 }
 
 /**
- * Compute \BigUnion ( sets[i] )
+ * Extend the relations <rels> to the full domain <vars> in parallel
  */
-#define big_union(first, count) RUN(big_union, first, count)
-TASK_2(BDD, big_union, int, first, int, count)
+VOID_TASK_3(extend_relations, rel_t*, rels, int, count, BDDSET, vars)
 {
-    if (count == 1) return next[first]->bdd;
+    if (count == 0) return;
+    if (count > 1) {
+        SPAWN(extend_relations, rels, count/2, vars);
+        CALL(extend_relations, rels+count/2, count-count/2, vars);
+        SYNC(extend_relations);
+        return;
+    }
 
-    bdd_refs_spawn(SPAWN(big_union, first, count/2));
-    BDD right = bdd_refs_push(CALL(big_union, first+count/2, count-count/2));
-    BDD left = bdd_refs_push(bdd_refs_sync(SYNC(big_union)));
-    BDD result = sylvan_or(left, right);
-    bdd_refs_pop(2);
-    return result;
+    rels[0]->bdd = CALL(extend_relation, rels[0]->bdd, rels[0]->variables);
+    rels[0]->variables = vars;
 }
 
 /**
@@ -784,6 +801,7 @@ VOID_TASK_0(run)
      */
 
     /* Open the file */
+    double t_read = wctime();
     FILE *f = fopen(model_filename, "rb");
     if (f == NULL) Abort("Cannot open file '%s'!\n", model_filename);
 
@@ -804,7 +822,8 @@ VOID_TASK_0(run)
 
     /* Read transition relations */
     for (int i=0; i<next_count; i++) next[i] = rel_load_proj(f);
-    for (int i=0; i<next_count; i++) rel_load(next[i], f);
+    rel_load_all(f, next, next_count);
+    long bytes_read = ftell(f);
 
     /* We ignore the reachable states and action labels that are stored after the relations */
 
@@ -831,7 +850,11 @@ VOID_TASK_0(run)
         }
     }
 
-    INFO("Read file '%s'\n", model_filename);
+    {
+        double t = wctime()-t_read;
+        char buf[32], buf2[32];
+        INFO("Read file '%s' in %.3f sec (%s, %s/sec)\n", model_filename, t, to_h(bytes_read, buf), to_h(t > 0 ? bytes_read/t : 0, buf2));
+    }
     INFO("%d integers per state, %d bits per state, %d transition groups\n", vectorsize, totalbits, next_count);
 
     /* if requested, print the transition matrix */
@@ -853,15 +876,15 @@ VOID_TASK_0(run)
         }
 
         INFO("Extending transition relations to full domain.\n");
-        for (int i=0; i<next_count; i++) {
-            next[i]->bdd = extend_relation(next[i]->bdd, next[i]->variables);
-            next[i]->variables = newvars;
-        }
+        RUN(extend_relations, next, next_count, newvars);
 
         bdd_refs_popptr(1);
 
         INFO("Taking union of all transition relations.\n");
-        next[0]->bdd = big_union(0, next_count);
+        BDD *bdds = (BDD*)malloc(sizeof(BDD) * next_count);
+        for (int i=0; i<next_count; i++) bdds[i] = next[i]->bdd;
+        next[0]->bdd = sylvan_or_n(bdds, next_count);
+        free(bdds);
 
         for (int i=1; i<next_count; i++) {
             next[i]->bdd = sylvan_false;
@@ -880,6 +903,7 @@ VOID_TASK_0(run)
 
     print_memory_usage();
 
+    sylvan_trace_begin("reachability");
     if (strategy == 0) {
         double t1 = wctime();
         RUN(bfs, states);
@@ -903,12 +927,20 @@ VOID_TASK_0(run)
     } else {
         Abort("Invalid strategy set?!\n");
     }
+    sylvan_trace_end("reachability");
 
     // Now we just have states
     INFO("Final states: %0.0f states\n", sylvan_satcount(states->bdd, states->variables));
     if (report_nodes) {
         INFO("Final states: %zu BDD nodes\n", sylvan_nodecount(states->bdd));
     }
+    if (report_profile) {
+        sylvan_profile_t profile;
+        mtbdd_profile(&states->bdd, 1, &profile);
+        INFO("Final states: ");
+        sylvan_profile_fprint(stdout, &profile);
+        sylvan_profile_free(&profile);
+    }
 }
 
 int
@@ -948,14 +980,37 @@ main(int argc, char **argv)
     sylvan_set_limits(max, 1, 6);
     sylvan_init_package();
     sylvan_init_bdd();
+    if (stats_sample > 0) sylvan_stats_set_sampling(stats_sample);
     sylvan_gc_hook_pregc(TASK(gc_start));
     sylvan_gc_hook_postgc(TASK(gc_end));
 
+    if (trace_filename != NULL) {
+        unsigned int categories = SYLVAN_TRACE_GC | SYLVAN_TRACE_TABLE | SYLVAN_TRACE_USER;
+        if (trace_cache) categories |= SYLVAN_TRACE_CACHE;
+        if (sylvan_trace_enable(categories, 1<<20) != 0) Abort("Sylvan is built without SYLVAN_TRACE!\n");
+    }
+
     RUN(run);
 
+    if (trace_filename != NULL) {
+        sylvan_trace_disable();
+        FILE *f = fopen(trace_filename, "w");
+        if (f == NULL) Abort("Cannot open file '%s'!\n", trace_filename);
+        size_t count = sylvan_trace_dump(f);
+        fclose(f);
+        INFO("Wrote %zu events to %s\n", count, trace_filename);
+    }
+
     print_memory_usage();
 
     sylvan_stats_report(stdout);
 
+    if (stats_filename != NULL) {
+        FILE *f = fopen(stats_filename, "w");
+        if (f == NULL) Abort("Cannot open file '%s'!\n", stats_filename);
+        sylvan_stats_report_json(f);
+        fclose(f);
+    }
+
     lace_stop();
 }
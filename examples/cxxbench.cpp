@@ -0,0 +1,160 @@
+/**
+ * Microbenchmark of the C++ Bdd/Mtbdd classes.
+ *
+ * Every worker evaluates small expressions like (a & b) | (c & ~d) on a pool of BDDs.
+ * The operations mostly hit the operation cache, so the benchmark measures the cost of
+ * the C++ objects (construction, copies, temporaries) rather than the BDD algorithms.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <sylvan.h>
+#include <sylvan_obj.hpp>
+
+using namespace sylvan;
+
+static int workers = 0; // autodetect
+static long iterations = 1000000; // iterations per task
+static int tasks = 0; // number of tasks (default: number of workers)
+
+static double
+wctime()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec + 1E-6 * tv.tv_usec);
+}
+
+static void
+print_usage()
+{
+    printf("Usage: cxxbench [-w <workers>] [-n <iterations>] [-t <tasks>]\n");
+}
+
+static void
+parse_args(int argc, char **argv)
+{
+    int key;
+    while ((key = getopt(argc, argv, "w:n:t:h")) != -1) {
+        switch (key) {
+            case 'w':
+                workers = atoi(optarg);
+                break;
+            case 'n':
+                iterations = atol(optarg);
+                break;
+            case 't':
+                tasks = atoi(optarg);
+                break;
+            default:
+                print_usage();
+                exit(0);
+        }
+    }
+}
+
+/**
+ * Evaluate expressions on a pool of 16 BDDs, returns a checksum
+ */
+TASK_1(uint64_t, bench_bdd, int, seed)
+{
+    std::vector<Bdd> pool;
+    for (uint32_t i=0; i<16; i++) {
+        Bdd x = Bdd::bddVar(i) & !Bdd::bddVar((i+1)%16);
+        pool.push_back(x | Bdd::bddVar((i+seed)%16));
+    }
+
+    uint64_t sum = 0;
+    for (long it=0; it<iterations; it++) {
+        const Bdd &a = pool[it & 15], &b = pool[(it >> 4) & 15];
+        const Bdd &c = pool[(it >> 2) & 15], &d = pool[(it >> 6) & 15];
+        Bdd r = (a & b) | (c & ~d);
+        if (!r.isConstant()) sum += r.TopVar();
+    }
+    return sum;
+}
+
+/**
+ * Evaluate conjunctions of four BDDs, which reuse the temporaries of the chain
+ */
+TASK_1(uint64_t, bench_chain, int, seed)
+{
+    std::vector<Bdd> pool;
+    for (uint32_t i=0; i<16; i++) {
+        Bdd x = Bdd::bddVar(i) | !Bdd::bddVar((i+1)%16);
+        pool.push_back(x | Bdd::bddVar((i+seed+3)%16));
+    }
+
+    uint64_t sum = 0;
+    for (long it=0; it<iterations; it++) {
+        const Bdd &a = pool[it & 15], &b = pool[(it >> 4) & 15];
+        const Bdd &c = pool[(it >> 2) & 15], &d = pool[(it >> 6) & 15];
+        Bdd r = a & b & c & d;
+        if (!r.isConstant()) sum += r.TopVar();
+    }
+    return sum;
+}
+
+TASK_1(uint64_t, bench_mtbdd, int, seed)
+{
+    std::vector<Mtbdd> pool;
+    for (uint32_t i=0; i<16; i++) {
+        Mtbdd x = Mtbdd(Bdd::bddVar(i)).Ite(Mtbdd::int64Terminal(i), Mtbdd::int64Terminal(seed));
+        pool.push_back(x);
+    }
+
+    uint64_t sum = 0;
+    for (long it=0; it<iterations; it++) {
+        const Mtbdd &a = pool[it & 15], &b = pool[(it >> 4) & 15], &c = pool[(it >> 2) & 15];
+        Mtbdd r = (a + b) * c;
+        if (!r.isLeaf()) sum += r.TopVar();
+    }
+    return sum;
+}
+
+static const char *bench_names[] = { "Bdd (a & b) | (c & ~d)", "Bdd a & b & c & d", "Mtbdd (a + b) * c" };
+
+TASK_1(double, bench, int, which)
+{
+    double t1 = wctime();
+    uint64_t sum = 0;
+    for (int i=0; i<tasks; i++) {
+        if (which == 0) SPAWN(bench_bdd, i);
+        else if (which == 1) SPAWN(bench_chain, i);
+        else SPAWN(bench_mtbdd, i);
+    }
+    for (int i=0; i<tasks; i++) {
+        if (which == 0) sum += SYNC(bench_bdd);
+        else if (which == 1) sum += SYNC(bench_chain);
+        else sum += SYNC(bench_mtbdd);
+    }
+    double t2 = wctime();
+    printf("%s: %ld x %d expressions in %.3f sec, %.2f M/sec (checksum %" PRIu64 ")\n",
+           bench_names[which], iterations, tasks, t2-t1, (double)iterations*tasks/(t2-t1)/1e6, sum);
+    return t2-t1;
+}
+
+int
+main(int argc, char **argv)
+{
+    parse_args(argc, argv);
+
+    lace_start(workers, 0);
+    if (tasks == 0) tasks = lace_workers();
+
+    sylvan_set_sizes(1LL<<20, 1LL<<20, 1LL<<20, 1LL<<20);
+    sylvan_init_package();
+    sylvan_init_mtbdd();
+
+    RUN(bench, 0);
+    RUN(bench, 1);
+    RUN(bench, 2);
+
+    sylvan_quit();
+    lace_stop();
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Compare the raw, packed and zlib formats of lddmc_writer_tobinary and mtbdd_writer_tobinary
+# on the LDD models in models/: file size, ratio to raw, and the time to write and read the file.
+#
+# Usage: formatbench.sh <build directory> [model...]
+#   e.g. examples/formatbench.sh build models/anderson.4.ldd
+# Without models, all LDD models in models/ are used. Every run is limited to $TIMEOUT seconds.
+# The zlib format requires that Sylvan is built with -DSYLVAN_ZLIB=ON.
+#
+
+BUILD=${1:?"usage: $0 <build directory> [model...]"}
+shift
+TIMEOUT=${TIMEOUT:-600}
+MODELS=${*:-$(ls "$(dirname "$0")"/../models/*.ldd)}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+printf "%-24s %-7s %12s %7s %9s %9s %12s %7s\n" "model" "format" "ldd bytes" "ratio" "write" "read" "bdd bytes" "ratio"
+for model in $MODELS; do
+    case "$model" in
+        *.ldd) ;;
+        *) continue ;;
+    esac
+    for format in raw packed zlib; do
+        out=$(timeout "$TIMEOUT" "$BUILD/examples/lddmc" -s sat --format=$format "$model" "$TMP/$format.ldd" 2>/dev/null)
+        size=$(echo "$out" | sed -n 's/.* Wrote \([0-9]*\) bytes in \(.*\) sec$/\1/p')
+        if [ -z "$size" ]; then
+            printf "%-24s %-7s %12s\n" "$(basename "$model")" $format "failed"
+            continue
+        fi
+        write=$(echo "$out" | sed -n 's/.* Wrote \([0-9]*\) bytes in \(.*\) sec$/\2/p')
+        read=$(timeout "$TIMEOUT" "$BUILD/examples/lddmc" -s sat "$TMP/$format.ldd" 2>/dev/null | sed -n "s/.* Read file '.*' in \([0-9.]*\) sec.*/\1/p")
+        timeout "$TIMEOUT" "$BUILD/examples/ldd2bdd" --format=$format "$TMP/$format.ldd" "$TMP/$format.bdd" >/dev/null 2>&1
+        bdd=$(wc -c < "$TMP/$format.bdd" 2>/dev/null)
+        [ $format = raw ] && rawsize=$size && rawbdd=$bdd
+        printf "%-24s %-7s %12s %7s %9s %9s %12s %7s\n" "$(basename "$model")" $format "$size" \
+            "$(awk "BEGIN { printf \"%.2f\", $rawsize/$size }")" "$write" "${read:-timeout}" "${bdd:-failed}" \
+            "$(awk "BEGIN { if (${bdd:-0} > 0) printf \"%.2f\", ${rawbdd:-0}/$bdd }")"
+    done
+done
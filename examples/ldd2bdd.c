@@ -16,12 +16,14 @@ static char* model_filename = NULL; // filename of model
 static char* bdd_filename = NULL; // filename of output BDD
 static int check_results = 0;
 static int no_reachable = 0;
+static sylvan_binary_format bdd_format = SYLVAN_BINARY_RAW; // format of output BDD
 
 static void
 print_usage()
 {
     printf("Usage: ldd2bdd [-vh] [-w <workers>] [--check-results] [--no-reachable]\n");
-    printf("            [--verbose] [--workers=<workers>] [--help] [--usage]\n");
+    printf("            [--verbose] [--workers=<workers>] [--format=<raw|packed|zlib>]\n");
+    printf("            [--help] [--usage]\n");
     printf("            <input-ldd> <output-bdd>\n");
 }
 
@@ -31,6 +33,8 @@ print_help()
     printf("Usage: ldd2bdd [OPTION...] <input-ldd> <output-bdd>\n\n");
     printf("      --check-results        Check new transition relations\n");
     printf("      --no-reachable         Do not write reachabile states\n");
+    printf("      --format=<raw|packed|zlib>\n");
+    printf("                             Format of the output BDD (default=raw)\n");
     printf("  -v, --verbose              Set verbose\n");
     printf("  -w, --workers=<workers>    Number of workers (default=0: autodetect)\n");
     printf("  -h, --help                 Give this help list\n");
@@ -44,6 +48,7 @@ parse_args(int argc, char **argv)
         {.name = "workers", .val = 'w', .has_arg = required_argument},
         {.name = "check-results", .val = 2, .has_arg = no_argument},
         {.name = "no-reachable", .val = 1, .has_arg = no_argument},
+        {.name = "format", .val = 3, .has_arg = required_argument},
         {.name = "verbose", .val = 'v', .has_arg = no_argument},
         {.name = "help", .val = 'h', .has_arg = no_argument},
         {.name = "usage", .val = 99, .has_arg = no_argument},
@@ -65,6 +70,15 @@ parse_args(int argc, char **argv)
             case 2:
                 check_results = 1;
                 break;
+            case 3:
+                if (strcmp(optarg, "raw")==0) bdd_format = SYLVAN_BINARY_RAW;
+                else if (strcmp(optarg, "packed")==0) bdd_format = SYLVAN_BINARY_PACKED;
+                else if (strcmp(optarg, "zlib")==0) bdd_format = SYLVAN_BINARY_PACKED_ZLIB;
+                else {
+                    print_usage();
+                    exit(0);
+                }
+                break;
             case 99:
                 print_usage();
                 exit(0);
@@ -105,8 +119,8 @@ static int has_actions = 0;
 #define Abort(...) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "Abort at line %d!\n", __LINE__); exit(-1); }
 
 /* Load a set from file */
-#define set_load(f) RUN(set_load, f)
-TASK_1(set_t, set_load, FILE*, f)
+#define set_load(f, reader) RUN(set_load, f, reader)
+TASK_2(set_t, set_load, FILE*, f, lddmc_reader_t, reader)
 {
     set_t set = (set_t)malloc(sizeof(struct set));
 
@@ -114,10 +128,10 @@ TASK_1(set_t, set_load, FILE*, f)
     if (fread(&k, sizeof(int), 1, f) != 1) Abort("Invalid input file!");
     if (k != -1) Abort("Invalid input file!");
 
-    lddmc_serialize_fromfile(f);
+    if (lddmc_reader_readbinary(reader, f) != 0) Abort("Invalid input file!");
     size_t dd;
     if (fread(&dd, sizeof(size_t), 1, f) != 1) Abort("Invalid input file!");
-    set->dd = lddmc_serialize_get_reversed(dd);
+    set->dd = lddmc_reader_get(reader, dd);
     lddmc_protect(&set->dd);
 
     return set;
@@ -178,13 +192,13 @@ TASK_1(rel_t, rel_load_proj, FILE*, f)
     return rel;
 }
 
-#define rel_load(f, rel) RUN(rel_load, f, rel)
-VOID_TASK_2(rel_load, FILE*, f, rel_t, rel)
+#define rel_load(f, reader, rel) RUN(rel_load, f, reader, rel)
+VOID_TASK_3(rel_load, FILE*, f, lddmc_reader_t, reader, rel_t, rel)
 {
-    lddmc_serialize_fromfile(f);
+    if (lddmc_reader_readbinary(reader, f) != 0) Abort("Invalid input file!");
     size_t dd;
     if (fread(&dd, sizeof(size_t), 1, f) != 1) Abort("Invalid input file!");
-    rel->dd = lddmc_serialize_get_reversed(dd);
+    rel->dd = lddmc_reader_get(reader, dd);
 }
 
 /**
@@ -548,7 +562,8 @@ VOID_TASK_0(run)
 
     // Read initial state
     if (verbose) printf("Loading initial state.\n");
-    set_t initial = set_load(f);
+    lddmc_reader_t reader = lddmc_reader_start();
+    set_t initial = set_load(f, reader);
 
     // Read number of transitions
     if (fread(&next_count, sizeof(int), 1, f) != 1) Abort("Invalid input file!\n");
@@ -557,7 +572,7 @@ VOID_TASK_0(run)
     // Read transitions
     if (verbose) printf("Loading transition relations.\n");
     for (int i=0; i<next_count; i++) next[i] = rel_load_proj(f);
-    for (int i=0; i<next_count; i++) rel_load(f, next[i]);
+    for (int i=0; i<next_count; i++) rel_load(f, reader, next[i]);
 
     // Read whether reachable states are stored
     int has_reachable = 0;
@@ -566,7 +581,8 @@ VOID_TASK_0(run)
 
     // Read reachable states
     if (verbose) printf("Loading reachable states.\n");
-    set_t states = set_load(f);
+    set_t states = set_load(f, reader);
+    lddmc_reader_end(reader);
     
     // Read number of action labels
     int action_labels_count = 0;
@@ -780,6 +796,7 @@ main(int argc, char **argv)
     sylvan_init_package();
     sylvan_init_ldd();
     sylvan_init_mtbdd();
+    if (sylvan_set_binary_format(bdd_format) != 0) Abort("Output format not supported, build Sylvan with SYLVAN_ZLIB!\n");
     sylvan_gc_hook_pregc(TASK(gc_start));
     sylvan_gc_hook_postgc(TASK(gc_end));
 
@@ -111,8 +111,8 @@ static int has_actions = 0;
 #define Abort(...) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "Abort at line %d!\n", __LINE__); exit(-1); }
 
 /* Load a set from file */
-#define set_load(f) RUN(set_load, f)
-TASK_1(set_t, set_load, FILE*, f)
+#define set_load(f, reader) RUN(set_load, f, reader)
+TASK_2(set_t, set_load, FILE*, f, lddmc_reader_t, reader)
 {
     set_t set = (set_t)malloc(sizeof(struct set));
 
@@ -120,10 +120,10 @@ TASK_1(set_t, set_load, FILE*, f)
     if (fread(&k, sizeof(int), 1, f) != 1) Abort("Invalid input file!");
     if (k != -1) Abort("Invalid input file!");
 
-    lddmc_serialize_fromfile(f);
+    if (lddmc_reader_readbinary(reader, f) != 0) Abort("Invalid input file!");
     size_t dd;
     if (fread(&dd, sizeof(size_t), 1, f) != 1) Abort("Invalid input file!");
-    set->dd = lddmc_serialize_get_reversed(dd);
+    set->dd = lddmc_reader_get(reader, dd);
     lddmc_protect(&set->dd);
 
     return set;
@@ -184,13 +184,13 @@ TASK_1(rel_t, rel_load_proj, FILE*, f)
     return rel;
 }
 
-#define rel_load(f, rel) RUN(rel_load, f, rel)
-VOID_TASK_2(rel_load, FILE*, f, rel_t, rel)
+#define rel_load(f, reader, rel) RUN(rel_load, f, reader, rel)
+VOID_TASK_3(rel_load, FILE*, f, lddmc_reader_t, reader, rel_t, rel)
 {
-    lddmc_serialize_fromfile(f);
+    if (lddmc_reader_readbinary(reader, f) != 0) Abort("Invalid input file!");
     size_t dd;
     if (fread(&dd, sizeof(size_t), 1, f) != 1) Abort("Invalid input file!");
-    rel->dd = lddmc_serialize_get_reversed(dd);
+    rel->dd = lddmc_reader_get(reader, dd);
 }
 
 /**
@@ -556,7 +556,8 @@ void run()
 
     // Read initial state
     if (verbose) printf("Loading initial state.\n");
-    set_t initial = set_load(f);
+    lddmc_reader_t reader = lddmc_reader_start();
+    set_t initial = set_load(f, reader);
 
     // Read number of transitions
     if (fread(&next_count, sizeof(int), 1, f) != 1) Abort("Invalid input file!\n");
@@ -565,7 +566,7 @@ void run()
     // Read transitions
     if (verbose) printf("Loading transition relations.\n");
     for (int i=0; i<next_count; i++) next[i] = rel_load_proj(f);
-    for (int i=0; i<next_count; i++) rel_load(f, next[i]);
+    for (int i=0; i<next_count; i++) rel_load(f, reader, next[i]);
 
     // Read whether reachable states are stored
     int has_reachable = 0;
@@ -574,7 +575,8 @@ void run()
 
     // Read reachable states
     if (verbose) printf("Loading reachable states.\n");
-    set_t states = set_load(f);
+    set_t states = set_load(f, reader);
+    lddmc_reader_end(reader);
     
     // Read number of action labels
     int action_labels_count = 0;
@@ -19,7 +19,10 @@ static int check_deadlocks = 0; // set to 1 to check for deadlocks on-the-fly
 static int print_transition_matrix = 0; // print transition relation matrix
 static int workers = 0; // autodetect
 static char* model_filename = NULL; // filename of model
+static char* stats_filename = NULL; // filename for the statistics in JSON
+static int stats_sample = 0; // sampling period of the statistics (0 = off)
 static char* out_filename = NULL; // filename of output
+static sylvan_binary_format out_format = SYLVAN_BINARY_RAW; // format of output
 
 static void
 print_usage()
@@ -27,7 +30,9 @@ print_usage()
     printf("Usage: lddmc [-h] [-s <bfs|par|sat|chaining>] [-w <workers>]\n");
     printf("            [--strategy=<bfs|par|sat|chaining>] [--workers=<workers>]\n");
     printf("            [--count-nodes] [--count-states] [--count-table] [--deadlocks]\n");
-    printf("            [--print-matrix] [--help] [--usage] <model> [<output-bdd>]\n");
+    printf("            [--print-matrix] [--format=<raw|packed|zlib>] [--stats-json=<file>]\n");
+    printf("            [--stats-sample=<period>] [--help] [--usage]\n");
+    printf("            <model> [<output-bdd>]\n");
 }
 
 static void
@@ -42,6 +47,11 @@ print_help()
     printf("      --count-table          Report table usage at each level\n");
     printf("      --deadlocks            Check for deadlocks\n");
     printf("      --print-matrix         Print transition matrix\n");
+    printf("      --format=<raw|packed|zlib>\n");
+    printf("                             Format of the output file (default=raw)\n");
+    printf("      --stats-json=<file>    Write the Sylvan statistics to <file> in JSON\n");
+    printf("      --stats-sample=<period>\n");
+    printf("                             Sample the Sylvan statistics (one of every <period> events)\n");
     printf("  -h, --help                 Give this help list\n");
     printf("      --usage                Give a short usage message\n");
 }
@@ -57,6 +67,9 @@ parse_args(int argc, char **argv)
         {.name = "count-states", .val = 1, .has_arg = no_argument},
         {.name = "count-table", .val = 2, .has_arg = no_argument},
         {.name = "print-matrix", .val = 4, .has_arg = no_argument},
+        {.name = "format", .val = 6, .has_arg = required_argument},
+        {.name = "stats-json", .val = 7, .has_arg = required_argument},
+        {.name = "stats-sample", .val = 8, .has_arg = required_argument},
         {.name = "help", .val = 'h', .has_arg = no_argument},
         {.name = "usage", .val = 99, .has_arg = no_argument},
         {},
@@ -93,6 +106,21 @@ parse_args(int argc, char **argv)
             case 5:
                 report_nodes = 1;
                 break;
+            case 6:
+                if (strcmp(optarg, "raw")==0) out_format = SYLVAN_BINARY_RAW;
+                else if (strcmp(optarg, "packed")==0) out_format = SYLVAN_BINARY_PACKED;
+                else if (strcmp(optarg, "zlib")==0) out_format = SYLVAN_BINARY_PACKED_ZLIB;
+                else {
+                    print_usage();
+                    exit(0);
+                }
+                break;
+            case 7:
+                stats_filename = optarg;
+                break;
+            case 8:
+                stats_sample = atoi(optarg);
+                break;
             case 99:
                 print_usage();
                 exit(0);
@@ -122,8 +150,7 @@ typedef struct relation
     MDD dd;
     MDD meta; // for relprod
     int r_k, w_k, *r_proj, *w_proj;
-    int firstvar; // for saturation/chaining
-    MDD topmeta; // for saturation
+    int firstvar; // for chaining
 } *rel_t;
 
 static int vector_size; // size of vector in integers
@@ -149,7 +176,7 @@ static double t_start;
  * Load a set from file
  */
 static set_t
-set_load(FILE* f)
+set_load(FILE* f, lddmc_reader_t reader)
 {
     set_t set = (set_t)malloc(sizeof(struct set));
 
@@ -159,25 +186,26 @@ set_load(FILE* f)
     if (k != -1) Abort("Invalid input file!\n"); // only support full vector
 
     /* read dd */
-    lddmc_serialize_fromfile(f);
+    if (lddmc_reader_readbinary(reader, f) != 0) Abort("Invalid input file!\n");
     size_t dd;
     if (fread(&dd, sizeof(size_t), 1, f) != 1) Abort("Invalid input file!\n");
-    set->dd = lddmc_serialize_get_reversed(dd);
+    set->dd = lddmc_reader_get(reader, dd);
     lddmc_protect(&set->dd);
 
     return set;
 }
 
 /**
- * Save a set to file
+ * Save a set to file, given its identifier from lddmc_writer_writenodes
+ * (all nodes are written in one block before the first set)
  */
 static void
-set_save(FILE* f, set_t set)
+set_save(FILE* f, size_t dd)
 {
     int k = -1;
     fwrite(&k, sizeof(int), 1, f);
-    size_t dd = lddmc_serialize_add(set->dd);
-    lddmc_serialize_tofile(f);
+    size_t empty = 0; // empty block of nodes
+    fwrite(&empty, sizeof(size_t), 1, f);
     fwrite(&dd, sizeof(size_t), 1, f);
 }
 
@@ -234,23 +262,30 @@ TASK_1(rel_t, rel_load_proj, FILE*, f)
 
     rel->meta = lddmc_cube((uint32_t*)meta, j);
     lddmc_protect(&rel->meta);
-    if (rel->firstvar != -1) {
-        rel->topmeta = lddmc_cube((uint32_t*)meta+rel->firstvar, j-rel->firstvar);
-        lddmc_protect(&rel->topmeta);
-    }
     rel->dd = lddmc_false;
     lddmc_protect(&rel->dd);
 
     return rel;
 }
 
-#define rel_load(f, rel) RUN(rel_load, f, rel)
-VOID_TASK_2(rel_load, FILE*, f, rel_t, rel)
+/**
+ * Load the LDDs of all transition relations from file
+ * The identifiers of a relation continue after those of the relations before it, so the
+ * blocks are read one after another, but the nodes of all relations are inserted at once,
+ * level by level in parallel, instead of one (often small) relation at a time.
+ */
+#define rel_load(f, reader, rels, count) RUN(rel_load, f, reader, rels, count)
+VOID_TASK_4(rel_load, FILE*, f, lddmc_reader_t, reader, rel_t*, rels, int, count)
 {
-    lddmc_serialize_fromfile(f);
-    size_t dd;
-    if (fread(&dd, sizeof(size_t), 1, f) != 1) Abort("Invalid input file!");
-    rel->dd = lddmc_serialize_get_reversed(dd);
+    size_t *dds = (size_t*)malloc(sizeof(size_t[count]));
+    lddmc_reader_defer(reader);
+    for (int i=0; i<count; i++) {
+        if (lddmc_reader_readbinary(reader, f) != 0) Abort("Invalid input file!");
+        if (fread(&dds[i], sizeof(size_t), 1, f) != 1) Abort("Invalid input file!");
+    }
+    lddmc_reader_flush(reader);
+    for (int i=0; i<count; i++) rels[i]->dd = lddmc_reader_get(reader, dds[i]);
+    free(dds);
 }
 
 /**
@@ -266,10 +301,10 @@ rel_save_proj(FILE* f, rel_t rel)
 }
 
 static void
-rel_save(FILE* f, rel_t rel)
+rel_save(FILE* f, size_t dd)
 {
-    size_t dd = lddmc_serialize_add(rel->dd);
-    lddmc_serialize_tofile(f);
+    size_t empty = 0; // empty block of nodes
+    fwrite(&empty, sizeof(size_t), 1, f);
     fwrite(&dd, sizeof(size_t), 1, f);
 }
 
@@ -411,11 +446,46 @@ TASK_5(MDD, go_par, MDD, cur, MDD, visited, size_t, from, size_t, len, MDD*, dea
     }
 }
 
+/**
+ * Report a level of the PAR strategy (without deadlock detection)
+ */
+VOID_TASK_5(par_level, size_t, level, MDD, visited, MDD, front, uint64_t, ns, void*, context)
+{
+    INFO("Level %zu done in %.3f sec", level, (double)ns/1000000000);
+    if (report_levels) {
+        printf(", %0.0f states explored", lddmc_satcount_cached(visited));
+    }
+    if (report_table) {
+        size_t filled, total;
+        sylvan_table_usage(&filled, &total);
+        printf(", table: %0.1f%% full (%zu nodes)", 100.0*(double)filled/total, filled);
+    }
+    char buf[32];
+    to_h(getCurrentRSS(), buf);
+    printf(", rss=%s.\n", buf);
+    (void)front;
+    (void)context;
+}
+
 /**
  * Implementation of the PAR strategy
  */
 VOID_TASK_1(par, set_t, set)
 {
+    if (!check_deadlocks) {
+        // without deadlock detection, use the pipelined reachability of Sylvan
+        MDD *relations = (MDD*)malloc(sizeof(MDD) * next_count);
+        MDD *metas = (MDD*)malloc(sizeof(MDD) * next_count);
+        for (int i=0; i<next_count; i++) {
+            relations[i] = next[i]->dd;
+            metas[i] = next[i]->meta;
+        }
+        set->dd = lddmc_reachable(set->dd, relations, metas, next_count, TASK(par_level), NULL);
+        free(relations);
+        free(metas);
+        return;
+    }
+
     /* Prepare variables */
     MDD visited = set->dd;
     MDD front = visited;
@@ -576,74 +646,20 @@ VOID_TASK_1(bfs, set_t, set)
     lddmc_refs_popptr(2);
 }
 
-/**
- * Implementation of (parallel) saturation
- * (assumes relations are ordered on first variable)
- */
-TASK_3(MDD, go_sat, MDD, set, int, idx, int, depth)
-{
-    /* Terminal cases */
-    if (set == lddmc_false) return lddmc_false;
-    if (idx == next_count) return set;
-
-    /* Consult the cache */
-    MDD result;
-    const MDD _set = set;
-    if (cache_get3(201LL<<40, _set, idx, 0, &result)) return result;
-    lddmc_refs_pushptr(&_set);
-
-    /**
-     * Possible improvement: cache more things (like intermediate results?)
-     *   and chain-apply more of the current level before going deeper?
-     */
-
-    /* Check if the relation should be applied */
-    const int var = next[idx]->firstvar;
-    assert(depth <= var);
-    if (depth == var) {
-        /* Count the number of relations starting here */
-        int n = 1;
-        while ((idx + n) < next_count && var == next[idx + n]->firstvar) n++;
-        /*
-         * Compute until fixpoint:
-         * - SAT deeper
-         * - chain-apply all current level once
-         */
-        MDD prev = lddmc_false;
-        lddmc_refs_pushptr(&set);
-        lddmc_refs_pushptr(&prev);
-        while (prev != set) {
-            prev = set;
-            // SAT deeper
-            set = CALL(go_sat, set, idx + n, depth);
-            // chain-apply all current level once
-            for (int i=0; i<n; i++) {
-                set = lddmc_relprod_union(set, next[idx+i]->dd, next[idx+i]->topmeta, set);
-            }
-        }
-        lddmc_refs_popptr(2);
-        result = set;
-    } else {
-        /* Recursive computation */
-        lddmc_refs_spawn(SPAWN(go_sat, lddmc_getright(set), idx, depth));
-        MDD down = lddmc_refs_push(CALL(go_sat, lddmc_getdown(set), idx, depth+1));
-        MDD right = lddmc_refs_sync(SYNC(go_sat));
-        lddmc_refs_pop(1);
-        result = lddmc_makenode(lddmc_getvalue(set), down, right);
-    }
-
-    /* Store in cache */
-    cache_put3(201LL<<40, _set, idx, 0, result);
-    lddmc_refs_popptr(1);
-    return result;
-}
-
 /**
  * Wrapper for the Saturation strategy
  */
 VOID_TASK_1(sat, set_t, set)
 {
-    set->dd = CALL(go_sat, set->dd, 0, 0);
+    MDD *relations = (MDD*)malloc(sizeof(MDD) * next_count);
+    MDD *metas = (MDD*)malloc(sizeof(MDD) * next_count);
+    for (int i=0; i<next_count; i++) {
+        relations[i] = next[i]->dd;
+        metas[i] = next[i]->meta;
+    }
+    set->dd = lddmc_saturate(set->dd, relations, metas, next_count);
+    free(relations);
+    free(metas);
 }
 
 /**
@@ -721,6 +737,7 @@ TASK_0(int, run)
      * Read the model from file
      */
 
+    double t_read = wctime();
     FILE *f = fopen(model_filename, "rb");
     if (f == NULL) {
         Abort("Cannot open file '%s'!\n", model_filename);
@@ -731,7 +748,8 @@ TASK_0(int, run)
     if (fread(&vector_size, sizeof(int), 1, f) != 1) Abort("Invalid input file!\n");
 
     /* Read initial state */
-    set_t initial = set_load(f);
+    lddmc_reader_t reader = lddmc_reader_start();
+    set_t initial = set_load(f, reader);
 
     /* Read number of transition relations */
     if (fread(&next_count, sizeof(int), 1, f) != 1) Abort("Invalid input file!\n");
@@ -739,7 +757,9 @@ TASK_0(int, run)
 
     /* Read transition relations */
     for (int i=0; i<next_count; i++) next[i] = rel_load_proj(f);
-    for (int i=0; i<next_count; i++) rel_load(f, next[i]);
+    rel_load(f, reader, next, next_count);
+    lddmc_reader_end(reader);
+    long bytes_read = ftell(f);
 
     /* We ignore the reachable states and action labels that are stored after the relations */
 
@@ -766,7 +786,11 @@ TASK_0(int, run)
         }
     }
 
-    INFO("Read file '%s'\n", model_filename);
+    {
+        double t = wctime()-t_read;
+        char buf[32], buf2[32];
+        INFO("Read file '%s' in %.3f sec (%s, %s/sec)\n", model_filename, t, to_h(bytes_read, buf), to_h(t > 0 ? bytes_read/t : 0, buf2));
+    }
     INFO("%d integers per state, %d transition groups\n", vector_size, next_count);
 
     if (print_transition_matrix) {
@@ -811,31 +835,42 @@ TASK_0(int, run)
 
     if (out_filename != NULL) {
         INFO("Writing to %s.\n", out_filename);
+        double t_write = wctime();
 
         // Create LDD file
         FILE *f = fopen(out_filename, "w");
-        lddmc_serialize_reset();
+        if (f == NULL) Abort("Cannot open file '%s'!\n", out_filename);
 
         // Write domain...
         fwrite(&vector_size, sizeof(int), 1, f);
 
-        // Write initial state...
-        set_save(f, initial);
+        // Write initial state, preceded by the nodes of all LDDs
+        MDD *dds = (MDD*)malloc(sizeof(MDD) * (next_count + 2));
+        dds[0] = initial->dd;
+        for (int i=0; i<next_count; i++) dds[i+1] = next[i]->dd;
+        dds[next_count+1] = states->dd;
+        int k = -1;
+        fwrite(&k, sizeof(int), 1, f);
+        lddmc_writer_writenodes(f, dds, next_count + 2);
+        fwrite(&dds[0], sizeof(size_t), 1, f);
 
         // Write number of transitions
         fwrite(&next_count, sizeof(int), 1, f);
 
         // Write transitions
         for (int i=0; i<next_count; i++) rel_save_proj(f, next[i]);
-        for (int i=0; i<next_count; i++) rel_save(f, next[i]);
+        for (int i=0; i<next_count; i++) rel_save(f, dds[i+1]);
 
         // Write reachable states
         int has_reachable = 1;
         fwrite(&has_reachable, sizeof(int), 1, f);
-        set_save(f, states);
+        set_save(f, dds[next_count+1]);
+        free(dds);
 
         // Write action labels
+        long size = ftell(f);
         fclose(f);
+        INFO("Wrote %ld bytes in %.3f sec\n", size, wctime()-t_write);
     }
 
     return 0;
@@ -879,6 +914,8 @@ main(int argc, char **argv)
     sylvan_set_limits(max, 1, 16);
     sylvan_init_package();
     sylvan_init_ldd();
+    if (stats_sample > 0) sylvan_stats_set_sampling(stats_sample);
+    if (sylvan_set_binary_format(out_format) != 0) Abort("Output format not supported, build Sylvan with SYLVAN_ZLIB!\n");
     sylvan_gc_hook_pregc(TASK(gc_start));
     sylvan_gc_hook_postgc(TASK(gc_end));
 
@@ -887,5 +924,12 @@ main(int argc, char **argv)
     print_memory_usage();
     sylvan_stats_report(stdout);
 
+    if (stats_filename != NULL) {
+        FILE *f = fopen(stats_filename, "w");
+        if (f == NULL) Abort("Cannot open file '%s'!\n", stats_filename);
+        sylvan_stats_report_json(f);
+        fclose(f);
+    }
+
     lace_stop();
 }
@@ -0,0 +1,28 @@
+#!/bin/sh
+#
+# Compare the reachability strategies of bddmc and lddmc on the models in models/.
+#
+# Usage: reachbench.sh <build directory> [model...]
+#   e.g. examples/reachbench.sh build models/anderson.4.bdd models/anderson.4.ldd
+# Without models, all models in models/ are used. Every run is limited to $TIMEOUT seconds.
+#
+
+BUILD=${1:?"usage: $0 <build directory> [model...]"}
+shift
+TIMEOUT=${TIMEOUT:-600}
+MODELS=${*:-$(ls "$(dirname "$0")"/../models/*.bdd "$(dirname "$0")"/../models/*.ldd)}
+
+printf "%-24s %12s %12s %12s %12s\n" "model" "bfs" "par" "chaining" "sat"
+for model in $MODELS; do
+    case "$model" in
+        *.bdd) tool="$BUILD/examples/bddmc" ;;
+        *.ldd) tool="$BUILD/examples/lddmc" ;;
+        *) continue ;;
+    esac
+    printf "%-24s" "$(basename "$model")"
+    for strategy in bfs par chaining sat; do
+        t=$(timeout "$TIMEOUT" "$tool" -s $strategy "$model" 2>/dev/null | sed -n 's/.* Time: \(.*\)$/\1/p')
+        printf " %12s" "${t:-timeout}"
+    done
+    printf "\n"
+done
@@ -55,11 +55,15 @@ namespace sylvan {
 
 #include <sylvan_common.h>
 #include <sylvan_stats.h>
+#include <sylvan_trace.h>
 #include <sylvan_mt.h>
 #include <sylvan_mtbdd.h>
 #include <sylvan_bdd.h>
+#include <sylvan_partrel.h>
 #include <sylvan_ldd.h>
 #include <sylvan_zdd.h>
+#include <sylvan_dump.h>
+#include <sylvan_profile.h>
 
 #ifdef __cplusplus
 }
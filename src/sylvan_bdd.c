@@ -17,6 +17,7 @@
 
 #include <sylvan_int.h>
 
+#include <errno.h>
 #include <inttypes.h>
 #include <math.h>
 #include <string.h>
@@ -932,6 +933,451 @@ TASK_IMPL_3(MTBDD, sylvan_and_project, MTBDD, a, MTBDD, b, MTBDD, v)
 }
 
 
+/**
+ * N-ary conjunction, disjunction and and-exists.
+ *
+ * The recursion handles at most BDD_NARY_MAX operands at once, so that the
+ * (sorted) operands fit in a single cache_get6 key. With more operands, the
+ * operands are first split into BDD_NARY_MAX groups that are conjoined in parallel.
+ */
+#define BDD_NARY_MAX 6
+
+/**
+ * Bring <ops> in canonical order, remove duplicates and sylvan_true.
+ * Returns the new number of operands, or -1 if the conjunction is sylvan_false.
+ */
+static int
+bdd_nary_normalize(BDD *ops, int n)
+{
+    // insertion sort on the node index, so complementary operands are adjacent
+    for (int i=1; i<n; i++) {
+        BDD x = ops[i];
+        int j = i;
+        while (j > 0 && (BDD_STRIPMARK(ops[j-1]) > BDD_STRIPMARK(x) ||
+                         (BDD_STRIPMARK(ops[j-1]) == BDD_STRIPMARK(x) && ops[j-1] > x))) {
+            ops[j] = ops[j-1];
+            j--;
+        }
+        ops[j] = x;
+    }
+    int k = 0;
+    for (int i=0; i<n; i++) {
+        if (ops[i] == sylvan_false) return -1;
+        if (ops[i] == sylvan_true) continue;
+        if (k > 0 && ops[k-1] == ops[i]) continue;
+        if (k > 0 && ops[k-1] == sylvan_not(ops[i])) return -1;
+        ops[k++] = ops[i];
+    }
+    return k;
+}
+
+TASK_2(BDD, sylvan_and_n_rec, const BDD*, ops, int, n)
+{
+    BDD f[BDD_NARY_MAX];
+    memcpy(f, ops, sizeof(BDD[n]));
+
+    /* Terminal cases */
+    n = bdd_nary_normalize(f, n);
+    if (n < 0) return sylvan_false;
+    if (n == 0) return sylvan_true;
+    if (n == 1) return f[0];
+    if (n == 2) return CALL(sylvan_and, f[0], f[1], 0);
+
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(BDD_AND_N);
+
+    /* Unused slots are 0 (sylvan_false), which never occurs in a normalized operand list */
+    for (int i=n; i<BDD_NARY_MAX; i++) f[i] = 0;
+
+    BDD result;
+    uint64_t unused;
+    if (cache_get6(CACHE_BDD_AND_N | f[0], f[1], f[2], f[3], f[4], f[5], &result, &unused)) {
+        sylvan_stats_count(BDD_AND_N_CACHED);
+        return result;
+    }
+
+    /* Get top variable */
+    BDDVAR level = 0xffffffff;
+    for (int i=0; i<n; i++) {
+        BDDVAR v = bddnode_getvariable(MTBDD_GETNODE(f[i]));
+        if (v < level) level = v;
+    }
+
+    /* Get cofactors, and check early whether a cofactor is sylvan_false */
+    BDD low_ops[BDD_NARY_MAX], high_ops[BDD_NARY_MAX];
+    int low_false = 0, high_false = 0;
+    for (int i=0; i<n; i++) {
+        bddnode_t nf = MTBDD_GETNODE(f[i]);
+        if (bddnode_getvariable(nf) == level) {
+            low_ops[i] = node_low(f[i], nf);
+            high_ops[i] = node_high(f[i], nf);
+        } else {
+            low_ops[i] = high_ops[i] = f[i];
+        }
+        if (low_ops[i] == sylvan_false) low_false = 1;
+        if (high_ops[i] == sylvan_false) high_false = 1;
+    }
+
+    /* Recursive computation */
+    BDD low = sylvan_false, high = sylvan_false;
+    if (!high_false) bdd_refs_spawn(SPAWN(sylvan_and_n_rec, high_ops, n));
+    if (!low_false) low = CALL(sylvan_and_n_rec, low_ops, n);
+    if (!high_false) {
+        bdd_refs_push(low);
+        high = bdd_refs_sync(SYNC(sylvan_and_n_rec));
+        bdd_refs_pop(1);
+    }
+
+    result = sylvan_makenode(level, low, high);
+
+    if (cache_put6(CACHE_BDD_AND_N | f[0], f[1], f[2], f[3], f[4], f[5], result, 0)) {
+        sylvan_stats_count(BDD_AND_N_CACHEDPUT);
+    }
+
+    return result;
+}
+
+TASK_IMPL_2(BDD, sylvan_and_n, const BDD*, bdds, size_t, n)
+{
+    for (size_t i=0; i<n; i++) {
+        if (bdds[i] == sylvan_false) return sylvan_false;
+    }
+
+    if (n <= BDD_NARY_MAX) return CALL(sylvan_and_n_rec, bdds, (int)n);
+
+    /* Conjoin BDD_NARY_MAX groups in parallel, then combine the results */
+    BDD res[BDD_NARY_MAX];
+    const size_t per = (n + BDD_NARY_MAX - 1) / BDD_NARY_MAX;
+    int groups = 0;
+    for (size_t i=0; i<n; i+=per, groups++) {
+        bdd_refs_spawn(SPAWN(sylvan_and_n, bdds + i, n - i < per ? n - i : per));
+    }
+    for (int g=groups-1; g>=0; g--) {
+        res[g] = bdd_refs_push(bdd_refs_sync(SYNC(sylvan_and_n)));
+    }
+    BDD result = CALL(sylvan_and_n_rec, res, groups);
+    bdd_refs_pop(groups);
+    return result;
+}
+
+#define BDD_OR_N_STACK 64
+
+TASK_IMPL_2(BDD, sylvan_or_n, const BDD*, bdds, size_t, n)
+{
+    // negate the operands in a stack array, or on the heap if there are many
+    BDD stack[BDD_OR_N_STACK];
+    BDD *negated = stack;
+    if (n > BDD_OR_N_STACK) {
+        negated = (BDD*)malloc(sizeof(BDD) * n);
+        if (negated == NULL) {
+            fprintf(stderr, "sylvan_or_n: Unable to allocate memory: %s!\n", strerror(errno));
+            exit(1);
+        }
+    }
+    for (size_t i=0; i<n; i++) negated[i] = sylvan_not(bdds[i]);
+    BDD result = sylvan_not(CALL(sylvan_and_n, negated, n));
+    if (negated != stack) free(negated);
+    return result;
+}
+
+TASK_3(BDD, sylvan_and_exists_n_rec, const BDD*, ops, int, n, BDDSET, v)
+{
+    BDD f[BDD_NARY_MAX];
+    memcpy(f, ops, sizeof(BDD[n]));
+
+    /* Terminal cases */
+    n = bdd_nary_normalize(f, n);
+    if (n < 0) return sylvan_false;
+    if (n == 0) return sylvan_true;
+    if (sylvan_set_isempty(v)) return CALL(sylvan_and_n_rec, f, n);
+    if (n == 1) return CALL(sylvan_exists, f[0], v, 0);
+    if (n == 2) return CALL(sylvan_and_exists, f[0], f[1], v, 0);
+
+    /* Get top variable */
+    BDDVAR level = 0xffffffff;
+    for (int i=0; i<n; i++) {
+        BDDVAR var = bddnode_getvariable(MTBDD_GETNODE(f[i]));
+        if (var < level) level = var;
+    }
+
+    /* Skip levels in v that are not in any operand */
+    bddnode_t nv = MTBDD_GETNODE(v);
+    BDDVAR vv = bddnode_getvariable(nv);
+    while (vv < level) {
+        v = node_high(v, nv);
+        if (sylvan_set_isempty(v)) return CALL(sylvan_and_n_rec, f, n);
+        nv = MTBDD_GETNODE(v);
+        vv = bddnode_getvariable(nv);
+    }
+
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(BDD_AND_EXISTS_N);
+
+    /* The cache key holds <v> and at most BDD_NARY_MAX-1 operands */
+    BDD result;
+    uint64_t unused;
+    for (int i=n; i<BDD_NARY_MAX; i++) f[i] = 0;
+    if (cache_get6(CACHE_BDD_AND_EXISTS_N | v, f[0], f[1], f[2], f[3], f[4], &result, &unused)) {
+        sylvan_stats_count(BDD_AND_EXISTS_N_CACHED);
+        return result;
+    }
+
+    /* Get cofactors, and check early whether a cofactor is sylvan_false */
+    BDD low_ops[BDD_NARY_MAX], high_ops[BDD_NARY_MAX];
+    int low_false = 0, high_false = 0;
+    for (int i=0; i<n; i++) {
+        bddnode_t nf = MTBDD_GETNODE(f[i]);
+        if (bddnode_getvariable(nf) == level) {
+            low_ops[i] = node_low(f[i], nf);
+            high_ops[i] = node_high(f[i], nf);
+        } else {
+            low_ops[i] = high_ops[i] = f[i];
+        }
+        if (low_ops[i] == sylvan_false) low_false = 1;
+        if (high_ops[i] == sylvan_false) high_false = 1;
+    }
+
+    if (level == vv) {
+        // level is in variable set, perform abstraction
+        BDD _v = node_high(v, nv);
+        BDD low = low_false ? sylvan_false : CALL(sylvan_and_exists_n_rec, low_ops, n, _v);
+        if (low == sylvan_true || high_false) {
+            result = low;
+        } else {
+            bdd_refs_push(low);
+            BDD high = CALL(sylvan_and_exists_n_rec, high_ops, n, _v);
+            if (high == sylvan_true || low == sylvan_false) {
+                result = high;
+                bdd_refs_pop(1);
+            } else if (high == sylvan_false) {
+                result = low;
+                bdd_refs_pop(1);
+            } else {
+                bdd_refs_push(high);
+                result = sylvan_or(low, high);
+                bdd_refs_pop(2);
+            }
+        }
+    } else {
+        // level is not in variable set
+        BDD low = sylvan_false, high = sylvan_false;
+        if (!high_false) bdd_refs_spawn(SPAWN(sylvan_and_exists_n_rec, high_ops, n, v));
+        if (!low_false) low = CALL(sylvan_and_exists_n_rec, low_ops, n, v);
+        if (!high_false) {
+            bdd_refs_push(low);
+            high = bdd_refs_sync(SYNC(sylvan_and_exists_n_rec));
+            bdd_refs_pop(1);
+        }
+        result = sylvan_makenode(level, low, high);
+    }
+
+    if (cache_put6(CACHE_BDD_AND_EXISTS_N | v, f[0], f[1], f[2], f[3], f[4], result, 0)) {
+        sylvan_stats_count(BDD_AND_EXISTS_N_CACHEDPUT);
+    }
+
+    return result;
+}
+
+TASK_IMPL_3(BDD, sylvan_and_exists_n, const BDD*, bdds, size_t, n, BDDSET, vars)
+{
+    for (size_t i=0; i<n; i++) {
+        if (bdds[i] == sylvan_false) return sylvan_false;
+    }
+
+    if (n < BDD_NARY_MAX) return CALL(sylvan_and_exists_n_rec, bdds, (int)n, vars);
+
+    /* Conjoin BDD_NARY_MAX-1 groups in parallel, then quantify over the results */
+    BDD res[BDD_NARY_MAX-1];
+    const size_t per = (n + BDD_NARY_MAX - 2) / (BDD_NARY_MAX - 1);
+    int groups = 0;
+    for (size_t i=0; i<n; i+=per, groups++) {
+        bdd_refs_spawn(SPAWN(sylvan_and_n, bdds + i, n - i < per ? n - i : per));
+    }
+    for (int g=groups-1; g>=0; g--) {
+        res[g] = bdd_refs_push(bdd_refs_sync(SYNC(sylvan_and_n)));
+    }
+    BDD result = CALL(sylvan_and_exists_n_rec, res, groups, vars);
+    bdd_refs_pop(groups);
+    return result;
+}
+
+/**
+ * Implication and equivalence checks that return a boolean, without building a BDD.
+ *
+ * The recursive tasks return 1 if the check holds, 0 if it does not hold, and -1 if
+ * they were aborted. As soon as a task finds a counterexample, it sets <shortcircuit>,
+ * so that all other tasks of the same check (including stolen tasks) return -1. A
+ * counterexample dominates aborted tasks, so the check as a whole returns 0 or 1.
+ * Aborted results are not stored in the operation cache.
+ */
+
+/**
+ * The terminal cases of a -> b: 1 or 0, or -2 if the check needs to recurse.
+ */
+static inline int
+bdd_leq_terminal(BDD a, BDD b)
+{
+    if (a == b || a == sylvan_false || b == sylvan_true) return 1;
+    if (a == sylvan_true || b == sylvan_false || a == sylvan_not(b)) return 0;
+    return -2;
+}
+
+TASK_3(int, sylvan_leq_rec, BDD, a, BDD, b, int*, shortcircuit)
+{
+    /* Check short circuit */
+    if (*shortcircuit) return -1;
+
+    /* Terminal cases */
+    int result = bdd_leq_terminal(a, b);
+    if (result != -2) return result;
+
+    /* a -> b equals !b -> !a, use the pair with the lowest node first for caching */
+    if (BDD_STRIPMARK(a) > BDD_STRIPMARK(b)) {
+        BDD t = a;
+        a = sylvan_not(b);
+        b = sylvan_not(t);
+    }
+
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(BDD_LEQ);
+
+    uint64_t cached;
+    if (cache_get3(CACHE_BDD_LEQ, a, b, 0, &cached)) {
+        sylvan_stats_count(BDD_LEQ_CACHED);
+        return (int)cached;
+    }
+
+    bddnode_t na = MTBDD_GETNODE(a);
+    bddnode_t nb = MTBDD_GETNODE(b);
+    BDDVAR va = bddnode_getvariable(na);
+    BDDVAR vb = bddnode_getvariable(nb);
+    BDDVAR level = va < vb ? va : vb;
+
+    BDD aLow = va == level ? node_low(a, na) : a;
+    BDD aHigh = va == level ? node_high(a, na) : a;
+    BDD bLow = vb == level ? node_low(b, nb) : b;
+    BDD bHigh = vb == level ? node_high(b, nb) : b;
+
+    /* Check the terminal cases of both cofactors before spawning */
+    int low = bdd_leq_terminal(aLow, bLow);
+    int high = bdd_leq_terminal(aHigh, bHigh);
+    if (low == 0 || high == 0) {
+        result = 0;
+    } else if (low == 1 && high == 1) {
+        result = 1;
+    } else if (low == 1) {
+        result = CALL(sylvan_leq_rec, aHigh, bHigh, shortcircuit);
+    } else if (high == 1) {
+        result = CALL(sylvan_leq_rec, aLow, bLow, shortcircuit);
+    } else {
+        SPAWN(sylvan_leq_rec, aHigh, bHigh, shortcircuit);
+        low = CALL(sylvan_leq_rec, aLow, bLow, shortcircuit);
+        if (low == 0) *shortcircuit = 1;
+        high = SYNC(sylvan_leq_rec);
+        result = (low == 0 || high == 0) ? 0 : (low == 1 && high == 1) ? 1 : -1;
+    }
+
+    if (result == 0) *shortcircuit = 1;
+    if (result == -1) return -1;
+
+    if (cache_put3(CACHE_BDD_LEQ, a, b, 0, result)) {
+        sylvan_stats_count(BDD_LEQ_CACHEDPUT);
+    }
+
+    return result;
+}
+
+TASK_IMPL_2(int, sylvan_leq, BDD, a, BDD, b)
+{
+    int shortcircuit = 0;
+    return CALL(sylvan_leq_rec, a, b, &shortcircuit) == 1;
+}
+
+TASK_IMPL_2(int, sylvan_disjoint, BDD, a, BDD, b)
+{
+    /* a and b are disjoint iff a -> !b */
+    int shortcircuit = 0;
+    return CALL(sylvan_leq_rec, a, sylvan_not(b), &shortcircuit) == 1;
+}
+
+TASK_4(int, sylvan_equiv_under_rec, BDD, a, BDD, b, BDD, care, int*, shortcircuit)
+{
+    /* Check short circuit */
+    if (*shortcircuit) return -1;
+
+    /* Terminal cases */
+    if (care == sylvan_false || a == b) return 1;
+    if (care == sylvan_true || a == sylvan_not(b)) return 0;
+
+    /* Normalize: a <-> b equals b <-> a and !a <-> !b */
+    if (BDD_STRIPMARK(a) > BDD_STRIPMARK(b)) {
+        BDD t = a;
+        a = b;
+        b = t;
+    }
+    if (BDD_HASMARK(a)) {
+        a = sylvan_not(a);
+        b = sylvan_not(b);
+    }
+
+    /* With a constant, this is an implication: false <-> b under care iff care -> !b */
+    if (a == sylvan_false) return CALL(sylvan_leq_rec, care, sylvan_not(b), shortcircuit);
+
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(BDD_EQUIV_UNDER);
+
+    uint64_t cached;
+    if (cache_get3(CACHE_BDD_EQUIV_UNDER, a, b, care, &cached)) {
+        sylvan_stats_count(BDD_EQUIV_UNDER_CACHED);
+        return (int)cached;
+    }
+
+    bddnode_t na = MTBDD_GETNODE(a);
+    bddnode_t nb = MTBDD_GETNODE(b);
+    bddnode_t nc = MTBDD_GETNODE(care);
+    BDDVAR va = bddnode_getvariable(na);
+    BDDVAR vb = bddnode_getvariable(nb);
+    BDDVAR vc = bddnode_getvariable(nc);
+    BDDVAR level = va < vb ? va : vb;
+    if (vc < level) level = vc;
+
+    BDD aLow = va == level ? node_low(a, na) : a;
+    BDD aHigh = va == level ? node_high(a, na) : a;
+    BDD bLow = vb == level ? node_low(b, nb) : b;
+    BDD bHigh = vb == level ? node_high(b, nb) : b;
+    BDD cLow = vc == level ? node_low(care, nc) : care;
+    BDD cHigh = vc == level ? node_high(care, nc) : care;
+
+    SPAWN(sylvan_equiv_under_rec, aHigh, bHigh, cHigh, shortcircuit);
+    int low = CALL(sylvan_equiv_under_rec, aLow, bLow, cLow, shortcircuit);
+    if (low == 0) *shortcircuit = 1;
+    int high = SYNC(sylvan_equiv_under_rec);
+    int result = (low == 0 || high == 0) ? 0 : (low == 1 && high == 1) ? 1 : -1;
+
+    if (result == 0) *shortcircuit = 1;
+    if (result == -1) return -1;
+
+    if (cache_put3(CACHE_BDD_EQUIV_UNDER, a, b, care, result)) {
+        sylvan_stats_count(BDD_EQUIV_UNDER_CACHEDPUT);
+    }
+
+    return result;
+}
+
+TASK_IMPL_3(int, sylvan_equiv_under, BDD, a, BDD, b, BDD, care)
+{
+    int shortcircuit = 0;
+    return CALL(sylvan_equiv_under_rec, a, b, care, &shortcircuit) == 1;
+}
+
 TASK_IMPL_4(BDD, sylvan_relnext, BDD, a, BDD, b, BDDSET, vars, BDDVAR, prev_level)
 {
     /* Compute R(s) = \exists x: A(x) \and B(x,s) with support(result) = s, support(A) = s, support(B) = s+t
@@ -1508,6 +1954,112 @@ TASK_IMPL_2(BDD, sylvan_closure, BDD, a, BDDVAR, prev_level)
 }
 
 
+/**
+ * Saturation: the relations sorted on the top variable of their cube.
+ * Every call to sylvan_saturate gets a unique id, which is part of the cache key.
+ */
+typedef struct bdd_saturate_ctx
+{
+    BDD *relations;
+    BDDSET *vars;
+    BDDVAR *top;
+    size_t count;
+    uint64_t id;
+} *bdd_saturate_ctx_t;
+
+static _Atomic(uint64_t) bdd_saturate_next_id = 0;
+
+TASK_3(BDD, sylvan_saturate_rec, BDD, set, size_t, idx, bdd_saturate_ctx_t, ctx)
+{
+    /* Terminal cases */
+    if (set == sylvan_false) return sylvan_false;
+    if (idx == ctx->count) return set;
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(BDD_SATURATE);
+
+    /* Consult cache */
+    BDD result;
+    const BDD _set = set;
+    if (cache_get3(CACHE_BDD_SATURATE, _set, idx, ctx->id, &result)) {
+        sylvan_stats_count(BDD_SATURATE_CACHED);
+        return result;
+    }
+    bdd_refs_pushptr(&_set);
+
+    const BDDVAR var = ctx->top[idx];
+    if (set == sylvan_true || var <= sylvan_var(set)) {
+        /* Find the relations of this level */
+        size_t next = idx+1;
+        while (next < ctx->count && ctx->top[next] == var) next++;
+
+        /* Until fixpoint: saturate the lower levels, then chain-apply this level once */
+        BDD prev = sylvan_false;
+        BDD step = sylvan_false;
+        bdd_refs_pushptr(&set);
+        bdd_refs_pushptr(&prev);
+        bdd_refs_pushptr(&step);
+        while (prev != set) {
+            prev = set;
+            set = CALL(sylvan_saturate_rec, set, next, ctx);
+            for (size_t i=idx; i<next; i++) {
+                step = CALL(sylvan_relnext, set, ctx->relations[i], ctx->vars[i], 0);
+                set = sylvan_not(CALL(sylvan_and, sylvan_not(set), sylvan_not(step), 0));
+                step = sylvan_false;
+            }
+        }
+        bdd_refs_popptr(3);
+        result = set;
+    } else {
+        /* Recursive computation */
+        bdd_refs_spawn(SPAWN(sylvan_saturate_rec, sylvan_low(set), idx, ctx));
+        BDD high = bdd_refs_push(CALL(sylvan_saturate_rec, sylvan_high(set), idx, ctx));
+        BDD low = bdd_refs_sync(SYNC(sylvan_saturate_rec));
+        bdd_refs_pop(1);
+        result = sylvan_makenode(sylvan_var(set), low, high);
+    }
+
+    /* Store in cache */
+    if (cache_put3(CACHE_BDD_SATURATE, _set, idx, ctx->id, result)) sylvan_stats_count(BDD_SATURATE_CACHEDPUT);
+    bdd_refs_popptr(1);
+    return result;
+}
+
+TASK_IMPL_4(BDD, sylvan_saturate, BDD, states, const BDD*, relations, const BDDSET*, vars, size_t, count)
+{
+    struct bdd_saturate_ctx ctx;
+    ctx.relations = (BDD*)malloc(sizeof(BDD) * (count > 0 ? count : 1));
+    ctx.vars = (BDDSET*)malloc(sizeof(BDDSET) * (count > 0 ? count : 1));
+    ctx.top = (BDDVAR*)malloc(sizeof(BDDVAR) * (count > 0 ? count : 1));
+    ctx.count = count;
+    ctx.id = atomic_fetch_add(&bdd_saturate_next_id, 1);
+
+    /* Sort the relations on their top variable (stable insertion sort) */
+    for (size_t i=0; i<count; i++) {
+        BDDVAR top = sylvan_set_isempty(vars[i]) ? (BDDVAR)-1 : sylvan_set_first(vars[i]);
+        size_t j = i;
+        while (j > 0 && ctx.top[j-1] > top) {
+            ctx.relations[j] = ctx.relations[j-1];
+            ctx.vars[j] = ctx.vars[j-1];
+            ctx.top[j] = ctx.top[j-1];
+            j--;
+        }
+        ctx.relations[j] = relations[i];
+        ctx.vars[j] = vars[i];
+        ctx.top[j] = top;
+    }
+
+    BDD result = CALL(sylvan_saturate_rec, states, 0, &ctx);
+
+    free(ctx.relations);
+    free(ctx.vars);
+    free(ctx.top);
+    return result;
+}
+
 /**
  * Function composition
  */
@@ -110,6 +110,35 @@ TASK_DECL_4(BDD, sylvan_and_exists, BDD, BDD, BDDSET, BDDVAR);
 TASK_DECL_3(BDD, sylvan_and_project, BDD, BDD, BDDSET);
 #define sylvan_and_project(a,b,vars) RUN(sylvan_and_project,a,b,vars)
 
+/**
+ * Compute the conjunction (or disjunction) of the <n> BDDs in <bdds>.
+ * All operands are processed in a single recursion, without intermediate results
+ * for every pair of operands. The array is not modified.
+ */
+TASK_DECL_2(BDD, sylvan_and_n, const BDD*, size_t);
+#define sylvan_and_n(bdds, n) RUN(sylvan_and_n, bdds, n)
+TASK_DECL_2(BDD, sylvan_or_n, const BDD*, size_t);
+#define sylvan_or_n(bdds, n) RUN(sylvan_or_n, bdds, n)
+
+/**
+ * Compute \exists <vars>: <bdds>[0] \and ... \and <bdds>[n-1]
+ */
+TASK_DECL_3(BDD, sylvan_and_exists_n, const BDD*, size_t, BDDSET);
+#define sylvan_and_exists_n(bdds, n, vars) RUN(sylvan_and_exists_n, bdds, n, vars)
+
+/**
+ * Check whether a implies b (a <= b), whether a and b are disjoint (a \and b = false),
+ * and whether a and b are equivalent on all assignments where <care> holds.
+ * These checks return 1 or 0 without building a BDD. The recursion stops in all
+ * (parallel) branches as soon as a counterexample is found.
+ */
+TASK_DECL_2(int, sylvan_leq, BDD, BDD);
+#define sylvan_leq(a, b) RUN(sylvan_leq, a, b)
+TASK_DECL_2(int, sylvan_disjoint, BDD, BDD);
+#define sylvan_disjoint(a, b) RUN(sylvan_disjoint, a, b)
+TASK_DECL_3(int, sylvan_equiv_under, BDD, BDD, BDD);
+#define sylvan_equiv_under(a, b, care) RUN(sylvan_equiv_under, a, b, care)
+
 /**
  * Compute R(s,t) = \exists x: A(s,x) \and B(x,t)
  *      or R(s)   = \exists x: A(s,x) \and B(x)
@@ -139,6 +168,17 @@ TASK_DECL_4(BDD, sylvan_relprev, BDD, BDD, BDDSET, BDDVAR);
 TASK_DECL_4(BDD, sylvan_relnext, BDD, BDD, BDDSET, BDDVAR);
 #define sylvan_relnext(a,b,vars) RUN(sylvan_relnext,a,b,vars,0)
 
+/**
+ * Compute the states reachable from <states> with the partitioned relation <relations>
+ * using (parallel) saturation.
+ * Every relation <relations>[i] is applied as in sylvan_relnext with the cube <vars>[i].
+ * The relations are grouped on the top variable of their cube (event locality) and
+ * saturated bottom-up, i.e., a group is only applied when all lower groups are saturated.
+ * The relations may be given in any order.
+ */
+TASK_DECL_4(BDD, sylvan_saturate, BDD, const BDD*, const BDDSET*, size_t);
+#define sylvan_saturate(states, relations, vars, count) RUN(sylvan_saturate, states, relations, vars, count)
+
 /**
  * Computes the transitive closure by traversing the BDD recursively.
  * See Y. Matsunaga, P. C. McGeer, R. K. Brayton
@@ -100,8 +100,8 @@ cache_hash6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t
     return hash;
 }
 
-int
-cache_get6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f, uint64_t *res1, uint64_t *res2)
+static inline int
+cache_get6_lookup(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f, uint64_t *res1, uint64_t *res2)
 {
     const uint64_t hash = cache_hash6(a, b, c, d, e, f);
 #if CACHE_MASK
@@ -126,6 +126,14 @@ cache_get6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t
     return atomic_load_explicit(s_bucket, memory_order_acquire) == s ? 1 : 0;
 }
 
+int
+cache_get6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f, uint64_t *res1, uint64_t *res2)
+{
+    int result = cache_get6_lookup(a, b, c, d, e, f, res1, res2);
+    sylvan_trace(SYLVAN_TRACE_CACHE, result ? SYLVAN_TRACE_CACHE_HIT : SYLVAN_TRACE_CACHE_MISS, (a >> 40) & 0x7fffff, 0);
+    return result;
+}
+
 int
 cache_put6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f, uint64_t res1, uint64_t res2)
 {
@@ -162,8 +170,8 @@ cache_put6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t
     return 1;
 }
 
-int
-cache_get(uint64_t a, uint64_t b, uint64_t c, uint64_t *res)
+static inline int
+cache_get_lookup(uint64_t a, uint64_t b, uint64_t c, uint64_t *res)
 {
     const uint64_t hash = cache_hash(a, b, c);
 #if CACHE_MASK
@@ -185,6 +193,14 @@ cache_get(uint64_t a, uint64_t b, uint64_t c, uint64_t *res)
     return atomic_load_explicit(s_bucket, memory_order_acquire) == s ? 1 : 0;
 }
 
+int
+cache_get(uint64_t a, uint64_t b, uint64_t c, uint64_t *res)
+{
+    int result = cache_get_lookup(a, b, c, res);
+    sylvan_trace(SYLVAN_TRACE_CACHE, result ? SYLVAN_TRACE_CACHE_HIT : SYLVAN_TRACE_CACHE_MISS, (a >> 40) & 0x7fffff, 0);
+    return result;
+}
+
 int
 cache_put(uint64_t a, uint64_t b, uint64_t c, uint64_t res)
 {
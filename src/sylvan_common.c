@@ -17,6 +17,9 @@
 
 #include <sylvan_int.h>
 
+#include <string.h> // memset
+#include <time.h>
+
 /**
  * Implementation of garbage collection
  */
@@ -44,6 +47,23 @@ sylvan_gc_disable()
     gc_enabled = 0;
 }
 
+/**
+ * Generational garbage collection: the number of minor collections between full collections
+ * (0 if not generational), the number of minor collections since the last full collection,
+ * and the number of old nodes (the live nodes after the previous collection).
+ */
+static unsigned int gc_full_every = 0;
+static unsigned int gc_minor_count = 0;
+static size_t gc_old_count = 0;
+
+void
+sylvan_gc_set_generational(unsigned int full_every)
+{
+    gc_full_every = full_every;
+    // the old nodes are only known after a full collection
+    gc_minor_count = full_every;
+}
+
 /**
  * This variable is used for a cas flag so only one gc runs at one time
  */
@@ -56,6 +76,7 @@ typedef struct gc_hook_entry
 {
     struct gc_hook_entry *next;
     gc_hook_cb cb;
+    const char *name;
 } * gc_hook_entry_t;
 
 static gc_hook_entry_t mark_list;
@@ -83,9 +104,16 @@ sylvan_gc_hook_postgc(gc_hook_cb callback)
 
 void
 sylvan_gc_add_mark(gc_hook_cb callback)
+{
+    sylvan_gc_add_mark_named(callback, NULL);
+}
+
+void
+sylvan_gc_add_mark_named(gc_hook_cb callback, const char *name)
 {
     gc_hook_entry_t e = (gc_hook_entry_t)malloc(sizeof(struct gc_hook_entry));
     e->cb = callback;
+    e->name = name;
     e->next = mark_list;
     mark_list = e;
 }
@@ -96,6 +124,101 @@ sylvan_gc_hook_main(gc_hook_cb callback)
     main_hook = callback;
 }
 
+/**
+ * The GC event log, a ring buffer of the last SYLVAN_GC_LOG_SIZE events.
+ * Every slot owns its array of marking callback information.
+ */
+static sylvan_gc_event_t gc_log[SYLVAN_GC_LOG_SIZE];
+static sylvan_gc_mark_info_t *gc_log_marks[SYLVAN_GC_LOG_SIZE];
+static unsigned int gc_log_marks_size[SYLVAN_GC_LOG_SIZE];
+static size_t gc_log_count = 0;
+static uint64_t gc_log_epoch = 0;
+
+/**
+ * The event of the running garbage collection, or NULL
+ */
+static sylvan_gc_event_t *gc_current = NULL;
+
+/**
+ * Whether the GC event log counts the marked nodes, see sylvan_gc_log_set_counts
+ */
+static int gc_log_counts = 0;
+
+static inline int
+gc_log_counting(void)
+{
+    return SYLVAN_STATS || sylvan_stats_sampling != 0 || gc_log_counts;
+}
+
+static uint64_t
+gc_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+size_t
+sylvan_gc_log_count(void)
+{
+    return gc_log_count;
+}
+
+int
+sylvan_gc_log_get(size_t index, sylvan_gc_event_t *event)
+{
+    if (index >= gc_log_count || index + SYLVAN_GC_LOG_SIZE < gc_log_count) return 0;
+    *event = gc_log[index % SYLVAN_GC_LOG_SIZE];
+    return 1;
+}
+
+void
+sylvan_gc_log_set_counts(int enabled)
+{
+    gc_log_counts = enabled ? 1 : 0;
+}
+
+void
+sylvan_gc_log_clear(void)
+{
+    for (int i=0; i<SYLVAN_GC_LOG_SIZE; i++) {
+        free(gc_log_marks[i]);
+        gc_log_marks[i] = NULL;
+        gc_log_marks_size[i] = 0;
+    }
+    gc_log_count = 0;
+}
+
+const char *
+sylvan_gc_phase_name(sylvan_gc_phase_t phase)
+{
+    static const char *names[SYLVAN_GC_PHASES] = {"pregc", "clear_cache", "mark", "resize", "rehash", "postgc"};
+    return (unsigned)phase < SYLVAN_GC_PHASES ? names[phase] : NULL;
+}
+
+/**
+ * Start a new event in the GC event log
+ */
+static sylvan_gc_event_t *
+gc_log_start(uint64_t start)
+{
+    const size_t slot = gc_log_count % SYLVAN_GC_LOG_SIZE;
+    unsigned int count = 0;
+    for (gc_hook_entry_t e = mark_list; e != NULL; e = e->next) count++;
+    if (count > gc_log_marks_size[slot]) {
+        gc_log_marks[slot] = (sylvan_gc_mark_info_t*)realloc(gc_log_marks[slot], sizeof(sylvan_gc_mark_info_t[count]));
+        gc_log_marks_size[slot] = count;
+    }
+
+    sylvan_gc_event_t *event = &gc_log[slot];
+    memset(event, 0, sizeof(sylvan_gc_event_t));
+    event->index = gc_log_count;
+    event->start = start - gc_log_epoch;
+    event->mark_count = count;
+    event->marks = gc_log_marks[slot];
+    return event;
+}
+
 /**
  * Clear the operation cache.
  */
@@ -111,15 +234,128 @@ VOID_TASK_IMPL_0(sylvan_clear_cache)
  * After marking, the "destroy" hooks are called for all unmarked nodes,
  * for example to free data of custom MTBDD leaves.
  */
-VOID_TASK_IMPL_0(sylvan_clear_and_mark)
+VOID_TASK_0(sylvan_mark_all)
 {
-    llmsset_clear_data(nodes);
+    if (gc_current == NULL) {
+        for (gc_hook_entry_t e = mark_list; e != NULL; e = e->next) {
+            WRAP(e->cb);
+        }
+    } else {
+        // record the time of every callback in the GC event log, and the newly marked nodes
+        // if counting is on (counting the marked nodes scans the entire nodes table)
+        const int counting = gc_log_counting();
+        sylvan_gc_mark_info_t *info = (sylvan_gc_mark_info_t*)gc_current->marks;
+        size_t marked = gc_current->nodes_old;
+        unsigned int i = 0;
+        for (gc_hook_entry_t e = mark_list; e != NULL; e = e->next, i++) {
+            uint64_t t = gc_time();
+            WRAP(e->cb);
+            info[i].time = gc_time() - t;
+            info[i].name = e->name;
+            info[i].nodes = 0;
+            if (counting) {
+                size_t count = llmsset_count_marked(nodes);
+                info[i].nodes = count - marked;
+                marked = count;
+            }
+        }
+        if (counting) gc_current->nodes_live = marked;
+    }
+}
 
-    for (gc_hook_entry_t e = mark_list; e != NULL; e = e->next) {
-        WRAP(e->cb);
+/**
+ * The marking engine. Every marking task starts with a stack of GC_MARK_STACK nodes, which grows
+ * on the heap if needed. After every GC_MARK_SPLIT visited nodes, the task offers half of its
+ * stack if it has no offer that is still waiting to be stolen, so every task has at most one
+ * such offer and one heap buffer per stolen offer.
+ */
+#define GC_MARK_STACK 512
+#define GC_MARK_SPLIT 32
+
+VOID_TASK_4(sylvan_gc_mark_stack, gc_mark_visit_cb, visit, uint64_t*, part, size_t, count, int, owned)
+{
+    uint64_t local[GC_MARK_STACK];
+    uint64_t *stack = local;
+    size_t size = GC_MARK_STACK;
+    memcpy(stack, part, count * sizeof(uint64_t));
+    if (owned) free(part);
+
+    Task *offered = NULL;
+    size_t spawned = 0, sp = count;
+    int visited = 0;
+    while (sp != 0) {
+        uint64_t children[2];
+        int n = visit(stack[--sp], children);
+        if (n == 0) continue;
+
+        if (++visited >= GC_MARK_SPLIT && sp >= 2 && (offered == NULL || TASK_IS_STOLEN(offered))) {
+            // offer the bottom half of the stack to other workers
+            size_t half = sp / 2;
+            uint64_t *offer = (uint64_t*)malloc(half * sizeof(uint64_t));
+            if (offer == NULL) {
+                fprintf(stderr, "sylvan_gc_mark_dd: Unable to allocate memory!\n");
+                exit(1);
+            }
+            memcpy(offer, stack, half * sizeof(uint64_t));
+            memmove(stack, stack + half, (sp - half) * sizeof(uint64_t));
+            sp -= half;
+            offered = SPAWN(sylvan_gc_mark_stack, visit, offer, half, 1);
+            spawned++;
+            visited = 0;
+        }
+
+        if (sp + n > size) {
+            // the previous offer was not stolen yet, keep the nodes in a larger stack
+            uint64_t *grown = (uint64_t*)realloc(stack == local ? NULL : stack, 2 * size * sizeof(uint64_t));
+            if (grown == NULL) {
+                fprintf(stderr, "sylvan_gc_mark_dd: Unable to allocate memory!\n");
+                exit(1);
+            }
+            if (stack == local) memcpy(grown, local, sp * sizeof(uint64_t));
+            stack = grown;
+            size *= 2;
+        }
+
+        for (int i=0; i<n; i++) stack[sp++] = children[i];
     }
 
+    if (stack != local) free(stack);
+    while (spawned--) SYNC(sylvan_gc_mark_stack);
+}
+
+VOID_TASK_IMPL_2(sylvan_gc_mark_dd, gc_mark_visit_cb, visit, uint64_t, dd)
+{
+    // roots that are terminals or already marked do not start a marking task
+    uint64_t children[2];
+    int n = visit(dd, children);
+    if (n != 0) CALL(sylvan_gc_mark_stack, visit, children, n, 0);
+}
+
+VOID_TASK_IMPL_0(sylvan_clear_and_mark)
+{
+    // a minor collection keeps all old nodes, so if they fill half of the table, the collection
+    // is full to also free the old nodes that died
+    const int minor = gc_full_every != 0 && gc_minor_count < gc_full_every &&
+                      gc_old_count * 2 <= llmsset_get_size(nodes);
+    if (minor) {
+        // keep the old nodes marked, only mark the young nodes
+        llmsset_clear_young(nodes);
+    } else {
+        llmsset_clear_data(nodes);
+    }
+    if (gc_current != NULL) {
+        gc_current->minor = minor;
+        gc_current->nodes_old = minor ? gc_old_count : 0;
+    }
+    CALL(sylvan_mark_all);
+
     llmsset_destroy_unmarked(nodes);
+
+    if (gc_full_every != 0) {
+        llmsset_promote(nodes);
+        gc_minor_count = minor ? gc_minor_count + 1 : 0;
+        gc_old_count = llmsset_count_marked(nodes);
+    }
 }
 
 /**
@@ -209,6 +445,11 @@ VOID_TASK_IMPL_0(sylvan_gc_normal_resize)
     }
 }
 
+/**
+ * Size of the nodes table requested by sylvan_gc_reserve, applied after the main hook
+ */
+static _Atomic(size_t) gc_reserve_size = 0;
+
 /**
  * Actual implementation of garbage collection
  */
@@ -217,29 +458,77 @@ VOID_TASK_0(sylvan_gc_go)
     sylvan_stats_count(SYLVAN_GC_COUNT);
     sylvan_timer_start(SYLVAN_GC);
 
+    uint64_t t = gc_time(), start = t;
+    sylvan_gc_event_t *event = gc_log_start(t);
+
     // call pre gc hooks
+    sylvan_timer_start(SYLVAN_GC_HOOKS);
     for (gc_hook_entry_t e = pregc_list; e != NULL; e = e->next) {
         WRAP(e->cb);
     }
+    sylvan_timer_stop(SYLVAN_GC_HOOKS);
+    event->phases[SYLVAN_GC_PHASE_PREGC] = gc_time() - t;
+    sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_PHASE, SYLVAN_GC_PHASE_PREGC, event->phases[SYLVAN_GC_PHASE_PREGC]);
+
+    event->table_before = llmsset_get_size(nodes);
+    event->cache_before = cache_getsize();
+    if (gc_log_counting()) event->nodes_before = llmsset_count_marked(nodes);
 
     /*
      * This simply clears the cache.
      * Alternatively, we could implement for example some strategy
      * where part of the cache is cleared and part is marked
      */
+    t = gc_time();
+    sylvan_timer_start(SYLVAN_GC_CLEAR_CACHE);
     CALL(sylvan_clear_cache);
+    sylvan_timer_stop(SYLVAN_GC_CLEAR_CACHE);
+    event->phases[SYLVAN_GC_PHASE_CLEAR_CACHE] = gc_time() - t;
+    sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_PHASE, SYLVAN_GC_PHASE_CLEAR_CACHE, event->phases[SYLVAN_GC_PHASE_CLEAR_CACHE]);
 
+    t = gc_time();
+    sylvan_timer_start(SYLVAN_GC_MARK);
+    gc_current = event;
     CALL(sylvan_clear_and_mark);
+    gc_current = NULL;
+    sylvan_timer_stop(SYLVAN_GC_MARK);
+    event->phases[SYLVAN_GC_PHASE_MARK] = gc_time() - t;
+    sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_PHASE, SYLVAN_GC_PHASE_MARK, event->phases[SYLVAN_GC_PHASE_MARK]);
 
     // call hooks for resizing and all that
+    t = gc_time();
+    sylvan_timer_start(SYLVAN_GC_RESIZE);
     WRAP(main_hook);
 
+    // grow the table further if requested by sylvan_gc_reserve
+    const size_t reserve = atomic_exchange(&gc_reserve_size, 0);
+    if (reserve > llmsset_get_size(nodes)) llmsset_set_size(nodes, reserve);
+    sylvan_timer_stop(SYLVAN_GC_RESIZE);
+    event->phases[SYLVAN_GC_PHASE_RESIZE] = gc_time() - t;
+    sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_PHASE, SYLVAN_GC_PHASE_RESIZE, event->phases[SYLVAN_GC_PHASE_RESIZE]);
+
+    t = gc_time();
+    sylvan_timer_start(SYLVAN_GC_REHASH);
     CALL(sylvan_rehash_all);
+    sylvan_timer_stop(SYLVAN_GC_REHASH);
+    event->phases[SYLVAN_GC_PHASE_REHASH] = gc_time() - t;
+    sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_PHASE, SYLVAN_GC_PHASE_REHASH, event->phases[SYLVAN_GC_PHASE_REHASH]);
+
+    event->table_after = llmsset_get_size(nodes);
+    event->cache_after = cache_getsize();
+    gc_log_count++;
 
     // call post gc hooks
+    t = gc_time();
+    sylvan_timer_start(SYLVAN_GC_HOOKS);
     for (gc_hook_entry_t e = postgc_list; e != NULL; e = e->next) {
         WRAP(e->cb);
     }
+    sylvan_timer_stop(SYLVAN_GC_HOOKS);
+    event->phases[SYLVAN_GC_PHASE_POSTGC] = gc_time() - t;
+    sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_PHASE, SYLVAN_GC_PHASE_POSTGC, event->phases[SYLVAN_GC_PHASE_POSTGC]);
+    event->pause = gc_time() - start;
+    sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_PHASE, SYLVAN_GC_PHASES, event->pause);
 
     sylvan_timer_stop(SYLVAN_GC);
 }
@@ -252,9 +541,11 @@ VOID_TASK_IMPL_0(sylvan_gc)
     if (gc_enabled) {
         int zero = 0;
         if (atomic_compare_exchange_strong(&gc, &zero, 1)) {
+            sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_REQUEST, 1, 0);
             NEWFRAME(sylvan_gc_go);
             gc = 0;
         } else {
+            sylvan_trace(SYLVAN_TRACE_GC, SYLVAN_TRACE_GC_REQUEST, 0, 0);
             /* wait for new frame to appear */
             while (atomic_load_explicit(&lace_newframe.t, memory_order_relaxed) == 0) {}
             lace_yield(__lace_worker, __lace_dq_head);
@@ -262,6 +553,28 @@ VOID_TASK_IMPL_0(sylvan_gc)
     }
 }
 
+/**
+ * Grow the nodes table for <count> new nodes
+ */
+VOID_TASK_IMPL_1(sylvan_gc_reserve, size_t, count)
+{
+    if (!gc_enabled) return;
+
+    size_t nodes_size = llmsset_get_size(nodes);
+    size_t nodes_max = llmsset_get_max_size(nodes);
+    if (nodes_size >= nodes_max) return;
+
+    size_t needed = 2 * (llmsset_count_marked(nodes) + count);
+    if (needed <= nodes_size) return;
+
+    size_t new_size = nodes_size;
+    while (new_size < needed && new_size < nodes_max) new_size = next_size(new_size);
+    if (new_size > nodes_max) new_size = nodes_max;
+
+    atomic_store(&gc_reserve_size, new_size);
+    CALL(sylvan_gc);
+}
+
 /**
  * The unique table
  */
@@ -375,6 +688,8 @@ sylvan_init_package(void)
 #else
     main_hook = TASK(sylvan_gc_normal_resize);
 #endif
+    sylvan_gc_log_clear();
+    gc_log_epoch = gc_time();
 
     sylvan_stats_init();
 }
@@ -424,6 +739,8 @@ sylvan_quit()
         free(e);
     }
 
+    sylvan_gc_log_clear();
+
     cache_free();
     llmsset_free(nodes);
 }
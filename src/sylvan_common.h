@@ -100,7 +100,8 @@ VOID_TASK_DECL_2(sylvan_table_usage, size_t*, size_t*);
  * 1) All installed pre_gc hooks are called.
  *    See sylvan_gc_hook_pre to add hooks.
  * 2) The operation cache is cleared.
- * 3) The nodes table (data part) is cleared.
+ * 3) The nodes table (data part) is cleared, except the old nodes of a minor garbage
+ *    collection (see sylvan_gc_set_generational).
  * 4) All nodes are marked (to be rehashed) using the various marking callbacks.
  *    See sylvan_gc_add_mark to add marking callbacks.
  *    Afterwards, the ondead hook is called for all now-dead nodes with the custom flag set.
@@ -112,6 +113,8 @@ VOID_TASK_DECL_2(sylvan_table_usage, size_t*, size_t*);
  * 7) All installed post_gc hooks are called.
  *    See sylvan_gc_hook_post to add hooks.
  *
+ * Every garbage collection is recorded in the GC event log, see sylvan_gc_log_get.
+ *
  * For parts of the garbage collection process, specific methods exist.
  * - sylvan_clear_cache() clears the operation cache (step 2)
  * - sylvan_clear_and_mark() performs steps 3 and 4.
@@ -138,6 +141,28 @@ VOID_TASK_DECL_0(sylvan_gc);
 void sylvan_gc_enable(void);
 void sylvan_gc_disable(void);
 
+/**
+ * Turn generational garbage collection on (<full_every> > 0) or off (0, the default).
+ *
+ * The nodes that survive a garbage collection become old. The next <full_every> garbage
+ * collections are minor: they keep all old nodes without marking them again, so the marking
+ * callbacks only trace (and only free) the nodes created since the previous garbage collection.
+ * Then a full garbage collection also frees the old nodes that died. If the old nodes fill more
+ * than half of the nodes table, the garbage collection is full instead of minor.
+ * This is useful when most nodes are long-lived, like the transition relation.
+ */
+void sylvan_gc_set_generational(unsigned int full_every);
+
+/**
+ * Make room for <count> new nodes before creating many nodes at once.
+ * If the nodes table is too small to hold the current nodes and <count> new nodes
+ * at a load factor of 50%, garbage collection is triggered and the nodes table is
+ * grown (up to the maximum size) before rehashing.
+ * Has no effect when garbage collection is disabled.
+ */
+VOID_TASK_DECL_1(sylvan_gc_reserve, size_t);
+#define sylvan_gc_reserve(count) (RUN(sylvan_gc_reserve, count))
+
 /**
  * Test if garbage collection must happen now.
  * This is just a call to the Lace framework to see if NEWFRAME has been used.
@@ -193,9 +218,117 @@ void sylvan_gc_hook_main(gc_hook_cb callback);
  *
  * The sylvan_count_refs() function uses the count_cb callbacks to compute the number
  * of references.
+ *
+ * The callback must mark every node reachable from its roots, not only the roots: a minor
+ * garbage collection (see sylvan_gc_set_generational) stops at old nodes, so it relies on all
+ * children of a marked node being marked when the nodes become old.
  */
 void sylvan_gc_add_mark(gc_hook_cb mark_cb);
 
+/**
+ * Add a marking mechanism with a name, which is used in the GC event log.
+ * The name is not copied and must remain valid.
+ */
+void sylvan_gc_add_mark_named(gc_hook_cb mark_cb, const char *name);
+
+/**
+ * The marking engine of the recursive marking functions mtbdd_gc_mark_rec, lddmc_gc_mark_rec
+ * and zdd_gc_mark_rec, for decision diagrams with at most two children per node.
+ *
+ * The visit callback claims the node of <dd> with llmsset_mark. If the node was not yet marked,
+ * it writes the children that must be marked to <children> and returns how many (at most 2);
+ * otherwise, and for terminals, it returns 0.
+ *
+ * Instead of one task per node, every marking task walks a subgraph with its own stack of nodes.
+ * When the last part that the task offered was stolen, the task offers the bottom half of its
+ * stack (the nodes nearest to the root) as a new task, so idle workers steal large subgraphs
+ * rather than single nodes. Otherwise the stack grows, so a task never has more than one offer
+ * waiting to be stolen.
+ */
+typedef int (*gc_mark_visit_cb)(uint64_t dd, uint64_t *children);
+VOID_TASK_DECL_2(sylvan_gc_mark_dd, gc_mark_visit_cb, uint64_t);
+#define sylvan_gc_mark_dd(visit, dd) CALL(sylvan_gc_mark_dd, visit, dd)
+
+/**
+ * GC EVENT LOG
+ *
+ * Every garbage collection is recorded in the GC event log, with the duration of each phase,
+ * the size of the nodes table and the operation cache before and after, the number of nodes
+ * in the table before garbage collection and the number of live (marked) nodes.
+ * For every marking callback, the log records the time spent and the number of nodes that were
+ * first marked by that callback (nodes that are shared with earlier callbacks are not counted).
+ *
+ * Post gc hooks already find the current event in the log, without its pause and the
+ * duration of the post gc phase. The log keeps the last SYLVAN_GC_LOG_SIZE events. It is always recorded, also without
+ * SYLVAN_STATS, and it is part of sylvan_stats_report and sylvan_stats_report_json.
+ */
+#define SYLVAN_GC_LOG_SIZE 256
+
+typedef enum {
+    SYLVAN_GC_PHASE_PREGC,       // pre gc hooks
+    SYLVAN_GC_PHASE_CLEAR_CACHE, // clearing the operation cache
+    SYLVAN_GC_PHASE_MARK,        // clearing the nodes table and marking
+    SYLVAN_GC_PHASE_RESIZE,      // the main hook (resizing)
+    SYLVAN_GC_PHASE_REHASH,      // rehashing the marked nodes
+    SYLVAN_GC_PHASE_POSTGC,      // post gc hooks
+    SYLVAN_GC_PHASES
+} sylvan_gc_phase_t;
+
+typedef struct sylvan_gc_mark_info
+{
+    const char *name;   // name of the marking callback (NULL if unnamed)
+    uint64_t time;      // time in ns
+    size_t nodes;       // number of nodes first marked by this callback (if counting, see below)
+} sylvan_gc_mark_info_t;
+
+typedef struct sylvan_gc_event
+{
+    uint64_t index;                     // number of the garbage collection (from 0)
+    uint64_t start;                     // start in ns since sylvan_init_package
+    uint64_t pause;                     // total duration in ns
+    uint64_t phases[SYLVAN_GC_PHASES];  // duration of every phase in ns
+    size_t table_before, table_after;   // size of the nodes table
+    size_t cache_before, cache_after;   // size of the operation cache
+    size_t nodes_before;                // number of nodes in the table before garbage collection (if counting)
+    size_t nodes_live;                  // number of nodes that survived garbage collection (if counting)
+    int minor;                          // 1 for a minor garbage collection, see sylvan_gc_set_generational
+    size_t nodes_old;                   // number of old nodes kept by a minor garbage collection
+    unsigned int mark_count;            // number of marking callbacks
+    const sylvan_gc_mark_info_t *marks; // the marking callbacks, in the order they were called
+} sylvan_gc_event_t;
+
+/**
+ * Returns the number of garbage collections since sylvan_init_package or sylvan_gc_log_clear.
+ */
+size_t sylvan_gc_log_count(void);
+
+/**
+ * Copy the event of garbage collection <index> to <event>.
+ * Returns 0 if the event is not in the log (anymore), 1 otherwise.
+ * The <marks> array belongs to the log and is valid until SYLVAN_GC_LOG_SIZE more
+ * garbage collections have happened, or until sylvan_gc_log_clear or sylvan_quit.
+ */
+int sylvan_gc_log_get(size_t index, sylvan_gc_event_t *event);
+
+/**
+ * Count the marked nodes in the GC event log (default: off).
+ * Every count scans the nodes table, so the node counts of the events (nodes_before, nodes_live
+ * and the nodes of every marking callback) are only recorded with <enabled> 1,
+ * when Sylvan is built with SYLVAN_STATS or when statistics sampling is on; otherwise they are 0.
+ * The durations are always recorded.
+ */
+void sylvan_gc_log_set_counts(int enabled);
+
+/**
+ * Clear the GC event log.
+ */
+void sylvan_gc_log_clear(void);
+
+/**
+ * Returns the name of a GC phase.
+ */
+const char *sylvan_gc_phase_name(sylvan_gc_phase_t phase);
+
 /**
  * One of the hooks for resizing behavior.
  * Default if SYLVAN_AGGRESSIVE_RESIZE is set.
@@ -212,6 +345,38 @@ VOID_TASK_DECL_0(sylvan_gc_aggressive_resize);
  */
 VOID_TASK_DECL_0(sylvan_gc_normal_resize);
 
+/**
+ * The types of handles (mtbdd_handle_get, lddmc_handle_get, zdd_handle_get), stored in bits 1-2
+ * of the handle next to the (8-aligned) address of the protected variable.
+ */
+#define HANDLES_MTBDD 0
+#define HANDLES_LDD 2
+#define HANDLES_ZDD 4
+
+/**
+ * Format of the files written by mtbdd_writer_tobinary, zdd_writer_tobinary and
+ * lddmc_serialize_tofile.
+ *
+ * The raw format (the default) writes 16 bytes per node. The packed format writes every
+ * node as a few varints, with the children relative to the number of the node, which
+ * is typically 3 to 5 times smaller. The packed format can be compressed further with
+ * zlib, if Sylvan is built with SYLVAN_ZLIB.
+ * The readers recognize all formats, so only the writers need to be configured.
+ * Files with leaves that have a custom hash function (e.g. GMP leaves) are always raw.
+ */
+typedef enum sylvan_binary_format {
+    SYLVAN_BINARY_RAW = 0,
+    SYLVAN_BINARY_PACKED = 1,
+    SYLVAN_BINARY_PACKED_ZLIB = 2,
+} sylvan_binary_format;
+
+/**
+ * Set the format for the binary writers.
+ * Returns 0 on success, or -1 if the format is not available.
+ */
+int sylvan_set_binary_format(sylvan_binary_format format);
+sylvan_binary_format sylvan_get_binary_format(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -24,11 +24,21 @@
 #define SYLVAN_STATS 0
 #endif
 
+/* Enable/disable the tracing hooks in the hot paths */
+#ifndef SYLVAN_TRACE
+#define SYLVAN_TRACE 0
+#endif
+
 /* Enable/disable using mmap to allocate large amounts of memory */
 #ifndef SYLVAN_USE_MMAP
 #define SYLVAN_USE_MMAP 0
 #endif
 
+/* Enable/disable compressing binary files with zlib */
+#ifndef SYLVAN_USE_ZLIB
+#define SYLVAN_USE_ZLIB 0
+#endif
+
 /* Aggressive or conservative resizing strategy */
 #ifndef SYLVAN_AGGRESSIVE_RESIZE
 #define SYLVAN_AGGRESSIVE_RESIZE 1
@@ -0,0 +1,571 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if SYLVAN_USE_MMAP
+#include <sys/mman.h> // for mmap
+#endif
+
+#include <sylvan_writer.h>
+
+static const char dump_magic[8] = { 'S', 'Y', 'L', 'V', 'A', 'N', 'D', 'D' };
+static const uint64_t dump_byteorder = 0x0102030405060708ULL;
+
+/* Number of nodes per task when inserting a level in parallel */
+#define DUMP_NODES_PER_TASK 4096
+
+/**
+ * Translate the index of a marked node (or a terminal) to its reference in the dump
+ */
+static inline uint64_t
+dump_ref(sylvan_writer_t w, uint64_t index)
+{
+    return index <= 1 ? index : sylvan_writer_get(w, index) + 1;
+}
+
+/**
+ * Write the header, the levels, the nodes and the roots of a numbered writer
+ */
+TASK_6(int, dump_write, FILE*, out, sylvan_writer_t, w, uint32_t, type, const uint64_t*, roots, size_t, count, sylvan_writer_encode_cb, encode_cb)
+{
+    sylvan_dump_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, dump_magic, sizeof(h.magic));
+    h.version = SYLVAN_DUMP_VERSION;
+    h.type = type;
+    h.byteorder = dump_byteorder;
+    h.nodecount = sylvan_writer_count(w);
+    h.levelcount = sylvan_writer_level_count(w);
+    h.rootcount = count;
+
+    fwrite(&h, sizeof(h), 1, out);
+    for (size_t k=0; k<h.levelcount; k++) {
+        uint64_t end = sylvan_writer_level_end(w, k);
+        fwrite(&end, sizeof(uint64_t), 1, out);
+    }
+    CALL(sylvan_writer_write, w, out, 1, h.nodecount, encode_cb);
+    if (count > 0) fwrite(roots, sizeof(uint64_t), count, out);
+
+    return ferror(out) ? -1 : 0;
+}
+
+/**
+ * Writing MTBDDs
+ */
+
+static uint32_t
+dump_mtbdd_level(uint64_t index, void *ctx)
+{
+    (void)ctx;
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    return mtbddnode_isleaf(n) ? (uint32_t)-1 : mtbddnode_getvariable(n);
+}
+
+/**
+ * Mark the nodes of <dd>; returns 1 if a leaf with a custom hash function was found
+ */
+TASK_2(int, dump_mtbdd_mark, MTBDD, dd, sylvan_writer_t, w)
+{
+    const uint64_t index = MTBDD_STRIPMARK(dd);
+    if (index <= 1 || !sylvan_writer_mark(w, index)) return 0;
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    if (mtbddnode_isleaf(n)) return sylvan_mt_has_custom_hash(mtbddnode_gettype(n));
+    SPAWN(dump_mtbdd_mark, mtbddnode_getlow(n), w);
+    int res = CALL(dump_mtbdd_mark, mtbddnode_gethigh(n), w);
+    return SYNC(dump_mtbdd_mark) | res;
+}
+
+VOID_TASK_4(dump_mtbdd_encode, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    for (size_t i=0; i<count; i++) {
+        mtbddnode_t n = MTBDD_GETNODE(sylvan_writer_getr(w, first+i));
+        mtbddnode_t r = (mtbddnode_t)(buf + 16*i);
+        if (mtbddnode_isleaf(n)) {
+            memcpy(r, n, sizeof(struct mtbddnode));
+            continue;
+        }
+        MTBDD low = dump_ref(w, mtbddnode_getlow(n));
+        MTBDD high = mtbddnode_gethigh(n);
+        high = MTBDD_TRANSFERMARK(high, dump_ref(w, MTBDD_STRIPMARK(high)));
+        if (mtbddnode_ismapnode(n)) mtbddnode_makemapnode(r, mtbddnode_getvariable(n), low, high);
+        else mtbddnode_makenode(r, mtbddnode_getvariable(n), low, high);
+    }
+}
+
+TASK_IMPL_3(int, mtbdd_dump, FILE*, out, const MTBDD*, dds, size_t, count)
+{
+    sylvan_writer_t w = sylvan_writer_alloc();
+
+    int unsupported = 0;
+    for (size_t i=0; i<count; i++) SPAWN(dump_mtbdd_mark, dds[i], w);
+    for (size_t i=0; i<count; i++) unsupported |= SYNC(dump_mtbdd_mark);
+    if (unsupported) {
+        sylvan_writer_free(w);
+        return -1;
+    }
+    CALL(sylvan_writer_number, w, dump_mtbdd_level, NULL);
+
+    uint64_t *roots = (uint64_t*)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    for (size_t i=0; i<count; i++) roots[i] = MTBDD_TRANSFERMARK(dds[i], dump_ref(w, MTBDD_STRIPMARK(dds[i])));
+
+    int res = CALL(dump_write, out, w, SYLVAN_DUMP_MTBDD, roots, count, TASK(dump_mtbdd_encode));
+
+    free(roots);
+    sylvan_writer_free(w);
+    return res;
+}
+
+/**
+ * Writing ZDDs
+ */
+
+static uint32_t
+dump_zdd_level(uint64_t index, void *ctx)
+{
+    (void)ctx;
+    zddnode_t n = ZDD_GETNODE(index);
+    return zddnode_isleaf(n) ? (uint32_t)-1 : zddnode_getvariable(n);
+}
+
+TASK_2(int, dump_zdd_mark, ZDD, dd, sylvan_writer_t, w)
+{
+    const uint64_t index = ZDD_GETINDEX(dd);
+    if (index <= 1 || !sylvan_writer_mark(w, index)) return 0;
+    zddnode_t n = ZDD_GETNODE(index);
+    if (zddnode_isleaf(n)) return sylvan_mt_has_custom_hash(zddnode_gettype(n));
+    SPAWN(dump_zdd_mark, zddnode_getlow(n), w);
+    int res = CALL(dump_zdd_mark, zddnode_gethigh(n), w);
+    return SYNC(dump_zdd_mark) | res;
+}
+
+VOID_TASK_4(dump_zdd_encode, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    for (size_t i=0; i<count; i++) {
+        zddnode_t n = ZDD_GETNODE(sylvan_writer_getr(w, first+i));
+        zddnode_t r = (zddnode_t)(buf + 16*i);
+        if (zddnode_isleaf(n)) {
+            memcpy(r, n, sizeof(struct zddnode));
+            continue;
+        }
+        ZDD low = zddnode_getlow(n);
+        ZDD high = zddnode_gethigh(n);
+        low = ZDD_SETINDEX(low, dump_ref(w, ZDD_GETINDEX(low)));
+        high = ZDD_SETINDEX(high, dump_ref(w, ZDD_GETINDEX(high)));
+        if (zddnode_ismapnode(n)) zddnode_makemapnode(r, zddnode_getvariable(n), low, high);
+        else zddnode_makenode(r, zddnode_getvariable(n), low, high);
+    }
+}
+
+TASK_IMPL_3(int, zdd_dump, FILE*, out, const ZDD*, dds, size_t, count)
+{
+    sylvan_writer_t w = sylvan_writer_alloc();
+
+    int unsupported = 0;
+    for (size_t i=0; i<count; i++) SPAWN(dump_zdd_mark, dds[i], w);
+    for (size_t i=0; i<count; i++) unsupported |= SYNC(dump_zdd_mark);
+    if (unsupported) {
+        sylvan_writer_free(w);
+        return -1;
+    }
+    CALL(sylvan_writer_number, w, dump_zdd_level, NULL);
+
+    uint64_t *roots = (uint64_t*)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    for (size_t i=0; i<count; i++) roots[i] = ZDD_SETINDEX(dds[i], dump_ref(w, ZDD_GETINDEX(dds[i])));
+
+    int res = CALL(dump_write, out, w, SYLVAN_DUMP_ZDD, roots, count, TASK(dump_zdd_encode));
+
+    free(roots);
+    sylvan_writer_free(w);
+    return res;
+}
+
+/**
+ * Writing LDDs
+ *
+ * The levels of LDDs are the heights of the nodes, as numbered by lddmc_writer_number.
+ */
+
+VOID_TASK_4(dump_ldd_encode, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    for (size_t i=0; i<count; i++) {
+        mddnode_t n = LDD_GETNODE(sylvan_writer_getr(w, first+i));
+        mddnode_t r = (mddnode_t)(buf + 16*i);
+        uint64_t right = dump_ref(w, mddnode_getright(n));
+        uint64_t down = dump_ref(w, mddnode_getdown(n));
+        if (mddnode_getcopy(n)) mddnode_makecopy(r, right, down);
+        else mddnode_make(r, mddnode_getvalue(n), right, down);
+    }
+}
+
+TASK_IMPL_3(int, lddmc_dump, FILE*, out, const MDD*, dds, size_t, count)
+{
+    sylvan_writer_t w = sylvan_writer_alloc();
+    CALL(lddmc_writer_number, w, dds, count);
+
+    uint64_t *roots = (uint64_t*)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    for (size_t i=0; i<count; i++) roots[i] = dump_ref(w, dds[i]);
+
+    int res = CALL(dump_write, out, w, SYLVAN_DUMP_LDD, roots, count, TASK(dump_ldd_encode));
+
+    free(roots);
+    sylvan_writer_free(w);
+    return res;
+}
+
+/**
+ * Loading
+ *
+ * While a dump is loaded, the translation array of the load is registered in a global
+ * list, so the nodes that were already inserted survive garbage collection.
+ */
+
+typedef struct dump_load {
+    struct dump_load *next;
+    uint32_t type;
+    uint64_t nodecount;
+    const uint8_t *nodes;   // node <n> is at nodes + 16*(n-1)
+    uint64_t *arr;          // arr[n] is the inserted node with number <n>
+} *dump_load_t;
+
+static dump_load_t dump_loads = NULL;
+static pthread_mutex_t dump_loads_lock = PTHREAD_MUTEX_INITIALIZER;
+static int dump_mark_registered = 0;
+
+VOID_TASK_3(dump_gc_mark_par, dump_load_t, ld, uint64_t, first, size_t, count)
+{
+    if (count > DUMP_NODES_PER_TASK) {
+        SPAWN(dump_gc_mark_par, ld, first, count/2);
+        CALL(dump_gc_mark_par, ld, first+count/2, count-count/2);
+        SYNC(dump_gc_mark_par);
+        return;
+    }
+
+    for (uint64_t i=first; i<first+count; i++) {
+        const uint64_t dd = ld->arr[i];
+        if (dd == 0) continue;
+        if (ld->type == SYLVAN_DUMP_LDD) CALL(lddmc_gc_mark_rec, dd);
+        else if (ld->type == SYLVAN_DUMP_ZDD) CALL(zdd_gc_mark_rec, dd);
+        else CALL(mtbdd_gc_mark_rec, dd);
+    }
+}
+
+VOID_TASK_0(dump_gc_mark)
+{
+    pthread_mutex_lock(&dump_loads_lock);
+    for (dump_load_t ld = dump_loads; ld != NULL; ld = ld->next) {
+        CALL(dump_gc_mark_par, ld, 1, ld->nodecount);
+    }
+    pthread_mutex_unlock(&dump_loads_lock);
+}
+
+static void
+dump_quit()
+{
+    dump_mark_registered = 0;
+}
+
+static void
+dump_register(dump_load_t ld)
+{
+    pthread_mutex_lock(&dump_loads_lock);
+    if (!dump_mark_registered) {
+        sylvan_gc_add_mark_named(TASK(dump_gc_mark), "dump_gc_mark");
+        sylvan_register_quit(dump_quit);
+        dump_mark_registered = 1;
+    }
+    ld->next = dump_loads;
+    dump_loads = ld;
+    pthread_mutex_unlock(&dump_loads_lock);
+}
+
+static void
+dump_unregister(dump_load_t ld)
+{
+    pthread_mutex_lock(&dump_loads_lock);
+    dump_load_t *p = &dump_loads;
+    while (*p != ld) p = &(*p)->next;
+    *p = ld->next;
+    pthread_mutex_unlock(&dump_loads_lock);
+}
+
+/**
+ * Translate a reference in the dump to the inserted node, or return (uint64_t)-1
+ * if the reference is not to a node of an earlier level (<limit> is the first number
+ * of the current level).
+ */
+static inline uint64_t
+dump_translate(dump_load_t ld, uint64_t ref, uint64_t limit)
+{
+    if (ref <= 1) return ref;
+    if (ref - 1 >= limit) return (uint64_t)-1;
+    return ld->arr[ref - 1];
+}
+
+/**
+ * Build the node with number <number> in the nodes table format, with translated references.
+ * Returns 0 if the node refers to an invalid node.
+ */
+static inline int
+dump_decode(dump_load_t ld, uint64_t number, uint64_t limit, uint64_t *a, uint64_t *b)
+{
+    struct { uint64_t a, b; } n;
+    memcpy(&n, ld->nodes + 16*(number-1), 16);
+
+    if (ld->type == SYLVAN_DUMP_MTBDD) {
+        mtbddnode_t node = (mtbddnode_t)&n;
+        if (!mtbddnode_isleaf(node)) {
+            const uint64_t high = mtbddnode_gethigh(node);
+            const uint64_t l = dump_translate(ld, mtbddnode_getlow(node), limit);
+            const uint64_t h = dump_translate(ld, MTBDD_STRIPMARK(high), limit);
+            if (l == (uint64_t)-1 || h == (uint64_t)-1) return 0;
+            if (mtbddnode_ismapnode(node)) mtbddnode_makemapnode(node, mtbddnode_getvariable(node), l, MTBDD_TRANSFERMARK(high, h));
+            else mtbddnode_makenode(node, mtbddnode_getvariable(node), l, MTBDD_TRANSFERMARK(high, h));
+        }
+    } else if (ld->type == SYLVAN_DUMP_ZDD) {
+        zddnode_t node = (zddnode_t)&n;
+        if (!zddnode_isleaf(node)) {
+            const uint64_t low = zddnode_getlow(node);
+            const uint64_t high = zddnode_gethigh(node);
+            const uint64_t l = dump_translate(ld, ZDD_GETINDEX(low), limit);
+            const uint64_t h = dump_translate(ld, ZDD_GETINDEX(high), limit);
+            if (l == (uint64_t)-1 || h == (uint64_t)-1) return 0;
+            if (zddnode_ismapnode(node)) zddnode_makemapnode(node, zddnode_getvariable(node), ZDD_SETINDEX(low, l), ZDD_SETINDEX(high, h));
+            else zddnode_makenode(node, zddnode_getvariable(node), ZDD_SETINDEX(low, l), ZDD_SETINDEX(high, h));
+        }
+    } else {
+        mddnode_t node = (mddnode_t)&n;
+        const uint64_t right = dump_translate(ld, mddnode_getright(node), limit);
+        const uint64_t down = dump_translate(ld, mddnode_getdown(node), limit);
+        if (right == (uint64_t)-1 || down == (uint64_t)-1 || right == lddmc_true) return 0;
+        if (mddnode_getcopy(node)) mddnode_makecopy(node, right, down);
+        else mddnode_make(node, mddnode_getvalue(node), right, down);
+    }
+
+    *a = n.a;
+    *b = n.b;
+    return 1;
+}
+
+/**
+ * Insert the nodes <first>...<first+count-1> of the level that starts at <limit>.
+ * Returns 1 if the dump is invalid, 0 otherwise.
+ */
+TASK_4(int, dump_insert_par, dump_load_t, ld, uint64_t, first, size_t, count, uint64_t, limit)
+{
+    if (count > DUMP_NODES_PER_TASK) {
+        SPAWN(dump_insert_par, ld, first, count/2, limit);
+        int res = CALL(dump_insert_par, ld, first+count/2, count-count/2, limit);
+        return SYNC(dump_insert_par) | res;
+    }
+
+    sylvan_gc_test();
+
+    for (uint64_t number=first; number<first+count; number++) {
+        uint64_t a, b;
+        if (!dump_decode(ld, number, limit, &a, &b)) return 1;
+
+        int created;
+        uint64_t index = llmsset_lookup(nodes, a, b, &created);
+        if (index == 0) {
+            /* the inserted nodes are marked by dump_gc_mark */
+            CALL(sylvan_gc);
+            index = llmsset_lookup(nodes, a, b, &created);
+            if (index == 0) {
+                fprintf(stderr, "Unique table full, %zu of %zu buckets filled!\n", llmsset_count_marked(nodes), llmsset_get_size(nodes));
+                exit(1);
+            }
+        }
+
+        if (ld->type == SYLVAN_DUMP_LDD) {
+            if (created) sylvan_stats_count(LDD_NODES_CREATED);
+            else sylvan_stats_count(LDD_NODES_REUSED);
+        } else {
+            if (created) sylvan_stats_count(BDD_NODES_CREATED);
+            else sylvan_stats_count(BDD_NODES_REUSED);
+        }
+
+        ld->arr[number] = index;
+    }
+
+    return 0;
+}
+
+/**
+ * Check the header, and return the size of the dump in bytes, or 0 if invalid
+ */
+static uint64_t
+dump_check_header(const sylvan_dump_header_t *h)
+{
+    if (memcmp(h->magic, dump_magic, sizeof(dump_magic)) != 0) return 0;
+    if (h->version != SYLVAN_DUMP_VERSION) return 0;
+    if (h->byteorder != dump_byteorder) return 0;
+    if (h->type > SYLVAN_DUMP_LDD) return 0;
+    if (h->levelcount > h->nodecount || h->nodecount > ((uint64_t)1 << 40)) return 0;
+    if (h->rootcount > ((uint64_t)1 << 40)) return 0;
+    return sizeof(sylvan_dump_header_t) + 8 * h->levelcount + 16 * h->nodecount + 8 * h->rootcount;
+}
+
+int
+sylvan_dump_header(FILE *in, sylvan_dump_header_t *header)
+{
+    off_t pos = ftello(in);
+    size_t res = fread(header, sizeof(sylvan_dump_header_t), 1, in);
+    fseeko(in, pos, SEEK_SET);
+    if (res != 1 || dump_check_header(header) == 0) return -1;
+    return 0;
+}
+
+/**
+ * Load the dump at the current position of <in> into <roots>
+ */
+TASK_4(int, dump_load, FILE*, in, uint32_t, type, uint64_t*, roots, size_t, count)
+{
+    const off_t pos = ftello(in);
+    if (pos < 0) return -1;
+
+    /* Obtain the dump in memory, preferably by mapping the file */
+    const uint8_t *data = NULL;
+    void *mapped = NULL;
+    size_t mapped_size = 0;
+    uint8_t *buffer = NULL;
+    uint64_t size = 0;
+    sylvan_dump_header_t h;
+
+#if SYLVAN_USE_MMAP
+    struct stat st;
+    if (fstat(fileno(in), &st) == 0 && S_ISREG(st.st_mode) && (uint64_t)st.st_size >= (uint64_t)pos + sizeof(h)) {
+        mapped_size = (size_t)st.st_size;
+        mapped = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE, fileno(in), 0);
+        if (mapped == MAP_FAILED) {
+            mapped = NULL;
+        } else {
+            data = (const uint8_t*)mapped + pos;
+            memcpy(&h, data, sizeof(h));
+            size = dump_check_header(&h);
+            if (size == 0 || size > mapped_size - (uint64_t)pos) {
+                munmap(mapped, mapped_size);
+                return -1;
+            }
+            madvise(mapped, mapped_size, MADV_SEQUENTIAL);
+        }
+    }
+#endif
+
+    if (data == NULL) {
+        /* Fall back to reading the dump into a buffer */
+        if (fread(&h, sizeof(h), 1, in) != 1 || (size = dump_check_header(&h)) == 0) {
+            fseeko(in, pos, SEEK_SET);
+            return -1;
+        }
+        buffer = (uint8_t*)malloc(size);
+        if (buffer == NULL) {
+            fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for loading a dump: %s!\n", (size_t)size, strerror(errno));
+            exit(1);
+        }
+        memcpy(buffer, &h, sizeof(h));
+        if (fread(buffer + sizeof(h), 1, size - sizeof(h), in) != size - sizeof(h)) {
+            free(buffer);
+            fseeko(in, pos, SEEK_SET);
+            return -1;
+        }
+        data = buffer;
+    }
+
+    int res = 0;
+    if (h.type != type || h.rootcount != count) res = -1;
+
+    /* Read and check the level boundaries */
+    uint64_t *ends = (uint64_t*)malloc(sizeof(uint64_t) * (h.levelcount + 1));
+    if (res == 0) {
+        memcpy(ends, data + sizeof(h), 8 * h.levelcount);
+        uint64_t prev = 0;
+        for (uint64_t k=0; k<h.levelcount; k++) {
+            if (ends[k] <= prev) res = -1;
+            prev = ends[k];
+        }
+        if (prev != h.nodecount) res = -1;
+    }
+
+    if (res == 0) {
+        /* Make room for all nodes at once, then insert the levels in order */
+        CALL(sylvan_gc_reserve, h.nodecount);
+
+        struct dump_load ld;
+        ld.type = type;
+        ld.nodecount = h.nodecount;
+        ld.nodes = data + sizeof(h) + 8 * h.levelcount;
+        ld.arr = (uint64_t*)calloc(h.nodecount + 1, sizeof(uint64_t));
+        dump_register(&ld);
+
+        uint64_t first = 1;
+        for (uint64_t k=0; k<h.levelcount && res == 0; k++) {
+            if (CALL(dump_insert_par, &ld, first, ends[k] - first + 1, first)) res = -1;
+            first = ends[k] + 1;
+        }
+
+        /* Translate the roots */
+        const uint8_t *stored = ld.nodes + 16 * h.nodecount;
+        for (size_t i=0; i<count && res == 0; i++) {
+            uint64_t v;
+            memcpy(&v, stored + 8*i, sizeof(uint64_t));
+            uint64_t r;
+            if (type == SYLVAN_DUMP_MTBDD) {
+                r = dump_translate(&ld, MTBDD_STRIPMARK(v), h.nodecount + 1);
+                roots[i] = MTBDD_TRANSFERMARK(v, r);
+            } else if (type == SYLVAN_DUMP_ZDD) {
+                r = dump_translate(&ld, ZDD_GETINDEX(v), h.nodecount + 1);
+                roots[i] = ZDD_SETINDEX(v, r);
+            } else {
+                r = dump_translate(&ld, v, h.nodecount + 1);
+                roots[i] = r;
+            }
+            if (r == (uint64_t)-1) res = -1;
+        }
+
+        dump_unregister(&ld);
+        free(ld.arr);
+    }
+
+    free(ends);
+#if SYLVAN_USE_MMAP
+    if (mapped != NULL) munmap(mapped, mapped_size);
+#endif
+    free(buffer);
+
+    fseeko(in, res == 0 ? pos + (off_t)size : pos, SEEK_SET);
+    return res;
+}
+
+TASK_IMPL_3(int, mtbdd_undump, FILE*, in, MTBDD*, dds, size_t, count)
+{
+    return CALL(dump_load, in, SYLVAN_DUMP_MTBDD, dds, count);
+}
+
+TASK_IMPL_3(int, zdd_undump, FILE*, in, ZDD*, dds, size_t, count)
+{
+    return CALL(dump_load, in, SYLVAN_DUMP_ZDD, dds, count);
+}
+
+TASK_IMPL_3(int, lddmc_undump, FILE*, in, MDD*, dds, size_t, count)
+{
+    return CALL(dump_load, in, SYLVAN_DUMP_LDD, dds, count);
+}
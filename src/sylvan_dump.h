@@ -0,0 +1,104 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Do not include this file directly. Instead, include sylvan.h */
+
+#ifndef SYLVAN_DUMP_H
+#define SYLVAN_DUMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Versioned binary format for MTBDDs, ZDDs and LDDs that can be loaded with mmap.
+ *
+ * A dump consists of:
+ * - a header of 64 bytes (sylvan_dump_header_t);
+ * - <levelcount> 64-bit numbers, the last node number of every level;
+ * - <nodecount> nodes of 16 bytes, in the same layout as in the nodes table;
+ * - <rootcount> 64-bit references to the stored decision diagrams.
+ *
+ * Nodes are numbered 1,...,<nodecount> and are grouped in levels, such that every node
+ * only refers to nodes of earlier levels. For MTBDDs and ZDDs, the first level contains
+ * the leaves and the other levels are the variables, from the deepest to the top variable.
+ * For LDDs, the level of a node is its height (following both the down and right edges).
+ * Inside the nodes, the references to node <n> are stored as <n>+1, while references to
+ * the terminals 0 and 1 (the false leaf, lddmc_false and lddmc_true) are kept as they are.
+ * The complement marks of MTBDD and ZDD edges are kept.
+ *
+ * Loading maps the file into memory and inserts every level in parallel directly from
+ * the mapped file, after growing the nodes table for the number of nodes in the header.
+ * The format uses the byte order of the machine and is not portable between little and
+ * big endian machines (this is detected when loading).
+ * Leaves with a custom hash function (e.g. GMP leaves) are pointers and are not supported.
+ */
+
+#define SYLVAN_DUMP_VERSION 1
+
+typedef enum sylvan_dump_type {
+    SYLVAN_DUMP_MTBDD = 0,
+    SYLVAN_DUMP_ZDD = 1,
+    SYLVAN_DUMP_LDD = 2,
+} sylvan_dump_type;
+
+typedef struct sylvan_dump_header {
+    char magic[8];              // "SYLVANDD"
+    uint32_t version;           // SYLVAN_DUMP_VERSION
+    uint32_t type;              // sylvan_dump_type
+    uint64_t byteorder;         // 0x0102030405060708 in the byte order of the writer
+    uint64_t nodecount;         // number of nodes
+    uint64_t levelcount;        // number of levels
+    uint64_t rootcount;         // number of stored decision diagrams
+    uint64_t reserved[2];       // zero
+} sylvan_dump_header_t;
+
+/**
+ * Write the <count> decision diagrams in <dds> to <out>.
+ * Returns 0 on success, or -1 if a leaf is not supported or the file could not be written.
+ */
+TASK_DECL_3(int, mtbdd_dump, FILE*, const MTBDD*, size_t);
+#define mtbdd_dump(out, dds, count) RUN(mtbdd_dump, out, dds, count)
+TASK_DECL_3(int, zdd_dump, FILE*, const ZDD*, size_t);
+#define zdd_dump(out, dds, count) RUN(zdd_dump, out, dds, count)
+TASK_DECL_3(int, lddmc_dump, FILE*, const MDD*, size_t);
+#define lddmc_dump(out, dds, count) RUN(lddmc_dump, out, dds, count)
+
+/**
+ * Load the <count> decision diagrams of a dump written earlier, starting at the current
+ * position of <in>. On success, the position of <in> is moved to the end of the dump.
+ * Returns 0 on success, or -1 if the file is not a valid dump of the right type with
+ * <count> decision diagrams.
+ */
+TASK_DECL_3(int, mtbdd_undump, FILE*, MTBDD*, size_t);
+#define mtbdd_undump(in, dds, count) RUN(mtbdd_undump, in, dds, count)
+TASK_DECL_3(int, zdd_undump, FILE*, ZDD*, size_t);
+#define zdd_undump(in, dds, count) RUN(zdd_undump, in, dds, count)
+TASK_DECL_3(int, lddmc_undump, FILE*, MDD*, size_t);
+#define lddmc_undump(in, dds, count) RUN(lddmc_undump, in, dds, count)
+
+/**
+ * Read the header of the dump at the current position of <in>, without moving the position.
+ * Returns 0 on success, or -1 if there is no valid header.
+ */
+int sylvan_dump_header(FILE *in, sylvan_dump_header_t *header);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -68,6 +68,11 @@ static const uint64_t CACHE_BDD_CLOSURE             = (13LL<<40);
 static const uint64_t CACHE_BDD_ISBDD               = (14LL<<40);
 static const uint64_t CACHE_BDD_SUPPORT             = (15LL<<40);
 static const uint64_t CACHE_BDD_PATHCOUNT           = (16LL<<40);
+static const uint64_t CACHE_BDD_AND_N               = (17LL<<40);
+static const uint64_t CACHE_BDD_AND_EXISTS_N        = (18LL<<40);
+static const uint64_t CACHE_BDD_SATURATE            = (19LL<<40);
+static const uint64_t CACHE_BDD_LEQ                 = (32LL<<40);
+static const uint64_t CACHE_BDD_EQUIV_UNDER         = (33LL<<40);
 
 // MDD operations
 static const uint64_t CACHE_MDD_RELPROD             = (20LL<<40);
@@ -81,14 +86,14 @@ static const uint64_t CACHE_MDD_RELPREV             = (27LL<<40);
 static const uint64_t CACHE_MDD_SATCOUNT            = (28LL<<40);
 static const uint64_t CACHE_MDD_SATCOUNTL1          = (29LL<<40);
 static const uint64_t CACHE_MDD_SATCOUNTL2          = (30LL<<40);
+static const uint64_t CACHE_MDD_SATURATE            = (31LL<<40);
 
 // MTBDD operations
 static const uint64_t CACHE_MTBDD_APPLY             = (40LL<<40);
 static const uint64_t CACHE_MTBDD_UAPPLY            = (41LL<<40);
 static const uint64_t CACHE_MTBDD_ABSTRACT          = (42LL<<40);
 static const uint64_t CACHE_MTBDD_ITE               = (43LL<<40);
-static const uint64_t CACHE_MTBDD_AND_ABSTRACT_PLUS = (44LL<<40);
-static const uint64_t CACHE_MTBDD_AND_ABSTRACT_MAX  = (45LL<<40);
+static const uint64_t CACHE_MTBDD_AND_ABSTRACT      = (44LL<<40);
 static const uint64_t CACHE_MTBDD_SUPPORT           = (46LL<<40);
 static const uint64_t CACHE_MTBDD_COMPOSE           = (47LL<<40);
 static const uint64_t CACHE_MTBDD_EQUAL_NORM        = (48LL<<40);
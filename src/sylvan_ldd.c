@@ -19,27 +19,37 @@
 
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
 #include <string.h>
+#include <time.h>
 
 #include <avl.h>
 #include <sylvan_refs.h>
+#include <sylvan_packed.h>
+#include <sylvan_writer.h>
 #include <sha2.h>
 
 /**
  * Implementation of garbage collection
  */
 
+/* Mark the node of <mdd> as 'in use' and obtain its children for the marking engine */
+static int
+lddmc_gc_mark_visit(uint64_t mdd, uint64_t *children)
+{
+    if (mdd <= lddmc_true) return 0;
+
+    if (!llmsset_mark(nodes, mdd)) return 0;
+    mddnode_t n = LDD_GETNODE(mdd);
+    children[0] = mddnode_getright(n);
+    children[1] = mddnode_getdown(n);
+    return 2;
+}
+
 /* Recursively mark MDD nodes as 'in use' */
 VOID_TASK_IMPL_1(lddmc_gc_mark_rec, MDD, mdd)
 {
-    if (mdd <= lddmc_true) return;
-
-    if (llmsset_mark(nodes, mdd)) {
-        mddnode_t n = LDD_GETNODE(mdd);
-        SPAWN(lddmc_gc_mark_rec, mddnode_getright(n));
-        CALL(lddmc_gc_mark_rec, mddnode_getdown(n));
-        SYNC(lddmc_gc_mark_rec);
-    }
+    sylvan_gc_mark_dd(lddmc_gc_mark_visit, mdd);
 }
 
 /**
@@ -71,6 +81,12 @@ lddmc_count_refs()
     return refs_count(&lddmc_refs);
 }
 
+void
+lddmc_set_deferred_refs(int deferred)
+{
+    refs_set_deferred(&lddmc_refs, deferred);
+}
+
 void
 lddmc_protect(MDD *a)
 {
@@ -94,9 +110,30 @@ lddmc_count_protected(void)
     return protect_count(&lddmc_protected);
 }
 
+uint64_t *
+lddmc_handle_get(MDD *ptr)
+{
+    return handles_get((uint64_t)(size_t)ptr | HANDLES_LDD);
+}
+
+void
+lddmc_handle_put(uint64_t *handle)
+{
+    handles_put(handle);
+}
+
+size_t
+lddmc_count_handles(void)
+{
+    return handles_count(HANDLES_LDD);
+}
+
 /* Called during garbage collection */
 VOID_TASK_0(lddmc_gc_mark_external_refs)
 {
+    // apply the buffered changes of the deferred mode
+    if (lddmc_refs.refs_deferred) refs_flush(&lddmc_refs);
+
     // iterate through refs hash table, mark all found
     size_t count=0;
     uint64_t *it = refs_iter(&lddmc_refs, 0, lddmc_refs.refs_size);
@@ -124,199 +161,86 @@ VOID_TASK_0(lddmc_gc_mark_protected)
     }
 }
 
-/* Infrastructure for internal markings */
-typedef struct lddmc_refs_task
-{
-    Task *t;
-    void *f;
-} *lddmc_refs_task_t;
-
-typedef struct lddmc_refs_internal
-{
-    const MDD **pbegin, **pend, **pcur;
-    MDD *rbegin, *rend, *rcur;
-    lddmc_refs_task_t sbegin, send, scur;
-} *lddmc_refs_internal_t;
-
-DECLARE_THREAD_LOCAL(lddmc_refs_key, lddmc_refs_internal_t);
-
-VOID_TASK_2(lddmc_refs_mark_p_par, const MDD**, begin, size_t, count)
+VOID_TASK_1(lddmc_gc_mark_handles_chunk, handles_chunk_t*, chunk)
 {
-    if (count < 32) {
-        while (count) {
-            CALL(lddmc_gc_mark_rec, **(begin++));
-            count--;
-        }
-    } else {
-        SPAWN(lddmc_refs_mark_p_par, begin, count / 2);
-        CALL(lddmc_refs_mark_p_par, begin + (count / 2), count - count / 2);
-        SYNC(lddmc_refs_mark_p_par);
+    size_t count=0;
+    for (int i=0; i<HANDLES_CHUNK_SIZE; i++) {
+        uint64_t h = chunk->slots[i];
+        if (HANDLES_TYPE(h) != HANDLES_LDD) continue;
+        SPAWN(lddmc_gc_mark_rec, *(MDD*)(size_t)(h & ~(uint64_t)7));
+        count++;
     }
-}
-
-VOID_TASK_2(lddmc_refs_mark_r_par, MDD*, begin, size_t, count)
-{
-    if (count < 32) {
-        while (count) {
-            CALL(lddmc_gc_mark_rec, *begin++);
-            count--;
-        }
-    } else {
-        SPAWN(lddmc_refs_mark_r_par, begin, count / 2);
-        CALL(lddmc_refs_mark_r_par, begin + (count / 2), count - count / 2);
-        SYNC(lddmc_refs_mark_r_par);
+    while (count--) {
+        SYNC(lddmc_gc_mark_rec);
     }
 }
 
-VOID_TASK_2(lddmc_refs_mark_s_par, lddmc_refs_task_t, begin, size_t, count)
+VOID_TASK_0(lddmc_gc_mark_handles)
 {
-    if (count < 32) {
-        while (count) {
-            Task *t = begin->t;
-            if (!TASK_IS_STOLEN(t)) return;
-            if (t->f == begin->f && TASK_IS_COMPLETED(t)) {
-                CALL(lddmc_gc_mark_rec, *(BDD*)TASK_RESULT(t));
-            }
-            begin += 1;
-            count -= 1;
-        }
-    } else {
-        if (!TASK_IS_STOLEN(begin->t)) return;
-        SPAWN(lddmc_refs_mark_s_par, begin, count / 2);
-        CALL(lddmc_refs_mark_s_par, begin + (count / 2), count - count / 2);
-        SYNC(lddmc_refs_mark_s_par);
+    // mark the handles of every chunk in parallel
+    size_t count=0;
+    for (handles_chunk_t *chunk = handles_chunks(); chunk != NULL; chunk = chunk->next) {
+        SPAWN(lddmc_gc_mark_handles_chunk, chunk);
+        count++;
+    }
+    while (count--) {
+        SYNC(lddmc_gc_mark_handles_chunk);
     }
 }
 
-VOID_TASK_0(lddmc_refs_mark_task)
-{
-    LOCALIZE_THREAD_LOCAL(lddmc_refs_key, lddmc_refs_internal_t);
-    SPAWN(lddmc_refs_mark_p_par, lddmc_refs_key->pbegin, lddmc_refs_key->pcur-lddmc_refs_key->pbegin);
-    SPAWN(lddmc_refs_mark_r_par, lddmc_refs_key->rbegin, lddmc_refs_key->rcur-lddmc_refs_key->rbegin);
-    CALL(lddmc_refs_mark_s_par, lddmc_refs_key->sbegin, lddmc_refs_key->scur-lddmc_refs_key->sbegin);
-    SYNC(lddmc_refs_mark_r_par);
-    SYNC(lddmc_refs_mark_p_par);
-}
-
+/* Infrastructure for internal markings, see sylvan_refs.h */
 VOID_TASK_0(lddmc_refs_mark)
 {
-    TOGETHER(lddmc_refs_mark_task);
-}
-
-void
-lddmc_refs_init_key(void)
-{
-    assert(lace_is_worker()); // only use inside Lace workers
-    lddmc_refs_internal_t s = (lddmc_refs_internal_t)malloc(sizeof(struct lddmc_refs_internal));
-    s->pcur = s->pbegin = (const MDD**)malloc(sizeof(MDD*) * 1024);
-    s->pend = s->pbegin + 1024;
-    s->rcur = s->rbegin = (MDD*)malloc(sizeof(MDD) * 1024);
-    s->rend = s->rbegin + 1024;
-    s->scur = s->sbegin = (lddmc_refs_task_t)malloc(sizeof(struct lddmc_refs_task) * 1024);
-    s->send = s->sbegin + 1024;
-    SET_THREAD_LOCAL(lddmc_refs_key, s);
-}
-
-VOID_TASK_0(lddmc_refs_init_task)
-{
-    lddmc_refs_init_key();
+    refs_mark(REFS_LDD, TASK(lddmc_gc_mark_rec));
 }
 
-VOID_TASK_0(lddmc_refs_init)
+static void
+lddmc_refs_init(void)
 {
-    INIT_THREAD_LOCAL(lddmc_refs_key);
-    TOGETHER(lddmc_refs_init_task);
-    sylvan_gc_add_mark(TASK(lddmc_refs_mark));
+    refs_init(REFS_LDD);
+    sylvan_gc_add_mark_named(TASK(lddmc_refs_mark), "lddmc_refs_mark");
 }
 
 void
-lddmc_refs_ptrs_up(lddmc_refs_internal_t lddmc_refs_key)
-{
-    size_t size = lddmc_refs_key->pend - lddmc_refs_key->pbegin;
-    lddmc_refs_key->pbegin = (const MDD**)realloc(lddmc_refs_key->pbegin, sizeof(MDD*) * size * 2);
-    lddmc_refs_key->pcur = lddmc_refs_key->pbegin + size;
-    lddmc_refs_key->pend = lddmc_refs_key->pbegin + (size * 2);
-}
-
-MDD __attribute__((noinline))
-lddmc_refs_refs_up(lddmc_refs_internal_t lddmc_refs_key, MDD res)
-{
-    long size = lddmc_refs_key->rend - lddmc_refs_key->rbegin;
-    lddmc_refs_key->rbegin = (MDD*)realloc(lddmc_refs_key->rbegin, sizeof(MDD) * size * 2);
-    lddmc_refs_key->rcur = lddmc_refs_key->rbegin + size;
-    lddmc_refs_key->rend = lddmc_refs_key->rbegin + (size * 2);
-    return res;
-}
-
-void __attribute__((noinline))
-lddmc_refs_tasks_up(lddmc_refs_internal_t lddmc_refs_key)
-{
-    long size = lddmc_refs_key->send - lddmc_refs_key->sbegin;
-    lddmc_refs_key->sbegin = (lddmc_refs_task_t)realloc(lddmc_refs_key->sbegin, sizeof(struct lddmc_refs_task) * size * 2);
-    lddmc_refs_key->scur = lddmc_refs_key->sbegin + size;
-    lddmc_refs_key->send = lddmc_refs_key->sbegin + (size * 2);
-}
-
-void __attribute__((unused))
 lddmc_refs_pushptr(const MDD *ptr)
 {
-    LOCALIZE_THREAD_LOCAL(lddmc_refs_key, lddmc_refs_internal_t);
-    if (lddmc_refs_key == 0) {
-        lddmc_refs_init_key();
-        lddmc_refs_pushptr(ptr);
-    } else {
-        *lddmc_refs_key->pcur++ = ptr;
-        if (lddmc_refs_key->pcur == lddmc_refs_key->pend) lddmc_refs_ptrs_up(lddmc_refs_key);
-    }
+    refs_stack_push(refs_stack(REFS_LDD, REFS_PTRS), (uint64_t)(size_t)ptr);
 }
 
-void __attribute__((unused))
+void
 lddmc_refs_popptr(size_t amount)
 {
-    LOCALIZE_THREAD_LOCAL(lddmc_refs_key, lddmc_refs_internal_t);
-    lddmc_refs_key->pcur -= amount;
+    refs_stack_pop(refs_stack(REFS_LDD, REFS_PTRS), amount);
 }
 
-MDD __attribute__((unused))
-lddmc_refs_push(MDD lddmc)
+MDD
+lddmc_refs_push(MDD dd)
 {
-    LOCALIZE_THREAD_LOCAL(lddmc_refs_key, lddmc_refs_internal_t);
-    if (lddmc_refs_key == 0) {
-        lddmc_refs_init_key();
-        return lddmc_refs_push(lddmc);
-    } else {
-        *(lddmc_refs_key->rcur++) = lddmc;
-        if (lddmc_refs_key->rcur == lddmc_refs_key->rend) return lddmc_refs_refs_up(lddmc_refs_key, lddmc);
-        else return lddmc;
-    }
+    refs_stack_push(refs_stack(REFS_LDD, REFS_VALUES), dd);
+    return dd;
 }
 
-void __attribute__((unused))
+void
 lddmc_refs_pop(long amount)
 {
-    LOCALIZE_THREAD_LOCAL(lddmc_refs_key, lddmc_refs_internal_t);
-    lddmc_refs_key->rcur -= amount;
+    refs_stack_pop(refs_stack(REFS_LDD, REFS_VALUES), amount);
 }
 
-void __attribute__((unused))
+void
 lddmc_refs_spawn(Task *t)
 {
-    LOCALIZE_THREAD_LOCAL(lddmc_refs_key, lddmc_refs_internal_t);
-    lddmc_refs_key->scur->t = t;
-    lddmc_refs_key->scur->f = t->f;
-    lddmc_refs_key->scur += 1;
-    if (lddmc_refs_key->scur == lddmc_refs_key->send) lddmc_refs_tasks_up(lddmc_refs_key);
+    refs_stack_push2(refs_stack(REFS_LDD, REFS_TASKS), (uint64_t)(size_t)t, (uint64_t)(size_t)t->f);
 }
 
-MDD __attribute__((unused))
+MDD
 lddmc_refs_sync(MDD result)
 {
-    LOCALIZE_THREAD_LOCAL(lddmc_refs_key, lddmc_refs_internal_t);
-    lddmc_refs_key->scur -= 1;
+    refs_stack_pop(refs_stack(REFS_LDD, REFS_TASKS), 2);
     return result;
 }
 
 VOID_TASK_DECL_0(lddmc_gc_mark_serialize);
+VOID_TASK_DECL_0(lddmc_gc_mark_readers);
 
 /**
  * Initialize and quit functions
@@ -332,9 +256,11 @@ void
 sylvan_init_ldd()
 {
     sylvan_register_quit(lddmc_quit);
-    sylvan_gc_add_mark(TASK(lddmc_gc_mark_external_refs));
-    sylvan_gc_add_mark(TASK(lddmc_gc_mark_protected));
-    sylvan_gc_add_mark(TASK(lddmc_gc_mark_serialize));
+    sylvan_gc_add_mark_named(TASK(lddmc_gc_mark_external_refs), "lddmc_gc_mark_external_refs");
+    sylvan_gc_add_mark_named(TASK(lddmc_gc_mark_protected), "lddmc_gc_mark_protected");
+    sylvan_gc_add_mark_named(TASK(lddmc_gc_mark_handles), "lddmc_gc_mark_handles");
+    sylvan_gc_add_mark_named(TASK(lddmc_gc_mark_serialize), "lddmc_gc_mark_serialize");
+    sylvan_gc_add_mark_named(TASK(lddmc_gc_mark_readers), "lddmc_gc_mark_readers");
 
     refs_create(&lddmc_refs, 1024);
     if (!lddmc_protected_created) {
@@ -342,7 +268,7 @@ sylvan_init_ldd()
         lddmc_protected_created = 1;
     }
 
-    RUN(lddmc_refs_init);
+    lddmc_refs_init();
 }
 
 /**
@@ -1636,6 +1562,173 @@ TASK_IMPL_4(MDD, lddmc_join, MDD, a, MDD, b, MDD, a_proj, MDD, b_proj)
     return result;
 }
 
+/**
+ * Saturation: the relations sorted on their first read or written variable,
+ * with the meta of every relation from that variable on.
+ * Every call to lddmc_saturate gets a unique id, which is part of the cache key.
+ */
+typedef struct lddmc_saturate_ctx
+{
+    MDD *relations;
+    MDD *topmetas;
+    uint32_t *first;
+    size_t count;
+    uint64_t id;
+} *lddmc_saturate_ctx_t;
+
+static _Atomic(uint64_t) lddmc_saturate_next_id = 0;
+
+TASK_4(MDD, lddmc_saturate_rec, MDD, set, size_t, idx, uint32_t, depth, lddmc_saturate_ctx_t, ctx)
+{
+    /* Terminal cases */
+    if (set == lddmc_false) return lddmc_false;
+    if (idx == ctx->count) return set;
+
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(LDD_SATURATE);
+
+    /* Consult cache */
+    MDD result;
+    const MDD _set = set;
+    if (cache_get3(CACHE_MDD_SATURATE, _set, idx, ctx->id, &result)) {
+        sylvan_stats_count(LDD_SATURATE_CACHED);
+        return result;
+    }
+    lddmc_refs_pushptr(&_set);
+
+    const uint32_t var = ctx->first[idx];
+    if (set == lddmc_true || depth >= var) {
+        /* Find the relations of this level */
+        size_t next = idx+1;
+        while (next < ctx->count && ctx->first[next] == var) next++;
+
+        /* Until fixpoint: saturate the lower levels, then chain-apply this level once */
+        MDD prev = lddmc_false;
+        lddmc_refs_pushptr(&set);
+        lddmc_refs_pushptr(&prev);
+        while (prev != set) {
+            prev = set;
+            set = CALL(lddmc_saturate_rec, set, next, depth, ctx);
+            for (size_t i=idx; i<next; i++) {
+                set = CALL(lddmc_relprod_union, set, ctx->relations[i], ctx->topmetas[i], set);
+            }
+        }
+        lddmc_refs_popptr(2);
+        result = set;
+    } else {
+        /* Recursive computation */
+        lddmc_refs_spawn(SPAWN(lddmc_saturate_rec, lddmc_getright(set), idx, depth, ctx));
+        MDD down = lddmc_refs_push(CALL(lddmc_saturate_rec, lddmc_getdown(set), idx, depth+1, ctx));
+        MDD right = lddmc_refs_sync(SYNC(lddmc_saturate_rec));
+        lddmc_refs_pop(1);
+        result = lddmc_makenode(lddmc_getvalue(set), down, right);
+    }
+
+    /* Store in cache */
+    if (cache_put3(CACHE_MDD_SATURATE, _set, idx, ctx->id, result)) sylvan_stats_count(LDD_SATURATE_CACHEDPUT);
+    lddmc_refs_popptr(1);
+    return result;
+}
+
+TASK_IMPL_4(MDD, lddmc_saturate, MDD, states, const MDD*, relations, const MDD*, metas, size_t, count)
+{
+    struct lddmc_saturate_ctx ctx;
+    ctx.relations = (MDD*)malloc(sizeof(MDD) * (count > 0 ? count : 1));
+    ctx.topmetas = (MDD*)malloc(sizeof(MDD) * (count > 0 ? count : 1));
+    ctx.first = (uint32_t*)malloc(sizeof(uint32_t) * (count > 0 ? count : 1));
+    ctx.count = 0;
+    ctx.id = atomic_fetch_add(&lddmc_saturate_next_id, 1);
+
+    /* Sort the relations on their first variable (stable insertion sort) */
+    for (size_t i=0; i<count; i++) {
+        /* Skip the variables that are not in the relation (meta 0) */
+        MDD topmeta = metas[i];
+        uint32_t first = 0;
+        while (topmeta > lddmc_true && lddmc_getvalue(topmeta) == 0) {
+            topmeta = lddmc_getdown(topmeta);
+            first++;
+        }
+        /* A relation that reads and writes no variables adds no states, like lddmc_relprod_union */
+        if (topmeta <= lddmc_true || lddmc_getvalue(topmeta) == (uint32_t)-1) continue;
+        size_t j = ctx.count++;
+        while (j > 0 && ctx.first[j-1] > first) {
+            ctx.relations[j] = ctx.relations[j-1];
+            ctx.topmetas[j] = ctx.topmetas[j-1];
+            ctx.first[j] = ctx.first[j-1];
+            j--;
+        }
+        ctx.relations[j] = relations[i];
+        ctx.topmetas[j] = topmeta;
+        ctx.first[j] = first;
+    }
+
+    MDD result = CALL(lddmc_saturate_rec, states, 0, 0, &ctx);
+
+    free(ctx.relations);
+    free(ctx.topmetas);
+    free(ctx.first);
+    return result;
+}
+
+/**
+ * Compute the union of the images of <front> for the given relations, minus <visited>.
+ * Every image is reduced to its new states as soon as it is computed, so the merge tree
+ * only unites new states and no separate minus phase follows.
+ */
+TASK_5(MDD, lddmc_reachable_step, MDD, front, MDD, visited, const MDD*, relations, const MDD*, metas, size_t, count)
+{
+    if (count == 0) return lddmc_false;
+    if (count == 1) {
+        MDD image = lddmc_refs_push(CALL(lddmc_relprod, front, relations[0], metas[0]));
+        MDD result = CALL(lddmc_minus, image, visited);
+        lddmc_refs_pop(1);
+        return result;
+    }
+
+    lddmc_refs_spawn(SPAWN(lddmc_reachable_step, front, visited, relations, metas, count/2));
+    MDD right = lddmc_refs_push(CALL(lddmc_reachable_step, front, visited, relations+count/2, metas+count/2, count-count/2));
+    MDD left = lddmc_refs_push(lddmc_refs_sync(SYNC(lddmc_reachable_step)));
+    MDD result = CALL(lddmc_union, left, right);
+    lddmc_refs_pop(2);
+    return result;
+}
+
+static uint64_t
+lddmc_reachable_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+TASK_IMPL_6(MDD, lddmc_reachable, MDD, states, const MDD*, relations, const MDD*, metas, size_t, count, lddmc_reachable_cb, cb, void*, context)
+{
+    MDD visited = states;
+    MDD front = states;
+    lddmc_refs_pushptr(&visited);
+    lddmc_refs_pushptr(&front);
+
+    sylvan_timer_start(LDD_REACHABLE_TIME);
+    size_t level = 0;
+    while (front != lddmc_false) {
+        uint64_t t = lddmc_reachable_time();
+        sylvan_timer_start(LDD_REACHABLE_LEVEL_TIME);
+        front = CALL(lddmc_reachable_step, front, visited, relations, metas, count);
+        visited = CALL(lddmc_union, visited, front);
+        sylvan_timer_stop(LDD_REACHABLE_LEVEL_TIME);
+        sylvan_stats_count(LDD_REACHABLE_LEVELS);
+        level++;
+        if (cb != NULL) WRAP(cb, level, visited, front, lddmc_reachable_time() - t, context);
+    }
+    sylvan_timer_stop(LDD_REACHABLE_TIME);
+
+    lddmc_refs_popptr(2);
+    return visited;
+}
+
 // so: proj: -2 (end; quantify rest), -1 (end; keep rest), 0 (quantify), 1 (keep)
 TASK_IMPL_2(MDD, lddmc_project, const MDD, mdd, const MDD, proj)
 {
@@ -2546,7 +2639,16 @@ lddmc_serialize_tofile(FILE *out)
     assert(count >= lddmc_ser_done);
     assert(count == lddmc_ser_counter-2);
     count -= lddmc_ser_done;
-    fwrite(&count, sizeof(size_t), 1, out);
+
+    /* In the packed format, nodes are varints with references relative to the node */
+    sylvan_packed_out_t p = NULL;
+    sylvan_binary_format format = sylvan_get_binary_format();
+    if (format != SYLVAN_BINARY_RAW) {
+        p = sylvan_packed_out_open(out, format == SYLVAN_BINARY_PACKED_ZLIB);
+        sylvan_packed_put(p, count);
+    } else {
+        fwrite(&count, sizeof(size_t), 1, out);
+    }
 
     struct lddmc_ser *s;
     avl_iter_t *it = lddmc_ser_reversed_iter(lddmc_ser_reversed_set);
@@ -2567,39 +2669,70 @@ lddmc_serialize_tofile(FILE *out)
         struct mddnode node;
         uint64_t right = lddmc_serialize_get(mddnode_getright(n));
         uint64_t down = lddmc_serialize_get(mddnode_getdown(n));
-        if (mddnode_getcopy(n)) mddnode_makecopy(&node, right, down);
-        else mddnode_make(&node, mddnode_getvalue(n), right, down);
 
         assert(right <= index);
         assert(down <= index);
 
+        if (p != NULL) {
+            sylvan_packed_put(p, ((uint64_t)mddnode_getvalue(n) << 1) | (mddnode_getcopy(n) ? 1 : 0));
+            sylvan_packed_put(p, sylvan_packed_ref(s->assigned, right, 2));
+            sylvan_packed_put(p, sylvan_packed_ref(s->assigned, down, 2));
+            continue;
+        }
+
+        if (mddnode_getcopy(n)) mddnode_makecopy(&node, right, down);
+        else mddnode_make(&node, mddnode_getvalue(n), right, down);
+
         fwrite(&node, sizeof(struct mddnode), 1, out);
     }
 
+    if (p != NULL) sylvan_packed_out_close(p);
     lddmc_ser_done = lddmc_ser_counter-2;
     lddmc_ser_reversed_iter_free(it);
 }
 
-void
+int
 lddmc_serialize_fromfile(FILE *in)
 {
     size_t count, i;
-    if (fread(&count, sizeof(size_t), 1, in) != 1) {
-        // TODO FIXME return error
-        printf("sylvan_serialize_fromfile: file format error, giving up\n");
-        exit(-1);
+    if (fread(&count, sizeof(size_t), 1, in) != 1) return -1;
+
+    sylvan_packed_in_t p = NULL;
+    if (sylvan_packed_is_magic(count)) {
+        uint64_t c;
+        p = sylvan_packed_in_open(in);
+        if (p == NULL) return -1;
+        if (sylvan_packed_get(p, &c) != 0) {
+            sylvan_packed_in_close(p);
+            return -1;
+        }
+        count = c;
     }
 
     for (i=1; i<=count; i++) {
         struct mddnode node;
-        if (fread(&node, sizeof(struct mddnode), 1, in) != 1) {
-            // TODO FIXME return error
-            printf("sylvan_serialize_fromfile: file format error, giving up\n");
-            exit(-1);
+        if (p != NULL) {
+            /* decode the node, which gets number lddmc_ser_done+2 */
+            const uint64_t number = lddmc_ser_done+2;
+            uint64_t value, right, down;
+            if (sylvan_packed_get(p, &value) != 0 || sylvan_packed_get(p, &right) != 0 ||
+                    sylvan_packed_get(p, &down) != 0 ||
+                    (right = sylvan_packed_deref(number, right, 2)) == (uint64_t)-1 ||
+                    (down = sylvan_packed_deref(number, down, 2)) == (uint64_t)-1) {
+                sylvan_packed_in_close(p);
+                return -1;
+            }
+            if (value & 1) mddnode_makecopy(&node, right, down);
+            else mddnode_make(&node, (uint32_t)(value >> 1), right, down);
+        } else if (fread(&node, sizeof(struct mddnode), 1, in) != 1) {
+            return -1;
         }
 
-        assert(mddnode_getright(&node) <= lddmc_ser_done+1);
-        assert(mddnode_getdown(&node) <= lddmc_ser_done+1);
+        /* nodes only refer to earlier nodes */
+        if (mddnode_getright(&node) > lddmc_ser_done+1 || mddnode_getdown(&node) > lddmc_ser_done+1) {
+            if (p != NULL) sylvan_packed_in_close(p);
+            return -1;
+        }
 
         MDD right = lddmc_serialize_get_reversed(mddnode_getright(&node));
         MDD down = lddmc_serialize_get_reversed(mddnode_getdown(&node));
@@ -2613,6 +2746,9 @@ lddmc_serialize_fromfile(FILE *in)
         lddmc_ser_insert(&lddmc_ser_set, &s);
         lddmc_ser_reversed_insert(&lddmc_ser_reversed_set, &s);
     }
+
+    if (p != NULL && sylvan_packed_in_close(p) != 0) return -1;
+    return 0;
 }
 
 VOID_TASK_IMPL_0(lddmc_gc_mark_serialize)
@@ -2626,6 +2762,396 @@ VOID_TASK_IMPL_0(lddmc_gc_mark_serialize)
     }
 }
 
+/**
+ * Writing LDDs in binary format using the parallel writer
+ *
+ * The right edge of an LDD node goes to a node of the same variable, so the nodes are
+ * numbered by height instead of by variable. The height is computed by a parallel
+ * recursion after marking, and stored by position in the writer.
+ */
+
+typedef struct lddmc_writer_ctx {
+    sylvan_writer_t w;
+    _Atomic(uint32_t) *heights;
+    uint32_t max;
+} lddmc_writer_ctx;
+
+static uint32_t
+lddmc_writer_level(uint64_t index, void *ctx)
+{
+    lddmc_writer_ctx *c = (lddmc_writer_ctx*)ctx;
+    uint64_t pos = sylvan_writer_position(c->w, index);
+    return c->max - atomic_load_explicit(c->heights + pos, memory_order_relaxed);
+}
+
+VOID_TASK_2(lddmc_writer_mark, MDD, dd, sylvan_writer_t, w)
+{
+    if (dd <= lddmc_true || !sylvan_writer_mark(w, dd)) return;
+    mddnode_t n = LDD_GETNODE(dd);
+    SPAWN(lddmc_writer_mark, mddnode_getright(n), w);
+    CALL(lddmc_writer_mark, mddnode_getdown(n), w);
+    SYNC(lddmc_writer_mark);
+}
+
+TASK_2(uint32_t, lddmc_writer_height, MDD, dd, lddmc_writer_ctx*, ctx)
+{
+    if (dd <= lddmc_true) return 0;
+    _Atomic(uint32_t) *h = ctx->heights + sylvan_writer_position(ctx->w, dd);
+    uint32_t res = atomic_load_explicit(h, memory_order_relaxed);
+    if (res != 0) return res;
+    mddnode_t n = LDD_GETNODE(dd);
+    SPAWN(lddmc_writer_height, mddnode_getright(n), ctx);
+    uint32_t down = CALL(lddmc_writer_height, mddnode_getdown(n), ctx);
+    uint32_t right = SYNC(lddmc_writer_height);
+    res = 1 + (down > right ? down : right);
+    atomic_store_explicit(h, res, memory_order_relaxed);
+    return res;
+}
+
+VOID_TASK_IMPL_3(lddmc_writer_number, sylvan_writer_t, w, const MDD*, dds, size_t, count)
+{
+    for (size_t i=0; i<count; i++) SPAWN(lddmc_writer_mark, dds[i], w);
+    for (size_t i=0; i<count; i++) SYNC(lddmc_writer_mark);
+    CALL(sylvan_writer_index, w);
+
+    lddmc_writer_ctx ctx;
+    ctx.w = w;
+    ctx.heights = (_Atomic(uint32_t)*)calloc(sylvan_writer_count(w) + 1, sizeof(uint32_t));
+    ctx.max = 0;
+    for (size_t i=0; i<count; i++) SPAWN(lddmc_writer_height, dds[i], &ctx);
+    for (size_t i=0; i<count; i++) {
+        uint32_t h = SYNC(lddmc_writer_height);
+        if (h > ctx.max) ctx.max = h;
+    }
+    CALL(sylvan_writer_number, w, lddmc_writer_level, &ctx);
+    free(ctx.heights);
+}
+
+/**
+ * Translate an LDD to its identifier in the block: node <n> is stored as <n>+1
+ */
+static inline uint64_t
+lddmc_writer_ref(sylvan_writer_t w, MDD dd)
+{
+    return dd <= lddmc_true ? dd : sylvan_writer_get(w, dd) + 1;
+}
+
+VOID_TASK_4(lddmc_writer_encode, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    for (size_t i=0; i<count; i++) {
+        mddnode_t n = LDD_GETNODE(sylvan_writer_getr(w, first+i));
+        mddnode_t r = (mddnode_t)(buf + 16*i);
+        uint64_t right = lddmc_writer_ref(w, mddnode_getright(n));
+        uint64_t down = lddmc_writer_ref(w, mddnode_getdown(n));
+        if (mddnode_getcopy(n)) mddnode_makecopy(r, right, down);
+        else mddnode_make(r, mddnode_getvalue(n), right, down);
+    }
+}
+
+/**
+ * Encode nodes for the packed format: (value << 1 | copy) and the relative right and down edges
+ */
+TASK_4(size_t, lddmc_writer_encode_packed, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    uint8_t *ptr = buf;
+    for (size_t i=0; i<count; i++) {
+        const uint64_t id = first+i+1;
+        mddnode_t n = LDD_GETNODE(sylvan_writer_getr(w, first+i));
+        ptr += sylvan_packed_encode(ptr, ((uint64_t)mddnode_getvalue(n) << 1) | mddnode_getcopy(n));
+        ptr += sylvan_packed_encode(ptr, sylvan_packed_ref(id, lddmc_writer_ref(w, mddnode_getright(n)), 2));
+        ptr += sylvan_packed_encode(ptr, sylvan_packed_ref(id, lddmc_writer_ref(w, mddnode_getdown(n)), 2));
+    }
+    return ptr - buf;
+}
+
+VOID_TASK_IMPL_3(lddmc_writer_writenodes, FILE*, out, MDD*, dds, int, count)
+{
+    sylvan_writer_t w = sylvan_writer_alloc();
+    CALL(lddmc_writer_number, w, dds, count > 0 ? (size_t)count : 0);
+
+    size_t nodecount = sylvan_writer_count(w);
+    sylvan_binary_format format = sylvan_get_binary_format();
+    if (format != SYLVAN_BINARY_RAW) {
+        sylvan_packed_out_t p = sylvan_packed_out_open(out, format == SYLVAN_BINARY_PACKED_ZLIB);
+        sylvan_packed_put(p, nodecount);
+        CALL(sylvan_packed_write_nodes, p, w, 1, nodecount, 3*SYLVAN_PACKED_MAX_VARINT, TASK(lddmc_writer_encode_packed));
+        sylvan_packed_out_close(p);
+    } else {
+        fwrite(&nodecount, sizeof(size_t), 1, out);
+        CALL(sylvan_writer_write, w, out, 1, nodecount, TASK(lddmc_writer_encode));
+    }
+
+    for (int i=0; i<count; i++) dds[i] = lddmc_writer_ref(w, dds[i]);
+    sylvan_writer_free(w);
+}
+
+VOID_TASK_IMPL_3(lddmc_writer_tobinary, FILE*, out, MDD*, dds, int, count)
+{
+    uint64_t *ids = (uint64_t*)malloc(sizeof(uint64_t) * (count > 0 ? count : 1));
+    for (int i=0; i<count; i++) ids[i] = dds[i];
+    CALL(lddmc_writer_writenodes, out, ids, count);
+    fwrite(&count, sizeof(int), 1, out);
+    if (count > 0) fwrite(ids, sizeof(uint64_t), count, out);
+    free(ids);
+}
+
+/**
+ * Reading LDDs in binary format
+ *
+ * Every active reader is registered in a list, so the nodes that were already inserted
+ * survive garbage collection.
+ */
+
+/* Number of nodes per task when inserting a level in parallel */
+#define LDDMC_READER_NODES_PER_TASK 1024
+
+struct lddmc_reader {
+    struct lddmc_reader *prev, *next;
+    uint64_t *arr;          // arr[i] is the LDD with identifier i+2
+    size_t count;           // number of identifiers inserted
+    size_t size;            // size of arr
+    struct mddnode *block;  // nodes read but not yet inserted, with identifiers count+2...
+    size_t block_count;     // number of nodes in block
+    size_t block_size;      // size of block
+    int defer;              // only insert the nodes in lddmc_reader_flush
+};
+
+static lddmc_reader_t lddmc_readers = NULL;
+static pthread_mutex_t lddmc_readers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+lddmc_reader_t
+lddmc_reader_start()
+{
+    lddmc_reader_t r = (lddmc_reader_t)malloc(sizeof(struct lddmc_reader));
+    r->prev = NULL;
+    r->arr = NULL;
+    r->count = 0;
+    r->size = 0;
+    r->block = NULL;
+    r->block_count = 0;
+    r->block_size = 0;
+    r->defer = 0;
+    pthread_mutex_lock(&lddmc_readers_lock);
+    r->next = lddmc_readers;
+    if (r->next != NULL) r->next->prev = r;
+    lddmc_readers = r;
+    pthread_mutex_unlock(&lddmc_readers_lock);
+    return r;
+}
+
+void
+lddmc_reader_end(lddmc_reader_t r)
+{
+    pthread_mutex_lock(&lddmc_readers_lock);
+    if (r->prev != NULL) r->prev->next = r->next;
+    else lddmc_readers = r->next;
+    if (r->next != NULL) r->next->prev = r->prev;
+    pthread_mutex_unlock(&lddmc_readers_lock);
+    free(r->arr);
+    free(r->block);
+    free(r);
+}
+
+void
+lddmc_reader_defer(lddmc_reader_t r)
+{
+    r->defer = 1;
+}
+
+MDD
+lddmc_reader_get(lddmc_reader_t r, uint64_t identifier)
+{
+    if (identifier <= lddmc_true) return identifier;
+    if (identifier - 2 >= r->count) return lddmc_false;
+    return r->arr[identifier - 2];
+}
+
+VOID_TASK_3(lddmc_gc_mark_reader, lddmc_reader_t, r, size_t, first, size_t, count)
+{
+    if (count > LDDMC_READER_NODES_PER_TASK) {
+        SPAWN(lddmc_gc_mark_reader, r, first, count/2);
+        CALL(lddmc_gc_mark_reader, r, first+count/2, count-count/2);
+        SYNC(lddmc_gc_mark_reader);
+        return;
+    }
+    for (size_t i=first; i<first+count; i++) CALL(lddmc_gc_mark_rec, r->arr[i]);
+}
+
+VOID_TASK_IMPL_0(lddmc_gc_mark_readers)
+{
+    pthread_mutex_lock(&lddmc_readers_lock);
+    for (lddmc_reader_t r = lddmc_readers; r != NULL; r = r->next) {
+        CALL(lddmc_gc_mark_reader, r, 0, r->count);
+    }
+    pthread_mutex_unlock(&lddmc_readers_lock);
+}
+
+/**
+ * Insert the nodes <order[0]>...<order[count-1]> of the block, which all have the same height.
+ * The node at position <i> of the block gets identifier <base>+<i>+2.
+ */
+VOID_TASK_5(lddmc_reader_insert_par, lddmc_reader_t, r, const struct mddnode*, block, const uint64_t*, order, size_t, count, size_t, base)
+{
+    if (count > LDDMC_READER_NODES_PER_TASK) {
+        SPAWN(lddmc_reader_insert_par, r, block, order, count/2, base);
+        CALL(lddmc_reader_insert_par, r, block, order+count/2, count-count/2, base);
+        SYNC(lddmc_reader_insert_par);
+        return;
+    }
+
+    for (size_t i=0; i<count; i++) {
+        const mddnode_t n = (mddnode_t)(block + order[i]);
+        MDD right = lddmc_reader_get(r, mddnode_getright(n));
+        MDD down = lddmc_reader_get(r, mddnode_getdown(n));
+        if (mddnode_getcopy(n)) r->arr[base + order[i]] = lddmc_make_copynode(down, right);
+        else r->arr[base + order[i]] = lddmc_makenode(mddnode_getvalue(n), down, right);
+    }
+}
+
+/**
+ * Read <count> nodes in the packed format to <block>
+ */
+static int
+lddmc_reader_readpacked(sylvan_packed_in_t p, struct mddnode *block, size_t count, size_t base)
+{
+    for (size_t i=0; i<count; i++) {
+        const uint64_t id = base+i+2;
+        uint64_t value, right, down;
+        if (sylvan_packed_get(p, &value) != 0) return -1;
+        if (sylvan_packed_get(p, &right) != 0) return -1;
+        if (sylvan_packed_get(p, &down) != 0) return -1;
+        right = sylvan_packed_deref(id, right, 2);
+        down = sylvan_packed_deref(id, down, 2);
+        if (right == (uint64_t)-1 || down == (uint64_t)-1) return -1;
+        if (value & 1) mddnode_makecopy(block+i, right, down);
+        else mddnode_make(block+i, (uint32_t)(value >> 1), right, down);
+    }
+    return 0;
+}
+
+TASK_IMPL_2(int, lddmc_reader_readbinary, lddmc_reader_t, r, FILE*, in)
+{
+    size_t count;
+    if (fread(&count, sizeof(size_t), 1, in) != 1) return -1;
+
+    sylvan_packed_in_t p = NULL;
+    if (sylvan_packed_is_magic(count)) {
+        p = sylvan_packed_in_open(in);
+        if (p == NULL) return -1;
+        uint64_t c;
+        if (sylvan_packed_get(p, &c) != 0) c = (uint64_t)-1;
+        count = c;
+    }
+    if (count > ((uint64_t)1 << 40)) {
+        if (p != NULL) sylvan_packed_in_close(p);
+        return -1;
+    }
+
+    /* Append the nodes to the block of nodes that are not yet inserted */
+    const size_t base = r->count + r->block_count;
+    if (r->block_count + count > r->block_size) {
+        size_t size = r->block_size == 0 ? 1024 : r->block_size;
+        while (size < r->block_count + count) size *= 2;
+        r->block = (struct mddnode*)realloc(r->block, sizeof(struct mddnode) * size);
+        r->block_size = size;
+    }
+    struct mddnode *block = r->block + r->block_count;
+    if (p != NULL) {
+        int res = lddmc_reader_readpacked(p, block, count, base);
+        if (sylvan_packed_in_close(p) != 0 || res != 0) return -1;
+    } else {
+        if (fread(block, sizeof(struct mddnode), count, in) != count) return -1;
+    }
+
+    /* Check the references */
+    for (size_t i=0; i<count; i++) {
+        const uint64_t id = base+i+2;
+        const uint64_t right = mddnode_getright(block+i);
+        const uint64_t down = mddnode_getdown(block+i);
+        if (right >= id || down >= id || right == lddmc_true) return -1;
+    }
+    r->block_count += count;
+
+    if (!r->defer) CALL(lddmc_reader_flush, r);
+    return 0;
+}
+
+VOID_TASK_IMPL_1(lddmc_reader_flush, lddmc_reader_t, r)
+{
+    const size_t count = r->block_count;
+    const size_t base = r->count;
+    struct mddnode *block = r->block;
+    if (count == 0) return;
+
+    /* Compute the height of every node in the block */
+    uint32_t *heights = (uint32_t*)malloc(sizeof(uint32_t) * count);
+    uint32_t max = 0;
+    for (size_t i=0; i<count; i++) {
+        const uint64_t right = mddnode_getright(block+i);
+        const uint64_t down = mddnode_getdown(block+i);
+        uint32_t hr = right >= base+2 ? heights[right-base-2] : 0;
+        uint32_t hd = down >= base+2 ? heights[down-base-2] : 0;
+        heights[i] = 1 + (hr > hd ? hr : hd);
+        if (heights[i] > max) max = heights[i];
+    }
+
+    /* Counting sort on the height */
+    uint64_t *start = (uint64_t*)calloc((size_t)max + 2, sizeof(uint64_t));
+    uint64_t *order = (uint64_t*)malloc(sizeof(uint64_t) * count);
+    for (size_t i=0; i<count; i++) start[heights[i]+1]++;
+    for (size_t h=1; h<=(size_t)max+1; h++) start[h] += start[h-1];
+    for (size_t i=0; i<count; i++) order[start[heights[i]]++] = i;
+    free(heights);
+
+    /* Make room for the new identifiers */
+    pthread_mutex_lock(&lddmc_readers_lock);
+    if (r->count + count > r->size) {
+        size_t size = r->size == 0 ? 1024 : r->size;
+        while (size < r->count + count) size *= 2;
+        r->arr = (uint64_t*)realloc(r->arr, sizeof(uint64_t) * size);
+        r->size = size;
+    }
+    memset(r->arr + r->count, 0, sizeof(uint64_t) * count);
+    r->count += count;
+    pthread_mutex_unlock(&lddmc_readers_lock);
+
+    /* Insert the nodes height by height (start[h-1] is now the end of height h) */
+    for (size_t h=1; h<=max; h++) {
+        CALL(lddmc_reader_insert_par, r, block, order + start[h-1], start[h] - start[h-1], base);
+    }
+
+    free(order);
+    free(start);
+    r->block_count = 0;
+}
+
+TASK_IMPL_3(int, lddmc_reader_frombinary, FILE*, in, MDD*, dds, int, count)
+{
+    lddmc_reader_t r = lddmc_reader_start();
+    if (CALL(lddmc_reader_readbinary, r, in) != 0) {
+        lddmc_reader_end(r);
+        return -1;
+    }
+
+    int actual_count;
+    if (fread(&actual_count, sizeof(int), 1, in) != 1 || actual_count != count) {
+        lddmc_reader_end(r);
+        return -1;
+    }
+
+    for (int i=0; i<count; i++) {
+        uint64_t v;
+        if (fread(&v, sizeof(uint64_t), 1, in) != 1 || (v > lddmc_true && v - 2 >= r->count)) {
+            lddmc_reader_end(r);
+            return -1;
+        }
+        dds[i] = lddmc_reader_get(r, v);
+    }
+
+    lddmc_reader_end(r);
+    return 0;
+}
+
 static void
 lddmc_sha2_rec(MDD mdd, SHA256_CTX *ctx)
 {
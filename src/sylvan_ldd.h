@@ -90,6 +90,43 @@ void lddmc_deref(MDD dd);
  */
 size_t lddmc_count_refs(void);
 
+/**
+ * Turn the deferred mode of the values table on or off, while no thread uses lddmc_ref and lddmc_deref.
+ * In the deferred mode, lddmc_ref and lddmc_deref only update a small buffer of the current thread,
+ * where a ref and a deref of the same MDD cancel out. The buffers of all threads are applied to
+ * the table when they are full, by garbage collection and by lddmc_count_refs. This avoids contention
+ * on the table when many threads ref and deref. It is off by default.
+ */
+void lddmc_set_deferred_refs(int deferred);
+
+/**
+ * Handles are a cheaper alternative to the pointers table for short-lived variables,
+ * such as the C++ Ldd objects. See mtbdd_handle_get.
+ */
+
+/**
+ * Take a handle that protects the variable at <ptr> (which must be 8-byte aligned).
+ */
+uint64_t *lddmc_handle_get(MDD* ptr);
+
+/**
+ * Let the handle protect the variable at <ptr> instead.
+ */
+static inline void lddmc_handle_set(uint64_t *handle, MDD* ptr)
+{
+    *handle = (uint64_t)(size_t)ptr | HANDLES_LDD;
+}
+
+/**
+ * Return the handle, the variable is no longer protected.
+ */
+void lddmc_handle_put(uint64_t *handle);
+
+/**
+ * Compute the number of LDD handles in use.
+ */
+size_t lddmc_count_handles(void);
+
 /**
  * Call mtbdd_gc_mark_rec for every mtbdd you want to keep in your custom mark functions.
  */
@@ -131,6 +168,34 @@ TASK_DECL_3(MDD, lddmc_relprod, MDD, MDD, MDD);
 TASK_DECL_4(MDD, lddmc_relprod_union, MDD, MDD, MDD, MDD);
 #define lddmc_relprod_union(a, b, meta, un) RUN(lddmc_relprod_union, a, b, meta, un)
 
+/**
+ * Compute the states reachable from <states> with the partitioned relation <relations>
+ * using (parallel) saturation.
+ * Every relation <relations>[i] is applied as in lddmc_relprod with the meta <metas>[i].
+ * The relations are grouped on their first read or written variable (event locality) and
+ * saturated bottom-up, i.e., a group is only applied when all lower groups are saturated.
+ * The relations may be given in any order. Relations of which the meta reads and writes no
+ * variables (for example lddmc_true) add no states and are skipped.
+ */
+TASK_DECL_4(MDD, lddmc_saturate, MDD, const MDD*, const MDD*, size_t);
+#define lddmc_saturate(states, relations, metas, count) RUN(lddmc_saturate, states, relations, metas, count)
+
+/**
+ * Compute the states reachable from <states> with the partitioned relation <relations>
+ * using breadth-first search. Every relation is applied as in lddmc_relprod with <metas>[i].
+ * Every level, the images of all relations are computed in parallel, every image is reduced
+ * to its new states (minus the visited states) as soon as it is available, and every two
+ * results are merged as soon as both are available. The union of the merge tree is the new
+ * frontier, without a barrier between the image, minus and union phases.
+ * If <cb> is not NULL, it is called after every level with the level number, the visited
+ * states, the new frontier, the time spent on the level (in ns) and <context>.
+ * The number of levels, the total time and the time of every level (with its histogram) are
+ * also reported in the statistics.
+ */
+LACE_TYPEDEF_CB(void, lddmc_reachable_cb, size_t, MDD, MDD, uint64_t, void*);
+TASK_DECL_6(MDD, lddmc_reachable, MDD, const MDD*, const MDD*, size_t, lddmc_reachable_cb, void*);
+#define lddmc_reachable(states, relations, metas, count, cb, context) RUN(lddmc_reachable, states, relations, metas, count, cb, context)
+
 /**
  * Calculate all predecessors to a in uni according to rel[proj]
  * <proj> follows the same semantics as relprod
@@ -244,7 +309,8 @@ TASK_DECL_4(MDD, lddmc_compose, MDD, lddmc_compose_cb, void*, int);
  * use lddmc_serialize_tofile
  *
  * LOADING:
- * use lddmc_serialize_fromfile (implies lddmc_serialize_reset)
+ * use lddmc_serialize_fromfile (implies lddmc_serialize_reset), which returns 0 if successful
+ * or -1 if the file is not valid; then the nodes read so far are in the table
  * use lddmc_serialize_get_reversed for every key
  *
  * MISC:
@@ -260,7 +326,104 @@ MDD lddmc_serialize_get_reversed(size_t value);
 void lddmc_serialize_reset(void);
 void lddmc_serialize_totext(FILE *out);
 void lddmc_serialize_tofile(FILE *out);
-void lddmc_serialize_fromfile(FILE *in);
+int lddmc_serialize_fromfile(FILE *in);
+
+/**
+ * Writing LDDs to file, without global state.
+ *
+ * The binary writer marks the nodes in parallel and numbers them by height (following
+ * both the down and the right edges), so every node only refers to nodes with a lower
+ * number; the nodes are then encoded in parallel and written in large chunks.
+ * Nodes are written as a block in the same format as lddmc_serialize_tofile, that is,
+ * the identifiers of the nodes start at 2, while lddmc_false and lddmc_true are 0 and 1.
+ * The format of the block is selected with sylvan_set_binary_format.
+ *
+ * - call lddmc_writer_tobinary to store LDDs in binary format.
+ * - OR:  lddmc_writer_writenodes to write one block with the nodes of several LDDs, and
+ *        store their identifiers yourself, e.g. in different places of the file.
+ */
+
+/**
+ * Write <count> decision diagrams given in <dds> in binary form to <file>.
+ *
+ * The format is as follows, to store <count> decision diagrams...
+ * a block of nodes, as written by lddmc_writer_writenodes
+ * int32_t: count -- number of stored decision diagrams
+ * <count> times uint64_t: each stored decision diagram
+ */
+VOID_TASK_DECL_3(lddmc_writer_tobinary, FILE*, MDD*, int);
+#define lddmc_writer_tobinary(file, dds, count) RUN(lddmc_writer_tobinary, file, dds, count)
+
+/**
+ * Write a block with all nodes of the <count> decision diagrams in <dds> to <file>,
+ * and replace every decision diagram in <dds> by its identifier in the block.
+ * The identifiers of every block start at 2, so only the first block written to a file
+ * can be read back with lddmc_serialize_fromfile or lddmc_reader_readbinary.
+ */
+VOID_TASK_DECL_3(lddmc_writer_writenodes, FILE*, MDD*, int);
+#define lddmc_writer_writenodes(file, dds, count) RUN(lddmc_writer_writenodes, file, dds, count)
+
+/**
+ * Reading LDDs from file (binary format).
+ *
+ * The function lddmc_reader_frombinary is the reverse of lddmc_writer_tobinary.
+ *
+ * One can also perform the procedure manually.
+ * - call lddmc_reader_start to allocate a reader
+ * - call lddmc_reader_readbinary to read a block of nodes from file
+ * - call lddmc_reader_get to obtain the LDD for the given identifier as stored in the file.
+ * - call lddmc_reader_end to free the reader
+ *
+ * The identifiers of every block continue after those of the blocks read earlier by the
+ * same reader, so a reader also reads files written with lddmc_serialize_tofile.
+ * Every block is inserted in parallel, by height. Readers do not share any state, and the
+ * LDDs of a reader are kept during garbage collection until lddmc_reader_end.
+ */
+
+/**
+ * Read <count> decision diagrams to <dds> from <file> in binary form.
+ * Returns 0 if successful, -1 otherwise.
+ */
+TASK_DECL_3(int, lddmc_reader_frombinary, FILE*, MDD*, int);
+#define lddmc_reader_frombinary(file, dds, count) RUN(lddmc_reader_frombinary, file, dds, count)
+
+typedef struct lddmc_reader *lddmc_reader_t;
+
+/**
+ * Allocate a reader.
+ */
+lddmc_reader_t lddmc_reader_start(void);
+
+/**
+ * Read the next block of nodes from <file>.
+ * Returns 0 if successful, -1 if the block is not valid.
+ */
+TASK_DECL_2(int, lddmc_reader_readbinary, lddmc_reader_t, FILE*);
+#define lddmc_reader_readbinary(reader, file) RUN(lddmc_reader_readbinary, reader, file)
+
+/**
+ * From now on, lddmc_reader_readbinary only reads the nodes, and they are inserted by
+ * lddmc_reader_flush. This inserts many small blocks (such as the transition relations
+ * of a model) in one parallel pass instead of one pass per block.
+ */
+void lddmc_reader_defer(lddmc_reader_t reader);
+
+/**
+ * Insert the nodes that were read since the last flush.
+ */
+VOID_TASK_DECL_1(lddmc_reader_flush, lddmc_reader_t);
+#define lddmc_reader_flush(reader) RUN(lddmc_reader_flush, reader)
+
+/**
+ * Retrieve the LDD of the given stored identifier, or lddmc_false if the identifier
+ * was not read or not inserted yet.
+ */
+MDD lddmc_reader_get(lddmc_reader_t reader, uint64_t identifier);
+
+/**
+ * Free the reader.
+ */
+void lddmc_reader_end(lddmc_reader_t reader);
 
 /**
  * Infrastructure for internal references.
@@ -109,4 +109,12 @@ mddnode_makecopy(mddnode_t n, uint64_t right, uint64_t down)
     n->b = ((down << 1) | 1) << 16;
 }
 
+/**
+ * Mark all nodes of the <count> LDDs in <dds> in the writer and number them by height,
+ * such that every node only refers to nodes with a lower number.
+ * Used by lddmc_writer_writenodes and lddmc_dump.
+ */
+struct sylvan_writer;
+VOID_TASK_DECL_3(lddmc_writer_number, struct sylvan_writer*, const MDD*, size_t);
+
 #endif
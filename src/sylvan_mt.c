@@ -16,6 +16,7 @@
  */
 
 #include <sylvan_int.h> // for llmsset*, nodes, sylvan_register_quit
+#include <sylvan_align.h>
 
 #include <inttypes.h>
 #include <string.h>
@@ -24,6 +25,46 @@
  * Handling of custom leaves "registry"
  */
 
+/**
+ * Leaf stores
+ *
+ * Every type with a custom hash function has a leaf store with the canonical values of its leaves,
+ * obtained with the create callback. The leaf nodes in the nodes table hold the canonical value,
+ * so they are found with the ordinary hash and comparison, without calling the callbacks.
+ *
+ * The store is an array of slots with a hash index (linear probing, 24 bits of the hash and 40 bits
+ * of the slot plus one). Every slot records the leaf node of its value in MTBDDs and in ZDDs. After
+ * garbage collection, the values of which no leaf node is marked are destroyed in one parallel pass,
+ * which also rebuilds the list of free slots, and the index is cleared and refilled with the live
+ * slots. Between garbage collections, slots are only taken from the list, so popping it with
+ * compare-and-swap has no ABA problem.
+ *
+ * The store starts with STORE_MIN_SIZE slots. At garbage collection, it grows to at least twice the
+ * number of live values, but never beyond the size of the nodes table, which bounds the number of
+ * leaf nodes. It does not shrink, as slots that are being created may not move.
+ */
+
+#define STORE_DEAD      ((uint64_t)-1)                  // node of a free slot
+#define STORE_MASK_SLOT ((uint64_t)0x000000ffffffffff)
+#define STORE_MASK_HASH ((uint64_t)0xffffff0000000000)
+#define STORE_MIN_SIZE  ((size_t)1024)
+
+typedef struct leafslot
+{
+    uint64_t value;                 // the canonical value, or the next free slot plus one
+    uint64_t hash;                  // the hash of the value
+    _Atomic(uint64_t) node[2];      // the leaf node of the value in MTBDDs and in ZDDs, or 0
+} leafslot_t;
+
+typedef struct leafstore
+{
+    leafslot_t *slots;              // array of <size> slots
+    _Atomic(uint64_t) *index;       // hash index of <size> buckets
+    size_t size;                    // power of 2, at most the size of the nodes table
+    _Atomic(size_t) count;          // number of slots taken from the end of the array
+    _Atomic(uint64_t) free;         // first free slot plus one, or 0
+} *leafstore_t;
+
 typedef struct
 {
     sylvan_mt_hash_cb hash_cb;
@@ -33,58 +74,259 @@ typedef struct
     sylvan_mt_to_str_cb to_str_cb;
     sylvan_mt_write_binary_cb write_binary_cb;
     sylvan_mt_read_binary_cb read_binary_cb;
+    _Atomic(leafstore_t) store;
 } customleaf_t;
 
 static customleaf_t *cl_registry;
 static size_t cl_registry_count;
 static size_t cl_registry_size;
 
+static void*
+store_alloc(size_t size)
+{
+    void *res = alloc_aligned(size);
+    if (res == 0) {
+        fprintf(stderr, "sylvan_mt: Unable to allocate memory for the leaf store!\n");
+        exit(1);
+    }
+    return res;
+}
+
 /**
- * Implementation of hooks for llmsset
+ * The size of the leaf store for <live> values, capped by the current size of the nodes table
  */
+static size_t
+store_size(size_t live)
+{
+    size_t max = 1;
+    while (max < llmsset_get_size(nodes)) max <<= 1;
+    size_t size = STORE_MIN_SIZE;
+    while (size < max && size < 2*live) size <<= 1;
+    return size < max ? size : max;
+}
 
 /**
- * Internal helper function
+ * Get the leaf store of <c>, create it for the first leaf of the type
  */
-static inline customleaf_t*
-sylvan_mt_from_node(uint64_t a, uint64_t b)
+static leafstore_t
+store_get(customleaf_t *c)
 {
-    uint32_t type = a & 0xffffffff;
-    assert(type < cl_registry_count);
-    return cl_registry + type;
-    (void)b;
+    leafstore_t s = atomic_load_explicit(&c->store, memory_order_acquire);
+    if (s != NULL) return s;
+
+    s = (leafstore_t)calloc(1, sizeof(struct leafstore));
+    if (s == NULL) {
+        fprintf(stderr, "sylvan_mt: Unable to allocate memory for the leaf store!\n");
+        exit(1);
+    }
+    s->size = store_size(0);
+    s->slots = (leafslot_t*)store_alloc(s->size * sizeof(leafslot_t));
+    s->index = (_Atomic(uint64_t)*)store_alloc(s->size * sizeof(uint64_t));
+
+    leafstore_t expected = NULL;
+    if (atomic_compare_exchange_strong(&c->store, &expected, s)) return s;
+
+    // another thread created the store first
+    free_aligned(s->slots, s->size * sizeof(leafslot_t));
+    free_aligned(s->index, s->size * sizeof(uint64_t));
+    free(s);
+    return expected;
 }
 
-static void
-_sylvan_create_cb(uint64_t *a, uint64_t *b)
+/**
+ * Take a free slot, or return STORE_DEAD if the store is full
+ */
+static uint64_t
+store_claim(leafstore_t s)
 {
-    customleaf_t *c = sylvan_mt_from_node(*a, *b);
-    if (c->create_cb != NULL) c->create_cb(b);
+    uint64_t head = atomic_load_explicit(&s->free, memory_order_acquire);
+    while (head != 0) {
+        if (atomic_compare_exchange_weak(&s->free, &head, s->slots[head-1].value)) return head-1;
+    }
+    size_t slot = atomic_fetch_add(&s->count, 1);
+    return slot < s->size ? slot : STORE_DEAD;
 }
 
+/**
+ * Insert <slot> into the hash index; only during garbage collection
+ */
 static void
-_sylvan_destroy_cb(uint64_t a, uint64_t b)
+store_index_insert(leafstore_t s, uint64_t slot)
 {
-    // for leaf
-    customleaf_t *c = sylvan_mt_from_node(a, b);
-    if (c->destroy_cb != NULL) c->destroy_cb(b);
+    const uint64_t hash = s->slots[slot].hash;
+    const uint64_t v = (hash & STORE_MASK_HASH) | (slot + 1);
+    for (uint64_t idx = hash & (s->size - 1);; idx = (idx + 1) & (s->size - 1)) {
+        uint64_t zero = 0;
+        if (atomic_compare_exchange_strong(s->index + idx, &zero, v)) return;
+    }
 }
 
-static uint64_t
-_sylvan_hash_cb(uint64_t a, uint64_t b, uint64_t seed)
+uint64_t
+sylvan_mt_store_find(uint32_t type, uint64_t *value)
 {
-    customleaf_t *c = sylvan_mt_from_node(a, b);
-    if (c->hash_cb != NULL) return c->hash_cb(b, seed ^ a);
-    else return sylvan_tabhash16(a, b, seed);
+    assert(type < cl_registry_count);
+    customleaf_t *c = cl_registry + type;
+    leafstore_t s = store_get(c);
+
+    const uint64_t hash = c->hash_cb(*value, 14695981039346656037LLU);
+    const uint64_t tag = hash & STORE_MASK_HASH;
+    uint64_t slot = STORE_DEAD;
+
+    uint64_t idx = hash & (s->size - 1);
+    for (size_t probes = 0; probes < s->size; probes++, idx = (idx + 1) & (s->size - 1)) {
+        _Atomic(uint64_t) *bucket = s->index + idx;
+        uint64_t v = atomic_load_explicit(bucket, memory_order_acquire);
+
+        if (v == 0) {
+            if (slot == STORE_DEAD) {
+                // claim a slot and create the canonical value
+                slot = store_claim(s);
+                if (slot == STORE_DEAD) return 0;
+                leafslot_t *sl = s->slots + slot;
+                sl->value = *value;
+                if (c->create_cb != NULL) c->create_cb(&sl->value);
+                sl->hash = hash;
+                atomic_store_explicit(&sl->node[0], 0, memory_order_relaxed);
+                atomic_store_explicit(&sl->node[1], 0, memory_order_relaxed);
+            }
+            if (atomic_compare_exchange_strong(bucket, &v, tag | (slot + 1))) {
+                *value = s->slots[slot].value;
+                return slot + 1;
+            }
+            // another thread inserted a value in this bucket, compare with it
+        }
+
+        if ((v & STORE_MASK_HASH) == tag) {
+            const uint64_t other = (v & STORE_MASK_SLOT) - 1;
+            const uint64_t other_value = s->slots[other].value;
+            if (c->equals_cb != NULL ? c->equals_cb(*value, other_value) : *value == other_value) {
+                if (slot != STORE_DEAD) {
+                    // another thread inserted an equal value first, give back our slot
+                    if (c->destroy_cb != NULL) c->destroy_cb(s->slots[slot].value);
+                    atomic_store_explicit(&s->slots[slot].node[0], STORE_DEAD, memory_order_relaxed);
+                }
+                *value = other_value;
+                return other + 1;
+            }
+        }
+    }
+
+    if (slot != STORE_DEAD) {
+        if (c->destroy_cb != NULL) c->destroy_cb(s->slots[slot].value);
+        atomic_store_explicit(&s->slots[slot].node[0], STORE_DEAD, memory_order_relaxed);
+    }
+    return 0;
 }
 
-static int
-_sylvan_equals_cb(uint64_t a, uint64_t b, uint64_t aa, uint64_t bb)
+void
+sylvan_mt_store_set_node(uint32_t type, uint64_t slot, int kind, uint64_t index)
 {
-    if (a != aa) return 0;
-    customleaf_t *c = sylvan_mt_from_node(a, b);
-    if (c->equals_cb != NULL) return c->equals_cb(b, bb);
-    else return b == bb ? 1 : 0;
+    leafstore_t s = atomic_load_explicit(&cl_registry[type].store, memory_order_relaxed);
+    atomic_store_explicit(&s->slots[slot-1].node[kind], index, memory_order_relaxed);
+}
+
+/**
+ * Destroy the values of <c> in the slots <first> to <first+count> without marked leaf nodes
+ * and link the free slots into the free list. Returns the number of live slots.
+ */
+TASK_3(size_t, store_sweep_par, customleaf_t*, c, size_t, first, size_t, count)
+{
+    if (count > 1024) {
+        size_t split = count/2;
+        SPAWN(store_sweep_par, c, first, split);
+        size_t live = CALL(store_sweep_par, c, first + split, count - split);
+        return live + SYNC(store_sweep_par);
+    }
+
+    leafstore_t s = atomic_load_explicit(&c->store, memory_order_relaxed);
+    uint64_t head = 0, tail = 0;
+    size_t live = 0;
+    for (size_t k=first; k<first+count; k++) {
+        leafslot_t *sl = s->slots + k;
+        uint64_t n0 = atomic_load_explicit(&sl->node[0], memory_order_relaxed);
+        uint64_t n1 = atomic_load_explicit(&sl->node[1], memory_order_relaxed);
+        if (n0 != STORE_DEAD) {
+            // a slot without leaf nodes is still being created, keep it
+            const int pending = n0 == 0 && n1 == 0;
+            if (n0 != 0 && !llmsset_is_marked(nodes, n0)) n0 = 0;
+            if (n1 != 0 && !llmsset_is_marked(nodes, n1)) n1 = 0;
+            if (pending || n0 != 0 || n1 != 0) {
+                atomic_store_explicit(&sl->node[0], n0, memory_order_relaxed);
+                atomic_store_explicit(&sl->node[1], n1, memory_order_relaxed);
+                live++;
+                continue;
+            }
+            if (c->destroy_cb != NULL) c->destroy_cb(sl->value);
+            atomic_store_explicit(&sl->node[0], STORE_DEAD, memory_order_relaxed);
+        }
+        // link the free slot
+        sl->value = head;
+        head = k + 1;
+        if (tail == 0) tail = head;
+    }
+
+    if (head != 0) {
+        uint64_t old = atomic_load_explicit(&s->free, memory_order_relaxed);
+        do {
+            s->slots[tail-1].value = old;
+        } while (!atomic_compare_exchange_weak(&s->free, &old, head));
+    }
+
+    return live;
+}
+
+/**
+ * Insert the live slots <first> to <first+count> of <c> into the (cleared) hash index.
+ */
+VOID_TASK_3(store_index_par, customleaf_t*, c, size_t, first, size_t, count)
+{
+    if (count > 1024) {
+        size_t split = count/2;
+        SPAWN(store_index_par, c, first, split);
+        CALL(store_index_par, c, first + split, count - split);
+        SYNC(store_index_par);
+        return;
+    }
+
+    leafstore_t s = atomic_load_explicit(&c->store, memory_order_relaxed);
+    for (size_t k=first; k<first+count; k++) {
+        if (atomic_load_explicit(&s->slots[k].node[0], memory_order_relaxed) != STORE_DEAD) store_index_insert(s, k);
+    }
+}
+
+/**
+ * After garbage collection, sweep the leaf stores, grow them for their live values and rebuild
+ * their indexes.
+ */
+VOID_TASK_0(sylvan_mt_gc)
+{
+    for (size_t type=0; type<cl_registry_count; type++) {
+        customleaf_t *c = cl_registry + type;
+        leafstore_t s = atomic_load_explicit(&c->store, memory_order_relaxed);
+        if (s == NULL) continue;
+
+        size_t count = atomic_load_explicit(&s->count, memory_order_relaxed);
+        if (count > s->size) count = s->size;
+        atomic_store_explicit(&s->count, count, memory_order_relaxed);
+
+        atomic_store_explicit(&s->free, 0, memory_order_relaxed);
+        const size_t live = CALL(store_sweep_par, c, 0, count);
+
+        const size_t size = store_size(live);
+        if (size > s->size) {
+            leafslot_t *slots = (leafslot_t*)store_alloc(size * sizeof(leafslot_t));
+            memcpy(slots, s->slots, count * sizeof(leafslot_t));
+            free_aligned(s->slots, s->size * sizeof(leafslot_t));
+            s->slots = slots;
+            free_aligned(s->index, s->size * sizeof(uint64_t));
+            s->index = (_Atomic(uint64_t)*)store_alloc(size * sizeof(uint64_t));
+            s->size = size;
+        } else {
+            memset(s->index, 0, s->size * sizeof(uint64_t));
+        }
+
+        CALL(store_index_par, c, 0, count);
+    }
 }
 
 uint32_t
@@ -153,6 +395,14 @@ sylvan_mt_quit()
     if (mt_initialized == 0) return;
     mt_initialized = 0;
 
+    for (size_t type=0; type<cl_registry_count; type++) {
+        leafstore_t s = cl_registry[type].store;
+        if (s == NULL) continue;
+        free_aligned(s->slots, s->size * sizeof(leafslot_t));
+        free_aligned(s->index, s->size * sizeof(uint64_t));
+        free(s);
+    }
+
     free(cl_registry);
     cl_registry = NULL;
     cl_registry_count = 0;
@@ -168,8 +418,8 @@ sylvan_init_mt()
     // Register quit handler to free structures
     sylvan_register_quit(sylvan_mt_quit);
 
-    // Tell llmsset to use our custom hooks
-    llmsset_set_custom(nodes, _sylvan_hash_cb, _sylvan_equals_cb, _sylvan_create_cb, _sylvan_destroy_cb);
+    // Destroy the values of dead leaves after garbage collection
+    sylvan_gc_hook_postgc(TASK(sylvan_mt_gc));
 
     // Initialize data structures
     cl_registry_size = 8;
@@ -259,3 +509,15 @@ sylvan_mt_read_binary(uint32_t type, uint64_t *value, FILE *in)
     if (c->read_binary_cb != NULL) return c->read_binary_cb(in, value);
     else return 0;
 }
+
+int
+sylvan_mt_skip_binary(uint32_t type, FILE *in)
+{
+    assert(type < cl_registry_count);
+    customleaf_t *c = cl_registry + type;
+    if (c->read_binary_cb == NULL) return 0;
+    uint64_t value;
+    if (c->read_binary_cb(in, &value) != 0) return -1;
+    if (c->destroy_cb != NULL) c->destroy_cb(value);
+    return 0;
+}
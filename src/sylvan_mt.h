@@ -57,6 +57,10 @@ extern "C" {
  * If the 64-byte value is also already a canonical representation, then the functions
  * hash, equals, create and destroy should be set to NULL.
  *
+ * Types with a hash function have a leaf store with the canonical values, obtained with create.
+ * The leaf nodes hold the canonical value, and the store destroys a value after the first garbage
+ * collection in which no leaf node of the value is marked.
+ *
  * Two values are equal (with equals) iff they have the same hash (with hash)
  *
  * A value v obtained due to create must be equal to the original value (with equals):
@@ -123,6 +127,29 @@ int sylvan_mt_write_binary(uint32_t type, uint64_t value, FILE *out);
  */
 int sylvan_mt_read_binary(uint32_t type, uint64_t *value, FILE *in);
 
+/**
+ * Skip a leaf in binary form, without creating the leaf (calls the read_binary callback of type
+ * and destroys the value that was read with the destroy callback).
+ */
+int sylvan_mt_skip_binary(uint32_t type, FILE *in);
+
+/* For internal use: the leaf stores of the types with a custom hash */
+#define SYLVAN_MT_STORE_MTBDD 0
+#define SYLVAN_MT_STORE_ZDD 1
+
+/**
+ * Replace <value> by its canonical value in the leaf store of <type>, which is created with the
+ * create callback if the store has no equal value yet. Returns the slot of the value (not 0),
+ * or 0 if the leaf store is full; then run garbage collection and try again.
+ */
+uint64_t sylvan_mt_store_find(uint32_t type, uint64_t *value);
+
+/**
+ * Record the leaf node <index> of the value in <slot>, for MTBDDs or ZDDs (SYLVAN_MT_STORE_*).
+ * The value is destroyed by the first garbage collection in which its leaf nodes are not marked.
+ */
+void sylvan_mt_store_set_node(uint32_t type, uint64_t slot, int kind, uint64_t index);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -19,10 +19,14 @@
 
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
+#include <stddef.h>
 #include <string.h>
 
 #include <sylvan_refs.h>
 #include <sylvan_sl.h>
+#include <sylvan_writer.h>
+#include <sylvan_packed.h>
 #include <sha2.h>
 
 /* Primitives */
@@ -85,20 +89,25 @@ mtbdd_getdouble(MTBDD leaf)
  * Implementation of garbage collection
  */
 
+/* Mark the node of <mtbdd> as 'in use' and obtain its children for the marking engine */
+static int
+mtbdd_gc_mark_visit(uint64_t mtbdd, uint64_t *children)
+{
+    if (mtbdd == mtbdd_true) return 0;
+    if (mtbdd == mtbdd_false) return 0;
+
+    if (!llmsset_mark(nodes, MTBDD_STRIPMARK(mtbdd))) return 0;
+    mtbddnode_t n = MTBDD_GETNODE(mtbdd);
+    if (mtbddnode_isleaf(n)) return 0;
+    children[0] = mtbddnode_getlow(n);
+    children[1] = mtbddnode_gethigh(n);
+    return 2;
+}
+
 /* Recursively mark MDD nodes as 'in use' */
 VOID_TASK_IMPL_1(mtbdd_gc_mark_rec, MDD, mtbdd)
 {
-    if (mtbdd == mtbdd_true) return;
-    if (mtbdd == mtbdd_false) return;
-
-    if (llmsset_mark(nodes, MTBDD_STRIPMARK(mtbdd))) {
-        mtbddnode_t n = MTBDD_GETNODE(mtbdd);
-        if (!mtbddnode_isleaf(n)) {
-            SPAWN(mtbdd_gc_mark_rec, mtbddnode_getlow(n));
-            CALL(mtbdd_gc_mark_rec, mtbddnode_gethigh(n));
-            SYNC(mtbdd_gc_mark_rec);
-        }
-    }
+    sylvan_gc_mark_dd(mtbdd_gc_mark_visit, mtbdd);
 }
 
 /**
@@ -130,6 +139,12 @@ mtbdd_count_refs()
     return refs_count(&mtbdd_refs);
 }
 
+void
+mtbdd_set_deferred_refs(int deferred)
+{
+    refs_set_deferred(&mtbdd_refs, deferred);
+}
+
 void
 mtbdd_protect(MTBDD *a)
 {
@@ -153,9 +168,30 @@ mtbdd_count_protected()
     return protect_count(&mtbdd_protected);
 }
 
+uint64_t *
+mtbdd_handle_get(MTBDD *ptr)
+{
+    return handles_get((uint64_t)(size_t)ptr | HANDLES_MTBDD);
+}
+
+void
+mtbdd_handle_put(uint64_t *handle)
+{
+    handles_put(handle);
+}
+
+size_t
+mtbdd_count_handles()
+{
+    return handles_count(HANDLES_MTBDD);
+}
+
 /* Called during garbage collection */
 VOID_TASK_0(mtbdd_gc_mark_external_refs)
 {
+    // apply the buffered changes of the deferred mode
+    if (mtbdd_refs.refs_deferred) refs_flush(&mtbdd_refs);
+
     // iterate through refs hash table, mark all found
     size_t count=0;
     uint64_t *it = refs_iter(&mtbdd_refs, 0, mtbdd_refs.refs_size);
@@ -183,199 +219,86 @@ VOID_TASK_0(mtbdd_gc_mark_protected)
     }
 }
 
-/* Infrastructure for internal markings */
-typedef struct mtbdd_refs_task
-{
-    Task *t;
-    void *f;
-} *mtbdd_refs_task_t;
-
-typedef struct mtbdd_refs_internal
+VOID_TASK_1(mtbdd_gc_mark_handles_chunk, handles_chunk_t*, chunk)
 {
-    const MTBDD **pbegin, **pend, **pcur;
-    MTBDD *rbegin, *rend, *rcur;
-    mtbdd_refs_task_t sbegin, send, scur;
-} *mtbdd_refs_internal_t;
-
-DECLARE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
-
-VOID_TASK_2(mtbdd_refs_mark_p_par, const MTBDD**, begin, size_t, count)
-{
-    if (count < 32) {
-        while (count) {
-            mtbdd_gc_mark_rec(**(begin++));
-            count--;
-        }
-    } else {
-        SPAWN(mtbdd_refs_mark_p_par, begin, count / 2);
-        CALL(mtbdd_refs_mark_p_par, begin + (count / 2), count - count / 2);
-        SYNC(mtbdd_refs_mark_p_par);
+    size_t count=0;
+    for (int i=0; i<HANDLES_CHUNK_SIZE; i++) {
+        uint64_t h = chunk->slots[i];
+        if (HANDLES_TYPE(h) != HANDLES_MTBDD) continue;
+        SPAWN(mtbdd_gc_mark_rec, *(MTBDD*)(size_t)h);
+        count++;
     }
-}
-
-VOID_TASK_2(mtbdd_refs_mark_r_par, MTBDD*, begin, size_t, count)
-{
-    if (count < 32) {
-        while (count) {
-            mtbdd_gc_mark_rec(*begin++);
-            count--;
-        }
-    } else {
-        SPAWN(mtbdd_refs_mark_r_par, begin, count / 2);
-        CALL(mtbdd_refs_mark_r_par, begin + (count / 2), count - count / 2);
-        SYNC(mtbdd_refs_mark_r_par);
+    while (count--) {
+        SYNC(mtbdd_gc_mark_rec);
     }
 }
 
-VOID_TASK_2(mtbdd_refs_mark_s_par, mtbdd_refs_task_t, begin, size_t, count)
+VOID_TASK_0(mtbdd_gc_mark_handles)
 {
-    if (count < 32) {
-        while (count > 0) {
-            Task *t = begin->t;
-            if (!TASK_IS_STOLEN(t)) return;
-            if (t->f == begin->f && TASK_IS_COMPLETED(t)) {
-                mtbdd_gc_mark_rec(*(MTBDD*)TASK_RESULT(t));
-            }
-            begin += 1;
-            count -= 1;
-        }
-    } else {
-        if (!TASK_IS_STOLEN(begin->t)) return;
-        SPAWN(mtbdd_refs_mark_s_par, begin, count / 2);
-        CALL(mtbdd_refs_mark_s_par, begin + (count / 2), count - count / 2);
-        SYNC(mtbdd_refs_mark_s_par);
+    // mark the handles of every chunk in parallel
+    size_t count=0;
+    for (handles_chunk_t *chunk = handles_chunks(); chunk != NULL; chunk = chunk->next) {
+        SPAWN(mtbdd_gc_mark_handles_chunk, chunk);
+        count++;
+    }
+    while (count--) {
+        SYNC(mtbdd_gc_mark_handles_chunk);
     }
 }
 
-VOID_TASK_0(mtbdd_refs_mark_task)
-{
-    LOCALIZE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
-    SPAWN(mtbdd_refs_mark_p_par, mtbdd_refs_key->pbegin, mtbdd_refs_key->pcur-mtbdd_refs_key->pbegin);
-    SPAWN(mtbdd_refs_mark_r_par, mtbdd_refs_key->rbegin, mtbdd_refs_key->rcur-mtbdd_refs_key->rbegin);
-    CALL(mtbdd_refs_mark_s_par, mtbdd_refs_key->sbegin, mtbdd_refs_key->scur-mtbdd_refs_key->sbegin);
-    SYNC(mtbdd_refs_mark_r_par);
-    SYNC(mtbdd_refs_mark_p_par);
-}
-
+/* Infrastructure for internal markings, see sylvan_refs.h */
 VOID_TASK_0(mtbdd_refs_mark)
 {
-    TOGETHER(mtbdd_refs_mark_task);
+    refs_mark(REFS_MTBDD, TASK(mtbdd_gc_mark_rec));
 }
 
-void
-mtbdd_refs_init_key(void)
-{
-    assert(lace_is_worker()); // only use inside Lace workers
-    mtbdd_refs_internal_t s = (mtbdd_refs_internal_t)malloc(sizeof(struct mtbdd_refs_internal));
-    s->pcur = s->pbegin = (const MTBDD**)malloc(sizeof(MTBDD*) * 1024);
-    s->pend = s->pbegin + 1024;
-    s->rcur = s->rbegin = (MTBDD*)malloc(sizeof(MTBDD) * 1024);
-    s->rend = s->rbegin + 1024;
-    s->scur = s->sbegin = (mtbdd_refs_task_t)malloc(sizeof(struct mtbdd_refs_task) * 1024);
-    s->send = s->sbegin + 1024;
-    SET_THREAD_LOCAL(mtbdd_refs_key, s);
-}
-
-VOID_TASK_0(mtbdd_refs_init_task)
-{
-    mtbdd_refs_init_key();
-}
-
-VOID_TASK_0(mtbdd_refs_init)
+static void
+mtbdd_refs_init(void)
 {
-    INIT_THREAD_LOCAL(mtbdd_refs_key);
-    TOGETHER(mtbdd_refs_init_task);
-    sylvan_gc_add_mark(TASK(mtbdd_refs_mark));
+    refs_init(REFS_MTBDD);
+    sylvan_gc_add_mark_named(TASK(mtbdd_refs_mark), "mtbdd_refs_mark");
 }
 
 void
-mtbdd_refs_ptrs_up(mtbdd_refs_internal_t mtbdd_refs_key)
-{
-    size_t cur = mtbdd_refs_key->pcur - mtbdd_refs_key->pbegin;
-    size_t size = mtbdd_refs_key->pend - mtbdd_refs_key->pbegin;
-    mtbdd_refs_key->pbegin = (const MTBDD**)realloc(mtbdd_refs_key->pbegin, sizeof(MTBDD*) * size * 2);
-    mtbdd_refs_key->pcur = mtbdd_refs_key->pbegin + cur;
-    mtbdd_refs_key->pend = mtbdd_refs_key->pbegin + (size * 2);
-}
-
-MTBDD __attribute__((noinline))
-mtbdd_refs_refs_up(mtbdd_refs_internal_t mtbdd_refs_key, MTBDD res)
-{
-    long size = mtbdd_refs_key->rend - mtbdd_refs_key->rbegin;
-    mtbdd_refs_key->rbegin = (MTBDD*)realloc(mtbdd_refs_key->rbegin, sizeof(MTBDD) * size * 2);
-    mtbdd_refs_key->rcur = mtbdd_refs_key->rbegin + size;
-    mtbdd_refs_key->rend = mtbdd_refs_key->rbegin + (size * 2);
-    return res;
-}
-
-void __attribute__((noinline))
-mtbdd_refs_tasks_up(mtbdd_refs_internal_t mtbdd_refs_key)
-{
-    long size = mtbdd_refs_key->send - mtbdd_refs_key->sbegin;
-    mtbdd_refs_key->sbegin = (mtbdd_refs_task_t)realloc(mtbdd_refs_key->sbegin, sizeof(struct mtbdd_refs_task) * size * 2);
-    mtbdd_refs_key->scur = mtbdd_refs_key->sbegin + size;
-    mtbdd_refs_key->send = mtbdd_refs_key->sbegin + (size * 2);
-}
-
-void __attribute__((unused))
 mtbdd_refs_pushptr(const MTBDD *ptr)
 {
-    LOCALIZE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
-    if (mtbdd_refs_key == 0) {
-        mtbdd_refs_init_key();
-        mtbdd_refs_pushptr(ptr);
-    } else {
-        *mtbdd_refs_key->pcur++ = ptr;
-        if (mtbdd_refs_key->pcur == mtbdd_refs_key->pend) mtbdd_refs_ptrs_up(mtbdd_refs_key);
-    }
+    refs_stack_push(refs_stack(REFS_MTBDD, REFS_PTRS), (uint64_t)(size_t)ptr);
 }
 
-void __attribute__((unused))
+void
 mtbdd_refs_popptr(size_t amount)
 {
-    LOCALIZE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
-    mtbdd_refs_key->pcur -= amount;
+    refs_stack_pop(refs_stack(REFS_MTBDD, REFS_PTRS), amount);
 }
 
-MTBDD __attribute__((unused))
-mtbdd_refs_push(MTBDD mtbdd)
+MTBDD
+mtbdd_refs_push(MTBDD dd)
 {
-    LOCALIZE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
-    if (mtbdd_refs_key == 0) {
-        mtbdd_refs_init_key();
-        return mtbdd_refs_push(mtbdd);
-    } else {
-        *(mtbdd_refs_key->rcur++) = mtbdd;
-        if (mtbdd_refs_key->rcur == mtbdd_refs_key->rend) return mtbdd_refs_refs_up(mtbdd_refs_key, mtbdd);
-        else return mtbdd;
-    }
+    refs_stack_push(refs_stack(REFS_MTBDD, REFS_VALUES), dd);
+    return dd;
 }
 
-void __attribute__((unused))
+void
 mtbdd_refs_pop(long amount)
 {
-    LOCALIZE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
-    mtbdd_refs_key->rcur -= amount;
+    refs_stack_pop(refs_stack(REFS_MTBDD, REFS_VALUES), amount);
 }
 
 void
 mtbdd_refs_spawn(Task *t)
 {
-    LOCALIZE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
-    mtbdd_refs_key->scur->t = t;
-    mtbdd_refs_key->scur->f = t->f;
-    mtbdd_refs_key->scur += 1;
-    if (mtbdd_refs_key->scur == mtbdd_refs_key->send) mtbdd_refs_tasks_up(mtbdd_refs_key);
+    refs_stack_push2(refs_stack(REFS_MTBDD, REFS_TASKS), (uint64_t)(size_t)t, (uint64_t)(size_t)t->f);
 }
 
 MTBDD
 mtbdd_refs_sync(MTBDD result)
 {
-    LOCALIZE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
-    mtbdd_refs_key->scur -= 1;
+    refs_stack_pop(refs_stack(REFS_MTBDD, REFS_TASKS), 2);
     return result;
 }
 
+VOID_TASK_DECL_0(mtbdd_gc_mark_readers);
+
 /**
  * Initialize and quit functions
  */
@@ -403,8 +326,10 @@ sylvan_init_mtbdd()
     mtbdd_initialized = 1;
 
     sylvan_register_quit(mtbdd_quit);
-    sylvan_gc_add_mark(TASK(mtbdd_gc_mark_external_refs));
-    sylvan_gc_add_mark(TASK(mtbdd_gc_mark_protected));
+    sylvan_gc_add_mark_named(TASK(mtbdd_gc_mark_external_refs), "mtbdd_gc_mark_external_refs");
+    sylvan_gc_add_mark_named(TASK(mtbdd_gc_mark_protected), "mtbdd_gc_mark_protected");
+    sylvan_gc_add_mark_named(TASK(mtbdd_gc_mark_handles), "mtbdd_gc_mark_handles");
+    sylvan_gc_add_mark_named(TASK(mtbdd_gc_mark_readers), "mtbdd_gc_mark_readers");
 
     refs_create(&mtbdd_refs, 1024);
     if (!mtbdd_protected_created) {
@@ -412,12 +337,30 @@ sylvan_init_mtbdd()
         mtbdd_protected_created = 1;
     }
 
-    RUN(mtbdd_refs_init);
+    mtbdd_refs_init();
 }
 
 /**
  * Primitives
  */
+
+/**
+ * Find or create the leaf node of a type with a custom hash, which holds the canonical value
+ * from the leaf store of the type. Returns 0 if the leaf store or the nodes table is full.
+ */
+static uint64_t
+mtbdd_lookup_custom(uint32_t type, uint64_t value, int *created)
+{
+    uint64_t slot = sylvan_mt_store_find(type, &value);
+    if (slot == 0) return 0;
+
+    struct mtbddnode n;
+    mtbddnode_makeleaf(&n, type, value);
+    uint64_t index = llmsset_lookup(nodes, n.a, n.b, created);
+    if (index != 0) sylvan_mt_store_set_node(type, slot, SYLVAN_MT_STORE_MTBDD, index);
+    return index;
+}
+
 MTBDD
 mtbdd_makeleaf(uint32_t type, uint64_t value)
 {
@@ -427,11 +370,11 @@ mtbdd_makeleaf(uint32_t type, uint64_t value)
     int custom = sylvan_mt_has_custom_hash(type);
 
     int created;
-    uint64_t index = custom ? llmsset_lookupc(nodes, n.a, n.b, &created) : llmsset_lookup(nodes, n.a, n.b, &created);
+    uint64_t index = custom ? mtbdd_lookup_custom(type, value, &created) : llmsset_lookup(nodes, n.a, n.b, &created);
     if (index == 0) {
         RUN(sylvan_gc);
 
-        index = custom ? llmsset_lookupc(nodes, n.a, n.b, &created) : llmsset_lookup(nodes, n.a, n.b, &created);
+        index = custom ? mtbdd_lookup_custom(type, value, &created) : llmsset_lookup(nodes, n.a, n.b, &created);
         if (index == 0) {
             fprintf(stderr, "BDD Unique table full, %zu of %zu buckets filled!\n", llmsset_count_marked(nodes), llmsset_get_size(nodes));
             exit(1);
@@ -2109,33 +2052,22 @@ TASK_IMPL_2(MTBDD, mtbdd_greater, MTBDD, a, MTBDD, b)
 }
 
 /**
- * Multiply <a> and <b>, and abstract variables <vars> using summation.
- * This is similar to the "and_exists" operation in BDDs.
+ * Apply <apply_op> to <a> and <b>, and abstract variables <v> using <abstract_op>.
+ * The product of <a> and <b> is never constructed: the abstraction is applied on the
+ * way up, so only the (smaller) abstracted MTBDDs are created.
  */
-TASK_IMPL_3(MTBDD, mtbdd_and_abstract_plus, MTBDD, a, MTBDD, b, MTBDD, v)
+TASK_IMPL_5(MTBDD, mtbdd_and_abstract, MTBDD, a, MTBDD, b, MTBDD, v, mtbdd_apply_op, apply_op, mtbdd_abstract_op, abstract_op)
 {
     /* Check terminal case */
-    if (v == mtbdd_true) return mtbdd_apply(a, b, TASK(mtbdd_op_times));
-    MTBDD result = CALL(mtbdd_op_times, &a, &b);
+    if (v == mtbdd_true) return mtbdd_apply(a, b, apply_op);
+    MTBDD result = WRAP(apply_op, &a, &b);
     if (result != mtbdd_invalid) {
         mtbdd_refs_push(result);
-        result = mtbdd_abstract(result, v, TASK(mtbdd_abstract_op_plus));
+        result = mtbdd_abstract(result, v, abstract_op);
         mtbdd_refs_pop(1);
         return result;
     }
 
-    /* Maybe perform garbage collection */
-    sylvan_gc_test();
-
-    /* Count operation */
-    sylvan_stats_count(MTBDD_AND_ABSTRACT_PLUS);
-
-    /* Check cache */
-    if (cache_get3(CACHE_MTBDD_AND_ABSTRACT_PLUS, a, b, v, &result)) {
-        sylvan_stats_count(MTBDD_AND_ABSTRACT_PLUS_CACHED);
-        return result;
-    }
-
     /* Now, v is not a constant, and either a or b is not a constant */
 
     /* Get top variable */
@@ -2147,15 +2079,33 @@ TASK_IMPL_3(MTBDD, mtbdd_and_abstract_plus, MTBDD, a, MTBDD, b, MTBDD, v)
     uint32_t vb = lb ? 0xffffffff : mtbddnode_getvariable(nb);
     uint32_t var = va < vb ? va : vb;
 
+    /* Skip k variables that are not in <a> or <b>; these are abstracted by op(r, r, k) */
     mtbddnode_t nv = MTBDD_GETNODE(v);
     uint32_t vv = mtbddnode_getvariable(nv);
+    uint64_t k = 0;
+    while (vv < var) {
+        k++;
+        v = node_gethigh(v, nv);
+        if (v == mtbdd_true) break;
+        nv = MTBDD_GETNODE(v);
+        vv = mtbddnode_getvariable(nv);
+    }
 
-    if (vv < var) {
-        /* Recursive, then abstract result */
-        result = CALL(mtbdd_and_abstract_plus, a, b, node_gethigh(v, nv));
-        mtbdd_refs_push(result);
-        result = mtbdd_apply(result, result, TASK(mtbdd_op_plus));
-        mtbdd_refs_pop(1);
+    /* Maybe perform garbage collection */
+    sylvan_gc_test();
+
+    /* Count operation */
+    sylvan_stats_count(MTBDD_AND_ABSTRACT);
+
+    /* Check cache (the pair of operations is part of the key) */
+    uint64_t unused;
+    if (cache_get6(CACHE_MTBDD_AND_ABSTRACT | a, b, v | (k << 40), (size_t)apply_op, (size_t)abstract_op, 0, &result, &unused)) {
+        sylvan_stats_count(MTBDD_AND_ABSTRACT_CACHED);
+        return result;
+    }
+
+    if (v == mtbdd_true) {
+        result = CALL(mtbdd_apply, a, b, apply_op);
     } else {
         /* Get cofactors */
         MTBDD alow, ahigh, blow, bhigh;
@@ -2166,107 +2116,51 @@ TASK_IMPL_3(MTBDD, mtbdd_and_abstract_plus, MTBDD, a, MTBDD, b, MTBDD, v)
 
         if (vv == var) {
             /* Recursive, then abstract result */
-            mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract_plus, ahigh, bhigh, node_gethigh(v, nv)));
-            MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract_plus, alow, blow, node_gethigh(v, nv)));
-            MTBDD high = mtbdd_refs_push(mtbdd_refs_sync(SYNC(mtbdd_and_abstract_plus)));
-            result = CALL(mtbdd_apply, low, high, TASK(mtbdd_op_plus));
+            MTBDD vnext = node_gethigh(v, nv);
+            mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract, ahigh, bhigh, vnext, apply_op, abstract_op));
+            MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract, alow, blow, vnext, apply_op, abstract_op));
+            MTBDD high = mtbdd_refs_push(mtbdd_refs_sync(SYNC(mtbdd_and_abstract)));
+            result = WRAP(abstract_op, low, high, 0);
             mtbdd_refs_pop(2);
-        } else /* vv > v */ {
+        } else /* vv > var */ {
             /* Recursive, then create node */
-            mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract_plus, ahigh, bhigh, v));
-            MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract_plus, alow, blow, v));
-            MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_and_abstract_plus));
+            mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract, ahigh, bhigh, v, apply_op, abstract_op));
+            MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract, alow, blow, v, apply_op, abstract_op));
+            MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_and_abstract));
             mtbdd_refs_pop(1);
             result = mtbdd_makenode(var, low, high);
         }
     }
 
+    if (k) {
+        mtbdd_refs_push(result);
+        result = WRAP(abstract_op, result, result, k);
+        mtbdd_refs_pop(1);
+    }
+
     /* Store in cache */
-    if (cache_put3(CACHE_MTBDD_AND_ABSTRACT_PLUS, a, b, v, result)) {
-        sylvan_stats_count(MTBDD_AND_ABSTRACT_PLUS_CACHEDPUT);
+    if (cache_put6(CACHE_MTBDD_AND_ABSTRACT | a, b, v | (k << 40), (size_t)apply_op, (size_t)abstract_op, 0, result, 0)) {
+        sylvan_stats_count(MTBDD_AND_ABSTRACT_CACHEDPUT);
     }
 
     return result;
 }
 
+/**
+ * Multiply <a> and <b>, and abstract variables <vars> using summation.
+ * This is similar to the "and_exists" operation in BDDs.
+ */
+TASK_IMPL_3(MTBDD, mtbdd_and_abstract_plus, MTBDD, a, MTBDD, b, MTBDD, v)
+{
+    return CALL(mtbdd_and_abstract, a, b, v, TASK(mtbdd_op_times), TASK(mtbdd_abstract_op_plus));
+}
+
 /**
  * Multiply <a> and <b>, and abstract variables <vars> by taking the maximum.
  */
 TASK_IMPL_3(MTBDD, mtbdd_and_abstract_max, MTBDD, a, MTBDD, b, MTBDD, v)
 {
-    /* Check terminal case */
-    if (v == mtbdd_true) return mtbdd_apply(a, b, TASK(mtbdd_op_times));
-    MTBDD result = CALL(mtbdd_op_times, &a, &b);
-    if (result != mtbdd_invalid) {
-        mtbdd_refs_push(result);
-        result = mtbdd_abstract(result, v, TASK(mtbdd_abstract_op_max));
-        mtbdd_refs_pop(1);
-        return result;
-    }
-
-    /* Now, v is not a constant, and either a or b is not a constant */
-
-    /* Get top variable */
-    int la = mtbdd_isleaf(a);
-    int lb = mtbdd_isleaf(b);
-    mtbddnode_t na = la ? 0 : MTBDD_GETNODE(a);
-    mtbddnode_t nb = lb ? 0 : MTBDD_GETNODE(b);
-    uint32_t va = la ? 0xffffffff : mtbddnode_getvariable(na);
-    uint32_t vb = lb ? 0xffffffff : mtbddnode_getvariable(nb);
-    uint32_t var = va < vb ? va : vb;
-
-    mtbddnode_t nv = MTBDD_GETNODE(v);
-    uint32_t vv = mtbddnode_getvariable(nv);
-
-    while (vv < var) {
-        /* we can skip variables, because max(r,r) = r */
-        v = node_gethigh(v, nv);
-        if (v == mtbdd_true) return mtbdd_apply(a, b, TASK(mtbdd_op_times));
-        nv = MTBDD_GETNODE(v);
-        vv = mtbddnode_getvariable(nv);
-    }
-
-    /* Maybe perform garbage collection */
-    sylvan_gc_test();
-
-    /* Count operation */
-    sylvan_stats_count(MTBDD_AND_ABSTRACT_MAX);
-
-    /* Check cache */
-    if (cache_get3(CACHE_MTBDD_AND_ABSTRACT_MAX, a, b, v, &result)) {
-        sylvan_stats_count(MTBDD_AND_ABSTRACT_MAX_CACHED);
-        return result;
-    }
-
-    /* Get cofactors */
-    MTBDD alow, ahigh, blow, bhigh;
-    alow  = (!la && va == var) ? node_getlow(a, na)  : a;
-    ahigh = (!la && va == var) ? node_gethigh(a, na) : a;
-    blow  = (!lb && vb == var) ? node_getlow(b, nb)  : b;
-    bhigh = (!lb && vb == var) ? node_gethigh(b, nb) : b;
-
-    if (vv == var) {
-        /* Recursive, then abstract result */
-        mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract_max, ahigh, bhigh, node_gethigh(v, nv)));
-        MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract_max, alow, blow, node_gethigh(v, nv)));
-        MTBDD high = mtbdd_refs_push(mtbdd_refs_sync(SYNC(mtbdd_and_abstract_max)));
-        result = CALL(mtbdd_apply, low, high, TASK(mtbdd_op_max));
-        mtbdd_refs_pop(2);
-    } else /* vv > v */ {
-        /* Recursive, then create node */
-        mtbdd_refs_spawn(SPAWN(mtbdd_and_abstract_max, ahigh, bhigh, v));
-        MTBDD low = mtbdd_refs_push(CALL(mtbdd_and_abstract_max, alow, blow, v));
-        MTBDD high = mtbdd_refs_sync(SYNC(mtbdd_and_abstract_max));
-        mtbdd_refs_pop(1);
-        result = mtbdd_makenode(var, low, high);
-    }
-
-    /* Store in cache */
-    if (cache_put3(CACHE_MTBDD_AND_ABSTRACT_MAX, a, b, v, result)) {
-        sylvan_stats_count(MTBDD_AND_ABSTRACT_MAX_CACHEDPUT);
-    }
-
-    return result;
+    return CALL(mtbdd_and_abstract, a, b, v, TASK(mtbdd_op_times), TASK(mtbdd_abstract_op_max));
 }
 
 /**
@@ -3254,24 +3148,119 @@ mtbdd_writer_end(sylvan_skiplist_t sl)
     sylvan_skiplist_free(sl);
 }
 
+/**
+ * Writing MTBDD files in binary format using the parallel writer
+ */
+
+static uint32_t
+mtbdd_writer_level(uint64_t index, void *ctx)
+{
+    (void)ctx;
+    mtbddnode_t n = (mtbddnode_t)llmsset_index_to_ptr(nodes, index);
+    return mtbddnode_isleaf(n) ? (uint32_t)-1 : mtbddnode_getvariable(n);
+}
+
+VOID_TASK_2(mtbdd_writer_mark, MTBDD, dd, sylvan_writer_t, w)
+{
+    const uint64_t index = MTBDD_STRIPMARK(dd);
+    if (index == 0 || !sylvan_writer_mark(w, index)) return;
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    if (mtbddnode_isleaf(n)) return;
+    SPAWN(mtbdd_writer_mark, mtbddnode_getlow(n), w);
+    CALL(mtbdd_writer_mark, mtbddnode_gethigh(n), w);
+    SYNC(mtbdd_writer_mark);
+}
+
+VOID_TASK_4(mtbdd_writer_encode, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    for (size_t i=0; i<count; i++) {
+        mtbddnode_t n = MTBDD_GETNODE(sylvan_writer_getr(w, first+i));
+        MTBDD low = mtbddnode_getlow(n);
+        MTBDD high = mtbddnode_gethigh(n);
+        if (low != 0) low = sylvan_writer_get(w, low);
+        if (MTBDD_STRIPMARK(high) != 0) high = MTBDD_TRANSFERMARK(high, sylvan_writer_get(w, MTBDD_STRIPMARK(high)));
+        mtbddnode_makenode((mtbddnode_t)(buf + 16*i), mtbddnode_getvariable(n), low, high);
+    }
+}
+
+/**
+ * Encode nodes for the packed format: a leaf as (type << 2 | 2) and its value,
+ * an internal node as (var << 2 | map) and the relative low and high edges,
+ * with the complement mark in the lowest bit of the high edge.
+ */
+TASK_4(size_t, mtbdd_writer_encode_packed, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    uint8_t *ptr = buf;
+    for (size_t i=0; i<count; i++) {
+        const uint64_t number = first+i;
+        mtbddnode_t n = MTBDD_GETNODE(sylvan_writer_getr(w, number));
+        if (mtbddnode_isleaf(n)) {
+            ptr += sylvan_packed_encode(ptr, ((uint64_t)mtbddnode_gettype(n) << 2) | 2);
+            ptr += sylvan_packed_encode(ptr, mtbddnode_getvalue(n));
+        } else {
+            MTBDD low = mtbddnode_getlow(n);
+            MTBDD high = mtbddnode_gethigh(n);
+            if (low != 0) low = sylvan_writer_get(w, low);
+            uint64_t h = MTBDD_STRIPMARK(high) == 0 ? 0 : sylvan_writer_get(w, MTBDD_STRIPMARK(high));
+            ptr += sylvan_packed_encode(ptr, ((uint64_t)mtbddnode_getvariable(n) << 2) | (mtbddnode_ismapnode(n) ? 1 : 0));
+            ptr += sylvan_packed_encode(ptr, sylvan_packed_ref(number, low, 1));
+            ptr += sylvan_packed_encode(ptr, (sylvan_packed_ref(number, h, 1) << 1) | (MTBDD_HASMARK(high) ? 1 : 0));
+        }
+    }
+    return ptr - buf;
+}
+
 VOID_TASK_IMPL_3(mtbdd_writer_tobinary, FILE *, out, MTBDD *, dds, int, count)
 {
-    sylvan_skiplist_t sl = mtbdd_writer_start();
+    sylvan_writer_t w = sylvan_writer_alloc();
 
-    for (int i=0; i<count; i++) {
-        CALL(mtbdd_writer_add, sl, dds[i]);
+    /* Mark all nodes in parallel, then number them by level */
+    for (int i=0; i<count; i++) SPAWN(mtbdd_writer_mark, dds[i], w);
+    for (int i=0; i<count; i++) SYNC(mtbdd_writer_mark);
+    CALL(sylvan_writer_number, w, mtbdd_writer_level, NULL);
+
+    size_t nodecount = sylvan_writer_count(w);
+
+    /* Leaves have the lowest numbers; custom leaves can only be written in the raw format */
+    uint64_t next = 1;
+    int custom = 0;
+    for (; next<=nodecount; next++) {
+        mtbddnode_t n = MTBDD_GETNODE(sylvan_writer_getr(w, next));
+        if (!mtbddnode_isleaf(n)) break;
+        if (sylvan_mt_has_custom_hash(mtbddnode_gettype(n))) custom = 1;
     }
 
-    mtbdd_writer_writebinary(out, sl);
+    sylvan_binary_format format = sylvan_get_binary_format();
+    if (format != SYLVAN_BINARY_RAW && !custom) {
+        /* Encode all nodes in parallel chunks, as varints */
+        sylvan_packed_out_t p = sylvan_packed_out_open(out, format == SYLVAN_BINARY_PACKED_ZLIB);
+        sylvan_packed_put(p, nodecount);
+        CALL(sylvan_packed_write_nodes, p, w, 1, nodecount, 3*SYLVAN_PACKED_MAX_VARINT, TASK(mtbdd_writer_encode_packed));
+        sylvan_packed_out_close(p);
+    } else {
+        fwrite(&nodecount, sizeof(size_t), 1, out);
+
+        /* Write the leaves one by one */
+        for (next=1; next<=nodecount; next++) {
+            mtbddnode_t n = MTBDD_GETNODE(sylvan_writer_getr(w, next));
+            if (!mtbddnode_isleaf(n)) break;
+            fwrite(n, sizeof(struct mtbddnode), 1, out);
+            sylvan_mt_write_binary(mtbddnode_gettype(n), mtbddnode_getvalue(n), out);
+        }
+
+        /* Encode and write the internal nodes in parallel chunks */
+        CALL(sylvan_writer_write, w, out, next, nodecount, TASK(mtbdd_writer_encode));
+    }
 
     fwrite(&count, sizeof(int), 1, out);
-    
+
     for (int i=0; i<count; i++) {
-        uint64_t v = mtbdd_writer_get(sl, dds[i]);
+        uint64_t v = MTBDD_STRIPMARK(dds[i]) == 0 ? 0 : sylvan_writer_get(w, MTBDD_STRIPMARK(dds[i]));
+        v = MTBDD_TRANSFERMARK(dds[i], v);
         fwrite(&v, sizeof(uint64_t), 1, out);
     }
 
-    mtbdd_writer_end(sl);
+    sylvan_writer_free(w);
 }
 
 void
@@ -3321,11 +3310,119 @@ VOID_TASK_IMPL_3(mtbdd_writer_totext, FILE *, out, MTBDD *, dds, int, count)
     mtbdd_writer_end(sl);
 }
 
+/**
+ * Reading MTBDDs in binary format
+ *
+ * The array of every active reader is registered in a list, so the nodes that were already
+ * created survive garbage collection, also while the reader is still reading nodes.
+ */
+
+/* Number of nodes per task when marking the nodes of a reader */
+#define MTBDD_READER_NODES_PER_TASK 1024
+
+typedef struct mtbdd_reader
+{
+    struct mtbdd_reader *prev, *next;
+    size_t count;           // number of identifiers created (arr[1]...arr[count])
+    uint64_t arr[];         // arr[i] is the MTBDD with identifier i
+} *mtbdd_reader_t;
+
+static mtbdd_reader_t mtbdd_readers = NULL;
+static pthread_mutex_t mtbdd_readers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline mtbdd_reader_t
+mtbdd_reader_of(uint64_t *arr)
+{
+    return (mtbdd_reader_t)((char*)arr - offsetof(struct mtbdd_reader, arr));
+}
+
+/**
+ * Allocate and register the translation array of a reader for <nodecount> nodes
+ */
+static uint64_t*
+mtbdd_reader_alloc(uint64_t nodecount)
+{
+    mtbdd_reader_t r = (mtbdd_reader_t)malloc(sizeof(struct mtbdd_reader) + sizeof(uint64_t)*(nodecount+1));
+    r->prev = NULL;
+    r->count = 0;
+    r->arr[0] = 0;
+    pthread_mutex_lock(&mtbdd_readers_lock);
+    r->next = mtbdd_readers;
+    if (r->next != NULL) r->next->prev = r;
+    mtbdd_readers = r;
+    pthread_mutex_unlock(&mtbdd_readers_lock);
+    return r->arr;
+}
+
+VOID_TASK_3(mtbdd_gc_mark_reader, mtbdd_reader_t, r, size_t, first, size_t, count)
+{
+    if (count > MTBDD_READER_NODES_PER_TASK) {
+        SPAWN(mtbdd_gc_mark_reader, r, first, count/2);
+        CALL(mtbdd_gc_mark_reader, r, first+count/2, count-count/2);
+        SYNC(mtbdd_gc_mark_reader);
+        return;
+    }
+    for (size_t i=first; i<first+count; i++) CALL(mtbdd_gc_mark_rec, r->arr[i]);
+}
+
+VOID_TASK_IMPL_0(mtbdd_gc_mark_readers)
+{
+    pthread_mutex_lock(&mtbdd_readers_lock);
+    for (mtbdd_reader_t r = mtbdd_readers; r != NULL; r = r->next) {
+        CALL(mtbdd_gc_mark_reader, r, 1, r->count);
+    }
+    pthread_mutex_unlock(&mtbdd_readers_lock);
+}
+
+/**
+ * Read the nodes of a file in the packed format, after the magic bytes
+ */
+static uint64_t*
+mtbdd_reader_readpacked(FILE *in)
+{
+    sylvan_packed_in_t p = sylvan_packed_in_open(in);
+    if (p == NULL) return NULL;
+
+    uint64_t nodecount;
+    if (sylvan_packed_get(p, &nodecount) != 0 || nodecount > ((uint64_t)1 << 40)) {
+        sylvan_packed_in_close(p);
+        return NULL;
+    }
+
+    uint64_t *arr = mtbdd_reader_alloc(nodecount);
+    mtbdd_reader_t r = mtbdd_reader_of(arr);
+    uint64_t i = 1;
+    for (; i<=nodecount; i++) {
+        uint64_t header, a, b;
+        if (sylvan_packed_get(p, &header) != 0 || sylvan_packed_get(p, &a) != 0) break;
+        if ((header & 3) == 2) {
+            arr[i] = mtbdd_makeleaf((uint32_t)(header >> 2), a);
+            r->count = i;
+            continue;
+        }
+        if (sylvan_packed_get(p, &b) != 0) break;
+        uint64_t l = sylvan_packed_deref(i, a, 1);
+        uint64_t h = sylvan_packed_deref(i, b >> 1, 1);
+        if (l == (uint64_t)-1 || h == (uint64_t)-1) break;
+        MTBDD low = arr[l];
+        MTBDD high = (b & 1) ? MTBDD_TOGGLEMARK(arr[h]) : arr[h];
+        if (header & 1) arr[i] = mtbdd_makemapnode((uint32_t)(header >> 2), low, high);
+        else arr[i] = mtbdd_makenode((uint32_t)(header >> 2), low, high);
+        r->count = i;
+    }
+
+    if (sylvan_packed_in_close(p) != 0 || i <= nodecount) {
+        mtbdd_reader_end(arr);
+        return NULL;
+    }
+    return arr;
+}
+
 /**
  * Reading a file earlier written with mtbdd_writer_writebinary
  * Returns an array with the conversion from stored identifier to MTBDD
- * This array is allocated with malloc and must be freed afterwards.
- * This method does not support custom leaves.
+ * This array must be freed afterwards with mtbdd_reader_end; until then, its MTBDDs are kept
+ * during garbage collection.
  */
 TASK_IMPL_1(uint64_t*, mtbdd_reader_readbinary, FILE*, in)
 {
@@ -3334,12 +3431,14 @@ TASK_IMPL_1(uint64_t*, mtbdd_reader_readbinary, FILE*, in)
         return NULL;
     }
 
-    uint64_t *arr = malloc(sizeof(uint64_t)*(nodecount+1));
-    arr[0] = 0;
+    if (sylvan_packed_is_magic(nodecount)) return mtbdd_reader_readpacked(in);
+
+    uint64_t *arr = mtbdd_reader_alloc(nodecount);
+    mtbdd_reader_t r = mtbdd_reader_of(arr);
     for (size_t i=1; i<=nodecount; i++) {
         struct mtbddnode node;
         if (fread(&node, sizeof(struct mtbddnode), 1, in) != 1) {
-            free(arr);
+            mtbdd_reader_end(arr);
             return NULL;
         }
 
@@ -3355,6 +3454,7 @@ TASK_IMPL_1(uint64_t*, mtbdd_reader_readbinary, FILE*, in)
             high = MTBDD_TRANSFERMARK(high, arr[MTBDD_STRIPMARK(high)]);
             arr[i] = mtbdd_makenode(mtbddnode_getvariable(&node), low, high);
         }
+        r->count = i;
     }
 
     return arr;
@@ -3370,12 +3470,19 @@ mtbdd_reader_get(uint64_t* arr, uint64_t identifier)
 }
 
 /**
- * Free the allocated translation array
+ * Unregister and free the allocated translation array
  */
 void
 mtbdd_reader_end(uint64_t *arr)
 {
-    free(arr);
+    if (arr == NULL) return;
+    mtbdd_reader_t r = mtbdd_reader_of(arr);
+    pthread_mutex_lock(&mtbdd_readers_lock);
+    if (r->prev != NULL) r->prev->next = r->next;
+    else mtbdd_readers = r->next;
+    if (r->next != NULL) r->next->prev = r->prev;
+    pthread_mutex_unlock(&mtbdd_readers_lock);
+    free(r);
 }
 
 /**
@@ -3413,6 +3520,55 @@ TASK_IMPL_3(int, mtbdd_reader_frombinary, FILE*, in, MTBDD*, dds, int, count)
     return 0;
 }
 
+/**
+ * Skip the nodes of a file in the packed format, after the magic bytes
+ */
+static int
+mtbdd_reader_skippacked(FILE *in)
+{
+    sylvan_packed_in_t p = sylvan_packed_in_open(in);
+    if (p == NULL) return -1;
+
+    uint64_t nodecount, i = 0;
+    if (sylvan_packed_get(p, &nodecount) == 0) {
+        for (; i<nodecount; i++) {
+            uint64_t header, a, b;
+            if (sylvan_packed_get(p, &header) != 0 || sylvan_packed_get(p, &a) != 0) break;
+            if ((header & 3) != 2 && sylvan_packed_get(p, &b) != 0) break;
+        }
+    } else {
+        nodecount = 1;
+    }
+
+    if (sylvan_packed_in_close(p) != 0 || i < nodecount) return -1;
+    return 0;
+}
+
+TASK_IMPL_1(int, mtbdd_reader_skipbinary, FILE*, in)
+{
+    size_t nodecount;
+    if (fread(&nodecount, sizeof(size_t), 1, in) != 1) return -1;
+
+    if (sylvan_packed_is_magic(nodecount)) {
+        if (mtbdd_reader_skippacked(in) != 0) return -1;
+    } else {
+        for (size_t i=0; i<nodecount; i++) {
+            struct mtbddnode node;
+            if (fread(&node, sizeof(struct mtbddnode), 1, in) != 1) return -1;
+            if (mtbddnode_isleaf(&node)) {
+                /* custom leaves may be followed by more data, which is consumed but not stored */
+                if (sylvan_mt_skip_binary(mtbddnode_gettype(&node), in) != 0) return -1;
+            }
+        }
+    }
+
+    /* Skip the stored identifiers */
+    int count;
+    if (fread(&count, sizeof(int), 1, in) != 1 || count < 0) return -1;
+    if (fseek(in, (long)count * (long)sizeof(uint64_t), SEEK_CUR) != 0) return -1;
+    return 0;
+}
+
 /**
  * Implementation of variable sets, i.e., cubes of (positive) variables.
  */
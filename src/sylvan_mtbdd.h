@@ -85,6 +85,10 @@ static const MTBDD sylvan_invalid    = 0xffffffffffffffffLL;
 #define sylvan_protect          mtbdd_protect
 #define sylvan_unprotect        mtbdd_unprotect
 #define sylvan_count_protected  mtbdd_count_protected
+#define sylvan_handle_get       mtbdd_handle_get
+#define sylvan_handle_set       mtbdd_handle_set
+#define sylvan_handle_put       mtbdd_handle_put
+#define sylvan_count_handles    mtbdd_count_handles
 #define sylvan_gc_mark_rec      mtbdd_gc_mark_rec
 #define sylvan_ithvar           mtbdd_ithvar
 #define bdd_refs_pushptr        mtbdd_refs_pushptr
@@ -554,6 +558,14 @@ TASK_DECL_3(MTBDD, mtbdd_abstract_op_max, MTBDD, MTBDD, int);
 TASK_DECL_3(MTBDD, mtbdd_ite, MTBDD, MTBDD, MTBDD);
 #define mtbdd_ite(f, g, h) RUN(mtbdd_ite, f, g, h);
 
+/**
+ * Apply the binary operation <apply_op> to <a> and <b>, and abstract variables <vars> using <abstract_op>.
+ * Computes mtbdd_abstract(mtbdd_apply(a, b, apply_op), vars, abstract_op) without building the
+ * intermediate MTBDD. Works for any leaf type (including custom types) supported by both operations.
+ */
+TASK_DECL_5(MTBDD, mtbdd_and_abstract, MTBDD, MTBDD, MTBDD, mtbdd_apply_op, mtbdd_abstract_op);
+#define mtbdd_and_abstract(a, b, vars, apply_op, abstract_op) RUN(mtbdd_and_abstract, a, b, vars, apply_op, abstract_op)
+
 /**
  * Multiply <a> and <b>, and abstract variables <vars> using summation.
  * This is similar to the "and_exists" operation in BDDs.
@@ -827,7 +839,10 @@ VOID_TASK_DECL_4(mtbdd_visit_par, MTBDD, mtbdd_visit_pre_cb, mtbdd_visit_post_cb
  * Every node that is to be written is assigned a number, starting from 1,
  * such that reading the result in the future can be done in one pass.
  *
- * We use a skiplist to store the assignment.
+ * The binary writer mtbdd_writer_tobinary marks the nodes in parallel and numbers
+ * them by level (leaves first, then from the deepest variable to the top variable);
+ * the nodes are then encoded in parallel and written in large chunks.
+ * The other functions use a skiplist to store the assignment.
  *
  * The functions mtbdd_writer_tobinary and mtbdd_writer_totext can be used to
  * store an array of MTBDDs to binary format or text format.
@@ -922,7 +937,8 @@ TASK_DECL_3(int, mtbdd_reader_frombinary, FILE*, MTBDD*, int);
 /**
  * Reading a file earlier written with mtbdd_writer_writebinary
  * Returns an array with the conversion from stored identifier to MTBDD
- * This array is allocated with malloc and must be freed afterwards.
+ * This array must be freed afterwards with mtbdd_reader_end. Until then, the MTBDDs in the
+ * array are kept during garbage collection, also while the nodes are being read.
  * Returns NULL if there was an error.
  */
 
@@ -939,6 +955,16 @@ MTBDD mtbdd_reader_get(uint64_t* arr, uint64_t identifier);
  */
 void mtbdd_reader_end(uint64_t *arr);
 
+/**
+ * Skip over the decision diagrams that mtbdd_reader_frombinary would read from <file>,
+ * without creating any nodes (the data of leaves with a custom binary format is read and discarded).
+ * This is used to find where the next decision diagram starts, for instance to read
+ * several decision diagrams of one file in parallel with a FILE* for each.
+ * Returns 0 if successful, -1 otherwise.
+ */
+TASK_DECL_1(int, mtbdd_reader_skipbinary, FILE*);
+#define mtbdd_reader_skipbinary(file) RUN(mtbdd_reader_skipbinary, file)
+
 /**
  * MTBDDMAP, maps uint32_t variables to MTBDDs.
  * A MTBDDMAP node has variable level, low edge going to the next MTBDDMAP, high edge to the mapped MTBDD.
@@ -1041,6 +1067,36 @@ void mtbdd_unprotect(MTBDD* ptr);
  */
 size_t mtbdd_count_protected(void);
 
+/**
+ * Handles are a cheaper alternative to the pointers table for short-lived variables,
+ * such as the C++ Bdd and Mtbdd objects. Every thread takes and returns handles with
+ * its own free list, without atomic operations; a handle may be returned by another
+ * thread than the one that took it. Handles are scanned during garbage collection.
+ */
+
+/**
+ * Take a handle that protects the variable at <ptr> (which must be 8-byte aligned).
+ */
+uint64_t *mtbdd_handle_get(MTBDD* ptr);
+
+/**
+ * Let the handle protect the variable at <ptr> instead.
+ */
+static inline void mtbdd_handle_set(uint64_t *handle, MTBDD* ptr)
+{
+    *handle = (uint64_t)(size_t)ptr | HANDLES_MTBDD;
+}
+
+/**
+ * Return the handle, the variable is no longer protected.
+ */
+void mtbdd_handle_put(uint64_t *handle);
+
+/**
+ * Compute the number of handles in use.
+ */
+size_t mtbdd_count_handles(void);
+
 /**
  * Store the MTBDD <dd> in the values table.
  */
@@ -1056,6 +1112,15 @@ void mtbdd_deref(MTBDD dd);
  */
 size_t mtbdd_count_refs(void);
 
+/**
+ * Turn the deferred mode of the values table on or off, while no thread uses mtbdd_ref and mtbdd_deref.
+ * In the deferred mode, mtbdd_ref and mtbdd_deref only update a small buffer of the current thread,
+ * where a ref and a deref of the same MTBDD cancel out. The buffers of all threads are applied to
+ * the table when they are full, by garbage collection and by mtbdd_count_refs. This avoids contention
+ * on the table when many threads ref and deref. It is off by default.
+ */
+void mtbdd_set_deferred_refs(int deferred);
+
 /**
  * Infrastructure for internal references.
  * Every thread has its own reference stacks. There are three stacks: pointer, values, tasks stack.
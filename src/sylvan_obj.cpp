@@ -38,23 +38,34 @@ Bdd::operator!=(const Bdd& other) const
 Bdd&
 Bdd::operator=(const Bdd& right)
 {
-    bdd = right.bdd;
+    assign(right.bdd);
+    return *this;
+}
+
+Bdd&
+Bdd::operator=(Bdd&& right)
+{
+    if (this != &right) {
+        if (handle != NULL) sylvan_handle_put(handle);
+        bdd = right.bdd;
+        handle = right.handle;
+        if (handle != NULL) sylvan_handle_set(handle, &bdd);
+        right.bdd = sylvan_false;
+        right.handle = NULL;
+    }
     return *this;
 }
 
 bool
 Bdd::operator<=(const Bdd& other) const
 {
-    // TODO: better implementation, since we are not interested in the BDD result
-    BDD r = sylvan_ite(this->bdd, sylvan_not(other.bdd), sylvan_false);
-    return r == sylvan_false;
+    return sylvan_leq(bdd, other.bdd);
 }
 
 bool
 Bdd::operator>=(const Bdd& other) const
 {
-    // TODO: better implementation, since we are not interested in the BDD result
-    return other <= *this;
+    return sylvan_leq(other.bdd, bdd);
 }
 
 bool
@@ -70,92 +81,148 @@ Bdd::operator>(const Bdd& other) const
 }
 
 Bdd
-Bdd::operator!() const
+Bdd::operator!() const &
 {
     return Bdd(sylvan_not(bdd));
 }
 
 Bdd
-Bdd::operator~() const
+Bdd::operator!() &&
+{
+    assign(sylvan_not(bdd));
+    return std::move(*this);
+}
+
+Bdd
+Bdd::operator~() const &
 {
     return Bdd(sylvan_not(bdd));
 }
 
 Bdd
-Bdd::operator*(const Bdd& other) const
+Bdd::operator~() &&
+{
+    assign(sylvan_not(bdd));
+    return std::move(*this);
+}
+
+Bdd
+Bdd::operator*(const Bdd& other) const &
 {
     return Bdd(sylvan_and(bdd, other.bdd));
 }
 
+Bdd
+Bdd::operator*(const Bdd& other) &&
+{
+    assign(sylvan_and(bdd, other.bdd));
+    return std::move(*this);
+}
+
 Bdd&
 Bdd::operator*=(const Bdd& other)
 {
-    bdd = sylvan_and(bdd, other.bdd);
+    assign(sylvan_and(bdd, other.bdd));
     return *this;
 }
 
 Bdd
-Bdd::operator&(const Bdd& other) const
+Bdd::operator&(const Bdd& other) const &
 {
     return Bdd(sylvan_and(bdd, other.bdd));
 }
 
+Bdd
+Bdd::operator&(const Bdd& other) &&
+{
+    assign(sylvan_and(bdd, other.bdd));
+    return std::move(*this);
+}
+
 Bdd&
 Bdd::operator&=(const Bdd& other)
 {
-    bdd = sylvan_and(bdd, other.bdd);
+    assign(sylvan_and(bdd, other.bdd));
     return *this;
 }
 
 Bdd
-Bdd::operator+(const Bdd& other) const
+Bdd::operator+(const Bdd& other) const &
 {
     return Bdd(sylvan_or(bdd, other.bdd));
 }
 
+Bdd
+Bdd::operator+(const Bdd& other) &&
+{
+    assign(sylvan_or(bdd, other.bdd));
+    return std::move(*this);
+}
+
 Bdd&
 Bdd::operator+=(const Bdd& other)
 {
-    bdd = sylvan_or(bdd, other.bdd);
+    assign(sylvan_or(bdd, other.bdd));
     return *this;
 }
 
 Bdd
-Bdd::operator|(const Bdd& other) const
+Bdd::operator|(const Bdd& other) const &
 {
     return Bdd(sylvan_or(bdd, other.bdd));
 }
 
+Bdd
+Bdd::operator|(const Bdd& other) &&
+{
+    assign(sylvan_or(bdd, other.bdd));
+    return std::move(*this);
+}
+
 Bdd&
 Bdd::operator|=(const Bdd& other)
 {
-    bdd = sylvan_or(bdd, other.bdd);
+    assign(sylvan_or(bdd, other.bdd));
     return *this;
 }
 
 Bdd
-Bdd::operator^(const Bdd& other) const
+Bdd::operator^(const Bdd& other) const &
 {
     return Bdd(sylvan_xor(bdd, other.bdd));
 }
 
+Bdd
+Bdd::operator^(const Bdd& other) &&
+{
+    assign(sylvan_xor(bdd, other.bdd));
+    return std::move(*this);
+}
+
 Bdd&
 Bdd::operator^=(const Bdd& other)
 {
-    bdd = sylvan_xor(bdd, other.bdd);
+    assign(sylvan_xor(bdd, other.bdd));
     return *this;
 }
 
 Bdd
-Bdd::operator-(const Bdd& other) const
+Bdd::operator-(const Bdd& other) const &
 {
     return Bdd(sylvan_and(bdd, sylvan_not(other.bdd)));
 }
 
+Bdd
+Bdd::operator-(const Bdd& other) &&
+{
+    assign(sylvan_and(bdd, sylvan_not(other.bdd)));
+    return std::move(*this);
+}
+
 Bdd&
 Bdd::operator-=(const Bdd& other)
 {
-    bdd = sylvan_and(bdd, sylvan_not(other.bdd));
+    assign(sylvan_and(bdd, sylvan_not(other.bdd)));
     return *this;
 }
 
@@ -222,9 +289,19 @@ Bdd::Xnor(const Bdd &g) const
 bool
 Bdd::Leq(const Bdd &g) const
 {
-    // TODO: better implementation, since we are not interested in the BDD result
-    BDD r = sylvan_ite(bdd, sylvan_not(g.bdd), sylvan_false);
-    return r == sylvan_false;
+    return sylvan_leq(bdd, g.bdd);
+}
+
+bool
+Bdd::Disjoint(const Bdd &g) const
+{
+    return sylvan_disjoint(bdd, g.bdd);
+}
+
+bool
+Bdd::EquivUnder(const Bdd &g, const Bdd &care) const
+{
+    return sylvan_equiv_under(bdd, g.bdd, care.bdd);
 }
 
 Bdd
@@ -491,8 +568,8 @@ Bdd::Else() const
  */
 
 BddMap::BddMap(uint32_t key_variable, const Bdd value)
+    : bdd(sylvan_map_add(sylvan_map_empty(), key_variable, value.bdd)), handle(sylvan_handle_get(&bdd))
 {
-    bdd = sylvan_map_add(sylvan_map_empty(), key_variable, value.bdd);
 }
 
 
@@ -505,7 +582,7 @@ BddMap::operator+(const Bdd& other) const
 BddMap&
 BddMap::operator+=(const Bdd& other)
 {
-    bdd = sylvan_map_addall(bdd, other.bdd);
+    assign(sylvan_map_addall(bdd, other.bdd));
     return *this;
 }
 
@@ -518,20 +595,20 @@ BddMap::operator-(const Bdd& other) const
 BddMap&
 BddMap::operator-=(const Bdd& other)
 {
-    bdd = sylvan_map_removeall(bdd, other.bdd);
+    assign(sylvan_map_removeall(bdd, other.bdd));
     return *this;
 }
 
 void
 BddMap::put(uint32_t key, Bdd value)
 {
-    bdd = sylvan_map_add(bdd, key, value.bdd);
+    assign(sylvan_map_add(bdd, key, value.bdd));
 }
 
 void
 BddMap::removeKey(uint32_t key)
 {
-    bdd = sylvan_map_remove(bdd, key);
+    assign(sylvan_map_remove(bdd, key));
 }
 
 size_t
@@ -747,58 +824,107 @@ Mtbdd::operator!=(const Mtbdd& other) const
 Mtbdd&
 Mtbdd::operator=(const Mtbdd& right)
 {
-    mtbdd = right.mtbdd;
+    assign(right.mtbdd);
+    return *this;
+}
+
+Mtbdd&
+Mtbdd::operator=(Mtbdd&& right)
+{
+    if (this != &right) {
+        if (handle != NULL) mtbdd_handle_put(handle);
+        mtbdd = right.mtbdd;
+        handle = right.handle;
+        if (handle != NULL) mtbdd_handle_set(handle, &mtbdd);
+        right.mtbdd = mtbdd_false;
+        right.handle = NULL;
+    }
     return *this;
 }
 
 Mtbdd
-Mtbdd::operator!() const
+Mtbdd::operator!() const &
 {
     return mtbdd_not(mtbdd);
 }
 
 Mtbdd
-Mtbdd::operator~() const
+Mtbdd::operator!() &&
+{
+    assign(mtbdd_not(mtbdd));
+    return std::move(*this);
+}
+
+Mtbdd
+Mtbdd::operator~() const &
 {
     return mtbdd_not(mtbdd);
 }
 
 Mtbdd
-Mtbdd::operator*(const Mtbdd& other) const
+Mtbdd::operator~() &&
+{
+    assign(mtbdd_not(mtbdd));
+    return std::move(*this);
+}
+
+Mtbdd
+Mtbdd::operator*(const Mtbdd& other) const &
 {
     return mtbdd_times(mtbdd, other.mtbdd);
 }
 
+Mtbdd
+Mtbdd::operator*(const Mtbdd& other) &&
+{
+    assign(mtbdd_times(mtbdd, other.mtbdd));
+    return std::move(*this);
+}
+
 Mtbdd&
 Mtbdd::operator*=(const Mtbdd& other)
 {
-    mtbdd = mtbdd_times(mtbdd, other.mtbdd);
+    assign(mtbdd_times(mtbdd, other.mtbdd));
     return *this;
 }
 
 Mtbdd
-Mtbdd::operator+(const Mtbdd& other) const
+Mtbdd::operator+(const Mtbdd& other) const &
 {
     return mtbdd_plus(mtbdd, other.mtbdd);
 }
 
+Mtbdd
+Mtbdd::operator+(const Mtbdd& other) &&
+{
+    assign(mtbdd_plus(mtbdd, other.mtbdd));
+    return std::move(*this);
+}
+
 Mtbdd&
 Mtbdd::operator+=(const Mtbdd& other)
 {
-    mtbdd = mtbdd_plus(mtbdd, other.mtbdd);
+    assign(mtbdd_plus(mtbdd, other.mtbdd));
     return *this;
 }
 
 Mtbdd
-Mtbdd::operator-(const Mtbdd& other) const
+Mtbdd::operator-(const Mtbdd& other) const &
 {
     return mtbdd_minus(mtbdd, other.mtbdd);
 }
 
+Mtbdd
+Mtbdd::operator-(const Mtbdd& other) &&
+{
+    assign(mtbdd_minus(mtbdd, other.mtbdd));
+    return std::move(*this);
+}
+
 Mtbdd&
 Mtbdd::operator-=(const Mtbdd& other)
 {
-    mtbdd = mtbdd_minus(mtbdd, other.mtbdd);
+    assign(mtbdd_minus(mtbdd, other.mtbdd));
     return *this;
 }
 
@@ -880,8 +1006,8 @@ Mtbdd::NodeCount() const
  */
 
 MtbddMap::MtbddMap(uint32_t key_variable, Mtbdd value)
+    : mtbdd(mtbdd_map_add(mtbdd_map_empty(), key_variable, value.mtbdd)), handle(mtbdd_handle_get(&mtbdd))
 {
-    mtbdd = mtbdd_map_add(mtbdd_map_empty(), key_variable, value.mtbdd);
 }
 
 MtbddMap
@@ -893,7 +1019,7 @@ MtbddMap::operator+(const Mtbdd& other) const
 MtbddMap&
 MtbddMap::operator+=(const Mtbdd& other)
 {
-    mtbdd = mtbdd_map_addall(mtbdd, other.mtbdd);
+    assign(mtbdd_map_addall(mtbdd, other.mtbdd));
     return *this;
 }
 
@@ -906,20 +1032,20 @@ MtbddMap::operator-(const Mtbdd& other) const
 MtbddMap&
 MtbddMap::operator-=(const Mtbdd& other)
 {
-    mtbdd = mtbdd_map_removeall(mtbdd, other.mtbdd);
+    assign(mtbdd_map_removeall(mtbdd, other.mtbdd));
     return *this;
 }
 
 void
 MtbddMap::put(uint32_t key, Mtbdd value)
 {
-    mtbdd = mtbdd_map_add(mtbdd, key, value.mtbdd);
+    assign(mtbdd_map_add(mtbdd, key, value.mtbdd));
 }
 
 void
 MtbddMap::removeKey(uint32_t key)
 {
-    mtbdd = mtbdd_map_remove(mtbdd, key);
+    assign(mtbdd_map_remove(mtbdd, key));
 }
 
 size_t
@@ -935,6 +1061,384 @@ MtbddMap::isEmpty()
 }
 
 
+/***
+ * Implementation of class Ldd
+ */
+
+Ldd
+Ldd::lddTrue()
+{
+    return lddmc_true;
+}
+
+Ldd
+Ldd::lddFalse()
+{
+    return lddmc_false;
+}
+
+Ldd
+Ldd::lddCube(std::vector<uint32_t> values)
+{
+    return lddmc_cube(values.data(), values.size());
+}
+
+bool
+Ldd::operator==(const Ldd& other) const
+{
+    return mdd == other.mdd;
+}
+
+bool
+Ldd::operator!=(const Ldd& other) const
+{
+    return mdd != other.mdd;
+}
+
+Ldd&
+Ldd::operator=(const Ldd& right)
+{
+    assign(right.mdd);
+    return *this;
+}
+
+Ldd&
+Ldd::operator=(Ldd&& right)
+{
+    assign(right.mdd);
+    return *this;
+}
+
+Ldd
+Ldd::operator|(const Ldd& other) const &
+{
+    return lddmc_union(mdd, other.mdd);
+}
+
+Ldd
+Ldd::operator|(const Ldd& other) &&
+{
+    assign(lddmc_union(mdd, other.mdd));
+    return std::move(*this);
+}
+
+Ldd&
+Ldd::operator|=(const Ldd& other)
+{
+    assign(lddmc_union(mdd, other.mdd));
+    return *this;
+}
+
+Ldd
+Ldd::operator&(const Ldd& other) const &
+{
+    return lddmc_intersect(mdd, other.mdd);
+}
+
+Ldd
+Ldd::operator&(const Ldd& other) &&
+{
+    assign(lddmc_intersect(mdd, other.mdd));
+    return std::move(*this);
+}
+
+Ldd&
+Ldd::operator&=(const Ldd& other)
+{
+    assign(lddmc_intersect(mdd, other.mdd));
+    return *this;
+}
+
+Ldd
+Ldd::operator-(const Ldd& other) const &
+{
+    return lddmc_minus(mdd, other.mdd);
+}
+
+Ldd
+Ldd::operator-(const Ldd& other) &&
+{
+    assign(lddmc_minus(mdd, other.mdd));
+    return std::move(*this);
+}
+
+Ldd&
+Ldd::operator-=(const Ldd& other)
+{
+    assign(lddmc_minus(mdd, other.mdd));
+    return *this;
+}
+
+bool
+Ldd::isTrue() const
+{
+    return mdd == lddmc_true;
+}
+
+bool
+Ldd::isFalse() const
+{
+    return mdd == lddmc_false;
+}
+
+uint32_t
+Ldd::Value() const
+{
+    return lddmc_getvalue(mdd);
+}
+
+Ldd
+Ldd::Down() const
+{
+    return lddmc_getdown(mdd);
+}
+
+Ldd
+Ldd::Right() const
+{
+    return lddmc_getright(mdd);
+}
+
+bool
+Ldd::Contains(std::vector<uint32_t> values) const
+{
+    return lddmc_member_cube(mdd, values.data(), values.size());
+}
+
+Ldd
+Ldd::RelProd(const Ldd& rel, const Ldd& meta) const
+{
+    return lddmc_relprod(mdd, rel.mdd, meta.mdd);
+}
+
+Ldd
+Ldd::RelPrev(const Ldd& rel, const Ldd& meta, const Ldd& universe) const
+{
+    return lddmc_relprev(mdd, rel.mdd, meta.mdd, universe.mdd);
+}
+
+Ldd
+Ldd::Project(const Ldd& proj) const
+{
+    return lddmc_project(mdd, proj.mdd);
+}
+
+double
+Ldd::SatCount() const
+{
+    return lddmc_satcount_cached(mdd);
+}
+
+size_t
+Ldd::NodeCount() const
+{
+    return lddmc_nodecount(mdd);
+}
+
+MDD
+Ldd::GetLDD() const
+{
+    return mdd;
+}
+
+
+/***
+ * Implementation of class Zdd
+ */
+
+Zdd::Zdd(const Bdd &from, const BddSet &domain) : zdd(zdd_from_mtbdd(from.bdd, domain.set.bdd)), handle(zdd_handle_get(&zdd))
+{
+}
+
+Zdd
+Zdd::zddOne()
+{
+    return zdd_true;
+}
+
+Zdd
+Zdd::zddZero()
+{
+    return zdd_false;
+}
+
+Zdd
+Zdd::zddVar(uint32_t var)
+{
+    return zdd_ithvar(var);
+}
+
+Zdd
+Zdd::zddDomain(std::vector<uint32_t> variables)
+{
+    return zdd_set_from_array(variables.data(), variables.size());
+}
+
+bool
+Zdd::operator==(const Zdd& other) const
+{
+    return zdd == other.zdd;
+}
+
+bool
+Zdd::operator!=(const Zdd& other) const
+{
+    return zdd != other.zdd;
+}
+
+Zdd&
+Zdd::operator=(const Zdd& right)
+{
+    assign(right.zdd);
+    return *this;
+}
+
+Zdd&
+Zdd::operator=(Zdd&& right)
+{
+    assign(right.zdd);
+    return *this;
+}
+
+Zdd
+Zdd::operator&(const Zdd& other) const &
+{
+    return zdd_and(zdd, other.zdd);
+}
+
+Zdd
+Zdd::operator&(const Zdd& other) &&
+{
+    assign(zdd_and(zdd, other.zdd));
+    return std::move(*this);
+}
+
+Zdd&
+Zdd::operator&=(const Zdd& other)
+{
+    assign(zdd_and(zdd, other.zdd));
+    return *this;
+}
+
+Zdd
+Zdd::operator|(const Zdd& other) const &
+{
+    return zdd_or(zdd, other.zdd);
+}
+
+Zdd
+Zdd::operator|(const Zdd& other) &&
+{
+    assign(zdd_or(zdd, other.zdd));
+    return std::move(*this);
+}
+
+Zdd&
+Zdd::operator|=(const Zdd& other)
+{
+    assign(zdd_or(zdd, other.zdd));
+    return *this;
+}
+
+Zdd
+Zdd::operator-(const Zdd& other) const &
+{
+    return zdd_diff(zdd, other.zdd);
+}
+
+Zdd
+Zdd::operator-(const Zdd& other) &&
+{
+    assign(zdd_diff(zdd, other.zdd));
+    return std::move(*this);
+}
+
+Zdd&
+Zdd::operator-=(const Zdd& other)
+{
+    assign(zdd_diff(zdd, other.zdd));
+    return *this;
+}
+
+bool
+Zdd::isOne() const
+{
+    return zdd == zdd_true;
+}
+
+bool
+Zdd::isZero() const
+{
+    return zdd == zdd_false;
+}
+
+bool
+Zdd::isLeaf() const
+{
+    return zdd_isleaf(zdd);
+}
+
+uint32_t
+Zdd::TopVar() const
+{
+    return zdd_getvar(zdd);
+}
+
+Zdd
+Zdd::Then() const
+{
+    return zdd_gethigh(zdd);
+}
+
+Zdd
+Zdd::Else() const
+{
+    return zdd_getlow(zdd);
+}
+
+Zdd
+Zdd::Not(const Zdd& domain) const
+{
+    return zdd_not(zdd, domain.zdd);
+}
+
+Zdd
+Zdd::Ite(const Zdd& g, const Zdd& h, const Zdd& domain) const
+{
+    return zdd_ite(zdd, g.zdd, h.zdd, domain.zdd);
+}
+
+Zdd
+Zdd::ExistAbstract(const Zdd& variables) const
+{
+    return zdd_exists(zdd, variables.zdd);
+}
+
+Bdd
+Zdd::ToBdd(const Zdd& domain) const
+{
+    return zdd_to_mtbdd(zdd, domain.zdd);
+}
+
+double
+Zdd::SatCount() const
+{
+    return zdd_satcount(zdd);
+}
+
+size_t
+Zdd::NodeCount() const
+{
+    return zdd_nodecount_one(zdd);
+}
+
+ZDD
+Zdd::GetZDD() const
+{
+    return zdd;
+}
+
+
 /***
  * Implementation of class Sylvan
  */
@@ -970,6 +1474,18 @@ Sylvan::initMtbdd()
     sylvan_init_mtbdd();
 }
 
+void
+Sylvan::initLdd()
+{
+    sylvan_init_ldd();
+}
+
+void
+Sylvan::initZdd()
+{
+    sylvan_init_zdd();
+}
+
 void
 Sylvan::quitPackage()
 {
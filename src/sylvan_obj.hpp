@@ -18,6 +18,7 @@
 #define SYLVAN_OBJ_H
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <lace.h>
@@ -33,13 +34,23 @@ class Bdd {
     friend class BddSet;
     friend class BddMap;
     friend class Mtbdd;
+    friend class Zdd;
 
 public:
-    Bdd() { bdd = sylvan_false; sylvan_protect(&bdd); }
-    Bdd(const BDD from) : bdd(from) { sylvan_protect(&bdd); }
-    Bdd(const Bdd &from) : bdd(from.bdd) { sylvan_protect(&bdd); }
-    Bdd(const uint32_t var) { bdd = sylvan_ithvar(var); sylvan_protect(&bdd); }
-    ~Bdd() { sylvan_unprotect(&bdd); }
+    Bdd() : bdd(sylvan_false), handle(sylvan_handle_get(&bdd)) {}
+    Bdd(const BDD from) : bdd(from), handle(sylvan_handle_get(&bdd)) {}
+    Bdd(const Bdd &from) : bdd(from.bdd), handle(sylvan_handle_get(&bdd)) {}
+    Bdd(const uint32_t var) : bdd(sylvan_ithvar(var)), handle(sylvan_handle_get(&bdd)) {}
+    ~Bdd() { if (handle != NULL) sylvan_handle_put(handle); }
+
+    /**
+     * @brief Moves the Bdd and its handle; <from> becomes bddZero() until it is assigned again.
+     */
+    Bdd(Bdd &&from) : bdd(from.bdd), handle(from.handle) {
+        if (handle != NULL) sylvan_handle_set(handle, &bdd);
+        from.bdd = sylvan_false;
+        from.handle = NULL;
+    }
 
     /**
      * @brief Creates a Bdd representing just the variable index in its positive form
@@ -82,23 +93,34 @@ public:
     bool operator==(const Bdd& other) const;
     bool operator!=(const Bdd& other) const;
     Bdd& operator=(const Bdd& right);
+    Bdd& operator=(Bdd&& right);
     bool operator<=(const Bdd& other) const;
     bool operator>=(const Bdd& other) const;
     bool operator<(const Bdd& other) const;
     bool operator>(const Bdd& other) const;
-    Bdd operator!() const;
-    Bdd operator~() const;
-    Bdd operator*(const Bdd& other) const;
+    Bdd operator!() const &;
+    Bdd operator!() &&;
+    Bdd operator~() const &;
+    Bdd operator~() &&;
+
+    Bdd operator*(const Bdd& other) const &;
+    Bdd operator*(const Bdd& other) &&;
     Bdd& operator*=(const Bdd& other);
-    Bdd operator&(const Bdd& other) const;
+    Bdd operator&(const Bdd& other) const &;
+    Bdd operator&(const Bdd& other) &&;
     Bdd& operator&=(const Bdd& other);
-    Bdd operator+(const Bdd& other) const;
+    Bdd operator+(const Bdd& other) const &;
+    Bdd operator+(const Bdd& other) &&;
     Bdd& operator+=(const Bdd& other);
-    Bdd operator|(const Bdd& other) const;
+    Bdd operator|(const Bdd& other) const &;
+    Bdd operator|(const Bdd& other) &&;
     Bdd& operator|=(const Bdd& other);
-    Bdd operator^(const Bdd& other) const;
+
+    Bdd operator^(const Bdd& other) const &;
+    Bdd operator^(const Bdd& other) &&;
     Bdd& operator^=(const Bdd& other);
-    Bdd operator-(const Bdd& other) const;
+    Bdd operator-(const Bdd& other) const &;
+    Bdd operator-(const Bdd& other) &&;
     Bdd& operator-=(const Bdd& other);
 
     /**
@@ -191,6 +213,16 @@ public:
      */
     bool Leq(const Bdd& g) const;
 
+    /**
+     * @brief Returns whether f and g have no elements in common
+     */
+    bool Disjoint(const Bdd& g) const;
+
+    /**
+     * @brief Returns whether f and g contain the same elements of care
+     */
+    bool EquivUnder(const Bdd& g, const Bdd& care) const;
+
     /**
      * @brief Computes the reverse application of a transition relation to this set.
      * @param relation the transition relation to apply
@@ -326,12 +358,22 @@ public:
 
 private:
     BDD bdd;
+    uint64_t *handle; // protects bdd during garbage collection, NULL after a move
+
+    /**
+     * @brief Sets the value, and takes a new handle if this Bdd was moved
+     */
+    void assign(BDD value) {
+        if (handle == NULL) handle = sylvan_handle_get(&bdd);
+        bdd = value;
+    }
 };
 
 class BddSet
 {
     friend class Bdd;
     friend class Mtbdd;
+    friend class Zdd;
     Bdd set;
 
 public:
@@ -482,12 +524,31 @@ class BddMap
 {
     friend class Bdd;
     BDD bdd;
-    BddMap(const BDD from) : bdd(from) { sylvan_protect(&bdd); }
-    BddMap(const Bdd &from) : bdd(from.bdd) { sylvan_protect(&bdd); }
+    uint64_t *handle;
+    BddMap(const BDD from) : bdd(from), handle(sylvan_handle_get(&bdd)) {}
+    BddMap(const Bdd &from) : bdd(from.bdd), handle(sylvan_handle_get(&bdd)) {}
 public:
-    BddMap(const BddMap& from) : bdd(from.bdd) { sylvan_protect(&bdd); }
-    BddMap() : bdd(sylvan_map_empty()) { sylvan_protect(&bdd); }
-    ~BddMap() { sylvan_unprotect(&bdd); }
+    BddMap(const BddMap& from) : bdd(from.bdd), handle(sylvan_handle_get(&bdd)) {}
+    BddMap(BddMap&& from) : bdd(from.bdd), handle(from.handle) {
+        if (handle != NULL) sylvan_handle_set(handle, &bdd);
+        from.bdd = sylvan_map_empty();
+        from.handle = NULL;
+    }
+    BddMap() : bdd(sylvan_map_empty()), handle(sylvan_handle_get(&bdd)) {}
+    ~BddMap() { if (handle != NULL) sylvan_handle_put(handle); }
+
+    BddMap& operator=(const BddMap& right) { assign(right.bdd); return *this; }
+    BddMap& operator=(BddMap&& right) {
+        if (this != &right) {
+            if (handle != NULL) sylvan_handle_put(handle);
+            bdd = right.bdd;
+            handle = right.handle;
+            if (handle != NULL) sylvan_handle_set(handle, &bdd);
+            right.bdd = sylvan_map_empty();
+            right.handle = NULL;
+        }
+        return *this;
+    }
 
     BddMap(uint32_t key_variable, const Bdd value);
 
@@ -515,6 +576,12 @@ public:
      * @brief Returns non-zero when this map is empty
      */
     bool isEmpty() const;
+
+private:
+    void assign(BDD value) {
+        if (handle == NULL) handle = sylvan_handle_get(&bdd);
+        bdd = value;
+    }
 };
 
 class MtbddMap;
@@ -524,11 +591,20 @@ class Mtbdd {
     friend class MtbddMap;
 
 public:
-    Mtbdd() { mtbdd = sylvan_false; mtbdd_protect(&mtbdd); }
-    Mtbdd(const MTBDD from) : mtbdd(from) { mtbdd_protect(&mtbdd); }
-    Mtbdd(const Mtbdd &from) : mtbdd(from.mtbdd) { mtbdd_protect(&mtbdd); }
-    Mtbdd(const Bdd &from) : mtbdd(from.bdd) { mtbdd_protect(&mtbdd); }
-    ~Mtbdd() { mtbdd_unprotect(&mtbdd); }
+    Mtbdd() : mtbdd(mtbdd_false), handle(mtbdd_handle_get(&mtbdd)) {}
+    Mtbdd(const MTBDD from) : mtbdd(from), handle(mtbdd_handle_get(&mtbdd)) {}
+    Mtbdd(const Mtbdd &from) : mtbdd(from.mtbdd), handle(mtbdd_handle_get(&mtbdd)) {}
+    Mtbdd(const Bdd &from) : mtbdd(from.bdd), handle(mtbdd_handle_get(&mtbdd)) {}
+    ~Mtbdd() { if (handle != NULL) mtbdd_handle_put(handle); }
+
+    /**
+     * @brief Moves the Mtbdd and its handle; <from> becomes mtbddZero() until it is assigned again.
+     */
+    Mtbdd(Mtbdd &&from) : mtbdd(from.mtbdd), handle(from.handle) {
+        if (handle != NULL) mtbdd_handle_set(handle, &mtbdd);
+        from.mtbdd = mtbdd_false;
+        from.handle = NULL;
+    }
 
     /**
      * @brief Creates a Mtbdd leaf representing the int64 value <value>
@@ -595,13 +671,19 @@ public:
     bool operator==(const Mtbdd& other) const;
     bool operator!=(const Mtbdd& other) const;
     Mtbdd& operator=(const Mtbdd& right);
-    Mtbdd operator!() const;
-    Mtbdd operator~() const;
-    Mtbdd operator*(const Mtbdd& other) const;
+    Mtbdd& operator=(Mtbdd&& right);
+    Mtbdd operator!() const &;
+    Mtbdd operator!() &&;
+    Mtbdd operator~() const &;
+    Mtbdd operator~() &&;
+    Mtbdd operator*(const Mtbdd& other) const &;
+    Mtbdd operator*(const Mtbdd& other) &&;
     Mtbdd& operator*=(const Mtbdd& other);
-    Mtbdd operator+(const Mtbdd& other) const;
+    Mtbdd operator+(const Mtbdd& other) const &;
+    Mtbdd operator+(const Mtbdd& other) &&;
     Mtbdd& operator+=(const Mtbdd& other);
-    Mtbdd operator-(const Mtbdd& other) const;
+    Mtbdd operator-(const Mtbdd& other) const &;
+    Mtbdd operator-(const Mtbdd& other) &&;
     Mtbdd& operator-=(const Mtbdd& other);
 
     // not implemented (compared to Bdd): <=, >=, <, >, &, &=, |, |=, ^, ^=
@@ -775,17 +857,46 @@ public:
 
 private:
     MTBDD mtbdd;
+    uint64_t *handle; // protects mtbdd during garbage collection, NULL after a move
+
+    /**
+     * @brief Sets the value, and takes a new handle if this Mtbdd was moved
+     */
+    void assign(MTBDD value) {
+        if (handle == NULL) handle = mtbdd_handle_get(&mtbdd);
+        mtbdd = value;
+    }
 };
 
 class MtbddMap
 {
     friend class Mtbdd;
     MTBDD mtbdd;
-    MtbddMap(MTBDD from) : mtbdd(from) { mtbdd_protect(&mtbdd); }
-    MtbddMap(Mtbdd &from) : mtbdd(from.mtbdd) { mtbdd_protect(&mtbdd); }
+    uint64_t *handle;
+    MtbddMap(MTBDD from) : mtbdd(from), handle(mtbdd_handle_get(&mtbdd)) {}
+    MtbddMap(Mtbdd &from) : mtbdd(from.mtbdd), handle(mtbdd_handle_get(&mtbdd)) {}
 public:
-    MtbddMap() : mtbdd(mtbdd_map_empty()) { mtbdd_protect(&mtbdd); }
-    ~MtbddMap() { mtbdd_unprotect(&mtbdd); }
+    MtbddMap(const MtbddMap& from) : mtbdd(from.mtbdd), handle(mtbdd_handle_get(&mtbdd)) {}
+    MtbddMap(MtbddMap&& from) : mtbdd(from.mtbdd), handle(from.handle) {
+        if (handle != NULL) mtbdd_handle_set(handle, &mtbdd);
+        from.mtbdd = mtbdd_map_empty();
+        from.handle = NULL;
+    }
+    MtbddMap() : mtbdd(mtbdd_map_empty()), handle(mtbdd_handle_get(&mtbdd)) {}
+    ~MtbddMap() { if (handle != NULL) mtbdd_handle_put(handle); }
+
+    MtbddMap& operator=(const MtbddMap& right) { assign(right.mtbdd); return *this; }
+    MtbddMap& operator=(MtbddMap&& right) {
+        if (this != &right) {
+            if (handle != NULL) mtbdd_handle_put(handle);
+            mtbdd = right.mtbdd;
+            handle = right.handle;
+            if (handle != NULL) mtbdd_handle_set(handle, &mtbdd);
+            right.mtbdd = mtbdd_map_empty();
+            right.handle = NULL;
+        }
+        return *this;
+    }
 
     MtbddMap(uint32_t key_variable, Mtbdd value);
 
@@ -813,6 +924,293 @@ public:
      * @brief Returns non-zero when this map is empty
      */
     bool isEmpty();
+
+private:
+    void assign(MTBDD value) {
+        if (handle == NULL) handle = mtbdd_handle_get(&mtbdd);
+        mtbdd = value;
+    }
+};
+
+class Ldd {
+    friend class Sylvan;
+
+public:
+    Ldd() : mdd(lddmc_false), handle(lddmc_handle_get(&mdd)) {}
+    Ldd(const MDD from) : mdd(from), handle(lddmc_handle_get(&mdd)) {}
+    Ldd(const Ldd &from) : mdd(from.mdd), handle(lddmc_handle_get(&mdd)) {}
+    ~Ldd() { if (handle != NULL) lddmc_handle_put(handle); }
+
+    /**
+     * @brief Moves the Ldd and its handle; <from> becomes lddFalse() until it is assigned again.
+     */
+    Ldd(Ldd &&from) : mdd(from.mdd), handle(from.handle) {
+        if (handle != NULL) lddmc_handle_set(handle, &mdd);
+        from.mdd = lddmc_false;
+        from.handle = NULL;
+    }
+
+    /**
+     * @brief Returns the Ldd representing the set containing only the empty vector
+     */
+    static Ldd lddTrue();
+
+    /**
+     * @brief Returns the Ldd representing the empty set
+     */
+    static Ldd lddFalse();
+
+    /**
+     * @brief Returns the Ldd representing the set containing only the vector <values>
+     */
+    static Ldd lddCube(std::vector<uint32_t> values);
+
+    bool operator==(const Ldd& other) const;
+    bool operator!=(const Ldd& other) const;
+    Ldd& operator=(const Ldd& right);
+    Ldd& operator=(Ldd&& right);
+
+    /**
+     * @brief Set union (lddmc_union)
+     */
+    Ldd operator|(const Ldd& other) const &;
+    Ldd operator|(const Ldd& other) &&;
+    Ldd& operator|=(const Ldd& other);
+
+    /**
+     * @brief Set intersection (lddmc_intersect)
+     */
+    Ldd operator&(const Ldd& other) const &;
+    Ldd operator&(const Ldd& other) &&;
+    Ldd& operator&=(const Ldd& other);
+
+    /**
+     * @brief Set difference (lddmc_minus)
+     */
+    Ldd operator-(const Ldd& other) const &;
+    Ldd operator-(const Ldd& other) &&;
+    Ldd& operator-=(const Ldd& other);
+
+    /**
+     * @brief Returns true if this Ldd is lddTrue()
+     */
+    bool isTrue() const;
+
+    /**
+     * @brief Returns true if this Ldd is lddFalse()
+     */
+    bool isFalse() const;
+
+    /**
+     * @brief Returns the value in the root node of this Ldd
+     */
+    uint32_t Value() const;
+
+    /**
+     * @brief Follows the "down" edge of the root node of this Ldd (the vectors that continue with Value())
+     */
+    Ldd Down() const;
+
+    /**
+     * @brief Follows the "right" edge of the root node of this Ldd (the vectors with a higher first value)
+     */
+    Ldd Right() const;
+
+    /**
+     * @brief Returns true if this Ldd contains the vector <values>
+     */
+    bool Contains(std::vector<uint32_t> values) const;
+
+    /**
+     * @brief Computes the successors of this set of states according to the relation <rel>.
+     * @param meta describes how <rel> reads and writes the vector, see lddmc_relprod
+     */
+    Ldd RelProd(const Ldd& rel, const Ldd& meta) const;
+
+    /**
+     * @brief Computes the predecessors of this set of states in <universe> according to the relation <rel>.
+     * @param meta describes how <rel> reads and writes the vector, see lddmc_relprod
+     */
+    Ldd RelPrev(const Ldd& rel, const Ldd& meta, const Ldd& universe) const;
+
+    /**
+     * @brief Projects this set onto the positions in <proj>, see lddmc_project
+     */
+    Ldd Project(const Ldd& proj) const;
+
+    /**
+     * @brief Computes the number of vectors in this set
+     */
+    double SatCount() const;
+
+    /**
+     * @brief Gets the number of nodes in this Ldd. Not thread-safe!
+     */
+    size_t NodeCount() const;
+
+    /**
+     * @brief Gets the MDD of this Ldd (for C functions)
+     */
+    MDD GetLDD() const;
+
+private:
+    MDD mdd;
+    uint64_t *handle; // protects mdd during garbage collection, NULL after a move
+
+    /**
+     * @brief Sets the value, and takes a new handle if this Ldd was moved
+     */
+    void assign(MDD value) {
+        if (handle == NULL) handle = lddmc_handle_get(&mdd);
+        mdd = value;
+    }
+};
+
+class Zdd {
+    friend class Sylvan;
+
+public:
+    Zdd() : zdd(zdd_false), handle(zdd_handle_get(&zdd)) {}
+    Zdd(const ZDD from) : zdd(from), handle(zdd_handle_get(&zdd)) {}
+    Zdd(const Zdd &from) : zdd(from.zdd), handle(zdd_handle_get(&zdd)) {}
+    ~Zdd() { if (handle != NULL) zdd_handle_put(handle); }
+
+    /**
+     * @brief Moves the Zdd and its handle; <from> becomes zddZero() until it is assigned again.
+     */
+    Zdd(Zdd &&from) : zdd(from.zdd), handle(from.handle) {
+        if (handle != NULL) zdd_handle_set(handle, &zdd);
+        from.zdd = zdd_false;
+        from.handle = NULL;
+    }
+
+    /**
+     * @brief Converts the Bdd <from> to a Zdd on the variables <domain>
+     */
+    Zdd(const Bdd &from, const BddSet &domain);
+
+    /**
+     * @brief Returns the Zdd representing "True" on the empty domain (the set containing the empty set)
+     */
+    static Zdd zddOne();
+
+    /**
+     * @brief Returns the Zdd representing "False" (the empty set)
+     */
+    static Zdd zddZero();
+
+    /**
+     * @brief Returns the Zdd representing the positive literal of variable <var>
+     */
+    static Zdd zddVar(uint32_t var);
+
+    /**
+     * @brief Returns the variable domain containing the variables <variables>, which is also "True" on that domain
+     */
+    static Zdd zddDomain(std::vector<uint32_t> variables);
+
+    bool operator==(const Zdd& other) const;
+    bool operator!=(const Zdd& other) const;
+    Zdd& operator=(const Zdd& right);
+    Zdd& operator=(Zdd&& right);
+
+    /**
+     * @brief Logical and (zdd_and)
+     */
+    Zdd operator&(const Zdd& other) const &;
+    Zdd operator&(const Zdd& other) &&;
+    Zdd& operator&=(const Zdd& other);
+
+    /**
+     * @brief Logical or (zdd_or)
+     */
+    Zdd operator|(const Zdd& other) const &;
+    Zdd operator|(const Zdd& other) &&;
+    Zdd& operator|=(const Zdd& other);
+
+    /**
+     * @brief Set difference, i.e., this and not <other> (zdd_diff)
+     */
+    Zdd operator-(const Zdd& other) const &;
+    Zdd operator-(const Zdd& other) &&;
+    Zdd& operator-=(const Zdd& other);
+
+    /**
+     * @brief Returns true if this Zdd is zddOne()
+     */
+    bool isOne() const;
+
+    /**
+     * @brief Returns true if this Zdd is zddZero()
+     */
+    bool isZero() const;
+
+    /**
+     * @brief Returns true if this Zdd is a leaf
+     */
+    bool isLeaf() const;
+
+    /**
+     * @brief Returns the top variable index of this Zdd (the variable in the root node)
+     */
+    uint32_t TopVar() const;
+
+    /**
+     * @brief Follows the high edge ("then") of the root node of this Zdd
+     */
+    Zdd Then() const;
+
+    /**
+     * @brief Follows the low edge ("else") of the root node of this Zdd
+     */
+    Zdd Else() const;
+
+    /**
+     * @brief Computes the negation of this Zdd on the variable domain <domain>
+     */
+    Zdd Not(const Zdd& domain) const;
+
+    /**
+     * @brief Computes IF this THEN <g> ELSE <h> on the variable domain <domain>
+     */
+    Zdd Ite(const Zdd& g, const Zdd& h, const Zdd& domain) const;
+
+    /**
+     * @brief Computes \exists <variables>: this
+     */
+    Zdd ExistAbstract(const Zdd& variables) const;
+
+    /**
+     * @brief Converts this Zdd on the variable domain <domain> to a Bdd
+     */
+    Bdd ToBdd(const Zdd& domain) const;
+
+    /**
+     * @brief Computes the number of satisfying assignments (the number of paths to True)
+     */
+    double SatCount() const;
+
+    /**
+     * @brief Gets the number of nodes in this Zdd. Not thread-safe!
+     */
+    size_t NodeCount() const;
+
+    /**
+     * @brief Gets the ZDD of this Zdd (for C functions)
+     */
+    ZDD GetZDD() const;
+
+private:
+    ZDD zdd;
+    uint64_t *handle; // protects zdd during garbage collection, NULL after a move
+
+    /**
+     * @brief Sets the value, and takes a new handle if this Zdd was moved
+     */
+    void assign(ZDD value) {
+        if (handle == NULL) handle = zdd_handle_get(&zdd);
+        zdd = value;
+    }
 };
 
 class Sylvan {
@@ -849,6 +1247,16 @@ public:
      */
     static void initMtbdd();
 
+    /**
+     * @brief Initializes the LDD module of the Sylvan framework.
+     */
+    static void initLdd();
+
+    /**
+     * @brief Initializes the ZDD module of the Sylvan framework.
+     */
+    static void initZdd();
+
     /**
      * @brief Frees all memory in use by Sylvan.
      * Warning: if you have any Bdd objects which are not bddZero() or bddOne() after this, your program may crash!
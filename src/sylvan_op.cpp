@@ -0,0 +1,27 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_op.hpp>
+
+namespace sylvan {
+
+TASK_IMPL_5(uint64_t, sylvan_op_task, void*, fn, uint64_t, a, uint64_t, b, uint64_t, c, void*, state)
+{
+    return ((sylvan_op_fn)fn)(__lace_worker, __lace_dq_head, a, b, c, state);
+}
+
+}
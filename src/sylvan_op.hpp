@@ -0,0 +1,285 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYLVAN_OP_H
+#define SYLVAN_OP_H
+
+#include <atomic>
+#include <exception>
+#include <type_traits>
+
+#include <sylvan_obj.hpp>
+#include <sylvan_cache.h>
+
+namespace sylvan {
+
+/**
+ * User-defined parallel operations on decision diagrams in C++, with the same structure as the
+ * operations of Sylvan, but without the TASK macros.
+ *
+ * An operation is a class that derives from Operation<Op> and implements
+ *
+ *     static MTBDD compute(OpContext<Op> &ctx, MTBDD a, ...);
+ *
+ * with one to three arguments. The first argument is a decision diagram; the others are decision
+ * diagrams or integers of at most 64 bits. compute is called for every recursive step. It uses the
+ * context to spawn, call and sync the recursive steps, and to access the operation cache with the
+ * arguments as key. The context keeps the results of the recursive steps safe from garbage collection
+ * until compute returns. Run the operation with Op::run(a, ...), which returns the MTBDD like the
+ * C functions of Sylvan.
+ *
+ * If compute throws an exception, the other recursive steps are cancelled and run throws the
+ * exception. Results computed with raw C functions in compute can be protected with ctx.push.
+ *
+ * Example:
+ *
+ *     struct And : public Operation<And> {
+ *         static MTBDD compute(OpContext<And> &ctx, MTBDD a, MTBDD b) {
+ *             if (a == mtbdd_false || b == mtbdd_false) return mtbdd_false;
+ *             if (a == mtbdd_true) return b;
+ *             if (b == mtbdd_true) return a;
+ *             MTBDD result;
+ *             if (ctx.cache_get(result, a, b)) return result;
+ *             uint32_t var = ...;
+ *             ctx.spawn(mtbdd_gethigh(a), mtbdd_gethigh(b));
+ *             MTBDD low = ctx.call(mtbdd_getlow(a), mtbdd_getlow(b));
+ *             MTBDD high = ctx.sync();
+ *             result = mtbdd_makenode(var, low, high);
+ *             ctx.cache_put(result, a, b);
+ *             return result;
+ *         }
+ *     };
+ *     Bdd c = And::run(a, b);
+ */
+
+typedef uint64_t (*sylvan_op_fn)(WorkerP*, Task*, uint64_t, uint64_t, uint64_t, void*);
+
+/**
+ * The Lace task that runs every step of every user-defined operation, with the operation as <fn>
+ */
+TASK_DECL_5(uint64_t, sylvan_op_task, void*, uint64_t, uint64_t, uint64_t, void*);
+
+/**
+ * The state of one run of an operation, shared by all its steps
+ */
+struct OpState
+{
+    std::atomic<int> failed;        // set when a step throws; the other steps are cancelled
+    std::exception_ptr error;       // the first exception, written by the step that set <failed>
+
+    OpState() : failed(0) {}
+};
+
+/**
+ * Thrown by the steps of a cancelled operation
+ */
+struct OpCancelled {};
+
+/**
+ * The cache key of an argument of an operation
+ */
+static inline uint64_t op_key(const Bdd &dd) { return dd.GetBDD(); }
+static inline uint64_t op_key(const Mtbdd &dd) { return dd.GetMTBDD(); }
+template <typename T>
+static inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, uint64_t>::type
+op_key(T value) { return (uint64_t)value; }
+
+template <typename Op> class Operation;
+
+/**
+ * The context of one step of the operation Op. The Lace macros in the methods use the members
+ * __lace_worker and __lace_dq_head, like the body of a TASK.
+ */
+template <typename Op>
+class OpContext
+{
+    friend class Operation<Op>;
+
+public:
+    /**
+     * @brief Spawns the step with the given arguments, to be synced with sync()
+     */
+    template <typename... Args>
+    void spawn(Args... args) {
+        check_args<Args...>();
+        const uint64_t k[] = { op_key(args)..., 0, 0 };
+        mtbdd_refs_spawn(SPAWN(sylvan_op_task, (void*)&Operation<Op>::step, k[0], k[1], k[2], state));
+        spawned++;
+    }
+
+    /**
+     * @brief Syncs the last spawned step and returns its result, which is protected until compute returns
+     */
+    MTBDD sync() {
+        MTBDD result = mtbdd_refs_sync(SYNC(sylvan_op_task));
+        spawned--;
+        return check(result);
+    }
+
+    /**
+     * @brief Runs the step with the given arguments and returns its result, which is protected until
+     * compute returns
+     */
+    template <typename... Args>
+    MTBDD call(Args... args) {
+        check_args<Args...>();
+        const uint64_t k[] = { op_key(args)..., 0, 0 };
+        return check(CALL(sylvan_op_task, (void*)&Operation<Op>::step, k[0], k[1], k[2], state));
+    }
+
+    /**
+     * @brief Protects <dd> from garbage collection until compute returns
+     */
+    MTBDD push(MTBDD dd) {
+        mtbdd_refs_push(dd);
+        pushed++;
+        return dd;
+    }
+
+    /**
+     * @brief Obtains the result of the step with the given arguments from the operation cache
+     */
+    template <typename... Args>
+    bool cache_get(MTBDD &result, Args... args) {
+        check_args<Args...>();
+        const uint64_t k[] = { op_key(args)..., 0, 0 };
+        return cache_get3(Operation<Op>::opid(), k[0], k[1], k[2], &result);
+    }
+
+    /**
+     * @brief Stores the result of the step with the given arguments in the operation cache
+     */
+    template <typename... Args>
+    void cache_put(MTBDD result, Args... args) {
+        check_args<Args...>();
+        const uint64_t k[] = { op_key(args)..., 0, 0 };
+        cache_put3(Operation<Op>::opid(), k[0], k[1], k[2], result);
+    }
+
+    /**
+     * @brief Syncs the steps that are still spawned and releases the protected results
+     */
+    ~OpContext() {
+        while (spawned > 0) {
+            mtbdd_refs_sync(SYNC(sylvan_op_task));
+            spawned--;
+        }
+        if (pushed > 0) mtbdd_refs_pop(pushed);
+    }
+
+    WorkerP *__lace_worker;
+    Task *__lace_dq_head;
+
+private:
+    OpState *state;
+    long pushed;
+    long spawned;
+
+    OpContext(WorkerP *w, Task *dq, OpState *s) : __lace_worker(w), __lace_dq_head(dq), state(s), pushed(0), spawned(0) {}
+    OpContext(const OpContext&) = delete;
+    OpContext& operator=(const OpContext&) = delete;
+
+    template <typename... Args>
+    static void check_args() {
+        static_assert(sizeof...(Args) >= 1 && sizeof...(Args) <= 3, "operations have one to three arguments");
+    }
+
+    /**
+     * Protects the result of a step, or throws OpCancelled if the operation is cancelled
+     */
+    MTBDD check(MTBDD result) {
+        if (state->failed.load(std::memory_order_relaxed)) throw OpCancelled();
+        return push(result);
+    }
+};
+
+/**
+ * Base class of user-defined operations; see above
+ */
+template <typename Op>
+class Operation
+{
+    friend class OpContext<Op>;
+
+public:
+    /**
+     * @brief Runs the operation on the given arguments, and throws the exception of compute if any
+     */
+    template <typename... Args>
+    static MTBDD run(const Args&... args) {
+        static_assert(sizeof...(Args) >= 1 && sizeof...(Args) <= 3, "operations have one to three arguments");
+        const uint64_t k[] = { op_key(args)..., 0, 0 };
+        OpState state;
+        MTBDD result = RUN(sylvan_op_task, (void*)&step, k[0], k[1], k[2], &state);
+        if (state.failed) std::rethrow_exception(state.error);
+        return result;
+    }
+
+    /**
+     * @brief The operation id of Op in the operation cache
+     */
+    static uint64_t opid() {
+        static const uint64_t id = cache_next_opid();
+        return id;
+    }
+
+private:
+    template <typename... Args>
+    static MTBDD apply(OpContext<Op> &ctx, MTBDD (*compute)(OpContext<Op>&, Args...), const uint64_t *k) {
+        return apply_n(ctx, compute, k, std::integral_constant<size_t, sizeof...(Args)>());
+    }
+
+    template <typename F>
+    static MTBDD apply_n(OpContext<Op> &ctx, F compute, const uint64_t *k, std::integral_constant<size_t, 1>) {
+        return compute(ctx, k[0]);
+    }
+
+    template <typename F>
+    static MTBDD apply_n(OpContext<Op> &ctx, F compute, const uint64_t *k, std::integral_constant<size_t, 2>) {
+        return compute(ctx, k[0], k[1]);
+    }
+
+    template <typename F>
+    static MTBDD apply_n(OpContext<Op> &ctx, F compute, const uint64_t *k, std::integral_constant<size_t, 3>) {
+        return compute(ctx, k[0], k[1], k[2]);
+    }
+
+    /**
+     * One step of the operation, run by sylvan_op_task. Exceptions do not leave the step.
+     */
+    static uint64_t step(WorkerP *__lace_worker, Task *__lace_dq_head, uint64_t a, uint64_t b, uint64_t c, void *s) {
+        OpState *state = (OpState*)s;
+        if (state->failed.load(std::memory_order_relaxed)) return mtbdd_invalid;
+
+        sylvan_gc_test();
+
+        const uint64_t k[] = { a, b, c };
+        try {
+            OpContext<Op> ctx(__lace_worker, __lace_dq_head, state);
+            return apply(ctx, &Op::compute, k);
+        } catch (const OpCancelled&) {
+        } catch (...) {
+            int expected = 0;
+            if (state->failed.compare_exchange_strong(expected, 1)) state->error = std::current_exception();
+        }
+        return mtbdd_invalid;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,314 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <errno.h>
+#include <string.h>
+
+#if SYLVAN_USE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <sylvan_packed.h>
+
+static const char packed_magic[8] = { 'S', 'Y', 'L', 'V', 'A', 'N', 'D', 'P' };
+
+#define PACKED_VERSION 1
+#define PACKED_FLAG_ZLIB 1
+
+/* Size of the (uncompressed) blocks */
+#define PACKED_BLOCK 1048576
+/* Number of nodes that are encoded at once */
+#define PACKED_CHUNK 262144
+/* Number of nodes per task when encoding in parallel */
+#define PACKED_NODES_PER_TASK 4096
+
+/**
+ * The format of mtbdd_writer_tobinary, zdd_writer_tobinary and lddmc_serialize_tofile
+ */
+static sylvan_binary_format binary_format = SYLVAN_BINARY_RAW;
+
+int
+sylvan_set_binary_format(sylvan_binary_format format)
+{
+#if !SYLVAN_USE_ZLIB
+    if (format == SYLVAN_BINARY_PACKED_ZLIB) return -1;
+#endif
+    if (format > SYLVAN_BINARY_PACKED_ZLIB) return -1;
+    binary_format = format;
+    return 0;
+}
+
+sylvan_binary_format
+sylvan_get_binary_format()
+{
+    return binary_format;
+}
+
+int
+sylvan_packed_is_magic(uint64_t word)
+{
+    return memcmp(&word, packed_magic, sizeof(packed_magic)) == 0 ? 1 : 0;
+}
+
+static void*
+packed_alloc(size_t size)
+{
+    void *res = malloc(size > 0 ? size : 1);
+    if (res == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for a packed stream: %s!\n", size, strerror(errno));
+        exit(1);
+    }
+    return res;
+}
+
+/**
+ * Writing
+ *
+ * Every block is written as two 32-bit numbers, the size of the data and the size
+ * as stored, followed by the stored data. If both sizes are equal, the block is not
+ * compressed. The stream ends with an empty block.
+ */
+
+struct sylvan_packed_out
+{
+    FILE *out;
+    int compress;
+    size_t len;                 // number of bytes in the block
+    uint8_t *block;             // the current block
+    uint8_t *zbuf;              // buffer for the compressed block
+    size_t zlen;                // size of the compressed buffer
+};
+
+static void
+packed_flush(sylvan_packed_out_t p)
+{
+    if (p->len == 0) return;
+    uint32_t sizes[2] = { (uint32_t)p->len, (uint32_t)p->len };
+    const uint8_t *data = p->block;
+#if SYLVAN_USE_ZLIB
+    if (p->compress) {
+        uLongf zlen = (uLongf)p->zlen;
+        if (compress2(p->zbuf, &zlen, p->block, (uLong)p->len, 1) == Z_OK && zlen < p->len) {
+            sizes[1] = (uint32_t)zlen;
+            data = p->zbuf;
+        }
+    }
+#endif
+    fwrite(sizes, sizeof(uint32_t), 2, p->out);
+    fwrite(data, 1, sizes[1], p->out);
+    p->len = 0;
+}
+
+sylvan_packed_out_t
+sylvan_packed_out_open(FILE *out, int compress)
+{
+    sylvan_packed_out_t p = (sylvan_packed_out_t)packed_alloc(sizeof(struct sylvan_packed_out));
+    p->out = out;
+    p->compress = compress;
+    p->len = 0;
+    p->block = (uint8_t*)packed_alloc(PACKED_BLOCK);
+    p->zbuf = NULL;
+    p->zlen = 0;
+#if SYLVAN_USE_ZLIB
+    if (compress) {
+        p->zlen = compressBound(PACKED_BLOCK);
+        p->zbuf = (uint8_t*)packed_alloc(p->zlen);
+    }
+#else
+    p->compress = 0;
+#endif
+
+    uint32_t header[2] = { PACKED_VERSION, p->compress ? PACKED_FLAG_ZLIB : 0 };
+    fwrite(packed_magic, 1, sizeof(packed_magic), out);
+    fwrite(header, sizeof(uint32_t), 2, out);
+    return p;
+}
+
+void
+sylvan_packed_append(sylvan_packed_out_t p, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        size_t n = PACKED_BLOCK - p->len;
+        if (n > len) n = len;
+        memcpy(p->block + p->len, buf, n);
+        p->len += n;
+        buf += n;
+        len -= n;
+        if (p->len == PACKED_BLOCK) packed_flush(p);
+    }
+}
+
+void
+sylvan_packed_put(sylvan_packed_out_t p, uint64_t value)
+{
+    uint8_t buf[SYLVAN_PACKED_MAX_VARINT];
+    sylvan_packed_append(p, buf, sylvan_packed_encode(buf, value));
+}
+
+int
+sylvan_packed_out_close(sylvan_packed_out_t p)
+{
+    packed_flush(p);
+    uint32_t end[2] = { 0, 0 };
+    fwrite(end, sizeof(uint32_t), 2, p->out);
+    int res = ferror(p->out) ? -1 : 0;
+    free(p->block);
+    free(p->zbuf);
+    free(p);
+    return res;
+}
+
+/**
+ * The writer and callback of sylvan_packed_write_nodes
+ */
+typedef struct packed_encode {
+    sylvan_writer_t w;
+    size_t max_node;
+    sylvan_packed_encode_cb encode_cb;
+} packed_encode;
+
+/**
+ * Encode the nodes <first>...<first+count-1>, where node <first> starts at <buf> and
+ * <lens> gets the number of bytes of every range of PACKED_NODES_PER_TASK nodes.
+ */
+VOID_TASK_5(sylvan_packed_encode_par, packed_encode*, e, uint64_t, first, size_t, count, uint8_t*, buf, size_t*, lens)
+{
+    if (count > PACKED_NODES_PER_TASK) {
+        size_t split = ((count/2 + PACKED_NODES_PER_TASK - 1) / PACKED_NODES_PER_TASK) * PACKED_NODES_PER_TASK;
+        SPAWN(sylvan_packed_encode_par, e, first, split, buf, lens);
+        CALL(sylvan_packed_encode_par, e, first+split, count-split, buf+e->max_node*split, lens+split/PACKED_NODES_PER_TASK);
+        SYNC(sylvan_packed_encode_par);
+    } else {
+        lens[0] = WRAP(e->encode_cb, e->w, first, count, buf);
+    }
+}
+
+VOID_TASK_IMPL_6(sylvan_packed_write_nodes, sylvan_packed_out_t, p, sylvan_writer_t, w, uint64_t, first, uint64_t, last, size_t, max_node, sylvan_packed_encode_cb, encode_cb)
+{
+    if (first > last) return;
+    packed_encode e = { w, max_node, encode_cb };
+    uint8_t *buf = (uint8_t*)packed_alloc(max_node * PACKED_CHUNK);
+    size_t *lens = (size_t*)packed_alloc(sizeof(size_t) * (PACKED_CHUNK / PACKED_NODES_PER_TASK));
+    while (first <= last) {
+        size_t count = last - first + 1;
+        if (count > PACKED_CHUNK) count = PACKED_CHUNK;
+        CALL(sylvan_packed_encode_par, &e, first, count, buf, lens);
+        for (size_t i=0; i*PACKED_NODES_PER_TASK<count; i++) {
+            sylvan_packed_append(p, buf + max_node*PACKED_NODES_PER_TASK*i, lens[i]);
+        }
+        first += count;
+    }
+    free(lens);
+    free(buf);
+}
+
+/**
+ * Reading
+ */
+
+struct sylvan_packed_in
+{
+    FILE *in;
+    int compressed;
+    size_t len;                 // number of bytes in the block
+    size_t pos;                 // position in the block
+    int end;                    // set when the empty block was read
+    uint8_t *block;
+    uint8_t *zbuf;
+};
+
+/**
+ * Read the next block. Returns 0 on success, -1 on error or at the end of the stream.
+ */
+static int
+packed_next_block(sylvan_packed_in_t p)
+{
+    if (p->end) return -1;
+    uint32_t sizes[2];
+    if (fread(sizes, sizeof(uint32_t), 2, p->in) != 2) return -1;
+    if (sizes[0] == 0) {
+        p->end = 1;
+        return -1;
+    }
+    if (sizes[0] > PACKED_BLOCK || sizes[1] > sizes[0]) return -1;
+    if (sizes[1] == sizes[0]) {
+        if (fread(p->block, 1, sizes[0], p->in) != sizes[0]) return -1;
+    } else {
+#if SYLVAN_USE_ZLIB
+        if (!p->compressed) return -1;
+        if (fread(p->zbuf, 1, sizes[1], p->in) != sizes[1]) return -1;
+        uLongf len = PACKED_BLOCK;
+        if (uncompress(p->block, &len, p->zbuf, sizes[1]) != Z_OK || len != sizes[0]) return -1;
+#else
+        return -1;
+#endif
+    }
+    p->len = sizes[0];
+    p->pos = 0;
+    return 0;
+}
+
+sylvan_packed_in_t
+sylvan_packed_in_open(FILE *in)
+{
+    uint32_t header[2];
+    if (fread(header, sizeof(uint32_t), 2, in) != 2) return NULL;
+    if (header[0] != PACKED_VERSION) return NULL;
+    if (header[1] & ~PACKED_FLAG_ZLIB) return NULL;
+#if !SYLVAN_USE_ZLIB
+    if (header[1] & PACKED_FLAG_ZLIB) return NULL;
+#endif
+
+    sylvan_packed_in_t p = (sylvan_packed_in_t)packed_alloc(sizeof(struct sylvan_packed_in));
+    p->in = in;
+    p->compressed = header[1] & PACKED_FLAG_ZLIB ? 1 : 0;
+    p->len = 0;
+    p->pos = 0;
+    p->end = 0;
+    p->block = (uint8_t*)packed_alloc(PACKED_BLOCK);
+    p->zbuf = p->compressed ? (uint8_t*)packed_alloc(PACKED_BLOCK) : NULL;
+    return p;
+}
+
+int
+sylvan_packed_get(sylvan_packed_in_t p, uint64_t *value)
+{
+    uint64_t res = 0;
+    for (unsigned shift=0; shift<64; shift+=7) {
+        if (p->pos == p->len && packed_next_block(p) != 0) return -1;
+        uint8_t b = p->block[p->pos++];
+        res |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            *value = res;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int
+sylvan_packed_in_close(sylvan_packed_in_t p)
+{
+    /* all data must be used and the next block must be the empty block */
+    int res = (p->pos == p->len && packed_next_block(p) != 0 && p->end) ? 0 : -1;
+    free(p->block);
+    free(p->zbuf);
+    free(p);
+    return res;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYLVAN_PACKED_H
+#define SYLVAN_PACKED_H
+
+#include <sylvan_writer.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Packed node stream for the binary writers and readers in Sylvan.
+ *
+ * Instead of 16 bytes per node, the nodes are written as a stream of varints (7 bits
+ * per byte, the high bit is set on all but the last byte). References to children are
+ * stored relative to the number of the node itself, so they are small when the nodes
+ * are numbered in level order. The stream is written in blocks of 1 MB, which are
+ * optionally compressed with zlib.
+ *
+ * The stream starts with the 8 bytes "SYLVANDP", so readers can distinguish it from
+ * the node count that starts the raw format.
+ */
+typedef struct sylvan_packed_out *sylvan_packed_out_t;
+typedef struct sylvan_packed_in *sylvan_packed_in_t;
+
+/* Maximum number of bytes of one varint */
+#define SYLVAN_PACKED_MAX_VARINT 10
+
+/**
+ * Returns 1 if the given 8 bytes (read as the node count of the raw format) are the
+ * start of a packed stream.
+ */
+int sylvan_packed_is_magic(uint64_t word);
+
+/**
+ * Start a packed stream on <out>, compressed with zlib if <compress> is set.
+ */
+sylvan_packed_out_t sylvan_packed_out_open(FILE *out, int compress);
+
+/**
+ * Write one varint to the stream.
+ */
+void sylvan_packed_put(sylvan_packed_out_t p, uint64_t value);
+
+/**
+ * Write <len> bytes of encoded varints to the stream.
+ */
+void sylvan_packed_append(sylvan_packed_out_t p, const uint8_t *buf, size_t len);
+
+/**
+ * Finish the stream and free <p>. Returns 0 on success, -1 if writing failed.
+ */
+int sylvan_packed_out_close(sylvan_packed_out_t p);
+
+/**
+ * Continue reading a packed stream from <in>, after the magic bytes were read.
+ * Returns NULL if the stream is invalid or uses compression that is not available.
+ */
+sylvan_packed_in_t sylvan_packed_in_open(FILE *in);
+
+/**
+ * Read one varint from the stream. Returns 0 on success, -1 on error.
+ */
+int sylvan_packed_get(sylvan_packed_in_t p, uint64_t *value);
+
+/**
+ * Read the end of the stream and free <p>. Returns 0 on success, -1 on error.
+ */
+int sylvan_packed_in_close(sylvan_packed_in_t p);
+
+/**
+ * Encode <value> as a varint to <buf>, returns the number of bytes.
+ */
+static inline size_t
+sylvan_packed_encode(uint8_t *buf, uint64_t value)
+{
+    size_t len = 0;
+    while (value >= 0x80) {
+        buf[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[len++] = (uint8_t)value;
+    return len;
+}
+
+/**
+ * Encode the reference to <ref> from node <number>. References below <terminals> are
+ * the terminals and are kept; the nodes are numbered from <terminals> and every node
+ * only refers to nodes with a lower number.
+ */
+static inline uint64_t
+sylvan_packed_ref(uint64_t number, uint64_t ref, uint64_t terminals)
+{
+    return ref < terminals ? ref : terminals + (number - 1 - ref);
+}
+
+/**
+ * Decode the reference <enc> of node <number>, or return (uint64_t)-1 if it is invalid.
+ */
+static inline uint64_t
+sylvan_packed_deref(uint64_t number, uint64_t enc, uint64_t terminals)
+{
+    if (enc < terminals) return enc;
+    if (number <= terminals || enc - terminals > number - 1 - terminals) return (uint64_t)-1;
+    return number - 1 - (enc - terminals);
+}
+
+/**
+ * Callback for sylvan_packed_write_nodes: encode the nodes with numbers <first>...<first+count-1>
+ * to <buf> (at most <max_node> bytes per node), and return the number of bytes.
+ */
+LACE_TYPEDEF_CB(size_t, sylvan_packed_encode_cb, sylvan_writer_t, uint64_t, size_t, uint8_t*);
+
+/**
+ * Encode the nodes with numbers <first>...<last> of the writer <w> in parallel and write
+ * them to the stream in order.
+ */
+VOID_TASK_DECL_6(sylvan_packed_write_nodes, sylvan_packed_out_t, sylvan_writer_t, uint64_t, uint64_t, size_t, sylvan_packed_encode_cb);
+#define sylvan_packed_write_nodes(p, w, first, last, max_node, encode_cb) RUN(sylvan_packed_write_nodes, p, w, first, last, max_node, encode_cb)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <sylvan_partrel.h>
+
+/**
+ * A quantification schedule: the image is computed as
+ *   R := \exists <initial>: S
+ *   R := \exists <quantify>[i]: R \and <clusters>[i]   (for every cluster i)
+ */
+struct sylvan_partrel_schedule
+{
+    BDDSET initial;     // variables not in any cluster, quantified first
+    size_t count;       // number of clusters
+    BDD *clusters;      // conjunction of the partitions in every cluster
+    BDDSET *quantify;   // variables quantified after every cluster
+    size_t *sizes;      // number of nodes of every cluster
+};
+
+struct sylvan_partrel
+{
+    BDDMAP next_map;    // s' := s, applied after the image
+    BDDMAP prev_map;    // s := s', applied before the preimage
+    struct sylvan_partrel_schedule next, prev;
+};
+
+/**
+ * Compute <a> \cap <b> for two variable sets
+ */
+TASK_2(BDDSET, partrel_set_intersect, BDDSET, a, BDDSET, b)
+{
+    BDDSET a_not_b = bdd_refs_push(mtbdd_set_minus(a, b));
+    BDDSET result = mtbdd_set_minus(a, a_not_b);
+    bdd_refs_pop(1);
+    return result;
+}
+
+/**
+ * Order the partitions, greedily picking the partition with the highest benefit, then cluster them.
+ * The benefit of a partition is a simplified version of the IWLS95 heuristic:
+ * the fraction of its quantifiable variables that can be quantified right after it (no other
+ * remaining partition depends on them), plus (with half weight) the fraction of its other
+ * variables that are already in the product, i.e., that it does not introduce.
+ */
+VOID_TASK_6(partrel_schedule, const BDD*, relations, const BDDSET*, supports, size_t, count, BDDSET, q, size_t, cluster_limit, struct sylvan_partrel_schedule*, sched)
+{
+    /* Obtain the supports as arrays */
+    uint32_t **supp = (uint32_t**)malloc(sizeof(uint32_t*) * (count > 0 ? count : 1));
+    size_t *supp_count = (size_t*)malloc(sizeof(size_t) * (count > 0 ? count : 1));
+    uint32_t nvars = 0;
+    for (size_t i=0; i<count; i++) {
+        supp_count[i] = mtbdd_set_count(supports[i]);
+        supp[i] = (uint32_t*)malloc(sizeof(uint32_t) * (supp_count[i] > 0 ? supp_count[i] : 1));
+        mtbdd_set_to_array(supports[i], supp[i]);
+        for (size_t j=0; j<supp_count[i]; j++) {
+            if (supp[i][j] >= nvars) nvars = supp[i][j] + 1;
+        }
+    }
+
+    uint8_t *inq = (uint8_t*)calloc(nvars + 1, 1);
+    for (BDDSET s = q; !mtbdd_set_isempty(s); s = mtbdd_set_next(s)) {
+        uint32_t v = mtbdd_set_first(s);
+        if (v < nvars) inq[v] = 1;
+    }
+
+    /* occ[v] counts the remaining partitions that depend on quantifiable variable v */
+    uint32_t *occ = (uint32_t*)calloc(nvars + 1, sizeof(uint32_t));
+    uint8_t *present = (uint8_t*)calloc(nvars + 1, 1);
+    uint8_t *done = (uint8_t*)calloc(count + 1, 1);
+    size_t *order = (size_t*)malloc(sizeof(size_t) * (count > 0 ? count : 1));
+    for (size_t i=0; i<count; i++) {
+        for (size_t j=0; j<supp_count[i]; j++) {
+            if (inq[supp[i][j]]) occ[supp[i][j]]++;
+        }
+    }
+
+    for (size_t step=0; step<count; step++) {
+        size_t best = 0;
+        double best_score = -1.0;
+        for (size_t i=0; i<count; i++) {
+            if (done[i]) continue;
+            size_t quantifiable = 0, local = 0, other = 0, introduced = 0;
+            for (size_t j=0; j<supp_count[i]; j++) {
+                uint32_t v = supp[i][j];
+                if (inq[v]) {
+                    quantifiable++;
+                    if (occ[v] == 1) local++;
+                } else {
+                    other++;
+                    if (!present[v]) introduced++;
+                }
+            }
+            double score = quantifiable ? (double)local / quantifiable : 0.0;
+            score += 0.5 * (other ? (double)(other - introduced) / other : 1.0);
+            if (score > best_score) {
+                best_score = score;
+                best = i;
+            }
+        }
+        order[step] = best;
+        done[best] = 1;
+        for (size_t j=0; j<supp_count[best]; j++) {
+            uint32_t v = supp[best][j];
+            if (inq[v]) occ[v]--;
+            else present[v] = 1;
+        }
+    }
+
+    /* Cluster the partitions in this order, until a cluster exceeds the limit */
+    sched->clusters = (BDD*)malloc(sizeof(BDD) * (count > 0 ? count : 1));
+    sched->quantify = (BDDSET*)malloc(sizeof(BDDSET) * (count > 0 ? count : 1));
+    sched->sizes = (size_t*)malloc(sizeof(size_t) * (count > 0 ? count : 1));
+    sched->count = 0;
+
+    BDD cur = sylvan_true, cand = sylvan_true;
+    BDDSET cur_supp = mtbdd_set_empty();
+    bdd_refs_pushptr(&cur);
+    bdd_refs_pushptr(&cand);
+    bdd_refs_pushptr(&cur_supp);
+    for (size_t step=0; step<count; step++) {
+        size_t p = order[step];
+        cand = sylvan_and(cur, relations[p]);
+        if (cur != sylvan_true && mtbdd_nodecount(cand) > cluster_limit) {
+            size_t k = sched->count++;
+            sched->clusters[k] = cur;
+            sched->quantify[k] = cur_supp; // support for now, replaced below
+            mtbdd_protect(&sched->clusters[k]);
+            mtbdd_protect(&sched->quantify[k]);
+            cur = relations[p];
+            cur_supp = supports[p];
+        } else {
+            cur = cand;
+            cur_supp = mtbdd_set_union(cur_supp, supports[p]);
+        }
+    }
+    if (count > 0) {
+        size_t k = sched->count++;
+        sched->clusters[k] = cur;
+        sched->quantify[k] = cur_supp;
+        mtbdd_protect(&sched->clusters[k]);
+        mtbdd_protect(&sched->quantify[k]);
+    }
+    bdd_refs_popptr(3);
+
+    /* Quantify every variable after the last cluster that depends on it */
+    BDDSET later = mtbdd_set_empty();
+    bdd_refs_pushptr(&later);
+    for (size_t k=sched->count; k>0; k--) {
+        BDDSET cluster_supp = bdd_refs_push(sched->quantify[k-1]);
+        BDDSET local = bdd_refs_push(CALL(partrel_set_intersect, cluster_supp, q));
+        sched->quantify[k-1] = mtbdd_set_minus(local, later);
+        later = mtbdd_set_union(later, cluster_supp);
+        bdd_refs_pop(2);
+        sched->sizes[k-1] = mtbdd_nodecount(sched->clusters[k-1]);
+        sylvan_stats_add(PARTREL_CLUSTER_NODES, sched->sizes[k-1]);
+    }
+    sylvan_stats_add(PARTREL_CLUSTERS, sched->count);
+    sched->initial = mtbdd_set_minus(q, later);
+    mtbdd_protect(&sched->initial);
+    bdd_refs_popptr(1);
+
+    for (size_t i=0; i<count; i++) free(supp[i]);
+    free(supp);
+    free(supp_count);
+    free(inq);
+    free(occ);
+    free(present);
+    free(done);
+    free(order);
+}
+
+TASK_IMPL_5(sylvan_partrel_t, sylvan_partrel_create, const BDD*, relations, const BDDSET*, supports, size_t, count, BDDSET, vars, size_t, cluster_limit)
+{
+    sylvan_partrel_t rel = (sylvan_partrel_t)malloc(sizeof(struct sylvan_partrel));
+
+    /* Obtain the pairs (s,s') in <vars> and the renaming maps */
+    size_t nvars = mtbdd_set_count(vars);
+    uint32_t *arr = (uint32_t*)malloc(sizeof(uint32_t) * (nvars > 0 ? nvars : 1));
+    mtbdd_set_to_array(vars, arr);
+
+    BDDSET q_next = mtbdd_set_empty(), q_prev = mtbdd_set_empty();
+    bdd_refs_pushptr(&q_next);
+    bdd_refs_pushptr(&q_prev);
+    rel->next_map = sylvan_map_empty();
+    rel->prev_map = sylvan_map_empty();
+    mtbdd_protect(&rel->next_map);
+    mtbdd_protect(&rel->prev_map);
+    for (size_t i=nvars; i>0; i--) {
+        uint32_t s = arr[i-1] & ~1U;
+        if (i < nvars && (arr[i] & ~1U) == s) continue; // pair already added
+        q_next = mtbdd_set_add(q_next, s);
+        q_prev = mtbdd_set_add(q_prev, s+1);
+        rel->next_map = sylvan_map_add(rel->next_map, s+1, sylvan_ithvar(s));
+        rel->prev_map = sylvan_map_add(rel->prev_map, s, sylvan_ithvar(s+1));
+    }
+    free(arr);
+
+    CALL(partrel_schedule, relations, supports, count, q_next, cluster_limit, &rel->next);
+    CALL(partrel_schedule, relations, supports, count, q_prev, cluster_limit, &rel->prev);
+    bdd_refs_popptr(2);
+
+    return rel;
+}
+
+static void
+partrel_schedule_free(struct sylvan_partrel_schedule *sched)
+{
+    for (size_t i=0; i<sched->count; i++) {
+        mtbdd_unprotect(&sched->clusters[i]);
+        mtbdd_unprotect(&sched->quantify[i]);
+    }
+    mtbdd_unprotect(&sched->initial);
+    free(sched->clusters);
+    free(sched->quantify);
+    free(sched->sizes);
+}
+
+void
+sylvan_partrel_free(sylvan_partrel_t rel)
+{
+    partrel_schedule_free(&rel->next);
+    partrel_schedule_free(&rel->prev);
+    mtbdd_unprotect(&rel->next_map);
+    mtbdd_unprotect(&rel->prev_map);
+    free(rel);
+}
+
+TASK_2(BDD, partrel_image, BDD, states, struct sylvan_partrel_schedule*, sched)
+{
+    BDD result = CALL(sylvan_exists, states, sched->initial, 0);
+    for (size_t i=0; i<sched->count && result != sylvan_false; i++) {
+        bdd_refs_push(result);
+        result = CALL(sylvan_and_exists, result, sched->clusters[i], sched->quantify[i], 0);
+        bdd_refs_pop(1);
+        sylvan_stats_count(PARTREL_IMAGE_STEPS);
+    }
+    return result;
+}
+
+TASK_IMPL_2(BDD, sylvan_partrel_next, BDD, states, sylvan_partrel_t, rel)
+{
+    BDD result = bdd_refs_push(CALL(partrel_image, states, &rel->next));
+    result = sylvan_compose(result, rel->next_map);
+    bdd_refs_pop(1);
+    return result;
+}
+
+TASK_IMPL_2(BDD, sylvan_partrel_prev, BDD, states, sylvan_partrel_t, rel)
+{
+    BDD primed = bdd_refs_push(sylvan_compose(states, rel->prev_map));
+    BDD result = CALL(partrel_image, primed, &rel->prev);
+    bdd_refs_pop(1);
+    return result;
+}
+
+size_t
+sylvan_partrel_cluster_count(sylvan_partrel_t rel, int prev)
+{
+    return prev ? rel->prev.count : rel->next.count;
+}
+
+size_t
+sylvan_partrel_cluster_size(sylvan_partrel_t rel, int prev, size_t i)
+{
+    return prev ? rel->prev.sizes[i] : rel->next.sizes[i];
+}
+
+static void
+partrel_set_fprint(FILE *out, BDDSET set)
+{
+    fprintf(out, "{");
+    for (int first = 1; !mtbdd_set_isempty(set); set = mtbdd_set_next(set), first = 0) {
+        fprintf(out, first ? "%" PRIu32 : ",%" PRIu32, mtbdd_set_first(set));
+    }
+    fprintf(out, "}");
+}
+
+static void
+partrel_schedule_fprint(FILE *out, const char *name, struct sylvan_partrel_schedule *sched)
+{
+    fprintf(out, "%s: %zu clusters, quantify first: ", name, sched->count);
+    partrel_set_fprint(out, sched->initial);
+    fprintf(out, "\n");
+    for (size_t i=0; i<sched->count; i++) {
+        fprintf(out, "  cluster %zu: %zu nodes, quantify: ", i, sched->sizes[i]);
+        partrel_set_fprint(out, sched->quantify[i]);
+        fprintf(out, "\n");
+    }
+}
+
+void
+sylvan_partrel_fprint(FILE *out, sylvan_partrel_t rel)
+{
+    partrel_schedule_fprint(out, "Image", &rel->next);
+    partrel_schedule_fprint(out, "Preimage", &rel->prev);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Do not include this file directly. Instead, include sylvan.h */
+
+#ifndef SYLVAN_PARTREL_H
+#define SYLVAN_PARTREL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Conjunctively partitioned transition relations.
+ *
+ * A partitioned relation is T(s,s') = T_1(s,s') \and ... \and T_n(s,s'), where every
+ * partition T_i only depends on the variables in its support.
+ * As with sylvan_relnext, s and s' are interleaved with s even and s' odd (s+1),
+ * and <vars> is the cube of all s and/or s' variables of the relation.
+ * Variables of a state set that are not in <vars> are kept.
+ *
+ * When the relation is created, the partitions are ordered and clustered (in the style
+ * of IWLS95) for both the image and the preimage. The image is then computed as a chain
+ * of sylvan_and_exists calls, quantifying every variable as soon as no later cluster
+ * depends on it, so the monolithic relation is never built.
+ */
+typedef struct sylvan_partrel *sylvan_partrel_t;
+
+/**
+ * Create a partitioned relation from the <count> partitions in <relations>,
+ * where <supports>[i] is the set of variables (s and s') that <relations>[i] depends on.
+ * Clusters are grown until their conjunction exceeds <cluster_limit> nodes.
+ * The arrays are copied; the BDDs are protected until sylvan_partrel_free.
+ */
+TASK_DECL_5(sylvan_partrel_t, sylvan_partrel_create, const BDD*, const BDDSET*, size_t, BDDSET, size_t);
+#define sylvan_partrel_create(relations, supports, count, vars, cluster_limit) RUN(sylvan_partrel_create, relations, supports, count, vars, cluster_limit)
+
+/**
+ * Free a partitioned relation.
+ */
+void sylvan_partrel_free(sylvan_partrel_t rel);
+
+/**
+ * Compute the successors of <states> (like sylvan_relnext with the monolithic relation).
+ */
+TASK_DECL_2(BDD, sylvan_partrel_next, BDD, sylvan_partrel_t);
+#define sylvan_partrel_next(states, rel) RUN(sylvan_partrel_next, states, rel)
+
+/**
+ * Compute the predecessors of <states> (like sylvan_relprev with the monolithic relation).
+ */
+TASK_DECL_2(BDD, sylvan_partrel_prev, BDD, sylvan_partrel_t);
+#define sylvan_partrel_prev(states, rel) RUN(sylvan_partrel_prev, states, rel)
+
+/**
+ * Get the number of clusters of the image (<prev>=0) or preimage (<prev>=1) schedule,
+ * and the number of nodes of the <i>th cluster.
+ */
+size_t sylvan_partrel_cluster_count(sylvan_partrel_t rel, int prev);
+size_t sylvan_partrel_cluster_size(sylvan_partrel_t rel, int prev, size_t i);
+
+/**
+ * Write the image and preimage schedules (cluster sizes and quantified variables) to <out>.
+ */
+void sylvan_partrel_fprint(FILE *out, sylvan_partrel_t rel);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
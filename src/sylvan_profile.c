@@ -0,0 +1,207 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+#include <sylvan_align.h>
+
+#include <string.h>
+
+#include <sylvan_writer.h>
+
+/**
+ * The counts of one worker, on its own cache line
+ */
+typedef union profile_worker
+{
+    struct {
+        uint32_t size;          // size of the arrays
+        size_t *nodes;
+        size_t *edges;
+        size_t leaves;
+        size_t leaf_edges;
+        int reach_false, reach_true;
+    };
+    char pad[LINE_SIZE];
+} profile_worker_t;
+
+typedef struct profile_ctx
+{
+    sylvan_writer_t visited;    // bitmap of the visited nodes
+    profile_worker_t *workers;
+} profile_ctx_t;
+
+/**
+ * Count an edge to the given variable, and the node if it is visited for the first time
+ */
+static inline int
+profile_count(profile_worker_t *w, uint32_t var, int first)
+{
+    if (var >= w->size) {
+        uint32_t size = w->size * 2 > var ? w->size * 2 : var + 1;
+        w->nodes = (size_t*)realloc(w->nodes, sizeof(size_t[size]));
+        w->edges = (size_t*)realloc(w->edges, sizeof(size_t[size]));
+        memset(w->nodes + w->size, 0, sizeof(size_t[size - w->size]));
+        memset(w->edges + w->size, 0, sizeof(size_t[size - w->size]));
+        w->size = size;
+    }
+    w->edges[var]++;
+    if (first) w->nodes[var]++;
+    return first;
+}
+
+TASK_2(int, mtbdd_profile_pre, MTBDD, dd, profile_ctx_t*, ctx)
+{
+    profile_worker_t *w = &ctx->workers[__lace_worker->worker];
+    if (dd == mtbdd_false || dd == mtbdd_true) {
+        w->leaf_edges++;
+        if (dd == mtbdd_false) w->reach_false = 1;
+        else w->reach_true = 1;
+        return 0;
+    }
+    int first = sylvan_writer_mark(ctx->visited, MTBDD_STRIPMARK(dd));
+    if (mtbdd_isleaf(dd)) {
+        w->leaf_edges++;
+        if (first) w->leaves++;
+        return 0;
+    }
+    return profile_count(w, mtbdd_getvar(dd), first);
+}
+
+TASK_2(int, zdd_profile_pre, ZDD, dd, profile_ctx_t*, ctx)
+{
+    profile_worker_t *w = &ctx->workers[__lace_worker->worker];
+    if (dd == zdd_false || dd == zdd_true) {
+        w->leaf_edges++;
+        if (dd == zdd_false) w->reach_false = 1;
+        else w->reach_true = 1;
+        return 0;
+    }
+    int first = sylvan_writer_mark(ctx->visited, ZDD_GETINDEX(dd));
+    if (zdd_isleaf(dd)) {
+        w->leaf_edges++;
+        if (first) w->leaves++;
+        return 0;
+    }
+    return profile_count(w, zdd_getvar(dd), first);
+}
+
+static void
+profile_start(profile_ctx_t *ctx)
+{
+    ctx->visited = sylvan_writer_alloc();
+    ctx->workers = (profile_worker_t*)alloc_aligned(sizeof(profile_worker_t[lace_workers()]));
+    if (ctx->workers == NULL) {
+        fprintf(stderr, "sylvan_profile: Unable to allocate memory!\n");
+        exit(1);
+    }
+    memset(ctx->workers, 0, sizeof(profile_worker_t[lace_workers()]));
+}
+
+/**
+ * Add up the counts of all workers
+ */
+static void
+profile_finish(profile_ctx_t *ctx, sylvan_profile_t *profile)
+{
+    const unsigned int n = lace_workers();
+    memset(profile, 0, sizeof(sylvan_profile_t));
+    int reach_false = 0, reach_true = 0;
+    for (unsigned int i=0; i<n; i++) {
+        profile_worker_t *w = &ctx->workers[i];
+        if (w->size > profile->levels) profile->levels = w->size;
+        profile->leaves += w->leaves;
+        profile->leaf_edges += w->leaf_edges;
+        reach_false |= w->reach_false;
+        reach_true |= w->reach_true;
+    }
+    profile->leaves += reach_false + reach_true;
+    profile->nodes = (size_t*)calloc(profile->levels ? profile->levels : 1, sizeof(size_t));
+    profile->edges = (size_t*)calloc(profile->levels ? profile->levels : 1, sizeof(size_t));
+    for (unsigned int i=0; i<n; i++) {
+        profile_worker_t *w = &ctx->workers[i];
+        for (uint32_t v=0; v<w->size; v++) {
+            profile->nodes[v] += w->nodes[v];
+            profile->edges[v] += w->edges[v];
+        }
+        free(w->nodes);
+        free(w->edges);
+    }
+    // the arrays of the workers grow by doubling; keep the levels up to the highest variable
+    while (profile->levels > 0 && profile->edges[profile->levels-1] == 0) profile->levels--;
+    profile->total = profile->leaves;
+    for (uint32_t v=0; v<profile->levels; v++) {
+        profile->total += profile->nodes[v];
+        if (profile->nodes[v] > profile->peak_width) {
+            profile->peak_width = profile->nodes[v];
+            profile->peak_level = v;
+        }
+    }
+    free_aligned(ctx->workers, sizeof(profile_worker_t[n]));
+    sylvan_writer_free(ctx->visited);
+}
+
+VOID_TASK_IMPL_3(mtbdd_profile, const MTBDD*, dds, size_t, count, sylvan_profile_t*, profile)
+{
+    profile_ctx_t ctx;
+    profile_start(&ctx);
+    for (size_t i=0; i<count; i++) {
+        SPAWN(mtbdd_visit_par, dds[i], (mtbdd_visit_pre_cb)TASK(mtbdd_profile_pre), NULL, &ctx);
+    }
+    for (size_t i=0; i<count; i++) SYNC(mtbdd_visit_par);
+    profile_finish(&ctx, profile);
+}
+
+VOID_TASK_IMPL_3(zdd_profile, const ZDD*, dds, size_t, count, sylvan_profile_t*, profile)
+{
+    profile_ctx_t ctx;
+    profile_start(&ctx);
+    for (size_t i=0; i<count; i++) {
+        SPAWN(zdd_visit_par, dds[i], (zdd_visit_pre_cb)TASK(zdd_profile_pre), NULL, &ctx);
+    }
+    for (size_t i=0; i<count; i++) SYNC(zdd_visit_par);
+    profile_finish(&ctx, profile);
+}
+
+void
+sylvan_profile_free(sylvan_profile_t *profile)
+{
+    free(profile->nodes);
+    free(profile->edges);
+    profile->nodes = NULL;
+    profile->edges = NULL;
+    profile->levels = 0;
+}
+
+void
+sylvan_profile_fprint(FILE *out, const sylvan_profile_t *profile)
+{
+    size_t internal = profile->total - profile->leaves, edges = 0;
+    uint32_t used = 0;
+    for (uint32_t v=0; v<profile->levels; v++) {
+        edges += profile->edges[v];
+        if (profile->nodes[v] != 0) used++;
+    }
+    fprintf(out, "%zu nodes (%zu leaves) on %u variables, average in-degree %.2f, peak width %zu at variable %u\n",
+            profile->total, profile->leaves, used, internal ? (double)edges/internal : 0.0,
+            profile->peak_width, profile->peak_level);
+    for (uint32_t v=0; v<profile->levels; v++) {
+        if (profile->nodes[v] == 0) continue;
+        int bar = (int)((40 * profile->nodes[v] + profile->peak_width - 1) / profile->peak_width);
+        fprintf(out, "%8u %12zu %8.2f %.*s\n", v, profile->nodes[v],
+                (double)profile->edges[v]/profile->nodes[v], bar, "########################################");
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Do not include this file directly. Instead, include sylvan.h */
+
+#ifndef SYLVAN_PROFILE_H
+#define SYLVAN_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Per-variable profile of the nodes of a set of MTBDDs or ZDDs.
+ *
+ * The profile counts the distinct nodes of every variable and the edges to these nodes,
+ * from the roots and from other nodes. The average in-degree of a variable (edges/nodes)
+ * shows how much its nodes are shared, and the variable with the most nodes (the peak
+ * width) shows where the variable ordering blows up.
+ *
+ * The nodes are visited in parallel with mtbdd_visit_par and zdd_visit_par. Every worker
+ * counts in its own arrays, which are added up afterwards.
+ */
+typedef struct sylvan_profile {
+    uint32_t levels;            // number of entries in <nodes> and <edges> (highest variable + 1)
+    size_t *nodes;              // number of nodes of every variable
+    size_t *edges;              // number of edges to the nodes of every variable
+    size_t leaves;              // number of distinct leaves (true and false count as two leaves)
+    size_t leaf_edges;          // number of edges to the leaves
+    size_t total;               // number of nodes, including the leaves
+    uint32_t peak_level;        // variable with the most nodes
+    size_t peak_width;          // number of nodes of <peak_level>
+} sylvan_profile_t;
+
+/**
+ * Compute the profile of the <count> decision diagrams in <dds>.
+ * Release the result with sylvan_profile_free.
+ */
+VOID_TASK_DECL_3(mtbdd_profile, const MTBDD*, size_t, sylvan_profile_t*);
+#define mtbdd_profile(dds, count, profile) RUN(mtbdd_profile, dds, count, profile)
+VOID_TASK_DECL_3(zdd_profile, const ZDD*, size_t, sylvan_profile_t*);
+#define zdd_profile(dds, count, profile) RUN(zdd_profile, dds, count, profile)
+
+/**
+ * Free the arrays of a profile.
+ */
+void sylvan_profile_free(sylvan_profile_t *profile);
+
+/**
+ * Write the profile to <out>: a summary line, then the number of nodes and the average
+ * in-degree of every variable that has nodes, with a bar relative to the peak width.
+ */
+void sylvan_profile_fprint(FILE *out, const sylvan_profile_t *profile);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
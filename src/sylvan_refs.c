@@ -36,16 +36,36 @@ static const uint64_t refs_ts = 0x7fffffffffffffff; // tombstone
 
 #define fnvhash8(a) sylvan_fnvhash8(a, 14695981039346656037LLU)
 
+// The count is a signed 24-bit number; only the deferred mode makes negative counts
+#define refs_getcount(d) ((int64_t)(d) >> 40)
+#define refs_live(d) ((d) != 0 && (d) != refs_ts && refs_getcount(d) > 0)
+#define refs_clamp(c) ((c) > 0x7fffff ? 0x7fffff : (c) < -0x800000 ? -0x800000 : (c))
+
+static size_t
+refs_count_entries(refs_table_t *tbl)
+{
+    size_t count = 0;
+    _Atomic(uint64_t) *bucket = tbl->refs_table;
+    _Atomic(uint64_t) * const end = bucket + tbl->refs_size;
+    while (bucket != end) {
+        uint64_t d = atomic_load_explicit(bucket, memory_order_relaxed);
+        if (d != 0 && d != refs_ts) count++;
+        bucket++;
+    }
+    return count;
+}
+
 // Count number of unique entries (not number of references)
 size_t
 refs_count(refs_table_t *tbl)
 {
+    if (tbl->refs_deferred) refs_flush(tbl);
     size_t count = 0;
     _Atomic(uint64_t) *bucket = tbl->refs_table;
     _Atomic(uint64_t) * const end = bucket + tbl->refs_size;
     while (bucket != end) {
         uint64_t d = atomic_load_explicit(bucket, memory_order_relaxed);
-        if (d != 0 && d != refs_ts) count++;
+        if (refs_live(d)) count++;
         bucket++;
     }
     return count;
@@ -124,7 +144,7 @@ refs_resize(refs_table_t *tbl)
 
     // calculate new size
     size_t new_size = tbl->refs_size;
-    size_t count = refs_count(tbl);
+    size_t count = refs_count_entries(tbl);
     if (count*4 > tbl->refs_size) new_size *= 2;
 
     // allocate new table
@@ -175,8 +195,11 @@ refs_leave(refs_table_t *tbl)
     }
 }
 
+/**
+ * Add <dir> to the count of <a>. A missing value is only inserted with a negative count if <force> is set.
+ */
 static inline int
-refs_modify(refs_table_t *tbl, const uint64_t a, const int dir)
+refs_modify(refs_table_t *tbl, const uint64_t a, const int64_t dir, const int force)
 {
     _Atomic(uint64_t)* bucket;
     _Atomic(uint64_t)* ts_bucket;
@@ -198,22 +221,22 @@ ref_restart:
         } else if (v == 0) {
             // not found
             res = 0;
-            if (dir < 0) goto ref_exit;
+            if (dir < 0 && !force) goto ref_exit;
             if (ts_bucket != NULL) {
                 bucket = ts_bucket;
                 ts_bucket = NULL;
                 v = refs_ts;
             }
-            new_v = a | (1ULL << 40);
+            new_v = a | ((uint64_t)refs_clamp(dir) << 40);
             goto ref_mod;
         } else if ((v & 0x000000ffffffffff) == a) {
             // found
             res = 1;
-            uint64_t count = v >> 40;
+            int64_t count = refs_getcount(v);
             if (count == 0x7fffff) goto ref_exit;
-            count += dir;
+            count = refs_clamp(count + dir);
             if (count == 0) new_v = refs_ts;
-            else new_v = a | (count << 40);
+            else new_v = a | ((uint64_t)count << 40);
             goto ref_mod;
         }
 
@@ -221,14 +244,14 @@ ref_restart:
     }
 
     // not found after linear probing
-    if (dir < 0) {
+    if (dir < 0 && !force) {
         res = 0;
         goto ref_exit;
     } else if (ts_bucket != NULL) {
         bucket = ts_bucket;
         ts_bucket = NULL;
         v = refs_ts;
-        new_v = a | (1ULL << 40);
+        new_v = a | ((uint64_t)refs_clamp(dir) << 40);
         if (!atomic_compare_exchange_weak(bucket, &v, new_v)) goto ref_retry;
         res = 1;
         goto ref_exit;
@@ -236,7 +259,7 @@ ref_restart:
         // hash table full
         refs_leave(tbl);
         refs_resize(tbl);
-        return refs_modify(tbl, a, dir);
+        return refs_modify(tbl, a, dir, force);
     }
 
 ref_mod:
@@ -247,19 +270,153 @@ ref_exit:
     return res;
 }
 
+/**
+ * Deferred mode: every thread has a buffer for every table, with a small hash map from values to the sum
+ * of their changes. The lock of a buffer is only contended when refs_flush applies it.
+ */
+#define REFS_BUFFER_SIZE 256
+
+typedef struct refs_buffer
+{
+    refs_table_t *tbl;              // the table of the buffer, or NULL if the table is freed
+    struct refs_buffer *next;       // the next buffer of the same thread
+    struct refs_buffer *tbl_next;   // the next buffer of the same table
+    _Atomic(int) lock;
+    int used;                       // number of used slots
+    uint64_t keys[REFS_BUFFER_SIZE];
+    int64_t deltas[REFS_BUFFER_SIZE];
+} refs_buffer_t;
+
+static DECLARE_THREAD_LOCAL(refs_buffers, refs_buffer_t*);
+
+#ifdef __ELF__
+#define refs_buffers_init()
+#else
+static pthread_once_t refs_buffers_once = PTHREAD_ONCE_INIT;
+static void refs_buffers_init_key(void) { INIT_THREAD_LOCAL(refs_buffers); }
+#define refs_buffers_init() pthread_once(&refs_buffers_once, refs_buffers_init_key)
+#endif
+
+static refs_buffer_t *
+refs_buffer_get(refs_table_t *tbl)
+{
+    refs_buffers_init();
+    LOCALIZE_THREAD_LOCAL(refs_buffers, refs_buffer_t*);
+    refs_buffer_t *buf, *reuse = NULL;
+    for (buf = refs_buffers; buf != NULL; buf = buf->next) {
+        if (buf->tbl == tbl) return buf;
+        if (buf->tbl == NULL) reuse = buf;
+    }
+    if (reuse != NULL) {
+        buf = reuse;
+    } else {
+        buf = (refs_buffer_t*)calloc(1, sizeof(refs_buffer_t));
+        if (buf == NULL) {
+            fprintf(stderr, "refs: Unable to allocate memory: %s!\n", strerror(errno));
+            exit(1);
+        }
+        buf->next = refs_buffers;
+        SET_THREAD_LOCAL(refs_buffers, buf);
+    }
+    buf->tbl = tbl;
+    refs_buffer_t *head = atomic_load_explicit(&tbl->refs_buffers, memory_order_relaxed);
+    do {
+        buf->tbl_next = head;
+    } while (!atomic_compare_exchange_weak(&tbl->refs_buffers, &head, buf));
+    return buf;
+}
+
+static inline void
+refs_buffer_lock(refs_buffer_t *buf)
+{
+    while (atomic_exchange_explicit(&buf->lock, 1, memory_order_acquire)) continue;
+}
+
+static inline void
+refs_buffer_unlock(refs_buffer_t *buf)
+{
+    atomic_store_explicit(&buf->lock, 0, memory_order_release);
+}
+
+// Apply and clear the buffer; the caller holds the lock
+static void
+refs_buffer_apply(refs_buffer_t *buf)
+{
+    if (buf->used == 0) return;
+    for (int i=0; i<REFS_BUFFER_SIZE; i++) {
+        if (buf->keys[i] != 0 && buf->deltas[i] != 0) refs_modify(buf->tbl, buf->keys[i], buf->deltas[i], 1);
+        buf->keys[i] = 0;
+    }
+    buf->used = 0;
+}
+
+static void
+refs_defer(refs_table_t *tbl, uint64_t a, int64_t delta)
+{
+    refs_buffer_t *buf = refs_buffer_get(tbl);
+    refs_buffer_lock(buf);
+    size_t i = fnvhash8(a) & (REFS_BUFFER_SIZE - 1);
+    for (int n=0; n<16; n++) {
+        uint64_t k = buf->keys[i];
+        if (k == a) {
+            buf->deltas[i] += delta;
+            refs_buffer_unlock(buf);
+            return;
+        }
+        if (k == 0) {
+            if (buf->used >= REFS_BUFFER_SIZE * 3 / 4) break;
+            buf->keys[i] = a;
+            buf->deltas[i] = delta;
+            buf->used++;
+            refs_buffer_unlock(buf);
+            return;
+        }
+        i = (i + 1) & (REFS_BUFFER_SIZE - 1);
+    }
+    // buffer full, apply it to the table
+    refs_buffer_apply(buf);
+    i = fnvhash8(a) & (REFS_BUFFER_SIZE - 1);
+    buf->keys[i] = a;
+    buf->deltas[i] = delta;
+    buf->used = 1;
+    refs_buffer_unlock(buf);
+}
+
+void
+refs_flush(refs_table_t *tbl)
+{
+    for (refs_buffer_t *buf = atomic_load(&tbl->refs_buffers); buf != NULL; buf = buf->tbl_next) {
+        refs_buffer_lock(buf);
+        refs_buffer_apply(buf);
+        refs_buffer_unlock(buf);
+    }
+}
+
+void
+refs_set_deferred(refs_table_t *tbl, int deferred)
+{
+    if (!deferred) refs_flush(tbl);
+    tbl->refs_deferred = deferred;
+}
+
 void
 refs_up(refs_table_t *tbl, uint64_t a)
 {
-    refs_modify(tbl, a, 1);
+    if (tbl->refs_deferred) refs_defer(tbl, a, 1);
+    else refs_modify(tbl, a, 1, 0);
 }
 
 void
 refs_down(refs_table_t *tbl, uint64_t a)
 {
+    if (tbl->refs_deferred) {
+        refs_defer(tbl, a, -1);
+        return;
+    }
 #ifdef NDEBUG
-    refs_modify(tbl, a, -1);
+    refs_modify(tbl, a, -1, 0);
 #else
-    int res = refs_modify(tbl, a, -1);
+    int res = refs_modify(tbl, a, -1, 0);
     assert(res != 0);
 #endif
 }
@@ -273,7 +430,7 @@ refs_iter(refs_table_t *tbl, size_t first, size_t end)
     _Atomic(uint64_t)* bucket = tbl->refs_table + first;
     while (bucket != tbl->refs_table + end) {
         uint64_t d = atomic_load_explicit(bucket, memory_order_relaxed);
-        if (d != 0 && d != refs_ts) return (uint64_t*)bucket;
+        if (refs_live(d)) return (uint64_t*)bucket;
         bucket++;
     }
     return NULL;
@@ -289,7 +446,7 @@ refs_next(refs_table_t *tbl, uint64_t **_bucket, size_t end)
     bucket++;
     while (bucket != tbl->refs_table + end) {
         uint64_t d = atomic_load_explicit(bucket, memory_order_relaxed);
-        if (d != 0 && d != refs_ts) {
+        if (refs_live(d)) {
             *_bucket = (uint64_t*)bucket;
             return result;
         }
@@ -313,11 +470,20 @@ refs_create(refs_table_t *tbl, size_t _refs_size)
         fprintf(stderr, "refs: Unable to allocate memory: %s!\n", strerror(errno));
         exit(1);
     }
+    tbl->refs_deferred = 0;
+    tbl->refs_buffers = NULL;
 }
 
 void
 refs_free(refs_table_t *tbl)
 {
+    // the buffers stay with their threads, for a next table
+    for (refs_buffer_t *buf = atomic_load(&tbl->refs_buffers); buf != NULL; buf = buf->tbl_next) {
+        memset(buf->keys, 0, sizeof(buf->keys));
+        buf->used = 0;
+        buf->tbl = NULL;
+    }
+    tbl->refs_buffers = NULL;
     free_aligned(tbl->refs_table, tbl->refs_size * sizeof(uint64_t));
 }
 
@@ -407,7 +573,7 @@ protect_resize(refs_table_t *tbl)
 
     // calculate new size
     size_t new_size = tbl->refs_size;
-    size_t count = refs_count(tbl);
+    size_t count = refs_count_entries(tbl);
     if (count*4 > tbl->refs_size) new_size *= 2;
 
     // allocate new table
@@ -597,3 +763,215 @@ protect_free(refs_table_t *tbl)
     free_aligned(tbl->refs_table, tbl->refs_size * sizeof(uint64_t));
     tbl->refs_table = 0;
 }
+
+/**
+ * Implementation of handles
+ */
+
+static _Atomic(handles_chunk_t*) handles_list = NULL;
+static DECLARE_THREAD_LOCAL(handles_free, uint64_t*);
+
+#ifdef __ELF__
+#define handles_init()
+#else
+static pthread_once_t handles_once = PTHREAD_ONCE_INIT;
+static void handles_init_key(void) { INIT_THREAD_LOCAL(handles_free); }
+#define handles_init() pthread_once(&handles_once, handles_init_key)
+#endif
+
+/**
+ * Allocate a new chunk and return its first slot, with all slots linked as free
+ */
+static uint64_t *
+handles_alloc(void)
+{
+    handles_chunk_t *chunk = (handles_chunk_t*)malloc(sizeof(handles_chunk_t));
+    if (chunk == NULL) {
+        fprintf(stderr, "refs: Unable to allocate memory: %s!\n", strerror(errno));
+        exit(1);
+    }
+    for (int i=0; i<HANDLES_CHUNK_SIZE-1; i++) chunk->slots[i] = (uint64_t)(size_t)&chunk->slots[i+1] | 1;
+    chunk->slots[HANDLES_CHUNK_SIZE-1] = 1;
+    handles_chunk_t *head = atomic_load_explicit(&handles_list, memory_order_relaxed);
+    do {
+        chunk->next = head;
+    } while (!atomic_compare_exchange_weak(&handles_list, &head, chunk));
+    return chunk->slots;
+}
+
+uint64_t *
+handles_get(uint64_t a)
+{
+    handles_init();
+    LOCALIZE_THREAD_LOCAL(handles_free, uint64_t*);
+    uint64_t *handle = handles_free;
+    if (handle == NULL) handle = handles_alloc();
+    SET_THREAD_LOCAL(handles_free, (uint64_t*)(size_t)(*handle & ~(uint64_t)1));
+    *handle = a;
+    return handle;
+}
+
+void
+handles_put(uint64_t *handle)
+{
+    handles_init();
+    LOCALIZE_THREAD_LOCAL(handles_free, uint64_t*);
+    *handle = (uint64_t)(size_t)handles_free | 1;
+    SET_THREAD_LOCAL(handles_free, handle);
+}
+
+handles_chunk_t *
+handles_chunks(void)
+{
+    return atomic_load_explicit(&handles_list, memory_order_acquire);
+}
+
+size_t
+handles_count(uint64_t type)
+{
+    size_t count = 0;
+    for (handles_chunk_t *chunk = handles_chunks(); chunk != NULL; chunk = chunk->next) {
+        for (int i=0; i<HANDLES_CHUNK_SIZE; i++) {
+            if (HANDLES_TYPE(chunk->slots[i]) == type) count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Implementation of the local references of the workers
+ */
+
+DECLARE_THREAD_LOCAL(refs_local_key, refs_local_t*);
+static _Atomic(refs_local_t*) refs_locals = NULL;
+
+#ifndef __ELF__
+static pthread_once_t refs_once = PTHREAD_ONCE_INIT;
+static void refs_init_key(void) { INIT_THREAD_LOCAL(refs_local_key); }
+#endif
+
+static refs_segment_t *
+refs_segment_alloc(refs_segment_t *prev)
+{
+    refs_segment_t *seg = (refs_segment_t*)malloc(sizeof(refs_segment_t));
+    if (seg == NULL) {
+        fprintf(stderr, "refs: Unable to allocate memory: %s!\n", strerror(errno));
+        exit(1);
+    }
+    seg->prev = prev;
+    seg->next = NULL;
+    return seg;
+}
+
+static void
+refs_stack_clear(refs_stack_t *s)
+{
+    s->seg = s->first;
+    s->cur = s->first->entries;
+    s->end = s->first->entries + REFS_SEGMENT_SIZE;
+}
+
+void
+refs_init(int type)
+{
+#ifndef __ELF__
+    pthread_once(&refs_once, refs_init_key);
+#endif
+    for (refs_local_t *local = atomic_load(&refs_locals); local != NULL; local = local->next) {
+        for (int kind=0; kind<3; kind++) refs_stack_clear(&local->stacks[type][kind]);
+    }
+}
+
+refs_local_t *
+refs_local_create(void)
+{
+    assert(lace_is_worker()); // only use inside Lace workers
+    refs_local_t *local = (refs_local_t*)malloc(sizeof(refs_local_t));
+    if (local == NULL) {
+        fprintf(stderr, "refs: Unable to allocate memory: %s!\n", strerror(errno));
+        exit(1);
+    }
+    for (int type=0; type<REFS_TYPES; type++) {
+        for (int kind=0; kind<3; kind++) {
+            local->stacks[type][kind].first = refs_segment_alloc(NULL);
+            refs_stack_clear(&local->stacks[type][kind]);
+        }
+    }
+    refs_local_t *head = atomic_load_explicit(&refs_locals, memory_order_relaxed);
+    do {
+        local->next = head;
+    } while (!atomic_compare_exchange_weak(&refs_locals, &head, local));
+    SET_THREAD_LOCAL(refs_local_key, local);
+    return local;
+}
+
+void __attribute__((noinline))
+refs_stack_grow(refs_stack_t *s)
+{
+    refs_segment_t *next = s->seg->next;
+    if (next == NULL) next = s->seg->next = refs_segment_alloc(s->seg);
+    s->seg = next;
+    s->cur = next->entries;
+    s->end = next->entries + REFS_SEGMENT_SIZE;
+}
+
+void __attribute__((noinline))
+refs_stack_shrink(refs_stack_t *s, size_t amount)
+{
+    refs_segment_t *seg = s->seg;
+    size_t count = s->cur - seg->entries;
+    while (amount > count) {
+        amount -= count;
+        seg = seg->prev;
+        assert(seg != NULL); // popped more than pushed
+        count = REFS_SEGMENT_SIZE;
+    }
+    s->seg = seg;
+    s->cur = seg->entries + count - amount;
+    s->end = seg->entries + REFS_SEGMENT_SIZE;
+}
+
+VOID_TASK_4(refs_mark_entries, uint64_t*, begin, size_t, count, int, kind, refs_mark_cb, cb)
+{
+    if (count > 64) {
+        size_t half = (count / 4) * 2; // keep the tasks in pairs
+        SPAWN(refs_mark_entries, begin, half, kind, cb);
+        CALL(refs_mark_entries, begin + half, count - half, kind, cb);
+        SYNC(refs_mark_entries);
+    } else if (kind == REFS_VALUES) {
+        for (size_t i=0; i<count; i++) WRAP(cb, begin[i]);
+    } else if (kind == REFS_PTRS) {
+        for (size_t i=0; i<count; i++) WRAP(cb, *(const uint64_t*)(size_t)begin[i]);
+    } else {
+        for (size_t i=0; i<count; i+=2) {
+            // tasks are stolen from the bottom of the deque, so stop at the first task that is not stolen
+            Task *t = (Task*)(size_t)begin[i];
+            if (!TASK_IS_STOLEN(t)) return;
+            if (t->f == (void*)(size_t)begin[i+1] && TASK_IS_COMPLETED(t)) {
+                WRAP(cb, *(uint64_t*)TASK_RESULT(t));
+            }
+        }
+    }
+}
+
+VOID_TASK_IMPL_2(refs_mark, int, type, refs_mark_cb, cb)
+{
+    // the workers wait in garbage collection, so their stacks do not change
+    size_t count = 0;
+    for (refs_local_t *local = atomic_load(&refs_locals); local != NULL; local = local->next) {
+        for (int kind=0; kind<3; kind++) {
+            refs_stack_t *s = &local->stacks[type][kind];
+            for (refs_segment_t *seg = s->first; ; seg = seg->next) {
+                size_t n = seg == s->seg ? (size_t)(s->cur - seg->entries) : REFS_SEGMENT_SIZE;
+                if (n != 0) {
+                    SPAWN(refs_mark_entries, seg->entries, n, kind, cb);
+                    count++;
+                }
+                if (seg == s->seg) break;
+            }
+        }
+    }
+    while (count--) {
+        SYNC(refs_mark_entries);
+    }
+}
@@ -40,17 +40,30 @@ typedef struct
     size_t refs_resize_size;              // size of previous table
     _Atomic(size_t) refs_resize_part;     // which part is next
     _Atomic(size_t) refs_resize_done;     // how many parts are done
+
+    /* deferred mode: every thread buffers its changes, see refs_set_deferred */
+    int refs_deferred;                              // 1 if changes are buffered
+    _Atomic(struct refs_buffer*) refs_buffers;      // the buffers of all threads
 } refs_table_t;
 
-// Count number of unique entries (not number of references)
+// Count number of unique entries (not number of references), after refs_flush
 size_t refs_count(refs_table_t *tbl);
 
 // Increase or decrease reference to 40-bit value a
-// Will fail (assertion) if more down than up are called for a
+// Will fail (assertion) if more down than up are called for a, unless deferred
 void refs_up(refs_table_t *tbl, uint64_t a);
 void refs_down(refs_table_t *tbl, uint64_t a);
 
-// Return a bucket or NULL to start iterating
+// Turn the deferred mode on or off, while the references do not change
+// In deferred mode, refs_up and refs_down only change a small hash map of the current thread, in which
+// an up and a down of the same value cancel out. A full map is applied to the table. The table may then
+// have negative counts for values of which the up is still in the map of another thread, until refs_flush.
+void refs_set_deferred(refs_table_t *tbl, int deferred);
+
+// Apply the buffered changes of all threads to the table, e.g. before garbage collection
+void refs_flush(refs_table_t *tbl);
+
+// Return a bucket or NULL to start iterating (only values with a positive count)
 uint64_t *refs_iter(refs_table_t *tbl, size_t first, size_t end);
 
 // Continue iterating, set bucket to next bucket or NULL
@@ -69,6 +82,117 @@ uint64_t protect_next(refs_table_t *tbl, uint64_t **bucket, size_t end);
 void protect_create(refs_table_t *tbl, size_t _refs_size);
 void protect_free(refs_table_t *tbl);
 
+/**
+ * Implementation of handles, a cheaper alternative to protect_up/protect_down
+ * Handles are slots in chunks of HANDLES_CHUNK_SIZE slots. A used slot stores a pointer to a
+ * protected variable, with the type of the variable in bits 1-2 (the pointer is 8-aligned).
+ * Every thread takes and returns handles with its own free list, without atomic operations.
+ * A free slot stores the next free slot, with bit 0 set. Chunks are never freed.
+ */
+#define HANDLES_CHUNK_SIZE 1023
+#define HANDLES_TYPE(h) ((h) & 7)  // the type of a used slot, or odd for a free slot
+
+typedef struct handles_chunk
+{
+    struct handles_chunk *next;
+    uint64_t slots[HANDLES_CHUNK_SIZE];
+} handles_chunk_t;
+
+// Take a handle that protects <a> (a pointer with the type in bits 1-2)
+uint64_t *handles_get(uint64_t a);
+
+// Return a handle to the free list of the current thread
+void handles_put(uint64_t *handle);
+
+// First chunk of the list of all chunks
+handles_chunk_t *handles_chunks(void);
+
+// Count the used handles of the given type
+size_t handles_count(uint64_t type);
+
+/**
+ * Implementation of the local references of the workers (mtbdd_refs_push and friends)
+ * Every thread has one refs_local_t, found with a single thread-local pointer, with three stacks
+ * for every type of decision diagram: values, pointers to variables, and spawned tasks (pairs of
+ * the Task and its function). The stacks consist of linked segments of REFS_SEGMENT_SIZE entries.
+ * Segments are never moved, so growing a stack does not copy it. Popped segments are kept for reuse.
+ */
+#define REFS_SEGMENT_SIZE 1024  // even, so a task never crosses a segment
+#define REFS_MTBDD 0
+#define REFS_LDD 1
+#define REFS_ZDD 2
+#define REFS_TYPES 3
+#define REFS_VALUES 0
+#define REFS_PTRS 1
+#define REFS_TASKS 2
+
+typedef struct refs_segment
+{
+    struct refs_segment *prev, *next;
+    uint64_t entries[REFS_SEGMENT_SIZE];
+} refs_segment_t;
+
+typedef struct refs_stack
+{
+    uint64_t *cur, *end;            // top of the stack and end of the current segment (cur < end)
+    refs_segment_t *seg, *first;    // current segment and first segment
+} refs_stack_t;
+
+typedef struct refs_local
+{
+    refs_stack_t stacks[REFS_TYPES][3];
+    struct refs_local *next;        // list of the refs_local of all threads
+} refs_local_t;
+
+extern DECLARE_THREAD_LOCAL(refs_local_key, refs_local_t*);
+
+// Prepare the stacks of the given type and empty them on all threads; call before using the stacks
+void refs_init(int type);
+
+// Create the refs_local of the current thread, which must be a Lace worker
+refs_local_t *refs_local_create(void);
+
+// Continue the stack in the next segment, or shrink the stack over multiple segments
+void refs_stack_grow(refs_stack_t *s);
+void refs_stack_shrink(refs_stack_t *s, size_t amount);
+
+static inline refs_stack_t *
+refs_stack(int type, int kind)
+{
+    LOCALIZE_THREAD_LOCAL(refs_local_key, refs_local_t*);
+    refs_local_t *local = refs_local_key;
+    if (__builtin_expect(local == NULL, 0)) local = refs_local_create();
+    return &local->stacks[type][kind];
+}
+
+static inline void
+refs_stack_push(refs_stack_t *s, uint64_t a)
+{
+    *s->cur++ = a;
+    if (__builtin_expect(s->cur == s->end, 0)) refs_stack_grow(s);
+}
+
+static inline void
+refs_stack_push2(refs_stack_t *s, uint64_t a, uint64_t b)
+{
+    s->cur[0] = a;
+    s->cur[1] = b;
+    s->cur += 2;
+    if (__builtin_expect(s->cur == s->end, 0)) refs_stack_grow(s);
+}
+
+static inline void
+refs_stack_pop(refs_stack_t *s, size_t amount)
+{
+    if (__builtin_expect(amount <= (size_t)(s->cur - s->seg->entries), 1)) s->cur -= amount;
+    else refs_stack_shrink(s, amount);
+}
+
+// Mark the decision diagrams of the stacks of the given type of all threads, one task per segment
+LACE_TYPEDEF_CB(void, refs_mark_cb, uint64_t);
+VOID_TASK_DECL_2(refs_mark, int, refs_mark_cb);
+#define refs_mark(type, cb) CALL(refs_mark, type, cb)
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -22,7 +22,11 @@
 #include <string.h> // memset
 #include <inttypes.h>
 
-#if SYLVAN_STATS
+#ifdef __MACH__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
 
 #ifdef __ELF__
 __thread sylvan_stats_t sylvan_stats;
@@ -30,96 +34,126 @@ __thread sylvan_stats_t sylvan_stats;
 pthread_key_t sylvan_stats_key;
 #endif
 
+/* The sampling period, 0 if sampling is off */
+unsigned int sylvan_stats_sampling = 0;
+
+/* Set once sampling is turned on, so the reports are written */
+static int sylvan_stats_sampled = 0;
+
 /**
- * Instructions for sylvan_stats_report
+ * Instructions for sylvan_stats_report and sylvan_stats_report_json
  */
 struct
 {
     int type; /* 0 for print line, 1 for simple counter, 2 for operation with CACHED and CACHEDPUT */
-              /* 3 for timer, 4 for report table data */
+              /* 3 for timer, 4 for report table data, 5 for the GC event log */
     int id;
     const char *key;
+    const char *json; /* key in the JSON report (the section for type 0) */
 } sylvan_report_info[] =
 {
-    {0, 0, "Tables"},
-    {1, BDD_NODES_CREATED, "MTBDD nodes created"},
-    {1, BDD_NODES_REUSED, "MTBDD nodes reused"},
-    {1, LDD_NODES_CREATED, "LDD nodes created"},
-    {1, LDD_NODES_REUSED, "LDD nodes reused"},
-    {1, LLMSSET_LOOKUP, "Lookup iterations"},
-    {4, 0, NULL}, /* trigger to report unique nodes and operation cache */
-
-    {0, 0, "Operation            Count            Cache get        Cache put"},
-    {2, BDD_AND, "BDD and"},
-    {2, BDD_XOR, "BDD xor"},
-    {2, BDD_ITE, "BDD ite"},
-    {2, BDD_EXISTS, "BDD exists"},
-    {2, BDD_PROJECT, "BDD project"},
-    {2, BDD_AND_EXISTS, "BDD andexists"},
-    {2, BDD_AND_PROJECT, "BDD andproject"},
-    {2, BDD_RELNEXT, "BDD relnext"},
-    {2, BDD_RELPREV, "BDD relprev"},
-    {2, BDD_CLOSURE, "BDD closure"},
-    {2, BDD_COMPOSE, "BDD compose"},
-    {2, BDD_RESTRICT, "BDD restrict"},
-    {2, BDD_CONSTRAIN, "BDD constrain"},
-    {2, BDD_SUPPORT, "BDD support"},
-    {2, BDD_SATCOUNT, "BDD satcount"},
-    {2, BDD_PATHCOUNT, "BDD pathcount"},
-    {2, BDD_ISBDD, "BDD isbdd"},
-
-    {2, MTBDD_APPLY, "MTBDD binary apply"},
-    {2, MTBDD_UAPPLY, "MTBDD unary apply"},
-    {2, MTBDD_ABSTRACT, "MTBDD abstract"},
-    {2, MTBDD_ITE, "MTBDD ite"},
-    {2, MTBDD_EQUAL_NORM, "MTBDD eq norm"},
-    {2, MTBDD_EQUAL_NORM_REL, "MTBDD eq norm rel"},
-    {2, MTBDD_LEQ, "MTBDD leq"},
-    {2, MTBDD_LESS, "MTBDD less"},
-    {2, MTBDD_GEQ, "MTBDD geq"},
-    {2, MTBDD_GREATER, "MTBDD greater"},
-    {2, MTBDD_AND_ABSTRACT_PLUS, "MTBDD and_abs_plus"},
-    {2, MTBDD_AND_ABSTRACT_MAX, "MTBDD and_abs_max"},
-    {2, MTBDD_COMPOSE, "MTBDD compose"},
-    {2, MTBDD_MINIMUM, "MTBDD minimum"},
-    {2, MTBDD_MAXIMUM, "MTBDD maximum"},
-    {2, MTBDD_EVAL_COMPOSE, "MTBDD eval_compose"},
-
-    {2, LDD_UNION, "LDD union"},
-    {2, LDD_MINUS, "LDD minus"},
-    {2, LDD_INTERSECT, "LDD intersect"},
-    {2, LDD_RELPROD, "LDD relprod"},
-    {2, LDD_RELPREV, "LDD relprev"},
-    {2, LDD_PROJECT, "LDD project"},
-    {2, LDD_JOIN, "LDD join"},
-    {2, LDD_MATCH, "LDD match"},
-    {2, LDD_SATCOUNT, "LDD satcount"},
-    {2, LDD_SATCOUNTL, "LDD satcountl"},
-    {2, LDD_ZIP, "LDD zip"},
-    {2, LDD_RELPROD_UNION, "LDD relprod_union"},
-    {2, LDD_PROJECT_MINUS, "LDD project_minus"},
-
-    {2, ZDD_FROM_MTBDD, "ZDD from_mtbdd"},
-    {2, ZDD_TO_MTBDD, "ZDD to_mtbdd"},
-    {2, ZDD_UNION_CUBE, "ZDD union_cube"},
-    {2, ZDD_EXTEND_DOMAIN, "ZDD ext_domain"},
-    {2, ZDD_SUPPORT, "ZDD support" },
-    {2, ZDD_PATHCOUNT, "ZDD pathcount" },
-    {2, ZDD_AND, "ZDD and" },
-    {2, ZDD_OR, "ZDD or" },
-    {2, ZDD_ITE, "ZDD ite" },
-    {2, ZDD_NOT, "ZDD not" },
-    {2, ZDD_DIFF, "ZDD diff" },
-    {2, ZDD_EXISTS, "ZDD exists" },
-    {2, ZDD_PROJECT, "ZDD project" },
-    {2, ZDD_ISOP, "zdd isop"},
-    {2, ZDD_COVER_TO_BDD, "zdd cover_to_bdd"},
-
-    {0, 0, "Garbage collection"},
-    {1, SYLVAN_GC_COUNT, "GC executions"},
-    {3, SYLVAN_GC, "Total time spent"},
-
-    {-1, -1, NULL},
+    {0, 0, "Tables", "tables"},
+    {1, BDD_NODES_CREATED, "MTBDD nodes created", "bdd_nodes_created"},
+    {1, BDD_NODES_REUSED, "MTBDD nodes reused", "bdd_nodes_reused"},
+    {1, LDD_NODES_CREATED, "LDD nodes created", "ldd_nodes_created"},
+    {1, LDD_NODES_REUSED, "LDD nodes reused", "ldd_nodes_reused"},
+    {1, ZDD_NODES_CREATED, "ZDD nodes created", "zdd_nodes_created"},
+    {1, ZDD_NODES_REUSED, "ZDD nodes reused", "zdd_nodes_reused"},
+    {1, LLMSSET_LOOKUP, "Lookup iterations", "llmsset_lookup"},
+    {4, 0, NULL, NULL}, /* trigger to report unique nodes and operation cache */
+
+    {0, 0, "Operation            Count            Cache get        Cache put", "operations"},
+    {2, BDD_AND, "BDD and", "bdd_and"},
+    {2, BDD_XOR, "BDD xor", "bdd_xor"},
+    {2, BDD_ITE, "BDD ite", "bdd_ite"},
+    {2, BDD_EXISTS, "BDD exists", "bdd_exists"},
+    {2, BDD_PROJECT, "BDD project", "bdd_project"},
+    {2, BDD_AND_EXISTS, "BDD andexists", "bdd_and_exists"},
+    {2, BDD_AND_PROJECT, "BDD andproject", "bdd_and_project"},
+    {2, BDD_RELNEXT, "BDD relnext", "bdd_relnext"},
+    {2, BDD_RELPREV, "BDD relprev", "bdd_relprev"},
+    {2, BDD_CLOSURE, "BDD closure", "bdd_closure"},
+    {2, BDD_COMPOSE, "BDD compose", "bdd_compose"},
+    {2, BDD_RESTRICT, "BDD restrict", "bdd_restrict"},
+    {2, BDD_CONSTRAIN, "BDD constrain", "bdd_constrain"},
+    {2, BDD_SUPPORT, "BDD support", "bdd_support"},
+    {2, BDD_SATCOUNT, "BDD satcount", "bdd_satcount"},
+    {2, BDD_PATHCOUNT, "BDD pathcount", "bdd_pathcount"},
+    {2, BDD_ISBDD, "BDD isbdd", "bdd_isbdd"},
+    {2, BDD_AND_N, "BDD and_n", "bdd_and_n"},
+    {2, BDD_AND_EXISTS_N, "BDD and_exists_n", "bdd_and_exists_n"},
+    {2, BDD_SATURATE, "BDD saturate", "bdd_saturate"},
+    {2, BDD_LEQ, "BDD leq", "bdd_leq"},
+    {2, BDD_EQUIV_UNDER, "BDD equiv_under", "bdd_equiv_under"},
+
+    {2, MTBDD_APPLY, "MTBDD binary apply", "mtbdd_apply"},
+    {2, MTBDD_UAPPLY, "MTBDD unary apply", "mtbdd_uapply"},
+    {2, MTBDD_ABSTRACT, "MTBDD abstract", "mtbdd_abstract"},
+    {2, MTBDD_ITE, "MTBDD ite", "mtbdd_ite"},
+    {2, MTBDD_EQUAL_NORM, "MTBDD eq norm", "mtbdd_equal_norm"},
+    {2, MTBDD_EQUAL_NORM_REL, "MTBDD eq norm rel", "mtbdd_equal_norm_rel"},
+    {2, MTBDD_LEQ, "MTBDD leq", "mtbdd_leq"},
+    {2, MTBDD_LESS, "MTBDD less", "mtbdd_less"},
+    {2, MTBDD_GEQ, "MTBDD geq", "mtbdd_geq"},
+    {2, MTBDD_GREATER, "MTBDD greater", "mtbdd_greater"},
+    {2, MTBDD_AND_ABSTRACT, "MTBDD and_abstract", "mtbdd_and_abstract"},
+    {2, MTBDD_COMPOSE, "MTBDD compose", "mtbdd_compose"},
+    {2, MTBDD_MINIMUM, "MTBDD minimum", "mtbdd_minimum"},
+    {2, MTBDD_MAXIMUM, "MTBDD maximum", "mtbdd_maximum"},
+    {2, MTBDD_EVAL_COMPOSE, "MTBDD eval_compose", "mtbdd_eval_compose"},
+
+    {2, LDD_UNION, "LDD union", "ldd_union"},
+    {2, LDD_MINUS, "LDD minus", "ldd_minus"},
+    {2, LDD_INTERSECT, "LDD intersect", "ldd_intersect"},
+    {2, LDD_RELPROD, "LDD relprod", "ldd_relprod"},
+    {2, LDD_RELPREV, "LDD relprev", "ldd_relprev"},
+    {2, LDD_PROJECT, "LDD project", "ldd_project"},
+    {2, LDD_JOIN, "LDD join", "ldd_join"},
+    {2, LDD_MATCH, "LDD match", "ldd_match"},
+    {2, LDD_SATCOUNT, "LDD satcount", "ldd_satcount"},
+    {2, LDD_SATCOUNTL, "LDD satcountl", "ldd_satcountl"},
+    {2, LDD_ZIP, "LDD zip", "ldd_zip"},
+    {2, LDD_RELPROD_UNION, "LDD relprod_union", "ldd_relprod_union"},
+    {2, LDD_PROJECT_MINUS, "LDD project_minus", "ldd_project_minus"},
+    {2, LDD_SATURATE, "LDD saturate", "ldd_saturate"},
+
+    {2, ZDD_FROM_MTBDD, "ZDD from_mtbdd", "zdd_from_mtbdd"},
+    {2, ZDD_TO_MTBDD, "ZDD to_mtbdd", "zdd_to_mtbdd"},
+    {2, ZDD_UNION_CUBE, "ZDD union_cube", "zdd_union_cube"},
+    {2, ZDD_EXTEND_DOMAIN, "ZDD ext_domain", "zdd_extend_domain"},
+    {2, ZDD_SUPPORT, "ZDD support", "zdd_support"},
+    {2, ZDD_PATHCOUNT, "ZDD pathcount", "zdd_pathcount"},
+    {2, ZDD_AND, "ZDD and", "zdd_and"},
+    {2, ZDD_OR, "ZDD or", "zdd_or"},
+    {2, ZDD_ITE, "ZDD ite", "zdd_ite"},
+    {2, ZDD_NOT, "ZDD not", "zdd_not"},
+    {2, ZDD_DIFF, "ZDD diff", "zdd_diff"},
+    {2, ZDD_EXISTS, "ZDD exists", "zdd_exists"},
+    {2, ZDD_PROJECT, "ZDD project", "zdd_project"},
+    {2, ZDD_ISOP, "zdd isop", "zdd_isop"},
+    {2, ZDD_COVER_TO_BDD, "zdd cover_to_bdd", "zdd_cover_to_bdd"},
+
+    {0, 0, "Partitioned relations", "partrel"},
+    {1, PARTREL_CLUSTERS, "Clusters created", "partrel_clusters"},
+    {1, PARTREL_CLUSTER_NODES, "Cluster nodes", "partrel_cluster_nodes"},
+    {1, PARTREL_IMAGE_STEPS, "Image steps", "partrel_image_steps"},
+
+    {0, 0, "Reachability", "reachability"},
+    {1, LDD_REACHABLE_LEVELS, "LDD levels", "ldd_reachable_levels"},
+    {3, LDD_REACHABLE_TIME, "LDD time", "ldd_reachable_time"},
+    {3, LDD_REACHABLE_LEVEL_TIME, "LDD level time", "ldd_reachable_level_time"},
+
+    {0, 0, "Garbage collection", "gc"},
+    {1, SYLVAN_GC_COUNT, "GC executions", "gc_count"},
+    {3, SYLVAN_GC, "Total time spent", "gc_time"},
+    {3, SYLVAN_GC_HOOKS, "GC hooks", "gc_hooks_time"},
+    {3, SYLVAN_GC_CLEAR_CACHE, "Clearing cache", "gc_clear_cache_time"},
+    {3, SYLVAN_GC_MARK, "Marking", "gc_mark_time"},
+    {3, SYLVAN_GC_RESIZE, "Resizing", "gc_resize_time"},
+    {3, SYLVAN_GC_REHASH, "Rehashing", "gc_rehash_time"},
+    {5, 0, NULL, NULL}, /* trigger to report the GC event log */
+
+    {-1, -1, NULL, NULL},
 };
 
 VOID_TASK_0(sylvan_stats_reset_perthread)
@@ -131,6 +165,7 @@ VOID_TASK_0(sylvan_stats_reset_perthread)
     for (int i=0; i<SYLVAN_TIMER_COUNTER; i++) {
         sylvan_stats.timers[i] = 0;
     }
+    memset(sylvan_stats.timer_histograms, 0, sizeof(sylvan_stats.timer_histograms));
 #else
     sylvan_stats_t *sylvan_stats = pthread_getspecific(sylvan_stats_key);
     if (sylvan_stats == NULL) {
@@ -139,6 +174,7 @@ VOID_TASK_0(sylvan_stats_reset_perthread)
             fprintf(stderr, "sylvan_stats: Unable to allocate memory: %s!\n", strerror(errno));
             exit(1);
         }
+        memset(sylvan_stats, 0, sizeof(sylvan_stats_t));
     }
     pthread_setspecific(sylvan_stats_key, sylvan_stats);
     for (int i=0; i<SYLVAN_COUNTER_COUNTER; i++) {
@@ -147,6 +183,7 @@ VOID_TASK_0(sylvan_stats_reset_perthread)
     for (int i=0; i<SYLVAN_TIMER_COUNTER; i++) {
         sylvan_stats->timers[i] = 0;
     }
+    memset(sylvan_stats->timer_histograms, 0, sizeof(sylvan_stats->timer_histograms));
 #endif
 }
 
@@ -175,6 +212,11 @@ VOID_TASK_1(sylvan_stats_sum, sylvan_stats_t*, target)
     for (int i=0; i<SYLVAN_TIMER_COUNTER; i++) {
         atomic_fetch_add((_Atomic(uint64_t)*)target->timers + i, sylvan_stats.timers[i]);
     }
+    for (int i=0; i<SYLVAN_TIMER_COUNTER; i++) {
+        for (int j=0; j<SYLVAN_TIMER_BUCKETS; j++) {
+            atomic_fetch_add((_Atomic(uint64_t)*)target->timer_histograms[i] + j, sylvan_stats.timer_histograms[i][j]);
+        }
+    }
 #else
     sylvan_stats_t *sylvan_stats = pthread_getspecific(sylvan_stats_key);
     if (sylvan_stats != NULL) {
@@ -184,6 +226,11 @@ VOID_TASK_1(sylvan_stats_sum, sylvan_stats_t*, target)
         for (int i=0; i<SYLVAN_TIMER_COUNTER; i++) {
             atomic_fetch_add((_Atomic(uint64_t)*)target->timers + i, sylvan_stats->timers[i]);
         }
+        for (int i=0; i<SYLVAN_TIMER_COUNTER; i++) {
+            for (int j=0; j<SYLVAN_TIMER_BUCKETS; j++) {
+                atomic_fetch_add((_Atomic(uint64_t)*)target->timer_histograms[i] + j, sylvan_stats->timer_histograms[i][j]);
+            }
+        }
     }
 #endif
 }
@@ -194,6 +241,125 @@ VOID_TASK_IMPL_1(sylvan_stats_snapshot, sylvan_stats_t*, target)
     TOGETHER(sylvan_stats_sum, target);
 }
 
+VOID_TASK_1(sylvan_stats_copy, sylvan_stats_t*, target)
+{
+    sylvan_stats_t *dst = target + __lace_worker->worker;
+#ifdef __ELF__
+    memcpy(dst, &sylvan_stats, sizeof(sylvan_stats_t));
+#else
+    sylvan_stats_t *sylvan_stats = pthread_getspecific(sylvan_stats_key);
+    if (sylvan_stats != NULL) memcpy(dst, sylvan_stats, sizeof(sylvan_stats_t));
+#endif
+}
+
+VOID_TASK_IMPL_1(sylvan_stats_snapshot_workers, sylvan_stats_t*, target)
+{
+    memset(target, 0, sizeof(sylvan_stats_t) * lace_workers());
+    TOGETHER(sylvan_stats_copy, target);
+}
+
+static inline sylvan_stats_t*
+sylvan_stats_local(void)
+{
+#ifdef __ELF__
+    return &sylvan_stats;
+#else
+    return (sylvan_stats_t*)pthread_getspecific(sylvan_stats_key);
+#endif
+}
+
+void
+sylvan_stats_timer_record(size_t timer, uint64_t time)
+{
+#ifdef __MACH__
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    time *= timebase.numer/timebase.denom;
+#endif
+    uint64_t us = time / 1000;
+    int bucket = 0;
+    while (us != 0 && bucket < SYLVAN_TIMER_BUCKETS-1) {
+        us >>= 1;
+        bucket++;
+    }
+    sylvan_stats_local()->timer_histograms[timer][bucket]++;
+}
+
+void
+sylvan_stats_set_sampling(unsigned int period)
+{
+#if !SYLVAN_STATS
+    if (period != 0) sylvan_stats_sampled = 1;
+    sylvan_stats_sampling = period;
+#else
+    (void)period;
+#endif
+}
+
+unsigned int
+sylvan_stats_get_sampling(void)
+{
+    return sylvan_stats_sampling;
+}
+
+/**
+ * Count one of every <sylvan_stats_sampling> events on average. The distance to the next
+ * sampled event is uniform in 1...2N-1, so the counters do not alias with the operations.
+ */
+void
+sylvan_stats_sample(size_t counter, size_t amount)
+{
+    sylvan_stats_t *stats = sylvan_stats_local();
+    if (stats == NULL) return; // not a Sylvan thread
+    if (stats->sample_countdown > 1) {
+        stats->sample_countdown--;
+        return;
+    }
+    const uint64_t period = sylvan_stats_sampling;
+    if (period == 0) return;
+    stats->counters[counter] += amount * period;
+    // xorshift
+    uint64_t x = stats->sample_rng;
+    if (x == 0) x = 0x9e3779b97f4a7c15ULL ^ (uint64_t)(size_t)stats;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    stats->sample_rng = x;
+    stats->sample_countdown = 1 + x % (2 * period - 1);
+}
+
+static uint64_t
+sylvan_stats_time(void)
+{
+#ifdef __MACH__
+    return mach_absolute_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+#endif
+}
+
+void
+sylvan_stats_sample_timer_start(size_t timer)
+{
+    sylvan_stats_t *stats = sylvan_stats_local();
+    if (stats != NULL) stats->timers_startstop[timer] = sylvan_stats_time();
+}
+
+uint64_t
+sylvan_stats_sample_timer_stop(size_t timer)
+{
+    sylvan_stats_t *stats = sylvan_stats_local();
+    // ignore timers that were started before sampling was turned on
+    if (stats == NULL || stats->timers_startstop[timer] == 0) return 0;
+    uint64_t t = sylvan_stats_time() - stats->timers_startstop[timer];
+    stats->timers_startstop[timer] = 0;
+    stats->timers[timer] += t;
+    sylvan_stats_timer_record(timer, t);
+    return t;
+}
+
 #define BLACK "\33[22;30m"
 #define GRAY "\33[1;30m"
 #define RED "\33[22;31m"
@@ -225,9 +391,79 @@ to_h(double size, char *buf)
     return buf;
 }
 
+/**
+ * Total time and nodes of the marking callbacks (by name) over the events in the GC event log
+ */
+typedef struct
+{
+    const char *name;
+    uint64_t time;
+    size_t nodes;
+} gc_mark_total_t;
+
+static unsigned int
+gc_mark_totals(gc_mark_total_t **result)
+{
+    gc_mark_total_t *totals = NULL;
+    unsigned int count = 0;
+    size_t n = sylvan_gc_log_count();
+    sylvan_gc_event_t event;
+    for (size_t i = n > SYLVAN_GC_LOG_SIZE ? n - SYLVAN_GC_LOG_SIZE : 0; i < n; i++) {
+        if (!sylvan_gc_log_get(i, &event)) continue;
+        for (unsigned int m=0; m<event.mark_count; m++) {
+            const char *name = event.marks[m].name != NULL ? event.marks[m].name : "(unnamed)";
+            unsigned int k = 0;
+            while (k < count && strcmp(totals[k].name, name) != 0) k++;
+            if (k == count) {
+                gc_mark_total_t *grown = (gc_mark_total_t*)realloc(totals, sizeof(gc_mark_total_t[count+1]));
+                if (grown == NULL) {
+                    fprintf(stderr, "sylvan_stats: Unable to allocate memory: %s!\n", strerror(errno));
+                    exit(1);
+                }
+                totals = grown;
+                totals[count++] = (gc_mark_total_t){name, 0, 0};
+            }
+            totals[k].time += event.marks[m].time;
+            totals[k].nodes += event.marks[m].nodes;
+        }
+    }
+    *result = totals;
+    return count;
+}
+
+static void
+gc_log_report(FILE *target, int color)
+{
+    size_t n = sylvan_gc_log_count();
+    if (n == 0) return;
+
+    gc_mark_total_t *totals;
+    unsigned int count = gc_mark_totals(&totals);
+    if (color) fprintf(target, WHITE "\n%-32s %-16s %s\n" NC, "Mark callback", "Time", "Nodes");
+    else fprintf(target, "\n%-32s %-16s %s\n", "Mark callback", "Time", "Nodes");
+    for (unsigned int k=0; k<count; k++) {
+        fprintf(target, "%-32s %'-16.6f %'zu\n", totals[k].name, (double)totals[k].time/1000000000, totals[k].nodes);
+    }
+    free(totals);
+
+    size_t first = n > SYLVAN_GC_LOG_SIZE ? n - SYLVAN_GC_LOG_SIZE : 0;
+    if (color) fprintf(target, WHITE "\nGC log (last %zu of %zu)\n" NC, n - first, n);
+    else fprintf(target, "\nGC log (last %zu of %zu)\n", n - first, n);
+    fprintf(target, "%-5s %-10s %-10s %-14s %-14s %-14s %-14s\n", "GC", "Start", "Pause", "Nodes before", "Nodes live", "Table before", "Table after");
+    sylvan_gc_event_t event;
+    for (size_t i=first; i<n; i++) {
+        if (!sylvan_gc_log_get(i, &event)) continue;
+        fprintf(target, "%-5zu %-10.3f %-10.6f %'-14zu %'-14zu %'-14zu %'-14zu\n", (size_t)event.index,
+                (double)event.start/1000000000, (double)event.pause/1000000000,
+                event.nodes_before, event.nodes_live, event.table_before, event.table_after);
+    }
+}
+
 void
 sylvan_stats_report(FILE *target)
 {
+    if (!SYLVAN_STATS && !sylvan_stats_sampled) return;
+
     sylvan_stats_t totals;
     sylvan_stats_snapshot(&totals);
 
@@ -242,6 +478,7 @@ sylvan_stats_report(FILE *target)
     int color = isatty(fileno(target)) ? 1 : 0;
     if (color) fprintf(target, ULINE WHITE "Sylvan statistics\n" NC);
     else fprintf(target, "Sylvan statistics\n");
+    if (!SYLVAN_STATS) fprintf(target, "(estimated from one of every %u events)\n", sylvan_stats_sampling);
 
     int i=0;
     for (;;) {
@@ -257,7 +494,7 @@ sylvan_stats_report(FILE *target)
             }
         } else if (type == 2) {
             if (totals.counters[id] > 0) {
-                fprintf(target, "%-20s %'-16"PRIu64 " %'-16"PRIu64" %'-16"PRIu64 "\n", sylvan_report_info[i].key, totals.counters[id], totals.counters[id+1], totals.counters[id+2]);
+                fprintf(target, "%-20s %'-16"PRIu64 " %'-16"PRIu64" %'-16"PRIu64 "\n", sylvan_report_info[i].key, totals.counters[id], totals.counters[id+2], totals.counters[id+1]);
             }
         } else if (type == 3) {
             if (totals.timers[id] > 0) {
@@ -273,30 +510,170 @@ sylvan_stats_report(FILE *target)
             to_h(36ULL * cache_getsize(), buf);
             to_h(36ULL * cache_getmaxsize(), buf2);
             fprintf(target, "%-20s %s (max real) of %s (allocated virtual memory).\n", "Memory (cache)", buf, buf2);
+        } else if (type == 5) {
+            gc_log_report(target, color);
         }
         i++;
     }
 }
 
-#else
-
-VOID_TASK_IMPL_0(sylvan_stats_init)
+/**
+ * Write the total and the value of every worker of counter (or timer) <id>
+ */
+static void
+json_value(FILE *target, const sylvan_stats_t *workers, unsigned int n, int timer, int id)
 {
+    uint64_t total = 0;
+    for (unsigned int w=0; w<n; w++) total += timer ? workers[w].timers[id] : workers[w].counters[id];
+    if (timer) fprintf(target, "{\"total\": %.9f, \"workers\": [", (double)total/1000000000);
+    else fprintf(target, "{\"total\": %"PRIu64", \"workers\": [", total);
+    for (unsigned int w=0; w<n; w++) {
+        if (w != 0) fprintf(target, ", ");
+        if (timer) fprintf(target, "%.9f", (double)workers[w].timers[id]/1000000000);
+        else fprintf(target, "%"PRIu64, workers[w].counters[id]);
+    }
+    fprintf(target, "]");
+    if (timer) {
+        fprintf(target, ", \"histogram\": [");
+        for (int b=0; b<SYLVAN_TIMER_BUCKETS; b++) {
+            uint64_t count = 0;
+            for (unsigned int w=0; w<n; w++) count += workers[w].timer_histograms[id][b];
+            fprintf(target, b ? ", %"PRIu64 : "%"PRIu64, count);
+        }
+        fprintf(target, "]");
+    }
+    fprintf(target, "}");
 }
 
-VOID_TASK_IMPL_0(sylvan_stats_reset)
+/**
+ * Write the marking callbacks and the events of the GC event log
+ */
+static void
+json_gc_log(FILE *target)
 {
+    gc_mark_total_t *totals;
+    unsigned int count = gc_mark_totals(&totals);
+    fprintf(target, "\"marks\": [");
+    for (unsigned int k=0; k<count; k++) {
+        fprintf(target, "%s\n      {\"name\": \"%s\", \"time\": %.9f, \"nodes\": %zu}", k ? "," : "",
+                totals[k].name, (double)totals[k].time/1000000000, totals[k].nodes);
+    }
+    fprintf(target, count ? "\n    ],\n    " : "],\n    ");
+    free(totals);
+
+    size_t n = sylvan_gc_log_count();
+    size_t first = n > SYLVAN_GC_LOG_SIZE ? n - SYLVAN_GC_LOG_SIZE : 0;
+    fprintf(target, "\"events\": [");
+    sylvan_gc_event_t event;
+    for (size_t i=first; i<n; i++) {
+        if (!sylvan_gc_log_get(i, &event)) continue;
+        fprintf(target, "%s\n      {\"index\": %"PRIu64", \"start\": %.9f, \"pause\": %.9f, \"phases\": {", i != first ? "," : "",
+                event.index, (double)event.start/1000000000, (double)event.pause/1000000000);
+        for (int p=0; p<SYLVAN_GC_PHASES; p++) {
+            fprintf(target, "%s\"%s\": %.9f", p ? ", " : "", sylvan_gc_phase_name(p), (double)event.phases[p]/1000000000);
+        }
+        fprintf(target, "}, \"table_before\": %zu, \"table_after\": %zu, \"cache_before\": %zu, \"cache_after\": %zu, ",
+                event.table_before, event.table_after, event.cache_before, event.cache_after);
+        fprintf(target, "\"nodes_before\": %zu, \"nodes_live\": %zu, \"minor\": %d, \"nodes_old\": %zu, \"marks\": [",
+                event.nodes_before, event.nodes_live, event.minor, event.nodes_old);
+        for (unsigned int m=0; m<event.mark_count; m++) {
+            const char *name = event.marks[m].name != NULL ? event.marks[m].name : "(unnamed)";
+            fprintf(target, "%s{\"name\": \"%s\", \"time\": %.9f, \"nodes\": %zu}", m ? ", " : "",
+                    name, (double)event.marks[m].time/1000000000, event.marks[m].nodes);
+        }
+        fprintf(target, "]}");
+    }
+    fprintf(target, n > first ? "\n    ]" : "]");
 }
 
-VOID_TASK_IMPL_1(sylvan_stats_snapshot, sylvan_stats_t*, target)
+static uint64_t
+json_total(const sylvan_stats_t *workers, unsigned int n, int id)
 {
-    memset(target, 0, sizeof(sylvan_stats_t));
+    uint64_t total = 0;
+    for (unsigned int w=0; w<n; w++) total += workers[w].counters[id];
+    return total;
 }
 
 void
-sylvan_stats_report(FILE* target)
+sylvan_stats_report_json(FILE *target)
 {
-    (void)target;
-}
+    if (!SYLVAN_STATS && !sylvan_stats_sampled) {
+        fprintf(target, "{}\n");
+        return;
+    }
+
+    const unsigned int n = lace_workers();
+    sylvan_stats_t *workers = (sylvan_stats_t*)malloc(sizeof(sylvan_stats_t) * n);
+    if (workers == NULL) {
+        fprintf(stderr, "sylvan_stats: Unable to allocate memory: %s!\n", strerror(errno));
+        exit(1);
+    }
+    sylvan_stats_snapshot_workers(workers);
 
+    // fix timers for MACH
+#ifdef __MACH__
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    uint64_t c = timebase.numer/timebase.denom;
+    for (unsigned int w=0; w<n; w++) {
+        for (int i=0;i<SYLVAN_TIMER_COUNTER;i++) workers[w].timers[i]*=c;
+    }
 #endif
+
+    // total cache lookups and hits of all operations
+    uint64_t lookups = 0, hits = 0;
+    for (int i=0; sylvan_report_info[i].id != -1; i++) {
+        if (sylvan_report_info[i].type != 2) continue;
+        lookups += json_total(workers, n, sylvan_report_info[i].id);
+        hits += json_total(workers, n, sylvan_report_info[i].id+2);
+    }
+
+    fprintf(target, "{\n  \"workers\": %u,\n  \"sampling\": %u,\n  \"timer_buckets_us\": [0", n, sylvan_stats_sampling);
+    for (int b=1; b<SYLVAN_TIMER_BUCKETS; b++) fprintf(target, ", %"PRIu64, (uint64_t)1 << (b-1));
+    fprintf(target, "]");
+    int first = 1, section = 0;
+    for (int i=0; sylvan_report_info[i].id != -1; i++) {
+        const int id = sylvan_report_info[i].id;
+        const int type = sylvan_report_info[i].type;
+        const char *key = sylvan_report_info[i].json;
+        if (type == 0) {
+            if (section) fprintf(target, "\n  }");
+            fprintf(target, ",\n  \"%s\": {", key);
+            section = 1;
+            first = 1;
+            continue;
+        }
+        fprintf(target, first ? "\n    " : ",\n    ");
+        first = 0;
+        if (type == 1 || type == 3) {
+            fprintf(target, "\"%s\": ", key);
+            json_value(target, workers, n, type == 3, id);
+        } else if (type == 2) {
+            uint64_t count = json_total(workers, n, id);
+            uint64_t cached = json_total(workers, n, id+2);
+            fprintf(target, "\"%s\": {\"count\": ", key);
+            json_value(target, workers, n, 0, id);
+            fprintf(target, ", \"cache_get\": ");
+            json_value(target, workers, n, 0, id+2);
+            fprintf(target, ", \"cache_put\": ");
+            json_value(target, workers, n, 0, id+1);
+            fprintf(target, ", \"cache_hit_ratio\": %.6f}", count ? (double)cached/count : 0.0);
+        } else if (type == 4) {
+            size_t filled = llmsset_count_marked(nodes), size = llmsset_get_size(nodes);
+            fprintf(target, "\"nodes\": {\"filled\": %zu, \"size\": %zu, \"max_size\": %zu, \"occupancy\": %.6f},\n    ",
+                    filled, size, llmsset_get_max_size(nodes), (double)filled/size);
+            filled = cache_getused();
+            size = cache_getsize();
+            fprintf(target, "\"cache\": {\"filled\": %zu, \"size\": %zu, \"max_size\": %zu, \"occupancy\": %.6f, ",
+                    filled, size, cache_getmaxsize(), (double)filled/size);
+            fprintf(target, "\"lookups\": %"PRIu64", \"hits\": %"PRIu64", \"hit_ratio\": %.6f}",
+                    lookups, hits, lookups ? (double)hits/lookups : 0.0);
+        } else if (type == 5) {
+            json_gc_log(target);
+        }
+    }
+    if (section) fprintf(target, "\n  }");
+    fprintf(target, "\n}\n");
+
+    free(workers);
+}
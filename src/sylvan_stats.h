@@ -53,6 +53,11 @@ typedef enum {
     OPCOUNTER(BDD_ISBDD),
     OPCOUNTER(BDD_SUPPORT),
     OPCOUNTER(BDD_PATHCOUNT),
+    OPCOUNTER(BDD_AND_N),
+    OPCOUNTER(BDD_AND_EXISTS_N),
+    OPCOUNTER(BDD_SATURATE),
+    OPCOUNTER(BDD_LEQ),
+    OPCOUNTER(BDD_EQUIV_UNDER),
 
     /* MTBDD operations */
     OPCOUNTER(MTBDD_APPLY),
@@ -65,8 +70,7 @@ typedef enum {
     OPCOUNTER(MTBDD_LESS),
     OPCOUNTER(MTBDD_GEQ),
     OPCOUNTER(MTBDD_GREATER),
-    OPCOUNTER(MTBDD_AND_ABSTRACT_PLUS),
-    OPCOUNTER(MTBDD_AND_ABSTRACT_MAX),
+    OPCOUNTER(MTBDD_AND_ABSTRACT),
     OPCOUNTER(MTBDD_COMPOSE),
     OPCOUNTER(MTBDD_MINIMUM),
     OPCOUNTER(MTBDD_MAXIMUM),
@@ -86,6 +90,7 @@ typedef enum {
     OPCOUNTER(LDD_ZIP),
     OPCOUNTER(LDD_RELPROD_UNION),
     OPCOUNTER(LDD_PROJECT_MINUS),
+    OPCOUNTER(LDD_SATURATE),
 
     /* ZDD operations */
     OPCOUNTER(ZDD_FROM_MTBDD),
@@ -104,6 +109,14 @@ typedef enum {
     OPCOUNTER(ZDD_ISOP),
     OPCOUNTER(ZDD_COVER_TO_BDD),
 
+    /* Partitioned relations */
+    PARTREL_CLUSTERS,
+    PARTREL_CLUSTER_NODES,
+    PARTREL_IMAGE_STEPS,
+
+    /* Reachability */
+    LDD_REACHABLE_LEVELS,
+
     /* Other counters */
     SYLVAN_GC_COUNT,
     LLMSSET_LOOKUP,
@@ -116,16 +129,34 @@ typedef enum {
 typedef enum
 {
     SYLVAN_GC,
+    SYLVAN_GC_HOOKS,
+    SYLVAN_GC_CLEAR_CACHE,
+    SYLVAN_GC_MARK,
+    SYLVAN_GC_RESIZE,
+    SYLVAN_GC_REHASH,
+    LDD_REACHABLE_TIME,
+    LDD_REACHABLE_LEVEL_TIME,
     SYLVAN_TIMER_COUNTER
 } Sylvan_Timers;
 
+/**
+ * Number of buckets of the timer histograms. Bucket 0 counts the measurements shorter
+ * than 1 us, bucket i those of at least 2^(i-1) and less than 2^i us, and the last
+ * bucket all longer measurements.
+ */
+#define SYLVAN_TIMER_BUCKETS 24
+
 typedef struct
 {
     uint64_t counters[SYLVAN_COUNTER_COUNTER];
     /* the timers are in ns */
     uint64_t timers[SYLVAN_TIMER_COUNTER];
-    /* startstop is for internal use */
+    /* histogram of the measurements of every timer */
+    uint64_t timer_histograms[SYLVAN_TIMER_COUNTER][SYLVAN_TIMER_BUCKETS];
+    /* startstop and the sampling state are for internal use */
     uint64_t timers_startstop[SYLVAN_TIMER_COUNTER];
+    uint64_t sample_countdown;
+    uint64_t sample_rng;
 } sylvan_stats_t;
 
 /**
@@ -146,11 +177,50 @@ VOID_TASK_DECL_0(sylvan_stats_reset);
 VOID_TASK_DECL_1(sylvan_stats_snapshot, sylvan_stats_t*);
 #define sylvan_stats_snapshot(target) RUN(sylvan_stats_snapshot, target)
 
+/**
+ * Obtain current counts of every worker, in <target>[0] ... <target>[lace_workers()-1]
+ * (this stops the world during counting)
+ */
+VOID_TASK_DECL_1(sylvan_stats_snapshot_workers, sylvan_stats_t*);
+#define sylvan_stats_snapshot_workers(target) RUN(sylvan_stats_snapshot_workers, target)
+
 /**
  * Write statistic report to file (stdout, stderr, etc)
+ * Writes nothing if no statistics are collected.
  */
 void sylvan_stats_report(FILE* target);
 
+/**
+ * Write all statistics to file as one JSON object. Every counter and timer has the
+ * total and the value of each worker, every operation also the cache hit ratio.
+ * The report also contains the occupancy of the nodes table and the operation cache
+ * and a histogram of every timer. Writes an empty object if no statistics are collected
+ * (without SYLVAN_STATS and if sampling was never turned on).
+ */
+void sylvan_stats_report_json(FILE* target);
+
+/**
+ * Sample the counters and timers at runtime, when Sylvan is built without SYLVAN_STATS.
+ * With <period> N > 0, every worker records on average one of every N counted events,
+ * weighted by N, and measures all timers. With <period> 0 (the default), sampling is off
+ * and every counted event only costs one well-predicted branch.
+ * The reports show the sampled estimates. With SYLVAN_STATS, all events are always
+ * counted exactly and this has no effect.
+ */
+void sylvan_stats_set_sampling(unsigned int period);
+
+/**
+ * Returns the sampling period (0 if sampling is off).
+ */
+unsigned int sylvan_stats_get_sampling(void);
+
+/* For internal use */
+extern unsigned int sylvan_stats_sampling;
+void sylvan_stats_sample(size_t counter, size_t amount);
+void sylvan_stats_timer_record(size_t timer, uint64_t time);
+void sylvan_stats_sample_timer_start(size_t timer);
+uint64_t sylvan_stats_sample_timer_stop(size_t timer);
+
 #if SYLVAN_STATS
 
 #ifdef __MACH__
@@ -209,17 +279,24 @@ sylvan_timer_start(size_t timer)
 #endif
 }
 
-static inline void
+/**
+ * Stop the timer, returns the time since sylvan_timer_start
+ */
+static inline uint64_t
 sylvan_timer_stop(size_t timer)
 {
     uint64_t t = getabstime();
 
 #ifdef __ELF__
-    sylvan_stats.timers[timer] += (t - sylvan_stats.timers_startstop[timer]);
+    t -= sylvan_stats.timers_startstop[timer];
+    sylvan_stats.timers[timer] += t;
 #else
     sylvan_stats_t *sylvan_stats = (sylvan_stats_t*)pthread_getspecific(sylvan_stats_key);
-    sylvan_stats->timers[timer] += (t - sylvan_stats->timers_startstop[timer]);
+    t -= sylvan_stats->timers_startstop[timer];
+    sylvan_stats->timers[timer] += t;
 #endif
+    sylvan_stats_timer_record(timer, t);
+    return t;
 }
 
 #else
@@ -227,26 +304,29 @@ sylvan_timer_stop(size_t timer)
 static inline void
 sylvan_stats_count(size_t counter)
 {
-    (void)counter;
+    if (__builtin_expect(sylvan_stats_sampling != 0, 0)) sylvan_stats_sample(counter, 1);
 }
 
 static inline void
 sylvan_stats_add(size_t counter, size_t amount)
 {
-    (void)counter;
-    (void)amount;
+    if (__builtin_expect(sylvan_stats_sampling != 0, 0)) sylvan_stats_sample(counter, amount);
 }
 
 static inline void
 sylvan_timer_start(size_t timer)
 {
-    (void)timer;
+    if (__builtin_expect(sylvan_stats_sampling != 0, 0)) sylvan_stats_sample_timer_start(timer);
 }
 
-static inline void
+/**
+ * Stop the timer, returns the time since sylvan_timer_start (0 if sampling is off)
+ */
+static inline uint64_t
 sylvan_timer_stop(size_t timer)
 {
-    (void)timer;
+    if (__builtin_expect(sylvan_stats_sampling != 0, 0)) return sylvan_stats_sample_timer_stop(timer);
+    return 0;
 }
 
 #endif
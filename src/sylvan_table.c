@@ -139,7 +139,11 @@ llmsset_lookup2(const llmsset_t dbs, uint64_t a, uint64_t b, int* created, const
             if (cidx == 0) {
                 // Claim data bucket and write data
                 cidx = claim_data_bucket(dbs);
-                if (cidx == (uint64_t)-1) return 0; // failed to claim a data bucket
+                if (cidx == (uint64_t)-1) {
+                    // failed to claim a data bucket
+                    sylvan_trace(SYLVAN_TRACE_TABLE, SYLVAN_TRACE_TABLE_FULL, 0, dbs->table_size);
+                    return 0;
+                }
                 if (custom) dbs->create_cb(&a, &b);
                 uint64_t *d_ptr = ((uint64_t*)dbs->data) + 2*cidx;
                 d_ptr[0] = a;
@@ -178,7 +182,11 @@ llmsset_lookup2(const llmsset_t dbs, uint64_t a, uint64_t b, int* created, const
         // find next idx on probe sequence
         idx = (idx & CL_MASK) | ((idx+1) & CL_MASK_R);
         if (idx == last) {
-            if (++i == dbs->threshold) return 0; // failed to find empty spot in probe sequence
+            if (++i == dbs->threshold) {
+                // failed to find empty spot in probe sequence
+                sylvan_trace(SYLVAN_TRACE_TABLE, SYLVAN_TRACE_TABLE_FULL, 0, dbs->table_size);
+                return 0;
+            }
 
             // go to next cache line in probe sequence
             hash_rehash += step;
@@ -298,13 +306,15 @@ llmsset_create(size_t initial_size, size_t max_size)
     /* Also allocate bitmaps. Each region is 64*8 = 512 buckets.
        Overhead of bitmap1: 1 bit per 4096 bucket.
        Overhead of bitmap2: 1 bit per bucket.
-       Overhead of bitmapc: 1 bit per bucket. */
+       Overhead of bitmapc: 1 bit per bucket.
+       Overhead of bitmapo: 1 bit per bucket. */
 
     dbs->bitmap1 = (_Atomic(uint64_t)*)alloc_aligned(dbs->max_size / (512*8));
     dbs->bitmap2 = (_Atomic(uint64_t)*)alloc_aligned(dbs->max_size / 8);
     dbs->bitmapc = (uint64_t*)alloc_aligned(dbs->max_size / 8);
+    dbs->bitmapo = (uint64_t*)alloc_aligned(dbs->max_size / 8);
 
-    if (dbs->table == 0 || dbs->data == 0 || dbs->bitmap1 == 0 || dbs->bitmap2 == 0 || dbs->bitmapc == 0) {
+    if (dbs->table == 0 || dbs->data == 0 || dbs->bitmap1 == 0 || dbs->bitmap2 == 0 || dbs->bitmapc == 0 || dbs->bitmapo == 0) {
         fprintf(stderr, "llmsset_create: Unable to allocate memory: %s!\n", strerror(errno));
         exit(1);
     }
@@ -342,6 +352,7 @@ llmsset_free(llmsset_t dbs)
     free_aligned(dbs->bitmap1, dbs->max_size / (512*8));
     free_aligned(dbs->bitmap2, dbs->max_size / 8);
     free_aligned(dbs->bitmapc, dbs->max_size / 8);
+    free_aligned(dbs->bitmapo, dbs->max_size / 8);
     free_aligned(dbs, sizeof(struct llmsset));
 }
 
@@ -349,6 +360,7 @@ VOID_TASK_IMPL_1(llmsset_clear, llmsset_t, dbs)
 {
     CALL(llmsset_clear_data, dbs);
     CALL(llmsset_clear_hashes, dbs);
+    clear_aligned(dbs->bitmapo, dbs->max_size / 8);
 }
 
 VOID_TASK_IMPL_1(llmsset_clear_data, llmsset_t, dbs)
@@ -367,6 +379,24 @@ VOID_TASK_IMPL_1(llmsset_clear_hashes, llmsset_t, dbs)
     clear_aligned(dbs->table, dbs->max_size * 8);
 }
 
+VOID_TASK_IMPL_1(llmsset_clear_young, llmsset_t, dbs)
+{
+    clear_aligned(dbs->bitmap1, dbs->max_size / (512*8));
+
+    // buckets beyond table_size are never marked, also not in bitmapo
+    memcpy((uint64_t*)dbs->bitmap2, dbs->bitmapo, dbs->table_size / 8);
+
+    // forbid first two positions (index 0 and 1)
+    dbs->bitmap2[0] |= 0xc000000000000000LL;
+
+    TOGETHER(llmsset_reset_region);
+}
+
+VOID_TASK_IMPL_1(llmsset_promote, llmsset_t, dbs)
+{
+    memcpy(dbs->bitmapo, (uint64_t*)dbs->bitmap2, dbs->table_size / 8);
+}
+
 int
 llmsset_is_marked(const llmsset_t dbs, uint64_t index)
 {
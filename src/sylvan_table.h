@@ -56,6 +56,7 @@ typedef struct llmsset
     _Atomic(uint64_t)* bitmap1;      // ownership bitmap (per 512 buckets)
     _Atomic(uint64_t)* bitmap2;      // bitmap for "contains data"
     uint64_t*          bitmapc;      // bitmap for "use custom functions"
+    uint64_t*          bitmapo;      // bitmap for "old" (generational garbage collection)
     size_t             max_size;     // maximum size of the hash table (for resizing)
     size_t             table_size;   // size of the hash table (number of slots) --> power of 2!
 #if LLMSSET_MASK
@@ -157,6 +158,21 @@ VOID_TASK_DECL_1(llmsset_clear_data, llmsset_t);
 VOID_TASK_DECL_1(llmsset_clear_hashes, llmsset_t);
 #define llmsset_clear_hashes(dbs) RUN(llmsset_clear_hashes, dbs)
 
+/**
+ * For generational garbage collection: clear the marks of the young buckets, but keep the
+ * old buckets marked. Marking then stops at old buckets and only traces young buckets.
+ * Old buckets must only refer to old buckets, which llmsset_promote ensures if the marking
+ * callbacks mark all children of a marked bucket.
+ */
+VOID_TASK_DECL_1(llmsset_clear_young, llmsset_t);
+#define llmsset_clear_young(dbs) RUN(llmsset_clear_young, dbs)
+
+/**
+ * Make all marked buckets old, and all other buckets young.
+ */
+VOID_TASK_DECL_1(llmsset_promote, llmsset_t);
+#define llmsset_promote(dbs) RUN(llmsset_promote, dbs)
+
 /**
  * Check if a certain data bucket is marked (in use).
  */
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+/* The traced categories, 0 if tracing is off */
+unsigned int sylvan_trace_categories = 0;
+
+typedef struct trace_entry
+{
+    uint64_t time;              // ns since sylvan_trace_enable
+    uint32_t type;              // sylvan_trace_type_t
+    uint32_t aux;
+    uint64_t arg;
+} trace_entry_t;
+
+/**
+ * The ring buffer of one worker, on its own cache line
+ */
+typedef union trace_buffer
+{
+    struct {
+        trace_entry_t *events;
+        uint64_t count;         // number of recorded events (also those that were overwritten)
+    };
+    char pad[LINE_SIZE];
+} trace_buffer_t;
+
+static trace_buffer_t *trace_buffers = NULL;
+static unsigned int trace_workers = 0;
+static size_t trace_capacity = 0;
+static uint64_t trace_epoch = 0;
+
+static inline uint64_t
+trace_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static void
+trace_free(void)
+{
+    for (unsigned int i=0; i<trace_workers; i++) free(trace_buffers[i].events);
+    free(trace_buffers);
+    trace_buffers = NULL;
+    trace_workers = 0;
+}
+
+int
+sylvan_trace_enable(unsigned int categories, size_t capacity)
+{
+    if (!SYLVAN_TRACE) return -1;
+
+    sylvan_trace_categories = 0;
+    trace_free();
+    if (capacity == 0 || categories == 0) return 0;
+
+    trace_workers = lace_workers();
+    trace_capacity = capacity;
+    trace_buffers = (trace_buffer_t*)calloc(trace_workers, sizeof(trace_buffer_t));
+    for (unsigned int i=0; i<trace_workers; i++) {
+        trace_buffers[i].events = (trace_entry_t*)malloc(sizeof(trace_entry_t[capacity]));
+        if (trace_buffers[i].events == NULL) {
+            fprintf(stderr, "sylvan_trace_enable: Unable to allocate memory!\n");
+            exit(1);
+        }
+    }
+    trace_epoch = trace_time();
+    sylvan_trace_categories = categories & SYLVAN_TRACE_ALL;
+    return 0;
+}
+
+void
+sylvan_trace_disable(void)
+{
+    sylvan_trace_categories = 0;
+}
+
+void
+sylvan_trace_event(uint32_t type, uint32_t aux, uint64_t arg)
+{
+    WorkerP *w = lace_get_worker();
+    if (w == NULL || trace_buffers == NULL || (unsigned int)w->worker >= trace_workers) return;
+    trace_buffer_t *b = &trace_buffers[w->worker];
+    trace_entry_t *e = &b->events[b->count++ % trace_capacity];
+    e->time = trace_time() - trace_epoch;
+    e->type = type;
+    e->aux = aux;
+    e->arg = arg;
+}
+
+void
+sylvan_trace_begin(const char *name)
+{
+    sylvan_trace(SYLVAN_TRACE_USER, SYLVAN_TRACE_USER_BEGIN, 0, (uint64_t)(size_t)name);
+}
+
+void
+sylvan_trace_end(const char *name)
+{
+    sylvan_trace(SYLVAN_TRACE_USER, SYLVAN_TRACE_USER_END, 0, (uint64_t)(size_t)name);
+}
+
+void
+sylvan_trace_mark(const char *name)
+{
+    sylvan_trace(SYLVAN_TRACE_USER, SYLVAN_TRACE_USER_MARK, 0, (uint64_t)(size_t)name);
+}
+
+/**
+ * Write a JSON string (the names are identifiers, but be safe)
+ */
+static void
+trace_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        if ((unsigned char)*s >= 0x20) fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+size_t
+sylvan_trace_dump(FILE *out)
+{
+    size_t written = 0;
+    fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"sylvan\"}}");
+    for (unsigned int w=0; w<trace_workers; w++) {
+        fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"worker %u\"}}", w, w);
+        trace_buffer_t *b = &trace_buffers[w];
+        uint64_t first = b->count > trace_capacity ? b->count - trace_capacity : 0;
+        for (uint64_t i=first; i<b->count; i++) {
+            const trace_entry_t *e = &b->events[i % trace_capacity];
+            uint64_t ts = e->time;
+            switch (e->type) {
+            case SYLVAN_TRACE_CACHE_HIT:
+            case SYLVAN_TRACE_CACHE_MISS:
+                fprintf(out, ",\n{\"name\": \"%s\", \"cat\": \"cache\", \"ph\": \"i\", \"s\": \"t\"",
+                        e->type == SYLVAN_TRACE_CACHE_HIT ? "cache hit" : "cache miss");
+                fprintf(out, ", \"ts\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"op\": %u}}", ts/1000.0, w, e->aux);
+                break;
+            case SYLVAN_TRACE_TABLE_FULL:
+                fprintf(out, ",\n{\"name\": \"table full\", \"cat\": \"table\", \"ph\": \"i\", \"s\": \"g\"");
+                fprintf(out, ", \"ts\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"size\": %"PRIu64"}}", ts/1000.0, w, e->arg);
+                break;
+            case SYLVAN_TRACE_GC_REQUEST:
+                fprintf(out, ",\n{\"name\": \"gc request\", \"cat\": \"gc\", \"ph\": \"i\", \"s\": \"t\"");
+                fprintf(out, ", \"ts\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"starts_gc\": %u}}", ts/1000.0, w, e->aux);
+                break;
+            case SYLVAN_TRACE_GC_PHASE:
+                // recorded at the end of the phase, with its duration
+                fprintf(out, ",\n{\"name\": \"%s\", \"cat\": \"gc\", \"ph\": \"X\"",
+                        e->aux < SYLVAN_GC_PHASES ? sylvan_gc_phase_name((sylvan_gc_phase_t)e->aux) : "gc");
+                fprintf(out, ", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u}", (ts - e->arg)/1000.0, e->arg/1000.0, w);
+                break;
+            case SYLVAN_TRACE_USER_BEGIN:
+            case SYLVAN_TRACE_USER_END:
+            case SYLVAN_TRACE_USER_MARK:
+                fprintf(out, ",\n{\"name\": ");
+                trace_string(out, (const char*)(size_t)e->arg);
+                if (e->type == SYLVAN_TRACE_USER_MARK) fprintf(out, ", \"cat\": \"user\", \"ph\": \"i\", \"s\": \"t\"");
+                else fprintf(out, ", \"cat\": \"user\", \"ph\": \"%s\"", e->type == SYLVAN_TRACE_USER_BEGIN ? "B" : "E");
+                fprintf(out, ", \"ts\": %.3f, \"pid\": 1, \"tid\": %u}", ts/1000.0, w);
+                break;
+            default:
+                continue;
+            }
+            written++;
+        }
+    }
+    fprintf(out, "\n]}\n");
+    return written;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Do not include this file directly. Instead, include sylvan.h */
+
+#ifndef SYLVAN_TRACE_H
+#define SYLVAN_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Tracing of events in the hot paths of Sylvan, for a timeline of every worker.
+ *
+ * The hooks are compiled in with the CMake option SYLVAN_TRACE. Without it, they are
+ * removed entirely; with it, every hook costs one well-predicted branch while tracing
+ * is off. When tracing is on, every worker records its events with a timestamp in its
+ * own ring buffer, which keeps the last <capacity> events.
+ *
+ * sylvan_trace_dump writes the events in the Chrome trace event format (JSON), which
+ * can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing, with one track per
+ * worker. Turn tracing on and off and dump the trace while no Sylvan operations run.
+ */
+typedef enum sylvan_trace_category {
+    SYLVAN_TRACE_CACHE = 1,     // operation cache hits and misses
+    SYLVAN_TRACE_TABLE = 2,     // nodes table full (no empty bucket in the probe sequence)
+    SYLVAN_TRACE_GC = 4,        // garbage collection requests and phases
+    SYLVAN_TRACE_USER = 8,      // spans and marks from sylvan_trace_begin/end/mark
+    SYLVAN_TRACE_ALL = 15,
+} sylvan_trace_category_t;
+
+/**
+ * Start tracing the given categories (a combination of sylvan_trace_category_t), with
+ * a ring buffer of <capacity> events per worker. This clears the previous trace; with
+ * <categories> or <capacity> 0, it only frees the buffers.
+ * Returns 0, or -1 if Sylvan is built without SYLVAN_TRACE.
+ */
+int sylvan_trace_enable(unsigned int categories, size_t capacity);
+
+/**
+ * Stop tracing. The recorded events are kept until the next sylvan_trace_enable.
+ */
+void sylvan_trace_disable(void);
+
+/**
+ * Write the recorded events to <out> in the Chrome trace event format.
+ * Returns the number of written events.
+ */
+size_t sylvan_trace_dump(FILE *out);
+
+/**
+ * Record the begin and the end of a span, or a single mark, on the current worker.
+ * The name is not copied and must remain valid until the trace is dumped.
+ */
+void sylvan_trace_begin(const char *name);
+void sylvan_trace_end(const char *name);
+void sylvan_trace_mark(const char *name);
+
+/* For internal use */
+typedef enum sylvan_trace_type {
+    SYLVAN_TRACE_CACHE_HIT,     // aux: operation
+    SYLVAN_TRACE_CACHE_MISS,    // aux: operation
+    SYLVAN_TRACE_TABLE_FULL,    // arg: size of the nodes table
+    SYLVAN_TRACE_GC_REQUEST,    // aux: 1 if this worker starts garbage collection
+    SYLVAN_TRACE_GC_PHASE,      // aux: phase (SYLVAN_GC_PHASES for all), arg: duration in ns
+    SYLVAN_TRACE_USER_BEGIN,    // arg: name
+    SYLVAN_TRACE_USER_END,      // arg: name
+    SYLVAN_TRACE_USER_MARK,     // arg: name
+} sylvan_trace_type_t;
+
+extern unsigned int sylvan_trace_categories;
+void sylvan_trace_event(uint32_t type, uint32_t aux, uint64_t arg);
+
+#if SYLVAN_TRACE
+#define sylvan_trace(category, type, aux, arg) do { \
+    if (__builtin_expect(sylvan_trace_categories & (category), 0)) sylvan_trace_event(type, aux, arg); \
+} while (0)
+#else
+#define sylvan_trace(category, type, aux, arg) do { (void)(aux); (void)(arg); } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <sylvan_align.h>
+#include <sylvan_writer.h>
+
+/* Number of bitmap words per block of the rank index (512 buckets) */
+#define WRITER_BLOCK 8
+/* Number of blocks per task when computing the rank index in parallel */
+#define WRITER_BLOCKS_PER_TASK 1024
+/* Number of nodes that are encoded and written at once (16 bytes each, i.e., 8 MB) */
+#define WRITER_CHUNK 524288
+/* Number of nodes per task when encoding in parallel */
+#define WRITER_NODES_PER_TASK 4096
+
+struct sylvan_writer
+{
+    size_t words;               // number of words in the bitmap
+    size_t blocks;              // number of blocks in the rank index
+    _Atomic(uint64_t) *bitmap;  // one bit per bucket of the nodes table
+    uint64_t *rank;             // number of marked nodes before every block
+    uint64_t *numbers;          // number of every marked node, in order of index
+    uint64_t *indices;          // index of every number (indices[0] is unused)
+    uint64_t *ends;             // last number of every level
+    size_t levels;              // number of (non-empty) levels
+    size_t count;               // number of marked nodes
+};
+
+static void*
+writer_alloc(size_t size)
+{
+    void *res = malloc(size > 0 ? size : 1);
+    if (res == NULL) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the writer: %s!\n", size, strerror(errno));
+        exit(1);
+    }
+    return res;
+}
+
+sylvan_writer_t
+sylvan_writer_alloc()
+{
+    sylvan_writer_t w = (sylvan_writer_t)writer_alloc(sizeof(struct sylvan_writer));
+    w->words = (nodes->table_size + 63) / 64;
+    w->blocks = (w->words + WRITER_BLOCK - 1) / WRITER_BLOCK;
+    w->bitmap = (_Atomic(uint64_t)*)alloc_aligned(sizeof(uint64_t) * w->blocks * WRITER_BLOCK);
+    if (w->bitmap == 0) {
+        fprintf(stderr, "sylvan: Unable to allocate memory (%'zu bytes) for the writer!\n", sizeof(uint64_t) * w->blocks * WRITER_BLOCK);
+        exit(1);
+    }
+    w->rank = NULL;
+    w->numbers = NULL;
+    w->indices = NULL;
+    w->ends = NULL;
+    w->levels = 0;
+    w->count = 0;
+    return w;
+}
+
+void
+sylvan_writer_free(sylvan_writer_t w)
+{
+    free_aligned(w->bitmap, sizeof(uint64_t) * w->blocks * WRITER_BLOCK);
+    free(w->rank);
+    free(w->numbers);
+    free(w->indices);
+    free(w->ends);
+    free(w);
+}
+
+int
+sylvan_writer_mark(sylvan_writer_t w, uint64_t index)
+{
+    _Atomic(uint64_t) *word = w->bitmap + index / 64;
+    const uint64_t bit = 1ULL << (index % 64);
+    if (atomic_load_explicit(word, memory_order_relaxed) & bit) return 0;
+    return (atomic_fetch_or(word, bit) & bit) ? 0 : 1;
+}
+
+/**
+ * Count the marked nodes in every block
+ */
+VOID_TASK_3(sylvan_writer_rank_par, sylvan_writer_t, w, size_t, first, size_t, count)
+{
+    if (count > WRITER_BLOCKS_PER_TASK) {
+        SPAWN(sylvan_writer_rank_par, w, first, count/2);
+        CALL(sylvan_writer_rank_par, w, first+count/2, count-count/2);
+        SYNC(sylvan_writer_rank_par);
+        return;
+    }
+
+    for (size_t b=first; b<first+count; b++) {
+        uint64_t r = 0;
+        for (size_t i=0; i<WRITER_BLOCK; i++) {
+            r += __builtin_popcountll(atomic_load_explicit(w->bitmap + b*WRITER_BLOCK + i, memory_order_relaxed));
+        }
+        w->rank[b] = r;
+    }
+}
+
+/**
+ * The level callback with its context
+ */
+typedef struct writer_level {
+    sylvan_writer_level_cb cb;
+    void *ctx;
+} writer_level;
+
+/**
+ * Collect the index and level of every marked node, in order of index
+ */
+VOID_TASK_6(sylvan_writer_collect_par, sylvan_writer_t, w, size_t, first, size_t, count, writer_level*, level, uint64_t*, indices, uint32_t*, levels)
+{
+    if (count > WRITER_BLOCKS_PER_TASK) {
+        SPAWN(sylvan_writer_collect_par, w, first, count/2, level, indices, levels);
+        CALL(sylvan_writer_collect_par, w, first+count/2, count-count/2, level, indices, levels);
+        SYNC(sylvan_writer_collect_par);
+        return;
+    }
+
+    for (size_t b=first; b<first+count; b++) {
+        uint64_t pos = w->rank[b];
+        for (size_t i=0; i<WRITER_BLOCK; i++) {
+            uint64_t word = atomic_load_explicit(w->bitmap + b*WRITER_BLOCK + i, memory_order_relaxed);
+            while (word) {
+                uint64_t index = (b*WRITER_BLOCK + i)*64 + __builtin_ctzll(word);
+                indices[pos] = index;
+                levels[pos] = level->cb(index, level->ctx);
+                pos++;
+                word &= word - 1;
+            }
+        }
+    }
+}
+
+VOID_TASK_IMPL_1(sylvan_writer_index, sylvan_writer_t, w)
+{
+    /* Compute the rank index (prefix sums of the marked nodes per block) */
+    if (w->rank != NULL) return;
+    w->rank = (uint64_t*)writer_alloc(sizeof(uint64_t) * w->blocks);
+    CALL(sylvan_writer_rank_par, w, 0, w->blocks);
+    uint64_t total = 0;
+    for (size_t b=0; b<w->blocks; b++) {
+        uint64_t r = w->rank[b];
+        w->rank[b] = total;
+        total += r;
+    }
+    w->count = total;
+}
+
+VOID_TASK_IMPL_3(sylvan_writer_number, sylvan_writer_t, w, sylvan_writer_level_cb, level_cb, void*, ctx)
+{
+    CALL(sylvan_writer_index, w);
+    const size_t total = w->count;
+
+    /* Obtain the index and level of every marked node */
+    uint64_t *indices = (uint64_t*)writer_alloc(sizeof(uint64_t) * total);
+    uint32_t *levels = (uint32_t*)writer_alloc(sizeof(uint32_t) * total);
+    writer_level level = { level_cb, ctx };
+    CALL(sylvan_writer_collect_par, w, 0, w->blocks, &level, indices, levels);
+
+    /* Counting sort on the level: leaves first, then from the deepest to the top variable */
+    uint32_t maxvar = 0;
+    for (size_t i=0; i<total; i++) {
+        if (levels[i] != (uint32_t)-1 && levels[i] > maxvar) maxvar = levels[i];
+    }
+    uint64_t *start = (uint64_t*)calloc((size_t)maxvar + 2, sizeof(uint64_t));
+    for (size_t i=0; i<total; i++) {
+        start[levels[i] == (uint32_t)-1 ? 0 : maxvar - levels[i] + 1]++;
+    }
+    w->ends = (uint64_t*)writer_alloc(sizeof(uint64_t) * ((size_t)maxvar + 2));
+    w->levels = 0;
+    uint64_t next = 1;
+    for (size_t k=0; k<(size_t)maxvar+2; k++) {
+        uint64_t c = start[k];
+        start[k] = next;
+        next += c;
+        if (c != 0) w->ends[w->levels++] = next - 1;
+    }
+
+    w->numbers = (uint64_t*)writer_alloc(sizeof(uint64_t) * total);
+    w->indices = (uint64_t*)writer_alloc(sizeof(uint64_t) * (total + 1));
+    w->indices[0] = 0;
+    for (size_t i=0; i<total; i++) {
+        uint64_t number = start[levels[i] == (uint32_t)-1 ? 0 : maxvar - levels[i] + 1]++;
+        w->numbers[i] = number;
+        w->indices[number] = indices[i];
+    }
+
+    free(start);
+    free(levels);
+    free(indices);
+}
+
+size_t
+sylvan_writer_count(sylvan_writer_t w)
+{
+    return w->count;
+}
+
+size_t
+sylvan_writer_level_count(sylvan_writer_t w)
+{
+    return w->levels;
+}
+
+uint64_t
+sylvan_writer_level_end(sylvan_writer_t w, size_t level)
+{
+    return w->ends[level];
+}
+
+uint64_t
+sylvan_writer_position(sylvan_writer_t w, uint64_t index)
+{
+    const size_t word = index / 64;
+    const size_t b = word / WRITER_BLOCK;
+    uint64_t r = w->rank[b];
+    for (size_t i=b*WRITER_BLOCK; i<word; i++) {
+        r += __builtin_popcountll(atomic_load_explicit(w->bitmap + i, memory_order_relaxed));
+    }
+    const uint64_t mask = (1ULL << (index % 64)) - 1;
+    r += __builtin_popcountll(atomic_load_explicit(w->bitmap + word, memory_order_relaxed) & mask);
+    return r;
+}
+
+uint64_t
+sylvan_writer_get(sylvan_writer_t w, uint64_t index)
+{
+    return w->numbers[sylvan_writer_position(w, index)];
+}
+
+uint64_t
+sylvan_writer_getr(sylvan_writer_t w, uint64_t number)
+{
+    return w->indices[number];
+}
+
+VOID_TASK_5(sylvan_writer_encode_par, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf, sylvan_writer_encode_cb, encode_cb)
+{
+    if (count > WRITER_NODES_PER_TASK) {
+        SPAWN(sylvan_writer_encode_par, w, first, count/2, buf, encode_cb);
+        CALL(sylvan_writer_encode_par, w, first+count/2, count-count/2, buf+16*(count/2), encode_cb);
+        SYNC(sylvan_writer_encode_par);
+    } else {
+        WRAP(encode_cb, w, first, count, buf);
+    }
+}
+
+VOID_TASK_IMPL_5(sylvan_writer_write, sylvan_writer_t, w, FILE*, out, uint64_t, first, uint64_t, last, sylvan_writer_encode_cb, encode_cb)
+{
+    if (first > last) return;
+    uint8_t *buf = (uint8_t*)writer_alloc(16 * WRITER_CHUNK);
+    while (first <= last) {
+        size_t count = last - first + 1;
+        if (count > WRITER_CHUNK) count = WRITER_CHUNK;
+        CALL(sylvan_writer_encode_par, w, first, count, buf, encode_cb);
+        fwrite(buf, 16, count, out);
+        first += count;
+    }
+    free(buf);
+}
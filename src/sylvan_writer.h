@@ -0,0 +1,122 @@
+/*
+ * Copyright 2011-2016 Formal Methods and Tools, University of Twente
+ * Copyright 2016-2017 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYLVAN_WRITER_H
+#define SYLVAN_WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Parallel numbering of nodes for the binary writers in Sylvan.
+ *
+ * Nodes are marked in a bitmap with one bit per bucket of the nodes table, which
+ * can be done concurrently by all workers. Afterwards, the marked nodes are numbered
+ * starting with 1, ordered by level: first all leaves, then the nodes of the
+ * deepest variable, up to the nodes of the top variable. Then every node has a
+ * higher number than its children, so the result can be read in one pass.
+ *
+ * Compared to the skiplist, this uses 1 bit per bucket of the nodes table plus
+ * 16 bytes per marked node, and has no limit on the number of nodes.
+ */
+typedef struct sylvan_writer *sylvan_writer_t;
+
+/**
+ * The level of a node for the numbering: its variable, or (uint32_t)-1 for a leaf.
+ * Every node must have a lower level than its children (except leaves).
+ */
+typedef uint32_t (*sylvan_writer_level_cb)(uint64_t index, void *ctx);
+
+/**
+ * Allocate a writer for the current nodes table.
+ */
+sylvan_writer_t sylvan_writer_alloc(void);
+
+/**
+ * Free the given writer.
+ */
+void sylvan_writer_free(sylvan_writer_t w);
+
+/**
+ * Mark the node with the given index.
+ * Returns 1 if the node was not yet marked, 0 otherwise. Thread-safe.
+ */
+int sylvan_writer_mark(sylvan_writer_t w, uint64_t index);
+
+/**
+ * Count the marked nodes. Call this after marking and before sylvan_writer_count and
+ * sylvan_writer_position. This is done by sylvan_writer_number if it was not done before.
+ */
+VOID_TASK_DECL_1(sylvan_writer_index, sylvan_writer_t);
+#define sylvan_writer_index(w) RUN(sylvan_writer_index, w)
+
+/**
+ * Number all marked nodes. Call this after marking and before sylvan_writer_get.
+ * The <ctx> is passed to <level_cb>.
+ */
+VOID_TASK_DECL_3(sylvan_writer_number, sylvan_writer_t, sylvan_writer_level_cb, void*);
+#define sylvan_writer_number(w, level_cb, ctx) RUN(sylvan_writer_number, w, level_cb, ctx)
+
+/**
+ * Get the number of marked nodes.
+ */
+size_t sylvan_writer_count(sylvan_writer_t w);
+
+/**
+ * Get the position (0,...,count-1) of the marked node with the given index among all
+ * marked nodes, in order of index. Unlike the number, this is available after
+ * sylvan_writer_index, so it can be used to store data per node in the level callback.
+ */
+uint64_t sylvan_writer_position(sylvan_writer_t w, uint64_t index);
+
+/**
+ * Get the number of levels, i.e., the number of distinct values of the level callback,
+ * and the last number of the given level (0,...,levels-1).
+ * The nodes of level k have numbers end(k-1)+1,...,end(k), with end(-1) = 0.
+ */
+size_t sylvan_writer_level_count(sylvan_writer_t w);
+uint64_t sylvan_writer_level_end(sylvan_writer_t w, size_t level);
+
+/**
+ * Get the number (1,...,count) of the marked node with the given index.
+ */
+uint64_t sylvan_writer_get(sylvan_writer_t w, uint64_t index);
+
+/**
+ * Get the index of the node with the given number (1,...,count).
+ */
+uint64_t sylvan_writer_getr(sylvan_writer_t w, uint64_t number);
+
+/**
+ * Callback for sylvan_writer_write: encode the nodes with numbers <first>...<first+count-1>
+ * as 16 bytes each to <buf>.
+ */
+LACE_TYPEDEF_CB(void, sylvan_writer_encode_cb, sylvan_writer_t, uint64_t, size_t, uint8_t*);
+
+/**
+ * Write the nodes with numbers <first>...<last> (16 bytes each) to <out>.
+ * The nodes are encoded in parallel in large chunks, which are then written with fwrite.
+ */
+VOID_TASK_DECL_5(sylvan_writer_write, sylvan_writer_t, FILE*, uint64_t, uint64_t, sylvan_writer_encode_cb);
+#define sylvan_writer_write(w, out, first, last, encode_cb) RUN(sylvan_writer_write, w, out, first, last, encode_cb)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -30,6 +30,8 @@
 
 #include <sylvan_refs.h>
 #include <sylvan_sl.h>
+#include <sylvan_writer.h>
+#include <sylvan_packed.h>
 
 /**
  * Basic ZDD node manipulation
@@ -110,24 +112,31 @@ zdd_getdouble(ZDD leaf)
  */
 
 /**
- * During garbage collection, recursively mark ZDD nodes in the nodes table to keep.
+ * Mark the node of <zdd> in the nodes table and obtain its children for the marking engine.
  */
-VOID_TASK_IMPL_1(zdd_gc_mark_rec, ZDD, zdd)
+static int
+zdd_gc_mark_visit(uint64_t zdd, uint64_t *children)
 {
-    if (zdd == zdd_true) return;
-    if (zdd == zdd_false) return;
+    if (zdd == zdd_true) return 0;
+    if (zdd == zdd_false) return 0;
 
     // Mark, and if returns 0, we are done
-    if (llmsset_mark(nodes, ZDD_GETINDEX(zdd)) != 0) {
-        // The node was not yet marked, so go recursive if not a leaf
-        zddnode_t n = ZDD_GETNODE(zdd);
-        if (!zddnode_isleaf(n)) {
-            // Recursively mark low and high
-            SPAWN(zdd_gc_mark_rec, zddnode_getlow(n));
-            CALL(zdd_gc_mark_rec, zddnode_gethigh(n));
-            SYNC(zdd_gc_mark_rec);
-        }
-    }
+    if (llmsset_mark(nodes, ZDD_GETINDEX(zdd)) == 0) return 0;
+
+    // The node was not yet marked, so mark its children if not a leaf
+    zddnode_t n = ZDD_GETNODE(zdd);
+    if (zddnode_isleaf(n)) return 0;
+    children[0] = zddnode_getlow(n);
+    children[1] = zddnode_gethigh(n);
+    return 2;
+}
+
+/**
+ * During garbage collection, recursively mark ZDD nodes in the nodes table to keep.
+ */
+VOID_TASK_IMPL_1(zdd_gc_mark_rec, ZDD, zdd)
+{
+    sylvan_gc_mark_dd(zdd_gc_mark_visit, zdd);
 }
 
 /**
@@ -160,6 +169,24 @@ zdd_count_protected()
     return protect_count(&zdd_protected);
 }
 
+uint64_t *
+zdd_handle_get(ZDD *ptr)
+{
+    return handles_get((uint64_t)(size_t)ptr | HANDLES_ZDD);
+}
+
+void
+zdd_handle_put(uint64_t *handle)
+{
+    handles_put(handle);
+}
+
+size_t
+zdd_count_handles(void)
+{
+    return handles_count(HANDLES_ZDD);
+}
+
 /**
  * Mark all external references (during garbage collection)
  */
@@ -178,179 +205,86 @@ VOID_TASK_0(zdd_gc_mark_protected)
     }
 }
 
-/**
- * Internal references (spawn/sync, push/pop)
- */
-typedef struct zdd_refs_task
+VOID_TASK_1(zdd_gc_mark_handles_chunk, handles_chunk_t*, chunk)
 {
-    Task *t;
-    void *f;
-} *zdd_refs_task_t;
-
-typedef struct zdd_refs_internal
-{
-    ZDD **pbegin, **pend, **pcur;
-    ZDD *rbegin, *rend, *rcur;
-    zdd_refs_task_t sbegin, send, scur;
-} *zdd_refs_internal_t;
-
-DECLARE_THREAD_LOCAL(zdd_refs_key, zdd_refs_internal_t);
-
-VOID_TASK_2(zdd_refs_mark_p_par, ZDD**, begin, size_t, count)
-{
-    if (count < 32) {
-        while (count) {
-            zdd_gc_mark_rec(**(begin++));
-            count--;
-        }
-    } else {
-        SPAWN(zdd_refs_mark_p_par, begin, count / 2);
-        CALL(zdd_refs_mark_p_par, begin + (count / 2), count - count / 2);
-        SYNC(zdd_refs_mark_p_par);
+    size_t count=0;
+    for (int i=0; i<HANDLES_CHUNK_SIZE; i++) {
+        uint64_t h = chunk->slots[i];
+        if (HANDLES_TYPE(h) != HANDLES_ZDD) continue;
+        SPAWN(zdd_gc_mark_rec, *(ZDD*)(size_t)(h & ~(uint64_t)7));
+        count++;
     }
-}
-
-VOID_TASK_2(zdd_refs_mark_r_par, ZDD*, begin, size_t, count)
-{
-    if (count < 32) {
-        while (count) {
-            zdd_gc_mark_rec(*begin++);
-            count--;
-        }
-    } else {
-        SPAWN(zdd_refs_mark_r_par, begin, count / 2);
-        CALL(zdd_refs_mark_r_par, begin + (count / 2), count - count / 2);
-        SYNC(zdd_refs_mark_r_par);
+    while (count--) {
+        SYNC(zdd_gc_mark_rec);
     }
 }
 
-VOID_TASK_2(zdd_refs_mark_s_par, zdd_refs_task_t, begin, size_t, count)
+/**
+ * Mark the variables protected by handles (during garbage collection)
+ */
+VOID_TASK_0(zdd_gc_mark_handles)
 {
-    if (count < 32) {
-        while (count) {
-            Task *t = begin->t;
-            if (!TASK_IS_STOLEN(t)) return;
-            if (t->f == begin->f && TASK_IS_COMPLETED(t)) {
-                zdd_gc_mark_rec(*(BDD*)TASK_RESULT(t));
-            }
-            begin += 1;
-            count -= 1;
-        }
-    } else {
-        if (!TASK_IS_STOLEN(begin->t)) return;
-        SPAWN(zdd_refs_mark_s_par, begin, count / 2);
-        CALL(zdd_refs_mark_s_par, begin + (count / 2), count - count / 2);
-        SYNC(zdd_refs_mark_s_par);
+    // mark the handles of every chunk in parallel
+    size_t count=0;
+    for (handles_chunk_t *chunk = handles_chunks(); chunk != NULL; chunk = chunk->next) {
+        SPAWN(zdd_gc_mark_handles_chunk, chunk);
+        count++;
+    }
+    while (count--) {
+        SYNC(zdd_gc_mark_handles_chunk);
     }
 }
 
-VOID_TASK_0(zdd_refs_mark_task)
-{
-    LOCALIZE_THREAD_LOCAL(zdd_refs_key, zdd_refs_internal_t);
-    SPAWN(zdd_refs_mark_p_par, zdd_refs_key->pbegin, zdd_refs_key->pcur-zdd_refs_key->pbegin);
-    SPAWN(zdd_refs_mark_r_par, zdd_refs_key->rbegin, zdd_refs_key->rcur-zdd_refs_key->rbegin);
-    CALL(zdd_refs_mark_s_par, zdd_refs_key->sbegin, zdd_refs_key->scur-zdd_refs_key->sbegin);
-    SYNC(zdd_refs_mark_r_par);
-    SYNC(zdd_refs_mark_p_par);
-}
-
+/**
+ * Internal references (spawn/sync, push/pop), see sylvan_refs.h
+ */
 VOID_TASK_0(zdd_refs_mark)
 {
-    TOGETHER(zdd_refs_mark_task);
-}
-
-VOID_TASK_0(zdd_refs_init_task)
-{
-    zdd_refs_internal_t s = (zdd_refs_internal_t)malloc(sizeof(struct zdd_refs_internal));
-    s->pcur = s->pbegin = (ZDD**)malloc(sizeof(ZDD*) * 1024);
-    s->pend = s->pbegin + 1024;
-    s->rcur = s->rbegin = (ZDD*)malloc(sizeof(ZDD) * 1024);
-    s->rend = s->rbegin + 1024;
-    s->scur = s->sbegin = (zdd_refs_task_t)malloc(sizeof(struct zdd_refs_task) * 1024);
-    s->send = s->sbegin + 1024;
-    SET_THREAD_LOCAL(zdd_refs_key, s);
+    refs_mark(REFS_ZDD, TASK(zdd_gc_mark_rec));
 }
 
-VOID_TASK_0(zdd_refs_init)
+static void
+zdd_refs_init(void)
 {
-    INIT_THREAD_LOCAL(zdd_refs_key);
-    TOGETHER(zdd_refs_init_task);
+    refs_init(REFS_ZDD);
+    sylvan_gc_add_mark_named(TASK(zdd_refs_mark), "zdd_refs_mark");
 }
 
 void
-zdd_refs_ptrs_up(zdd_refs_internal_t zdd_refs_key)
-{
-    size_t size = zdd_refs_key->pend - zdd_refs_key->pbegin;
-    zdd_refs_key->pbegin = (ZDD**)realloc(zdd_refs_key->pbegin, sizeof(ZDD*) * size*2);
-    zdd_refs_key->pcur = zdd_refs_key->pbegin + size;
-    zdd_refs_key->pend = zdd_refs_key->pend + size * 2;
-}
-
-ZDD __attribute__((noinline))
-zdd_refs_refs_up(zdd_refs_internal_t zdd_refs_key, ZDD res)
-{
-    long size = zdd_refs_key->rend - zdd_refs_key->rbegin;
-    zdd_refs_key->rbegin = (ZDD*)realloc(zdd_refs_key->rbegin, sizeof(ZDD) * size * 2);
-    zdd_refs_key->rcur = zdd_refs_key->rbegin + size;
-    zdd_refs_key->rend = zdd_refs_key->rbegin + (size * 2);
-    return res;
-}
-
-void __attribute__((noinline))
-zdd_refs_tasks_up(zdd_refs_internal_t zdd_refs_key)
-{
-    long size = zdd_refs_key->send - zdd_refs_key->sbegin;
-    zdd_refs_key->sbegin = (zdd_refs_task_t)realloc(zdd_refs_key->sbegin, sizeof(struct zdd_refs_task) * size * 2);
-    zdd_refs_key->scur = zdd_refs_key->sbegin + size;
-    zdd_refs_key->send = zdd_refs_key->sbegin + (size * 2);
-}
-
-void __attribute__((unused))
 zdd_refs_pushptr(ZDD *ptr)
 {
-    LOCALIZE_THREAD_LOCAL(zdd_refs_key, zdd_refs_internal_t);
-    *zdd_refs_key->pcur++ = ptr;
-    if (zdd_refs_key->pcur == zdd_refs_key->pend) zdd_refs_ptrs_up(zdd_refs_key);
+    refs_stack_push(refs_stack(REFS_ZDD, REFS_PTRS), (uint64_t)(size_t)ptr);
 }
 
-void __attribute__((unused))
+void
 zdd_refs_popptr(size_t amount)
 {
-    LOCALIZE_THREAD_LOCAL(zdd_refs_key, zdd_refs_internal_t);
-    zdd_refs_key->pcur -= amount;
+    refs_stack_pop(refs_stack(REFS_ZDD, REFS_PTRS), amount);
 }
 
-ZDD __attribute__((unused))
-zdd_refs_push(ZDD zdd)
+ZDD
+zdd_refs_push(ZDD dd)
 {
-    LOCALIZE_THREAD_LOCAL(zdd_refs_key, zdd_refs_internal_t);
-    *(zdd_refs_key->rcur++) = zdd;
-    if (zdd_refs_key->rcur == zdd_refs_key->rend) return zdd_refs_refs_up(zdd_refs_key, zdd);
-    else return zdd;
+    refs_stack_push(refs_stack(REFS_ZDD, REFS_VALUES), dd);
+    return dd;
 }
 
-void __attribute__((unused))
+void
 zdd_refs_pop(long amount)
 {
-    LOCALIZE_THREAD_LOCAL(zdd_refs_key, zdd_refs_internal_t);
-    zdd_refs_key->rcur -= amount;
+    refs_stack_pop(refs_stack(REFS_ZDD, REFS_VALUES), amount);
 }
 
-void __attribute__((unused))
+void
 zdd_refs_spawn(Task *t)
 {
-    LOCALIZE_THREAD_LOCAL(zdd_refs_key, zdd_refs_internal_t);
-    zdd_refs_key->scur->t = t;
-    zdd_refs_key->scur->f = t->f;
-    zdd_refs_key->scur += 1;
-    if (zdd_refs_key->scur == zdd_refs_key->send) zdd_refs_tasks_up(zdd_refs_key);
+    refs_stack_push2(refs_stack(REFS_ZDD, REFS_TASKS), (uint64_t)(size_t)t, (uint64_t)(size_t)t->f);
 }
 
-ZDD __attribute__((unused))
+ZDD
 zdd_refs_sync(ZDD result)
 {
-    LOCALIZE_THREAD_LOCAL(zdd_refs_key, zdd_refs_internal_t);
-    zdd_refs_key->scur -= 1;
+    refs_stack_pop(refs_stack(REFS_ZDD, REFS_TASKS), 2);
     return result;
 }
 
@@ -380,20 +314,38 @@ sylvan_init_zdd()
     zdd_initialized = 1;
 
     sylvan_register_quit(zdd_quit);
-    sylvan_gc_add_mark(TASK(zdd_gc_mark_protected));
-    sylvan_gc_add_mark(TASK(zdd_refs_mark));
+    sylvan_gc_add_mark_named(TASK(zdd_gc_mark_protected), "zdd_gc_mark_protected");
+    sylvan_gc_add_mark_named(TASK(zdd_gc_mark_handles), "zdd_gc_mark_handles");
 
     if (!zdd_protected_created) {
         protect_create(&zdd_protected, 4096);
         zdd_protected_created = 1;
     }
 
-    RUN(zdd_refs_init);
+    zdd_refs_init();
 }
 
 /**
  * Basic ZDD node creation functionality
  */
+
+/**
+ * Find or create the leaf node of a type with a custom hash, which holds the canonical value
+ * from the leaf store of the type. Returns 0 if the leaf store or the nodes table is full.
+ */
+static uint64_t
+zdd_lookup_custom(uint16_t type, uint64_t value, int *created)
+{
+    uint64_t slot = sylvan_mt_store_find(type, &value);
+    if (slot == 0) return 0;
+
+    struct zddnode n;
+    zddnode_makeleaf(&n, type, value);
+    uint64_t index = llmsset_lookup(nodes, n.a, n.b, created);
+    if (index != 0) sylvan_mt_store_set_node(type, slot, SYLVAN_MT_STORE_ZDD, index);
+    return index;
+}
+
 ZDD
 zdd_makeleaf(uint16_t type, uint64_t value)
 {
@@ -403,11 +355,11 @@ zdd_makeleaf(uint16_t type, uint64_t value)
     int custom = sylvan_mt_has_custom_hash(type);
 
     int created;
-    uint64_t index = custom ? llmsset_lookupc(nodes, n.a, n.b, &created) : llmsset_lookup(nodes, n.a, n.b, &created);
+    uint64_t index = custom ? zdd_lookup_custom(type, value, &created) : llmsset_lookup(nodes, n.a, n.b, &created);
     if (index == 0) {
         RUN(sylvan_gc);
 
-        index = custom ? llmsset_lookupc(nodes, n.a, n.b, &created) : llmsset_lookup(nodes, n.a, n.b, &created);
+        index = custom ? zdd_lookup_custom(type, value, &created) : llmsset_lookup(nodes, n.a, n.b, &created);
         if (index == 0) {
             fprintf(stderr, "BDD Unique table full, %zu of %zu buckets filled!\n", llmsset_count_marked(nodes), llmsset_get_size(nodes));
             exit(1);
@@ -1968,24 +1920,111 @@ zdd_writer_end(sylvan_skiplist_t sl)
     sylvan_skiplist_free(sl);
 }
 
-VOID_TASK_IMPL_3(zdd_writer_tobinary, FILE *, out, ZDD *, dds, int, count)
+/**
+ * Writing ZDD files in binary format using the parallel writer
+ */
+
+static uint32_t
+zdd_writer_level(uint64_t index, void *ctx)
 {
-    sylvan_skiplist_t sl = zdd_writer_start();
+    (void)ctx;
+    zddnode_t n = (zddnode_t)llmsset_index_to_ptr(nodes, index);
+    return zddnode_isleaf(n) ? (uint32_t)-1 : zddnode_getvariable(n);
+}
 
-    for (int i=0; i<count; i++) {
-        CALL(zdd_writer_add, sl, dds[i]);
+VOID_TASK_2(zdd_writer_mark, ZDD, dd, sylvan_writer_t, w)
+{
+    const uint64_t index = ZDD_GETINDEX(dd);
+    if (index <= 1 || !sylvan_writer_mark(w, index)) return;
+    zddnode_t n = ZDD_GETNODE(index);
+    if (zddnode_isleaf(n)) return;
+    SPAWN(zdd_writer_mark, zddnode_getlow(n), w);
+    CALL(zdd_writer_mark, zddnode_gethigh(n), w);
+    SYNC(zdd_writer_mark);
+}
+
+VOID_TASK_4(zdd_writer_encode, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    for (size_t i=0; i<count; i++) {
+        zddnode_t n = ZDD_GETNODE(sylvan_writer_getr(w, first+i));
+        if (zddnode_isleaf(n)) {
+            memcpy(buf + 16*i, n, sizeof(struct zddnode));
+            continue;
+        }
+        ZDD low = zddnode_getlow(n);
+        ZDD high = zddnode_gethigh(n);
+        if (ZDD_GETINDEX(low) > 1) low = ZDD_SETINDEX(low, sylvan_writer_get(w, ZDD_GETINDEX(low)));
+        if (ZDD_GETINDEX(high) > 1) high = ZDD_SETINDEX(high, sylvan_writer_get(w, ZDD_GETINDEX(high)));
+        zddnode_makenode((zddnode_t)(buf + 16*i), zddnode_getvariable(n), low, high);
     }
+}
 
-    zdd_writer_writebinary(out, sl);
+/**
+ * Encode the reference <dd> from node <number> for the packed format.
+ * The indices 0 and 1 are terminals, so node <n> is stored as <n>+1.
+ */
+static inline uint64_t
+zdd_writer_packed_ref(sylvan_writer_t w, uint64_t number, ZDD dd)
+{
+    uint64_t ref = ZDD_GETINDEX(dd);
+    if (ref > 1) ref = sylvan_writer_get(w, ref) + 1;
+    return (sylvan_packed_ref(number + 1, ref, 2) << 1) | (ZDD_HASMARK(dd) ? 1 : 0);
+}
+
+/**
+ * Encode nodes for the packed format: a leaf as (type << 2 | 2) and its value,
+ * an internal node as (var << 2 | map) and the relative low and high edges,
+ * with the complement mark in the lowest bit of each edge.
+ */
+TASK_4(size_t, zdd_writer_encode_packed, sylvan_writer_t, w, uint64_t, first, size_t, count, uint8_t*, buf)
+{
+    uint8_t *ptr = buf;
+    for (size_t i=0; i<count; i++) {
+        const uint64_t number = first+i;
+        zddnode_t n = ZDD_GETNODE(sylvan_writer_getr(w, number));
+        if (zddnode_isleaf(n)) {
+            ptr += sylvan_packed_encode(ptr, ((uint64_t)zddnode_gettype(n) << 2) | 2);
+            ptr += sylvan_packed_encode(ptr, zddnode_getvalue(n));
+        } else {
+            ptr += sylvan_packed_encode(ptr, ((uint64_t)zddnode_getvariable(n) << 2) | (zddnode_ismapnode(n) ? 1 : 0));
+            ptr += sylvan_packed_encode(ptr, zdd_writer_packed_ref(w, number, zddnode_getlow(n)));
+            ptr += sylvan_packed_encode(ptr, zdd_writer_packed_ref(w, number, zddnode_gethigh(n)));
+        }
+    }
+    return ptr - buf;
+}
+
+VOID_TASK_IMPL_3(zdd_writer_tobinary, FILE *, out, ZDD *, dds, int, count)
+{
+    sylvan_writer_t w = sylvan_writer_alloc();
+
+    /* Mark all nodes in parallel, then number them by level */
+    for (int i=0; i<count; i++) SPAWN(zdd_writer_mark, dds[i], w);
+    for (int i=0; i<count; i++) SYNC(zdd_writer_mark);
+    CALL(sylvan_writer_number, w, zdd_writer_level, NULL);
+
+    /* Encode and write all nodes in parallel chunks */
+    size_t nodecount = sylvan_writer_count(w);
+    sylvan_binary_format format = sylvan_get_binary_format();
+    if (format != SYLVAN_BINARY_RAW) {
+        sylvan_packed_out_t p = sylvan_packed_out_open(out, format == SYLVAN_BINARY_PACKED_ZLIB);
+        sylvan_packed_put(p, nodecount);
+        CALL(sylvan_packed_write_nodes, p, w, 1, nodecount, 3*SYLVAN_PACKED_MAX_VARINT, TASK(zdd_writer_encode_packed));
+        sylvan_packed_out_close(p);
+    } else {
+        fwrite(&nodecount, sizeof(size_t), 1, out);
+        CALL(sylvan_writer_write, w, out, 1, nodecount, TASK(zdd_writer_encode));
+    }
 
     fwrite(&count, sizeof(int), 1, out);
 
     for (int i=0; i<count; i++) {
-        uint64_t v = zdd_writer_get(sl, dds[i]);
+        uint64_t v = dds[i];
+        if (ZDD_GETINDEX(v) > 1) v = ZDD_SETINDEX(v, sylvan_writer_get(w, ZDD_GETINDEX(v)));
         fwrite(&v, sizeof(uint64_t), 1, out);
     }
 
-    zdd_writer_end(sl);
+    sylvan_writer_free(w);
 }
 
 void
@@ -2029,6 +2068,51 @@ VOID_TASK_IMPL_3(zdd_writer_totext, FILE *, out, ZDD *, dds, int, count)
     zdd_writer_end(sl);
 }
 
+/**
+ * Read the nodes of a file in the packed format, after the magic bytes
+ */
+static uint64_t*
+zdd_reader_readpacked(FILE *in)
+{
+    sylvan_packed_in_t p = sylvan_packed_in_open(in);
+    if (p == NULL) return NULL;
+
+    uint64_t nodecount;
+    if (sylvan_packed_get(p, &nodecount) != 0 || nodecount > ((uint64_t)1 << 40)) {
+        sylvan_packed_in_close(p);
+        return NULL;
+    }
+
+    /* node <n> is stored as <n>+1, the references 0 and 1 are the terminals */
+    uint64_t *arr = malloc(sizeof(uint64_t)*(nodecount+1));
+    arr[0] = 0;
+    uint64_t i = 1;
+    for (; i<=nodecount; i++) {
+        uint64_t header, a, b;
+        if (sylvan_packed_get(p, &header) != 0 || sylvan_packed_get(p, &a) != 0) break;
+        if ((header & 3) == 2) {
+            arr[i] = zdd_makeleaf((uint16_t)(header >> 2), a);
+            continue;
+        }
+        if (sylvan_packed_get(p, &b) != 0) break;
+        uint64_t l = sylvan_packed_deref(i + 1, a >> 1, 2);
+        uint64_t h = sylvan_packed_deref(i + 1, b >> 1, 2);
+        if (l == (uint64_t)-1 || h == (uint64_t)-1) break;
+        ZDD low = l > 1 ? arr[l - 1] : l;
+        ZDD high = h > 1 ? arr[h - 1] : h;
+        if (a & 1) low = ZDD_TOGGLEMARK(low);
+        if (b & 1) high = ZDD_TOGGLEMARK(high);
+        if (header & 1) arr[i] = zdd_makemapnode((uint32_t)(header >> 2), low, high);
+        else arr[i] = zdd_makenode((uint32_t)(header >> 2), low, high);
+    }
+
+    if (sylvan_packed_in_close(p) != 0 || i <= nodecount) {
+        free(arr);
+        return NULL;
+    }
+    return arr;
+}
+
 /**
  * Reading a file earlier written with zdd_writer_writebinary
  * Returns an array with the conversion from stored identifier to ZDD
@@ -2042,6 +2126,8 @@ TASK_IMPL_1(uint64_t*, zdd_reader_readbinary, FILE*, in)
         return NULL;
     }
 
+    if (sylvan_packed_is_magic(nodecount)) return zdd_reader_readpacked(in);
+
     uint64_t *arr = malloc(sizeof(uint64_t)*(nodecount+1));
     arr[0] = 0;
     for (size_t i=1; i<=nodecount; i++) {
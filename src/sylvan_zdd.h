@@ -81,6 +81,16 @@ zdd_makenode(uint32_t var, ZDD low, ZDD high)
     else return _zdd_makenode(var, low, high);
 }
 
+/**
+ * Create a ZDD leaf of type <type>, holding value <value>.
+ */
+ZDD zdd_makeleaf(uint16_t type, uint64_t value);
+
+/**
+ * Create a "map" node of variable <var>, as used by ZDD maps.
+ */
+ZDD zdd_makemapnode(uint32_t var, ZDD low, ZDD high);
+
 /**
  * Returns 1 is the ZDD is a leaf, or 0 otherwise.
  */
@@ -519,7 +529,10 @@ VOID_TASK_DECL_4(zdd_visit_par, ZDD, zdd_visit_pre_cb, zdd_visit_post_cb, void*)
  * Every node that is to be written is assigned a number, starting from 1,
  * such that reading the result in the future can be done in one pass.
  *
- * We use a skiplist to store the assignment.
+ * The binary writer zdd_writer_tobinary marks the nodes in parallel and numbers
+ * them by level (leaves first, then from the deepest variable to the top variable);
+ * the nodes are then encoded in parallel and written in large chunks.
+ * The other functions use a skiplist to store the assignment.
  *
  * One could use the following two methods to store an array of ZDDs.
  * - call zdd_writer_tobinary to store ZDDs in binary format.
@@ -648,6 +661,20 @@ void zdd_protect(ZDD* ptr);
 void zdd_unprotect(ZDD* ptr);
 size_t zdd_count_protected(void);
 
+/**
+ * Handles are a cheaper alternative to the pointers table for short-lived variables,
+ * such as the C++ Zdd objects. See mtbdd_handle_get.
+ * zdd_handle_get takes a handle that protects the variable at <ptr> (which must be 8-byte aligned),
+ * zdd_handle_set lets it protect the variable at <ptr> instead, and zdd_handle_put returns it.
+ */
+uint64_t *zdd_handle_get(ZDD* ptr);
+static inline void zdd_handle_set(uint64_t *handle, ZDD* ptr)
+{
+    *handle = (uint64_t)(size_t)ptr | HANDLES_ZDD;
+}
+void zdd_handle_put(uint64_t *handle);
+size_t zdd_count_handles(void);
+
 /**
  * If sylvan_set_ondead is set to a callback, then this function marks ZDDs (terminals).
  * When they are dead after the mark phase in garbage collection, the callback is called for marked ZDDs.
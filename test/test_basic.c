@@ -152,6 +152,20 @@ make_random_ldd_set(int depth, int maxvalue, int elements)
     return result;
 }
 
+static MTBDD
+make_random_mtbdd(int i, int j)
+{
+    if (i == j) return mtbdd_int64(rng(0, 4));
+
+    MTBDD low = make_random_mtbdd(i+1, j);
+    mtbdd_refs_push(low);
+    MTBDD high = make_random_mtbdd(i+1, j);
+    mtbdd_refs_push(high);
+    MTBDD result = rng(0, 3) ? mtbdd_makenode(i, low, high) : low;
+    mtbdd_refs_pop(2);
+    return result;
+}
+
 int testEqual(BDD a, BDD b)
 {
     if (a == b) return 1;
@@ -413,6 +427,636 @@ test_compose()
     return 0;
 }
 
+int
+test_nary()
+{
+    BDD ops[20];
+    for (int i=0; i<20; i++) {
+        ops[i] = make_random(rng(0, 8), 16);
+        if (rng(0, 4) == 0) ops[i] = sylvan_not(ops[i]);
+    }
+
+    BDDSET vars = sylvan_set_empty();
+    for (int i=15; i>=0; i--) {
+        if (rng(0, 2)) vars = sylvan_set_add(vars, i);
+    }
+    sylvan_protect(&vars);
+
+    for (int n=0; n<=20; n++) {
+        BDD conj = sylvan_true, disj = sylvan_false;
+        for (int i=0; i<n; i++) {
+            conj = sylvan_and(conj, ops[i]);
+            disj = sylvan_or(disj, ops[i]);
+        }
+        test_assert(testEqual(sylvan_and_n(ops, n), conj));
+        test_assert(testEqual(sylvan_or_n(ops, n), disj));
+        test_assert(testEqual(sylvan_and_exists_n(ops, n, vars), sylvan_exists(conj, vars)));
+    }
+
+    // duplicate and complementary operands
+    BDD dup[4] = {ops[0], ops[1], ops[0], ops[2]};
+    test_assert(testEqual(sylvan_and_n(dup, 4), sylvan_and(ops[0], sylvan_and(ops[1], ops[2]))));
+    dup[2] = sylvan_not(ops[0]);
+    test_assert(sylvan_and_n(dup, 4) == sylvan_false);
+    test_assert(sylvan_or_n(dup, 4) == sylvan_true);
+
+    // more operands than sylvan_or_n negates on the stack
+    BDD many[100];
+    BDD disj = sylvan_false;
+    for (int i=0; i<100; i++) {
+        many[i] = ops[i % 20];
+        disj = sylvan_or(disj, many[i]);
+    }
+    test_assert(testEqual(sylvan_or_n(many, 100), disj));
+
+    for (int i=0; i<20; i++) sylvan_deref(ops[i]);
+    sylvan_unprotect(&vars);
+    return 0;
+}
+
+int
+test_leq()
+{
+    for (int k=0; k<5; k++) {
+        BDD a = make_random(rng(2, 8), 16);
+        BDD b = make_random(rng(2, 8), 16);
+        BDD care = make_random(rng(2, 8), 16);
+        if (rng(0, 2)) {
+            // a -> b holds
+            BDD t = sylvan_ref(sylvan_or(a, b));
+            sylvan_deref(b);
+            b = t;
+        }
+        if (rng(0, 2)) {
+            // a <-> b under care holds
+            BDD t = sylvan_ref(sylvan_and(care, sylvan_equiv(a, b)));
+            sylvan_deref(care);
+            care = t;
+        }
+
+        test_assert(sylvan_leq(a, b) == (sylvan_and(a, sylvan_not(b)) == sylvan_false));
+        test_assert(sylvan_leq(b, a) == (sylvan_and(b, sylvan_not(a)) == sylvan_false));
+        test_assert(sylvan_disjoint(a, b) == (sylvan_and(a, b) == sylvan_false));
+        test_assert(sylvan_disjoint(a, sylvan_not(b)) == (sylvan_and(a, sylvan_not(b)) == sylvan_false));
+        test_assert(sylvan_equiv_under(a, b, care) == (sylvan_and(sylvan_xor(a, b), care) == sylvan_false));
+        test_assert(sylvan_equiv_under(a, sylvan_not(b), care) == (sylvan_and(sylvan_equiv(a, b), care) == sylvan_false));
+
+        test_assert(sylvan_leq(a, a) && sylvan_leq(sylvan_false, a) && sylvan_leq(a, sylvan_true));
+        test_assert(sylvan_leq(sylvan_and(a, b), a));
+        test_assert(sylvan_disjoint(a, sylvan_not(a)));
+        test_assert(sylvan_equiv_under(a, b, sylvan_false));
+        test_assert(sylvan_equiv_under(a, b, sylvan_true) == (a == b));
+
+        sylvan_deref(a);
+        sylvan_deref(b);
+        sylvan_deref(care);
+    }
+    return 0;
+}
+
+int
+test_partrel()
+{
+    // 7 pairs (s,s') in the relation, variables 14 and 15 are not in the relation
+    BDD rels[6];
+    BDDSET supps[6];
+    BDDSET vars = sylvan_set_empty(), odd = sylvan_set_empty();
+    sylvan_protect(&vars);
+    sylvan_protect(&odd);
+    for (int i=13; i>=0; i--) vars = sylvan_set_add(vars, i);
+    for (int i=15; i>=0; i-=2) odd = sylvan_set_add(odd, i);
+
+    BDD mono = sylvan_true;
+    sylvan_protect(&mono);
+    for (int i=0; i<6; i++) {
+        supps[i] = sylvan_set_empty();
+        for (int k=6; k>=0; k--) {
+            if (k == i || rng(0, 3) == 0) {
+                supps[i] = sylvan_set_add(supps[i], 2*k+1);
+                supps[i] = sylvan_set_add(supps[i], 2*k);
+            }
+        }
+        sylvan_protect(&supps[i]);
+        BDD r = make_random(0, 16);
+        rels[i] = sylvan_project(r, supps[i]);
+        sylvan_protect(&rels[i]);
+        sylvan_deref(r);
+        mono = sylvan_and(mono, rels[i]);
+    }
+
+    sylvan_partrel_t rel = sylvan_partrel_create(rels, supps, 6, vars, rng(1, 100));
+    test_assert(sylvan_partrel_cluster_count(rel, 0) >= 1);
+    test_assert(sylvan_partrel_cluster_count(rel, 0) <= 6);
+
+    for (int j=0; j<5; j++) {
+        BDD r = make_random(0, 16);
+        BDD states = sylvan_exists(r, odd);
+        sylvan_protect(&states);
+        sylvan_deref(r);
+        test_assert(testEqual(sylvan_partrel_next(states, rel), sylvan_relnext(states, mono, vars)));
+        test_assert(testEqual(sylvan_partrel_prev(states, rel), sylvan_relprev(mono, states, vars)));
+        sylvan_unprotect(&states);
+    }
+
+    sylvan_partrel_free(rel);
+    for (int i=0; i<6; i++) {
+        sylvan_unprotect(&rels[i]);
+        sylvan_unprotect(&supps[i]);
+    }
+    sylvan_unprotect(&mono);
+    sylvan_unprotect(&vars);
+    sylvan_unprotect(&odd);
+    return 0;
+}
+
+int
+test_saturate()
+{
+    // BDD: 5 relations over random pairs (s,s') of 6 state variables
+    BDD rels[5];
+    BDDSET vars[5];
+    BDDSET odd = sylvan_set_empty();
+    sylvan_protect(&odd);
+    for (int i=11; i>=0; i-=2) odd = sylvan_set_add(odd, i);
+    for (int i=0; i<5; i++) {
+        vars[i] = sylvan_set_empty();
+        for (int k=5; k>=0; k--) {
+            if (rng(0, 3) == 0) {
+                vars[i] = sylvan_set_add(vars[i], 2*k+1);
+                vars[i] = sylvan_set_add(vars[i], 2*k);
+            }
+        }
+        sylvan_protect(&vars[i]);
+        BDD r = make_random(0, 12);
+        rels[i] = sylvan_project(r, vars[i]);
+        sylvan_protect(&rels[i]);
+        sylvan_deref(r);
+    }
+
+    BDD r = make_random(0, 12);
+    BDD states = sylvan_exists(r, odd);
+    sylvan_protect(&states);
+    sylvan_deref(r);
+
+    BDD reach = states, prev = sylvan_false;
+    sylvan_protect(&reach);
+    sylvan_protect(&prev);
+    while (prev != reach) {
+        prev = reach;
+        for (int i=0; i<5; i++) reach = sylvan_or(reach, sylvan_relnext(reach, rels[i], vars[i]));
+    }
+    test_assert(testEqual(sylvan_saturate(states, rels, vars, 5), reach));
+
+    for (int i=0; i<5; i++) {
+        sylvan_unprotect(&rels[i]);
+        sylvan_unprotect(&vars[i]);
+    }
+    sylvan_unprotect(&odd);
+    sylvan_unprotect(&states);
+    sylvan_unprotect(&reach);
+    sylvan_unprotect(&prev);
+
+    // LDD: 5 relations that read and write one of 4 state variables
+    MDD lrels[5], metas[5];
+    for (int i=0; i<5; i++) {
+        uint32_t meta[6];
+        int k = rng(0, 4), j = 0;
+        for (int l=0; l<k; l++) meta[j++] = 0;
+        meta[j++] = 1;
+        meta[j++] = 2;
+        meta[j++] = (uint32_t)-1;
+        metas[i] = lddmc_cube(meta, j);
+        lddmc_protect(&metas[i]);
+        lrels[i] = make_random_ldd_set(2, 4, 4);
+        lddmc_protect(&lrels[i]);
+    }
+
+    MDD lstates = make_random_ldd_set(4, 4, 3);
+    lddmc_protect(&lstates);
+    MDD lreach = lstates, lprev = lddmc_false;
+    lddmc_protect(&lreach);
+    lddmc_protect(&lprev);
+    while (lprev != lreach) {
+        lprev = lreach;
+        for (int i=0; i<5; i++) lreach = lddmc_union(lreach, lddmc_relprod(lreach, lrels[i], metas[i]));
+    }
+    test_assert(lddmc_saturate(lstates, lrels, metas, 5) == lreach);
+
+    // relations that read and write no variables are skipped
+    MDD lrels7[7] = { lrels[0], lrels[1], lddmc_true, lrels[2], lrels[3], lrels[4], lddmc_true };
+    MDD metas7[7] = { metas[0], metas[1], lddmc_true, metas[2], metas[3], metas[4], lddmc_false };
+    test_assert(lddmc_saturate(lstates, lrels7, metas7, 7) == lreach);
+    test_assert(lddmc_reachable(lstates, lrels, metas, 5, NULL, NULL) == lreach);
+
+    for (int i=0; i<5; i++) {
+        lddmc_unprotect(&lrels[i]);
+        lddmc_unprotect(&metas[i]);
+    }
+    lddmc_unprotect(&lstates);
+    lddmc_unprotect(&lreach);
+    lddmc_unprotect(&lprev);
+    return 0;
+}
+
+/**
+ * Make three random MTBDDs and three random BDDs, one of which is a terminal, and protect them.
+ */
+static void
+make_mixed_dds(MTBDD dds[6])
+{
+    for (int i=0; i<3; i++) {
+        dds[i] = make_random_mtbdd(0, 12);
+        mtbdd_protect(&dds[i]);
+    }
+    for (int i=3; i<6; i++) {
+        dds[i] = make_random(0, 16);
+        if (rng(0, 2)) dds[i] = sylvan_not(dds[i]);
+        mtbdd_protect(&dds[i]);
+    }
+    dds[rng(3, 6)] = rng(0, 2) ? mtbdd_true : mtbdd_false;
+}
+
+static void
+free_mixed_dds(MTBDD dds[6])
+{
+    for (int i=0; i<6; i++) mtbdd_unprotect(&dds[i]);
+}
+
+/**
+ * The formats of the binary writers; the tests skip the formats that are not available.
+ */
+static const sylvan_binary_format binary_formats[] = {SYLVAN_BINARY_RAW, SYLVAN_BINARY_PACKED, SYLVAN_BINARY_PACKED_ZLIB};
+#define BINARY_FORMAT_COUNT (sizeof(binary_formats) / sizeof(binary_formats[0]))
+
+int
+test_serialize()
+{
+    MTBDD dds[6];
+    make_mixed_dds(dds);
+
+    FILE *f = tmpfile();
+    mtbdd_writer_tobinary(f, dds, 6);
+    rewind(f);
+    MTBDD test[6];
+    test_assert(mtbdd_reader_frombinary(f, test, 6) == 0);
+    fclose(f);
+    for (int i=0; i<6; i++) test_assert(test[i] == dds[i]);
+
+    free_mixed_dds(dds);
+    return 0;
+}
+
+int
+test_dump()
+{
+    MTBDD dds[6];
+    make_mixed_dds(dds);
+
+    MDD ldds[3];
+    for (int i=0; i<3; i++) {
+        ldds[i] = make_random_ldd_set(6, 10, 20);
+        lddmc_protect(&ldds[i]);
+    }
+    ldds[rng(0, 3)] = rng(0, 2) ? lddmc_true : lddmc_false;
+
+    FILE *f = tmpfile();
+    test_assert(mtbdd_dump(f, dds, 6) == 0);
+    test_assert(lddmc_dump(f, ldds, 3) == 0);
+    rewind(f);
+
+    sylvan_dump_header_t header;
+    test_assert(sylvan_dump_header(f, &header) == 0);
+    test_assert(header.type == SYLVAN_DUMP_MTBDD && header.rootcount == 6);
+
+    MTBDD test[6];
+    MDD ltest[3];
+    test_assert(lddmc_undump(f, ltest, 3) != 0);
+    test_assert(mtbdd_undump(f, test, 5) != 0);
+    test_assert(mtbdd_undump(f, test, 6) == 0);
+    test_assert(lddmc_undump(f, ltest, 3) == 0);
+    fclose(f);
+    for (int i=0; i<6; i++) test_assert(test[i] == dds[i]);
+    for (int i=0; i<3; i++) test_assert(ltest[i] == ldds[i]);
+
+    free_mixed_dds(dds);
+    for (int i=0; i<3; i++) lddmc_unprotect(&ldds[i]);
+    return 0;
+}
+
+int
+test_packed()
+{
+    MTBDD dds[6];
+    make_mixed_dds(dds);
+
+    MDD ldds[3];
+    for (int i=0; i<3; i++) {
+        ldds[i] = make_random_ldd_set(6, 10, 20);
+        lddmc_protect(&ldds[i]);
+    }
+
+    for (size_t k=0; k<BINARY_FORMAT_COUNT; k++) {
+        if (sylvan_set_binary_format(binary_formats[k]) != 0) continue;
+
+        FILE *f = tmpfile();
+        mtbdd_writer_tobinary(f, dds, 6);
+        size_t ids[3];
+        lddmc_serialize_reset();
+        for (int i=0; i<3; i++) ids[i] = lddmc_serialize_add(ldds[i]);
+        lddmc_serialize_tofile(f);
+        lddmc_serialize_reset();
+        sylvan_set_binary_format(SYLVAN_BINARY_RAW);
+        rewind(f);
+
+        MTBDD test[6];
+        test_assert(mtbdd_reader_frombinary(f, test, 6) == 0);
+        for (int i=0; i<6; i++) test_assert(test[i] == dds[i]);
+        test_assert(lddmc_serialize_fromfile(f) == 0);
+        for (int i=0; i<3; i++) test_assert(lddmc_serialize_get_reversed(ids[i]) == ldds[i]);
+        lddmc_serialize_reset();
+
+        // a truncated file is not valid
+        long end = ftell(f);
+        FILE *g = tmpfile();
+        rewind(f);
+        for (long l=0; l<end-1; l++) fputc(fgetc(f), g);
+        rewind(g);
+        test_assert(mtbdd_reader_skipbinary(g) == 0);
+        test_assert(lddmc_serialize_fromfile(g) != 0);
+        lddmc_serialize_reset();
+        test_assert(lddmc_serialize_fromfile(g) != 0);
+        lddmc_serialize_reset();
+        fclose(g);
+
+        // skipping the MTBDDs ends where the LDDs start
+        rewind(f);
+        test_assert(mtbdd_reader_skipbinary(f) == 0);
+        test_assert(lddmc_serialize_fromfile(f) == 0);
+        for (int i=0; i<3; i++) test_assert(lddmc_serialize_get_reversed(ids[i]) == ldds[i]);
+        lddmc_serialize_reset();
+        test_assert(mtbdd_reader_skipbinary(f) != 0);
+        fclose(f);
+    }
+
+    free_mixed_dds(dds);
+    for (int i=0; i<3; i++) lddmc_unprotect(&ldds[i]);
+    return 0;
+}
+
+int
+test_ldd_writer()
+{
+    MDD ldds[4];
+    for (int i=0; i<4; i++) {
+        ldds[i] = make_random_ldd_set(6, 10, 20);
+        lddmc_protect(&ldds[i]);
+    }
+    ldds[rng(0, 4)] = rng(0, 2) ? lddmc_true : lddmc_false;
+
+    for (size_t k=0; k<BINARY_FORMAT_COUNT; k++) {
+        if (sylvan_set_binary_format(binary_formats[k]) != 0) continue;
+
+        FILE *f = tmpfile();
+        lddmc_writer_tobinary(f, ldds, 4);
+        sylvan_set_binary_format(SYLVAN_BINARY_RAW);
+        rewind(f);
+        MDD test[4];
+        test_assert(lddmc_reader_frombinary(f, test, 3) != 0);
+        rewind(f);
+        test_assert(lddmc_reader_frombinary(f, test, 4) == 0);
+        fclose(f);
+        for (int i=0; i<4; i++) test_assert(test[i] == ldds[i]);
+    }
+
+    // a reader continues the identifiers of earlier blocks, as in lddmc_serialize_tofile
+    FILE *f = tmpfile();
+    size_t ids[4];
+    lddmc_serialize_reset();
+    for (int i=0; i<4; i++) {
+        ids[i] = lddmc_serialize_add(ldds[i]);
+        lddmc_serialize_tofile(f);
+    }
+    lddmc_serialize_reset();
+    rewind(f);
+    lddmc_reader_t reader = lddmc_reader_start();
+    for (int i=0; i<4; i++) {
+        test_assert(lddmc_reader_readbinary(reader, f) == 0);
+        test_assert(lddmc_reader_get(reader, ids[i]) == ldds[i]);
+    }
+    lddmc_reader_end(reader);
+
+    // deferred blocks are only inserted by lddmc_reader_flush
+    rewind(f);
+    reader = lddmc_reader_start();
+    lddmc_reader_defer(reader);
+    for (int i=0; i<4; i++) test_assert(lddmc_reader_readbinary(reader, f) == 0);
+    for (int i=0; i<4; i++) if (ids[i] > lddmc_true) test_assert(lddmc_reader_get(reader, ids[i]) == lddmc_false);
+    lddmc_reader_flush(reader);
+    for (int i=0; i<4; i++) test_assert(lddmc_reader_get(reader, ids[i]) == ldds[i]);
+    lddmc_reader_end(reader);
+    fclose(f);
+
+    for (int i=0; i<4; i++) lddmc_unprotect(&ldds[i]);
+    return 0;
+}
+
+int
+test_profile()
+{
+    MTBDD dds[4];
+    for (int i=0; i<4; i++) {
+        dds[i] = make_random(0, 16);
+        if (rng(0, 2)) dds[i] = sylvan_not(dds[i]);
+    }
+    dds[rng(0, 4)] = sylvan_ithvar(rng(0, 16));
+
+    sylvan_profile_t profile;
+    mtbdd_profile(dds, 4, &profile);
+
+    // every internal node has two edges, and every root is an edge
+    size_t internal = profile.total - profile.leaves, edges = profile.leaf_edges;
+    for (uint32_t v=0; v<profile.levels; v++) {
+        edges += profile.edges[v];
+        test_assert(profile.nodes[v] <= profile.peak_width);
+        test_assert(profile.edges[v] >= profile.nodes[v]);
+    }
+    test_assert(edges == 2 * internal + 4);
+    test_assert(internal == mtbdd_nodecount_more(dds, 4) - 1);
+    test_assert(profile.levels <= 16);
+    test_assert(profile.nodes[profile.peak_level] == profile.peak_width);
+    test_assert(profile.leaves == 2);
+
+    sylvan_profile_free(&profile);
+    return 0;
+}
+
+int
+test_gc_log()
+{
+    BDD dd = make_random(0, 16);
+    mtbdd_protect(&dd);
+
+    sylvan_gc_enable();
+    size_t count = sylvan_gc_log_count();
+    sylvan_gc();
+    sylvan_gc();
+    sylvan_gc_disable();
+    test_assert(sylvan_gc_log_count() == count + 2);
+
+    sylvan_gc_event_t event;
+    test_assert(sylvan_gc_log_get(count + 1, &event));
+    test_assert(!sylvan_gc_log_get(count + 2, &event));
+    test_assert(event.index == count + 1);
+    test_assert(event.table_after == llmsset_get_size(nodes));
+    test_assert(event.nodes_live >= mtbdd_nodecount(dd));
+    test_assert(event.nodes_live <= event.nodes_before);
+
+    uint64_t phases = 0;
+    for (int p=0; p<SYLVAN_GC_PHASES; p++) phases += event.phases[p];
+    test_assert(phases <= event.pause);
+
+    size_t marked = 0;
+    int found = 0;
+    for (unsigned int m=0; m<event.mark_count; m++) {
+        marked += event.marks[m].nodes;
+        if (event.marks[m].name != NULL && strcmp(event.marks[m].name, "mtbdd_gc_mark_protected") == 0) found = 1;
+    }
+    test_assert(found);
+    test_assert(marked == event.nodes_live);
+
+    mtbdd_unprotect(&dd);
+    return 0;
+}
+
+int
+test_stats()
+{
+    // if Sylvan is built without SYLVAN_STATS, the counters and timers are sampled
+    sylvan_stats_set_sampling(4);
+    const int sampled = sylvan_stats_get_sampling() == 4;
+    sylvan_stats_reset();
+
+    // the counts of this file only go through the sampling, as it is not built with SYLVAN_STATS
+    for (int i=0; i<100000; i++) sylvan_stats_count(BDD_PATHCOUNT);
+    BDD dd = make_random(0, 16);
+    mtbdd_protect(&dd);
+    dd = sylvan_and(dd, make_random(0, 16));
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc();
+    sylvan_gc_disable();
+    mtbdd_unprotect(&dd);
+
+    sylvan_stats_t stats;
+    sylvan_stats_snapshot(&stats);
+    if (sampled) test_assert(stats.counters[BDD_PATHCOUNT] >= 95000 && stats.counters[BDD_PATHCOUNT] <= 105000);
+    test_assert(stats.counters[BDD_AND] > 0);
+    test_assert(stats.timers[SYLVAN_GC] > 0);
+    uint64_t measured = 0;
+    for (int b=0; b<SYLVAN_TIMER_BUCKETS; b++) measured += stats.timer_histograms[SYLVAN_GC][b];
+    test_assert(measured == 2);
+
+    FILE *f = tmpfile();
+    sylvan_stats_report_json(f);
+    size_t len = (size_t)ftell(f);
+    char *buf = (char*)malloc(len + 1);
+    rewind(f);
+    test_assert(fread(buf, 1, len, f) == len);
+    buf[len] = 0;
+    fclose(f);
+    const char *keys[] = {"\"workers\"", "\"sampling\"", "\"timer_buckets_us\"", "\"tables\"", "\"nodes\"",
+                          "\"cache\"", "\"operations\"", "\"bdd_and\": {\"count\"", "\"cache_hit_ratio\"",
+                          "\"gc\"", "\"gc_time\": {\"total\"", "\"histogram\"", "\"events\""};
+    for (size_t k=0; k<sizeof(keys)/sizeof(keys[0]); k++) test_assert(strstr(buf, keys[k]) != NULL);
+    free(buf);
+
+    sylvan_stats_set_sampling(0);
+    sylvan_stats_reset();
+    return 0;
+}
+
+int
+test_trace()
+{
+    // without SYLVAN_TRACE, there is nothing to test
+    if (sylvan_trace_enable(SYLVAN_TRACE_ALL, 1<<16) != 0) return 0;
+
+    BDD dd = make_random(0, 16);
+    mtbdd_protect(&dd);
+    sylvan_trace_begin("test");
+    dd = sylvan_and(dd, make_random(0, 16));
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    sylvan_trace_end("test");
+    sylvan_trace_disable();
+    mtbdd_unprotect(&dd);
+
+    FILE *f = tmpfile();
+    size_t count = sylvan_trace_dump(f);
+    test_assert(count >= 4); // begin, end, gc request, gc phases
+
+    size_t len = (size_t)ftell(f);
+    char *buf = (char*)malloc(len + 1);
+    rewind(f);
+    test_assert(fread(buf, 1, len, f) == len);
+    buf[len] = 0;
+    fclose(f);
+    test_assert(strstr(buf, "\"traceEvents\"") != NULL);
+    test_assert(strstr(buf, "\"name\": \"test\", \"cat\": \"user\", \"ph\": \"B\"") != NULL);
+    test_assert(strstr(buf, "\"name\": \"mark\", \"cat\": \"gc\", \"ph\": \"X\"") != NULL);
+    test_assert(strstr(buf, "\"cat\": \"cache\"") != NULL);
+    free(buf);
+
+    // the ring buffer keeps the last events
+    test_assert(sylvan_trace_enable(SYLVAN_TRACE_USER, 4) == 0);
+    for (int i=0; i<10; i++) sylvan_trace_mark("tick");
+    sylvan_trace_disable();
+    f = tmpfile();
+    test_assert(sylvan_trace_dump(f) == 4);
+    fclose(f);
+
+    sylvan_trace_enable(0, 0);
+    return 0;
+}
+
+int
+test_mtbdd_and_abstract()
+{
+    MTBDD a = make_random_mtbdd(0, 8);
+    mtbdd_refs_push(a);
+    MTBDD b = make_random_mtbdd(2, 10);
+    mtbdd_refs_push(b);
+
+    BDDSET vars = mtbdd_set_empty();
+    for (int i=9; i>=0; i--) {
+        if (rng(0, 2)) vars = mtbdd_set_add(vars, i);
+    }
+    mtbdd_refs_push(vars);
+
+    mtbdd_apply_op apply_ops[] = {TASK(mtbdd_op_times), TASK(mtbdd_op_plus), TASK(mtbdd_op_max)};
+    mtbdd_abstract_op abstract_ops[] = {TASK(mtbdd_abstract_op_plus), TASK(mtbdd_abstract_op_min), TASK(mtbdd_abstract_op_max)};
+
+    for (int i=0; i<3; i++) {
+        for (int j=0; j<3; j++) {
+            MTBDD product = mtbdd_refs_push(mtbdd_apply(a, b, apply_ops[i]));
+            MTBDD expected = mtbdd_refs_push(mtbdd_abstract(product, vars, abstract_ops[j]));
+            test_assert(testEqual(mtbdd_and_abstract(a, b, vars, apply_ops[i], abstract_ops[j]), expected));
+            mtbdd_refs_pop(2);
+        }
+    }
+
+    MTBDD expected = mtbdd_refs_push(mtbdd_abstract_plus(mtbdd_times(a, b), vars));
+    test_assert(testEqual(mtbdd_and_abstract_plus(a, b, vars), expected));
+    mtbdd_refs_pop(1);
+    expected = mtbdd_refs_push(mtbdd_abstract_max(mtbdd_times(a, b), vars));
+    test_assert(testEqual(mtbdd_and_abstract_max(a, b, vars), expected));
+    mtbdd_refs_pop(1);
+
+    mtbdd_refs_pop(3);
+    return 0;
+}
+
 int
 test_ldd()
 {
@@ -509,6 +1153,326 @@ test_ldd()
     return 0;
 }
 
+/**
+ * Run garbage collection and return the number of nodes marked by the given marking callback
+ */
+static size_t
+gc_marked(const char *name)
+{
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+
+    sylvan_gc_event_t event;
+    if (!sylvan_gc_log_get(sylvan_gc_log_count() - 1, &event)) return 0;
+    for (unsigned int m=0; m<event.mark_count; m++) {
+        if (event.marks[m].name != NULL && strcmp(event.marks[m].name, name) == 0) return event.marks[m].nodes;
+    }
+    return 0;
+}
+
+#define refs_marked() gc_marked("mtbdd_refs_mark")
+
+TASK_1(BDD, test_refs_var, uint32_t, var)
+{
+    return sylvan_ithvar(var);
+}
+
+TASK_0(int, test_refs_stacks)
+{
+    // enough references for several segments of the stacks
+    static BDD vars[3000];
+    const size_t marked = refs_marked();
+
+    for (uint32_t i=0; i<3000; i+=2) {
+        mtbdd_refs_push(sylvan_ithvar(100000+i));
+        vars[i+1] = sylvan_ithvar(100000+i+1);
+        mtbdd_refs_pushptr(&vars[i+1]);
+    }
+    test_assert(refs_marked() == marked + 3000);
+
+    // pop across segments, then push again
+    mtbdd_refs_pop(1200);
+    test_assert(refs_marked() == marked + 1800);
+    for (uint32_t i=600; i<3000; i+=2) mtbdd_refs_push(sylvan_ithvar(100000+i));
+    test_assert(refs_marked() == marked + 3000);
+    mtbdd_refs_pop(1500);
+    mtbdd_refs_popptr(1500);
+    test_assert(refs_marked() == marked);
+
+    for (uint32_t i=0; i<1500; i++) mtbdd_refs_spawn(SPAWN(test_refs_var, 200000+i));
+    for (uint32_t i=1500; i>0; i--) test_assert(mtbdd_refs_sync(SYNC(test_refs_var)) == sylvan_ithvar(200000+i-1));
+    test_assert(refs_marked() == marked);
+
+    return 0;
+}
+
+int
+test_gc_generational()
+{
+    sylvan_gc_set_generational(2);
+    sylvan_gc_event_t event;
+
+    BDD dd = make_random(500, 516); // variables of no other test
+    mtbdd_protect(&dd);
+    sylvan_deref(dd);
+    const size_t dd_nodes = mtbdd_nodecount(dd) - 1;
+
+    // the first collection is full and makes the nodes old
+    const size_t marked = gc_marked("mtbdd_gc_mark_protected");
+    test_assert(sylvan_gc_log_get(sylvan_gc_log_count() - 1, &event) && !event.minor);
+    test_assert(marked >= dd_nodes);
+
+    // a minor collection only marks the young nodes
+    BDD young = sylvan_ithvar(400000);
+    mtbdd_protect(&young);
+    test_assert(gc_marked("mtbdd_gc_mark_protected") == 1);
+    test_assert(sylvan_gc_log_get(sylvan_gc_log_count() - 1, &event) && event.minor);
+    test_assert(event.nodes_old >= dd_nodes);
+    size_t sum = event.nodes_old;
+    for (unsigned int m=0; m<event.mark_count; m++) sum += event.marks[m].nodes;
+    test_assert(sum == event.nodes_live);
+
+    // minor collections keep old nodes that died, a full collection frees them
+    mtbdd_unprotect(&dd);
+    mtbdd_unprotect(&young);
+    test_assert(gc_marked("mtbdd_gc_mark_protected") == 0);
+    test_assert(sylvan_gc_log_get(sylvan_gc_log_count() - 1, &event) && event.minor);
+    const size_t live = event.nodes_live;
+    gc_marked("mtbdd_gc_mark_protected");
+    test_assert(sylvan_gc_log_get(sylvan_gc_log_count() - 1, &event) && !event.minor);
+    test_assert(event.nodes_live + dd_nodes <= live);
+
+    sylvan_gc_set_generational(0);
+    return 0;
+}
+
+/**
+ * The sum of variables 600000..601499 is a multiple of 3, with three nodes per level,
+ * deep and wide enough to fill the stacks of the marking engine
+ */
+static BDD
+make_sum_mod3()
+{
+    BDD r[3] = { sylvan_true, sylvan_false, sylvan_false };
+    for (uint32_t v=601499; v>=600000; v--) {
+        BDD n0 = sylvan_makenode(v, r[0], r[1]);
+        BDD n1 = sylvan_makenode(v, r[1], r[2]);
+        BDD n2 = sylvan_makenode(v, r[2], r[0]);
+        r[0] = n0; r[1] = n1; r[2] = n2;
+    }
+    return r[0];
+}
+
+int
+test_reader_gc()
+{
+    BDD dd = make_random(520, 536); // variables of no other test
+    const size_t dd_nodes = mtbdd_nodecount(dd) - 1;
+    FILE *f = tmpfile();
+    mtbdd_writer_tobinary(f, &dd, 1);
+    rewind(f);
+
+    // the nodes of a reader are kept until the reader ends
+    uint64_t *arr = mtbdd_reader_readbinary(f);
+    test_assert(arr != NULL);
+    int count;
+    uint64_t id;
+    test_assert(fread(&count, sizeof(int), 1, f) == 1 && fread(&id, sizeof(uint64_t), 1, f) == 1);
+    fclose(f);
+    test_assert(mtbdd_reader_get(arr, id) == dd);
+    test_assert(gc_marked("mtbdd_gc_mark_readers") == dd_nodes);
+    test_assert(mtbdd_reader_get(arr, id) == dd && mtbdd_nodecount(dd) - 1 == dd_nodes);
+    mtbdd_reader_end(arr);
+    test_assert(gc_marked("mtbdd_gc_mark_readers") == 0);
+    return 0;
+}
+
+int
+test_gc_mark_deep()
+{
+    BDD dd = make_sum_mod3();
+    mtbdd_protect(&dd);
+    const size_t dd_nodes = mtbdd_nodecount(dd) - 1;
+
+    // every node is marked once, and no node is lost when new nodes take the freed slots
+    test_assert(gc_marked("mtbdd_gc_mark_protected") == dd_nodes);
+    for (uint32_t v=0; v<2000; v++) sylvan_and(sylvan_ithvar(610000 + v), sylvan_ithvar(612000 + v));
+    test_assert(make_sum_mod3() == dd);
+    test_assert(mtbdd_nodecount(dd) - 1 == dd_nodes);
+
+    mtbdd_unprotect(&dd);
+    return 0;
+}
+
+/**
+ * A custom leaf type with boxed values, which counts the created and destroyed boxes
+ */
+static int boxed_created, boxed_destroyed;
+
+static uint64_t
+boxed_hash(uint64_t value, uint64_t seed)
+{
+    return sylvan_tabhash16(*(uint64_t*)value, 0, seed);
+}
+
+static int
+boxed_equals(uint64_t a, uint64_t b)
+{
+    return *(uint64_t*)a == *(uint64_t*)b;
+}
+
+static void
+boxed_create(uint64_t *value)
+{
+    uint64_t *box = (uint64_t*)malloc(sizeof(uint64_t));
+    *box = *(uint64_t*)*value;
+    *value = (uint64_t)box;
+    boxed_created++;
+}
+
+static void
+boxed_destroy(uint64_t value)
+{
+    free((uint64_t*)value);
+    boxed_destroyed++;
+}
+
+static int
+boxed_write_binary(FILE *out, uint64_t value)
+{
+    return fwrite((uint64_t*)value, sizeof(uint64_t), 1, out) == 1 ? 0 : -1;
+}
+
+static int
+boxed_read_binary(FILE *in, uint64_t *value)
+{
+    uint64_t *box = (uint64_t*)malloc(sizeof(uint64_t));
+    if (fread(box, sizeof(uint64_t), 1, in) != 1) {
+        free(box);
+        return -1;
+    }
+    *value = (uint64_t)box;
+    return 0;
+}
+
+int
+test_leaf_store()
+{
+    uint32_t type = sylvan_mt_create_type();
+    sylvan_mt_set_hash(type, boxed_hash);
+    sylvan_mt_set_equals(type, boxed_equals);
+    sylvan_mt_set_create(type, boxed_create);
+    sylvan_mt_set_destroy(type, boxed_destroy);
+
+    // equal values share one box and one leaf
+    MTBDD leaves[2000];
+    for (uint64_t i=0; i<2000; i++) {
+        uint64_t v = i % 1000;
+        leaves[i] = mtbdd_makeleaf(type, (uint64_t)&v);
+        test_assert(*(uint64_t*)mtbdd_getvalue(leaves[i]) == i % 1000);
+    }
+    test_assert(boxed_created == 1000);
+    for (int i=0; i<1000; i++) test_assert(leaves[i] == leaves[i+1000]);
+    test_assert(mtbdd_getvalue(leaves[0]) != mtbdd_getvalue(leaves[1]));
+
+    // garbage collection destroys the boxes of the leaves that are not kept
+    for (int i=0; i<100; i++) mtbdd_protect(&leaves[i]);
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    test_assert(boxed_destroyed == 900);
+
+    // the kept leaves are found again, the others are created again in the freed slots
+    for (uint64_t i=0; i<1000; i++) {
+        MTBDD leaf = mtbdd_makeleaf(type, (uint64_t)&i);
+        test_assert(*(uint64_t*)mtbdd_getvalue(leaf) == i);
+        if (i < 100) test_assert(leaf == leaves[i]);
+    }
+    test_assert(boxed_created == 1900);
+
+    // skipping the leaves in a file consumes their data without creating leaves
+    sylvan_mt_set_write_binary(type, boxed_write_binary);
+    sylvan_mt_set_read_binary(type, boxed_read_binary);
+    FILE *f = tmpfile();
+    mtbdd_writer_tobinary(f, leaves, 100);
+    fputc(42, f);
+    rewind(f);
+    test_assert(mtbdd_reader_skipbinary(f) == 0);
+    test_assert(fgetc(f) == 42);
+    fclose(f);
+    test_assert(boxed_created == 1900);
+    test_assert(boxed_destroyed == 1000);
+
+    // a full store grows at garbage collection to hold more live values
+    static MTBDD many[5000];
+    sylvan_gc_enable();
+    for (uint64_t i=0; i<5000; i++) {
+        uint64_t v = 10000 + i;
+        many[i] = mtbdd_false;
+        mtbdd_protect(&many[i]);
+        many[i] = mtbdd_makeleaf(type, (uint64_t)&v);
+    }
+    sylvan_gc_disable();
+    test_assert(boxed_created == 6900);
+    for (uint64_t i=0; i<5000; i++) {
+        uint64_t v = 10000 + i;
+        test_assert(*(uint64_t*)mtbdd_getvalue(many[i]) == v);
+        test_assert(mtbdd_makeleaf(type, (uint64_t)&v) == many[i]);
+    }
+    test_assert(boxed_created == 6900);
+
+    for (int i=0; i<100; i++) mtbdd_unprotect(&leaves[i]);
+    for (int i=0; i<5000; i++) mtbdd_unprotect(&many[i]);
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    test_assert(boxed_destroyed == 7000);
+    return 0;
+}
+
+static BDD deferred_vars[600], deferred_others[600];
+
+static void *
+test_deferred_refs_thread(void *arg)
+{
+    // deref in another thread, more values than fit in the buffer of the thread
+    for (int i=599; i>=0; i--) mtbdd_deref(deferred_others[i]);
+    return arg;
+}
+
+int
+test_deferred_refs()
+{
+    mtbdd_set_deferred_refs(1);
+    const size_t count = mtbdd_count_refs();
+    const size_t marked = gc_marked("mtbdd_gc_mark_external_refs");
+
+    for (int i=0; i<600; i++) deferred_vars[i] = mtbdd_ref(sylvan_ithvar(300000+i));
+    test_assert(mtbdd_count_refs() == count + 600);
+    test_assert(gc_marked("mtbdd_gc_mark_external_refs") == marked + 600);
+
+    // a ref and a deref cancel out in the buffer
+    for (int i=0; i<1000; i++) mtbdd_deref(mtbdd_ref(deferred_vars[i % 10]));
+    for (int i=0; i<300; i++) mtbdd_deref(deferred_vars[i]);
+    test_assert(mtbdd_count_refs() == count + 300);
+    for (int i=0; i<300; i++) mtbdd_ref(deferred_vars[i]);
+
+    // the derefs of another thread may reach the table before the refs of this thread
+    for (int i=0; i<600; i++) deferred_others[i] = mtbdd_ref(sylvan_ithvar(301000+i));
+    pthread_t t;
+    pthread_create(&t, NULL, test_deferred_refs_thread, NULL);
+    pthread_join(t, NULL);
+    test_assert(mtbdd_count_refs() == count + 600);
+    test_assert(gc_marked("mtbdd_gc_mark_external_refs") == marked + 600);
+    for (int i=0; i<600; i++) mtbdd_deref(deferred_vars[i]);
+    test_assert(gc_marked("mtbdd_gc_mark_external_refs") == marked);
+    test_assert(mtbdd_count_refs() == count);
+
+    mtbdd_set_deferred_refs(0);
+    return 0;
+}
+
 TASK_0(int, runtests)
 {
     // we are not testing garbage collection
@@ -527,6 +1491,47 @@ TASK_0(int, runtests)
     printf("Testing operators.\n");
     for (int j=0;j<10;j++) if (test_operators()) return 1;
 
+    printf("Testing n-ary operators.\n");
+    for (int j=0;j<10;j++) if (test_nary()) return 1;
+    printf("Testing implication checks.\n");
+    for (int j=0;j<10;j++) if (test_leq()) return 1;
+    printf("Testing partitioned relations.\n");
+    for (int j=0;j<10;j++) if (test_partrel()) return 1;
+    printf("Testing saturation.\n");
+    for (int j=0;j<10;j++) if (test_saturate()) return 1;
+    printf("Testing mtbdd and_abstract.\n");
+    for (int j=0;j<10;j++) if (test_mtbdd_and_abstract()) return 1;
+
+    printf("Testing serialization.\n");
+    for (int j=0;j<10;j++) if (test_serialize()) return 1;
+    printf("Testing dump.\n");
+    for (int j=0;j<10;j++) if (test_dump()) return 1;
+    printf("Testing packed format.\n");
+    for (int j=0;j<10;j++) if (test_packed()) return 1;
+    printf("Testing LDD writer and reader.\n");
+    for (int j=0;j<10;j++) if (test_ldd_writer()) return 1;
+
+    printf("Testing profile.\n");
+    for (int j=0;j<10;j++) if (test_profile()) return 1;
+    // the tests of garbage collection check the node counts of the GC event log
+    sylvan_gc_log_set_counts(1);
+    printf("Testing GC event log.\n");
+    if (test_gc_log()) return 1;
+    printf("Testing statistics.\n");
+    if (test_stats()) return 1;
+    printf("Testing trace.\n");
+    if (test_trace()) return 1;
+    printf("Testing refs stacks.\n");
+    if (CALL(test_refs_stacks)) return 1;
+    printf("Testing deferred refs.\n");
+    if (test_deferred_refs()) return 1;
+    printf("Testing generational GC.\n");
+    if (test_gc_generational()) return 1;
+    if (test_gc_mark_deep()) return 1;
+    if (test_reader_gc()) return 1;
+    printf("Testing leaf store.\n");
+    if (test_leaf_store()) return 1;
+
     printf("Testing ldd.\n");
     if (test_ldd()) return 1;
 
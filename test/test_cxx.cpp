@@ -3,8 +3,10 @@
  */
 
 #include <assert.h>
+#include <stdexcept>
 #include <sylvan.h>
 #include <sylvan_obj.hpp>
+#include <sylvan_op.hpp>
 
 #include "test_assert.h"
 
@@ -33,6 +35,202 @@ TASK_0(int, runtest)
     test_assert(v2.Compose(map) == (v1 + v2));
     test_assert((t * v2) == v2);
 
+    test_assert(v1 <= t && t >= v2 && v1 < t && !(t <= v1) && !(v1 < v1));
+    test_assert(v1.Leq(t) && !t.Leq(v1));
+    test_assert(v1.Disjoint(!v1) && !v1.Disjoint(t));
+    test_assert(t.EquivUnder(v1, v1) && !t.EquivUnder(v1, !v1) && t.EquivUnder(v2, ~v1 | v2));
+
+    return 0;
+}
+
+TASK_0(int, test_handles)
+{
+    size_t handles = sylvan_count_handles();
+    {
+        std::vector<Bdd> bdds;
+        for (uint32_t i=0; i<3000; i++) bdds.push_back(Bdd::bddVar(i % 20) & !Bdd::bddVar(20 + i % 7));
+        Mtbdd m = Mtbdd(bdds[5]) * Mtbdd::int64Terminal(3);
+        BddMap map, copy;
+        map.put(3, bdds[7]);
+        copy = map;
+        MtbddMap mmap(2, m);
+        test_assert(sylvan_count_handles() == handles + 3000 + 4);
+
+        // the nodes stay valid during garbage collection
+        BDD before = bdds[2999].GetBDD();
+        sylvan_gc_enable();
+        sylvan_gc();
+        sylvan_gc_disable();
+        test_assert(bdds[2999].GetBDD() == before);
+        test_assert(bdds[2999] == (Bdd::bddVar(2999 % 20) & !Bdd::bddVar(20 + 2999 % 7)));
+        test_assert(m == Mtbdd(bdds[5]) * Mtbdd::int64Terminal(3));
+        test_assert(Bdd::bddVar(3).Compose(copy) == bdds[7]);
+    }
+    test_assert(sylvan_count_handles() == handles);
+    return 0;
+}
+
+TASK_0(int, test_expressions)
+{
+    std::vector<Bdd> v;
+    for (uint32_t i=0; i<20; i++) v.push_back(Bdd::bddVar(i).Xor(Bdd::bddVar((i*7+3)%20)));
+
+    // the operators of Bdd compute the result right away
+    Bdd conj = v[0];
+    Bdd disj = v[0];
+    for (int i=1; i<20; i++) {
+        conj = conj.And(v[i]);
+        disj = disj.Or(v[i]);
+    }
+    test_assert(conj == (v[0] & v[1] & v[2] & v[3] & v[4] & v[5] & v[6] & v[7] & v[8] & v[9] &
+                         v[10] & v[11] & v[12] & v[13] & v[14] & v[15] & v[16] & v[17] & v[18] & v[19]));
+    test_assert(disj == (v[0] | v[1] | v[2] | v[3] | v[4] | v[5] | v[6] | v[7] | v[8] | v[9] |
+                         v[10] | v[11] | v[12] | v[13] | v[14] | v[15] | v[16] | v[17] | v[18] | v[19]));
+    test_assert((v[0] & !v[0]).isZero());
+    test_assert((v[0] | !v[0]).isOne());
+    test_assert((v[1] & v[2]).SatCount(BddSet::fromVector(std::vector<uint32_t>({1, 2, 5, 10, 17}))) == 8);
+    auto stored = (v[1] & v[2]) | (v[3] & v[4]);
+    test_assert(stored == v[1].And(v[2]).Or(v[3].And(v[4])));
+
+    // moves and rvalue operators
+    Bdd a = v[3] ^ v[4];
+    Bdd b = std::move(a);
+    test_assert(b == v[3].Xor(v[4]));
+    test_assert(a.isZero());
+    a = v[5];
+    test_assert(a == v[5]);
+    Bdd c = std::move(b);
+    c -= v[5];
+    test_assert(c == v[3].Xor(v[4]).And(!v[5]));
+    b = v[6] ^ v[7];
+    a = std::move(b);
+    test_assert(a == v[6].Xor(v[7]) && b.isZero());
+    b = v[8];
+    a = std::move(a);
+    test_assert(a == v[6].Xor(v[7]) && b == v[8]);
+    test_assert((!(v[1] ^ v[2])) == v[1].Xnor(v[2]));
+    Mtbdd x = Mtbdd::int64Terminal(2);
+    Mtbdd y = std::move(x);
+    x = y + y;
+    test_assert(x == Mtbdd::int64Terminal(4));
+    test_assert((x * y - y) == Mtbdd::int64Terminal(6));
+
+    sylvan_gc_enable();
+    sylvan_gc();
+    sylvan_gc_disable();
+    test_assert(a == v[6].Xor(v[7]) && c == v[3].Xor(v[4]).And(!v[5]));
+    return 0;
+}
+
+/**
+ * User-defined operations for test_operations
+ */
+struct And : public Operation<And>
+{
+    static MTBDD compute(OpContext<And> &ctx, MTBDD a, MTBDD b) {
+        if (a == sylvan_false || b == sylvan_false || a == sylvan_not(b)) return sylvan_false;
+        if (a == sylvan_true || a == b) return b;
+        if (b == sylvan_true) return a;
+        if (a > b) std::swap(a, b);
+
+        MTBDD result;
+        if (ctx.cache_get(result, a, b)) return result;
+
+        uint32_t va = mtbdd_getvar(a), vb = mtbdd_getvar(b);
+        uint32_t var = va < vb ? va : vb;
+        ctx.spawn(va == var ? sylvan_high(a) : a, vb == var ? sylvan_high(b) : b);
+        MTBDD low = ctx.call(va == var ? sylvan_low(a) : a, vb == var ? sylvan_low(b) : b);
+        MTBDD high = ctx.sync();
+        result = sylvan_makenode(var, low, high);
+        ctx.cache_put(result, a, b);
+        return result;
+    }
+};
+
+struct Xor : public Operation<Xor>
+{
+    static MTBDD compute(OpContext<Xor> &ctx, MTBDD a, MTBDD b) {
+        if (a == b) return sylvan_false;
+        if (a == sylvan_not(b)) return sylvan_true;
+        if (a == sylvan_false) return b;
+        if (b == sylvan_false) return a;
+        if (a == sylvan_true) return sylvan_not(b);
+        if (b == sylvan_true) return sylvan_not(a);
+        if (a > b) std::swap(a, b);
+
+        MTBDD result;
+        if (ctx.cache_get(result, a, b)) return result;
+
+        uint32_t va = mtbdd_getvar(a), vb = mtbdd_getvar(b);
+        uint32_t var = va < vb ? va : vb;
+        ctx.spawn(va == var ? sylvan_high(a) : a, vb == var ? sylvan_high(b) : b);
+        MTBDD low = ctx.call(va == var ? sylvan_low(a) : a, vb == var ? sylvan_low(b) : b);
+        MTBDD high = ctx.sync();
+        result = sylvan_makenode(var, low, high);
+        ctx.cache_put(result, a, b);
+        return result;
+    }
+};
+
+// the cofactor of <dd> for <var> := <value>, or throws if <var> is above <limit>
+struct Cofactor : public Operation<Cofactor>
+{
+    static MTBDD compute(OpContext<Cofactor> &ctx, MTBDD dd, uint32_t var, uint64_t value) {
+        if (sylvan_isconst(dd)) return dd;
+        uint32_t v = mtbdd_getvar(dd);
+        if (v > var) return dd;
+        if (v == var) return value & 1 ? sylvan_high(dd) : sylvan_low(dd);
+        if (v > (uint32_t)(value >> 32)) throw std::runtime_error("beyond the limit");
+
+        MTBDD result;
+        if (ctx.cache_get(result, dd, var, value)) return result;
+        ctx.spawn(sylvan_high(dd), var, value);
+        MTBDD low = ctx.call(sylvan_low(dd), var, value);
+        MTBDD high = ctx.sync();
+        result = ctx.push(sylvan_makenode(v, low, high));
+        ctx.cache_put(result, dd, var, value);
+        return result;
+    }
+};
+
+TASK_0(int, test_operations)
+{
+    std::vector<Bdd> v;
+    for (uint32_t i=0; i<24; i++) v.push_back(Bdd::bddVar(i).Xor(Bdd::bddVar((i*7+3)%24)) | Bdd::bddVar((i*5+1)%24));
+
+    for (int i=0; i<24; i++) {
+        test_assert(And::run(v[i], v[(i+5)%24]) == sylvan_and(v[i].GetBDD(), v[(i+5)%24].GetBDD()));
+        test_assert(Xor::run(v[i], !v[(i+3)%24]) == sylvan_xor(v[i].GetBDD(), sylvan_not(v[(i+3)%24].GetBDD())));
+        BddMap map(i, Bdd::bddOne());
+        test_assert(Bdd(Cofactor::run(v[i], i, (uint64_t)100 << 32 | 1)) == v[i].Compose(map));
+    }
+
+    // the results of the steps are protected while garbage collection runs during the operation
+    size_t gcs = sylvan_gc_log_count();
+    sylvan_gc_enable();
+    std::vector<Bdd> w;
+    for (uint32_t i=0; i<12; i++) w.push_back(Bdd::bddVar(i).Xor(Bdd::bddVar((i*7+3)%12)) | Bdd::bddVar((i*5+1)%12));
+    Bdd acc, expected;
+    for (uint32_t i=0; i<1000; i++) {
+        Bdd term = w[i%12] & w[(i*11+7)%12] & !w[(i*13+2)%12];
+        acc = Xor::run(acc, And::run(term, Bdd::bddVar(12+i%40)));
+        expected = sylvan_xor(expected.GetBDD(), sylvan_and(term.GetBDD(), sylvan_ithvar(12+i%40)));
+    }
+    sylvan_gc_disable();
+    test_assert(acc == expected);
+    test_assert(sylvan_gc_log_count() > gcs);
+
+    // exceptions are thrown by run, after the other steps are cancelled
+    Bdd big = v[0] & v[3] & v[9] & v[17];
+    bool thrown = false;
+    try {
+        Cofactor::run(big, 23, (uint64_t)5 << 32);
+    } catch (const std::runtime_error &e) {
+        thrown = true;
+    }
+    test_assert(thrown);
+    test_assert(Bdd(Cofactor::run(big, 23, (uint64_t)100 << 32)) == big.Compose(BddMap(23, Bdd::bddZero())));
+
     return 0;
 }
 
@@ -55,6 +253,9 @@ int main()
     test6();
 
     int res = RUN(runtest);
+    if (res == 0) res = RUN(test_handles);
+    if (res == 0) res = RUN(test_expressions);
+    if (res == 0) res = RUN(test_operations);
 
     sylvan_quit();
     lace_stop();
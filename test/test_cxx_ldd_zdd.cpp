@@ -0,0 +1,147 @@
+/**
+ * Tests of the C++ Ldd and Zdd classes
+ */
+
+#include <assert.h>
+#include <sylvan.h>
+#include <sylvan_obj.hpp>
+
+#include "test_assert.h"
+
+using namespace sylvan;
+
+TASK_0(int, test_ldd)
+{
+    Ldd a = Ldd::lddCube({0, 5});
+    Ldd b = Ldd::lddCube({1, 5});
+    Ldd c = Ldd::lddCube({2, 5});
+
+    test_assert(Ldd::lddTrue() != Ldd::lddFalse());
+    test_assert(Ldd().isFalse() && Ldd::lddTrue().isTrue());
+
+    // set operations
+    Ldd ab = a | b;
+    test_assert(ab.Contains({0, 5}) && ab.Contains({1, 5}) && !ab.Contains({2, 5}));
+    test_assert(ab.SatCount() == 2);
+    test_assert((ab & (b | c)) == b);
+    test_assert((ab - a) == b);
+    test_assert(ab.Value() == 0 && ab.Down() == Ldd::lddCube({5}) && ab.Right() == b);
+    Ldd s = a;
+    s |= c;
+    s -= a;
+    test_assert(s == c);
+    s &= ab;
+    test_assert(s.isFalse());
+
+    // the relation x := x + 1 on the first position, the second position is not in the relation
+    Ldd rel = Ldd::lddCube({0, 1}) | Ldd::lddCube({1, 2});
+    Ldd meta = Ldd::lddCube({1, 2, 0, (uint32_t)-1});
+    test_assert(ab.RelProd(rel, meta) == (b | c));
+    test_assert(a.RelProd(rel, meta).RelProd(rel, meta) == c);
+    test_assert(Ldd::lddCube({1, 2}).Project(Ldd::lddCube({1, 0, (uint32_t)-2})) == Ldd::lddCube({1}));
+
+    // moves and rvalue operators
+    Ldd m = std::move(ab);
+    test_assert(ab.isFalse() && m == (a | b));
+    ab = std::move(m) | c;
+    test_assert(ab.SatCount() == 3 && (std::move(ab) - c - b) == a);
+
+    return 0;
+}
+
+TASK_0(int, test_zdd)
+{
+    BddSet vars = BddSet::fromVector(std::vector<uint32_t>({1, 2, 3}));
+    Zdd domain = Zdd::zddDomain({1, 2, 3});
+    Bdd v1 = Bdd::bddVar(1), v2 = Bdd::bddVar(2), v3 = Bdd::bddVar(3);
+    Bdd f = v1 | v2, g = v2 & !v3;
+    Zdd zf(f, vars), zg(g, vars);
+
+    test_assert(Zdd::zddOne() != Zdd::zddZero());
+    test_assert(Zdd(Bdd::bddOne(), vars) == domain);
+    test_assert(Zdd().isZero() && Zdd::zddOne().isOne() && Zdd::zddOne().isLeaf());
+
+    // the operators match the operations on the Bdds
+    test_assert((zf & zg) == Zdd(f & g, vars));
+    test_assert((zf | zg) == Zdd(f | g, vars));
+    test_assert((zf - zg) == Zdd(f & !g, vars));
+    test_assert(zf.Not(domain) == Zdd(!f, vars));
+    test_assert(zg.Ite(zf, zf.Not(domain), domain) == Zdd(g.Ite(f, !f), vars));
+    test_assert((zf | zg).ToBdd(domain) == (f | g));
+    test_assert(zf.SatCount() == f.SatCount(vars));
+    test_assert(Zdd::zddVar(2).TopVar() == 2 && Zdd::zddVar(2).Then().isOne());
+    test_assert(zf.TopVar() == 1 && zf.Then() == Zdd(f, vars).Then() && zf.Else() != zf.Then());
+
+    Zdd z = zf;
+    z &= zg;
+    z |= zf;
+    test_assert(z == zf);
+    z -= zf;
+    test_assert(z.isZero());
+
+    // moves and rvalue operators
+    Zdd m = std::move(zf);
+    test_assert(zf.isZero() && m == Zdd(f, vars));
+    zf = std::move(m) - zg;
+    test_assert(zf == Zdd(f & !g, vars));
+
+    return 0;
+}
+
+TASK_0(int, test_handles)
+{
+    size_t ldd_handles = lddmc_count_handles();
+    size_t zdd_handles = zdd_count_handles();
+    size_t bdd_handles = sylvan_count_handles();
+    {
+        BddSet domain = BddSet::fromVector(std::vector<uint32_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+        std::vector<Ldd> ldds;
+        std::vector<Zdd> zdds;
+        for (uint32_t i=0; i<2000; i++) {
+            ldds.push_back(Ldd::lddCube({i % 17, i % 5, i}) | Ldd::lddCube({i, i % 3, 7}));
+            zdds.push_back(Zdd(Bdd::bddVar(i % 10) & !Bdd::bddVar((i + 3) % 10), domain) | Zdd::zddVar(i % 7));
+        }
+        test_assert(lddmc_count_handles() == ldd_handles + 2000);
+        test_assert(zdd_count_handles() == zdd_handles + 2000);
+        test_assert(sylvan_count_handles() == bdd_handles + 1);
+
+        // the nodes stay valid during garbage collection
+        MDD ldd_before = ldds[1999].GetLDD();
+        ZDD zdd_before = zdds[1999].GetZDD();
+        sylvan_gc_enable();
+        sylvan_gc();
+        sylvan_gc_disable();
+        // new nodes reuse the slots of the collected nodes
+        std::vector<Ldd> others;
+        for (uint32_t i=0; i<4000; i++) others.push_back(Ldd::lddCube({100000 + i, i, i}));
+        test_assert(ldds[1999].GetLDD() == ldd_before && zdds[1999].GetZDD() == zdd_before);
+        test_assert(ldds[1999].Contains({1999 % 17, 1999 % 5, 1999}) && ldds[1999].Contains({1999, 1999 % 3, 7}));
+        test_assert(ldds[1999].SatCount() == 2 && ldds[1234].NodeCount() == 6);
+        test_assert(zdds[1999] == (Zdd(Bdd::bddVar(9) & !Bdd::bddVar(2), domain) | Zdd::zddVar(1999 % 7)));
+    }
+    test_assert(lddmc_count_handles() == ldd_handles);
+    test_assert(zdd_count_handles() == zdd_handles);
+    return 0;
+}
+
+int main()
+{
+    // Standard Lace initialization with 1 worker
+    lace_start(1, 0);
+
+    // Simple Sylvan initialization, with BDD, LDD and ZDD support
+    sylvan_set_sizes(1LL<<16, 1LL<<16, 1LL<<16, 1LL<<16);
+    sylvan_init_package();
+    sylvan_init_bdd();
+    sylvan_init_ldd();
+    sylvan_init_zdd();
+
+    int res = RUN(test_ldd);
+    if (res == 0) res = RUN(test_zdd);
+    if (res == 0) res = RUN(test_handles);
+
+    sylvan_quit();
+    lace_stop();
+
+    return res;
+}
@@ -733,12 +733,53 @@ TASK_0(int, test_zdd_read_write)
         }
     }
 
-    FILE *f = tmpfile();
-    zdd_writer_tobinary(f, zdd_set, set_count);
-    rewind(f);
-    ZDD test[set_count];
-    test_assert(zdd_reader_frombinary(f, test, set_count) == 0);
-    for (int i=0; i<set_count; i++) test_assert(test[i] == zdd_set[i]);
+    for (int k=0; k<2; k++) {
+        sylvan_set_binary_format(k == 0 ? SYLVAN_BINARY_RAW : SYLVAN_BINARY_PACKED);
+        FILE *f = tmpfile();
+        zdd_writer_tobinary(f, zdd_set, set_count);
+        rewind(f);
+        ZDD test[set_count];
+        test_assert(zdd_reader_frombinary(f, test, set_count) == 0);
+        fclose(f);
+        for (int i=0; i<set_count; i++) test_assert(test[i] == zdd_set[i]);
+    }
+    sylvan_set_binary_format(SYLVAN_BINARY_RAW);
+
+    return 0;
+}
+
+TASK_0(int, test_zdd_profile)
+{
+    /**
+     * Test the profile with random sets on the even variables
+     */
+    int nvars = rng(8,12);
+    uint32_t dom_arr[nvars];
+    for (int i=0; i<nvars; i++) dom_arr[i] = i*2;
+    ZDD zdd_dom = zdd_set_from_array(dom_arr, nvars);
+
+    ZDD zdd_set[3];
+    for (int k=0; k<3; k++) {
+        zdd_set[k] = zdd_false;
+        int count = rng(4,100);
+        for (int i=0; i<count; i++) {
+            uint8_t arr[nvars];
+            for (int j=0; j<nvars; j++) arr[j] = rng(0, 2);
+            zdd_set[k] = zdd_union_cube(zdd_set[k], zdd_dom, arr, zdd_true);
+        }
+    }
+
+    sylvan_profile_t profile;
+    zdd_profile(zdd_set, 3, &profile);
+    size_t internal = profile.total - profile.leaves, edges = profile.leaf_edges;
+    for (uint32_t v=0; v<profile.levels; v++) {
+        edges += profile.edges[v];
+        if (v & 1) test_assert(profile.nodes[v] == 0);
+    }
+    test_assert(edges == 2 * internal + 3);
+    test_assert(profile.levels <= (uint32_t)(2 * nvars));
+    test_assert(profile.nodes[profile.peak_level] == profile.peak_width);
+    sylvan_profile_free(&profile);
 
     return 0;
 }
@@ -776,9 +817,11 @@ TASK_0(int, runtests)
     for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_exists)) return 1;
     // for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_relnext)) return 1;
     // for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_and_dom)) return 1;
-    // printf("test_zdd_read_write...\n");
-    // for (int k=0; k<10; k++) if (CALL(test_zdd_read_write)) return 1;
+    printf("test_zdd_read_write...\n");
+    for (int k=0; k<10; k++) if (CALL(test_zdd_read_write)) return 1;
     // for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_extend_domain)) return 1;
+    printf("test_zdd_profile...\n");
+    for (int k=0; k<test_iterations; k++) if (CALL(test_zdd_profile)) return 1;
     printf("test_zdd_isop_basic...\n");
     if (CALL(test_zdd_isop_basic)) return 1;
     printf("test_zdd_isop_random...\n");